@@ -13,9 +13,20 @@
 #include <string.h>
 #include <math.h>
 #include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 static const char* TAG = "AUDIO_PROCESSOR";
 
+// Бюджет тактов / Cycle budget
+#define BUDGET_DEFAULT_PERCENT      25   // Доля реального времени блока / Share of a block's real time
+#define DEGRADE_AFTER_BLOCKS        2    // Блоков сверх бюджета подряд до понижения / Over-budget blocks in a row before a downgrade
+#define RESTORE_AFTER_BLOCKS        40   // Спокойных блоков до повышения (~2.5 с) / Quiet blocks before a restore (~2.5 s)
+#define RESTORE_BACKOFF_MAX         8    // Предел удвоения окна после неудачного повышения / Window doubling cap after a failed restore
+#define RESTORE_HEADROOM_PERCENT    60   // Спокойный блок: меньше этой доли бюджета / Quiet block: below this share of the budget
+
 // Внутренняя структура аудио процессора / Internal audio processor structure
 struct audio_processor {
     audio_processor_config_t config;
@@ -29,6 +40,22 @@ struct audio_processor {
     float agc_envelope;         // Огибающая сигнала / Signal envelope
     float agc_attack_time;      // Время атаки / Attack time
     float agc_release_time;     // Время релиза / Release time
+    float agc_attack_alpha;     // Коэффициенты огибающей на сэмпл / Per-sample envelope coefficients
+    float agc_release_alpha;
+    
+    // Отсечка DC (дешевый режим фильтра) / DC blocker (cheap filter mode)
+    float dc_coeff;
+    float dc_input;
+    float dc_output;
+    
+    // Бюджет тактов / Cycle budget
+    audio_quality_t quality;
+    uint32_t backlog_blocks;        // Последнее сообщенное отставание / Last reported backlog
+    uint32_t over_budget_streak;
+    uint32_t quiet_streak;
+    uint32_t restore_after;         // Текущее окно до повышения / Current window before a restore
+    uint32_t blocks_since_restore;
+    audio_budget_stats_t budget;
     
     // Статистика / Statistics
     audio_stats_t stats;
@@ -97,16 +124,12 @@ static void apply_high_pass_filter(struct audio_processor* proc, float* audio, s
  * Apply AGC
  */
 static void apply_agc(struct audio_processor* proc, float* audio, size_t length) {
-    const float SAMPLE_RATE = (float)proc->config.sample_rate;
-    
     for (size_t i = 0; i < length; i++) {
         float sample = audio[i];
         float abs_sample = fabsf(sample);
         
         // Обновление огибающей / Update envelope
-        float time_constant = (abs_sample > proc->agc_envelope) ? 
-                              proc->agc_attack_time : proc->agc_release_time;
-        float alpha = expf(-1.0f / (time_constant * SAMPLE_RATE));
+        float alpha = (abs_sample > proc->agc_envelope) ? proc->agc_attack_alpha : proc->agc_release_alpha;
         proc->agc_envelope = alpha * proc->agc_envelope + (1.0f - alpha) * abs_sample;
         
         // Расчет усиления / Calculate gain
@@ -121,6 +144,243 @@ static void apply_agc(struct audio_processor* proc, float* audio, size_t length)
     }
 }
 
+/**
+ * @brief Применить отсечку DC 1-го порядка (дешевый режим фильтра)
+ * Apply a 1st-order DC blocker (cheap filter mode)
+ */
+static void apply_dc_blocker(struct audio_processor* proc, float* audio, size_t length) {
+    float x1 = proc->dc_input;
+    float y1 = proc->dc_output;
+    
+    for (size_t i = 0; i < length; i++) {
+        float x = audio[i];
+        y1 = x - x1 + proc->dc_coeff * y1;
+        x1 = x;
+        audio[i] = y1;
+    }
+    
+    proc->dc_input = x1;
+    proc->dc_output = y1;
+}
+
+/**
+ * @brief Применить AGC с пересчетом усиления раз в блок
+ * Apply AGC with the gain recomputed once per block
+ *
+ * Огибающая следует за пиком блока; усиление плавно меняется внутри блока,
+ * чтобы не было ступеньки на границе.
+ * The envelope follows the block peak; the gain ramps across the block so
+ * there is no step at the boundary.
+ */
+static void apply_agc_block(struct audio_processor* proc, float* audio, size_t length) {
+    const float SAMPLE_RATE = (float)proc->config.sample_rate;
+    
+    float peak = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        peak = fmaxf(peak, fabsf(audio[i]));
+    }
+    
+    // Те же постоянные времени, что и посэмпловом AGC / Same time constants as the per-sample AGC
+    float time_constant = (peak > proc->agc_envelope) ? proc->agc_attack_time : proc->agc_release_time;
+    float alpha = expf(-(float)length / (time_constant * SAMPLE_RATE));
+    proc->agc_envelope = alpha * proc->agc_envelope + (1.0f - alpha) * peak;
+    
+    float gain = proc->agc_gain;
+    if (proc->agc_envelope > 0.001f) {
+        float target_gain = proc->config.target_rms / proc->agc_envelope;
+        float gain_alpha = 1.0f - powf(1.0f - 0.001f, (float)length);
+        gain = gain_alpha * target_gain + (1.0f - gain_alpha) * gain;
+        gain = fmaxf(0.1f, fminf(10.0f, gain));
+    }
+    
+    float step = (gain - proc->agc_gain) / (float)length;
+    float current = proc->agc_gain;
+    for (size_t i = 0; i < length; i++) {
+        current += step;
+        audio[i] *= current;
+    }
+    proc->agc_gain = gain;
+}
+
+/**
+ * @brief Применить замороженное усиление AGC
+ * Apply the frozen AGC gain
+ */
+static void apply_fixed_gain(struct audio_processor* proc, float* audio, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        audio[i] *= proc->agc_gain;
+    }
+}
+
+/**
+ * @brief Меняет ли уровень что-то при текущей конфигурации
+ * Whether a level changes anything in the current configuration
+ */
+static bool quality_applies(struct audio_processor* proc, audio_quality_t quality) {
+    switch (quality) {
+        case AUDIO_QUALITY_BLOCK_AGC:
+        case AUDIO_QUALITY_FIXED_GAIN:
+            return proc->config.enable_agc;
+        case AUDIO_QUALITY_DC_FILTER:
+            return proc->config.enable_noise_reduction;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief Перейти на уровень качества
+ * Switch to a quality level
+ */
+static void set_quality(struct audio_processor* proc, audio_quality_t quality) {
+    // Фильтр, в который переходим, начинает с чистого состояния / The filter being switched to starts clean
+    bool was_dc = proc->quality >= AUDIO_QUALITY_DC_FILTER;
+    bool is_dc = quality >= AUDIO_QUALITY_DC_FILTER;
+    if (is_dc && !was_dc) {
+        proc->dc_input = 0.0f;
+        proc->dc_output = 0.0f;
+    } else if (was_dc && !is_dc) {
+        memset(proc->hp_states, 0, proc->config.filter_order * sizeof(float));
+    }
+    
+    proc->quality = quality;
+    proc->budget.quality = quality;
+    if (quality > proc->budget.worst_quality) {
+        proc->budget.worst_quality = quality;
+    }
+}
+
+/**
+ * @brief Понизить качество на один применимый уровень
+ * Downgrade quality by one applicable level
+ */
+static void degrade_quality(struct audio_processor* proc, bool backlog) {
+    audio_quality_t next = proc->quality + 1;
+    while (next < AUDIO_QUALITY_COUNT && !quality_applies(proc, next)) {
+        next++;
+    }
+    if (next >= AUDIO_QUALITY_COUNT) {
+        return; // Дальше упрощать нечего / Nothing left to simplify
+    }
+    
+    // Повышение не удержалось - дольше ждать следующего / A restore did not hold - wait longer for the next one
+    if (proc->budget.restorations > 0 && proc->blocks_since_restore < proc->restore_after) {
+        proc->restore_after *= 2;
+        if (proc->restore_after > RESTORE_AFTER_BLOCKS * RESTORE_BACKOFF_MAX) {
+            proc->restore_after = RESTORE_AFTER_BLOCKS * RESTORE_BACKOFF_MAX;
+        }
+    } else {
+        proc->restore_after = RESTORE_AFTER_BLOCKS;
+    }
+    
+    set_quality(proc, next);
+    proc->budget.degradations++;
+    if (backlog) {
+        proc->budget.backlog_degradations++;
+    }
+    proc->quiet_streak = 0;
+    
+    ESP_LOGW(TAG, "Quality downgraded to %d (%s): %u/%u cycles, backlog %u",
+             (int)next, backlog ? "backlog" : "over budget", proc->budget.block_cycles,
+             proc->budget.budget_cycles, proc->backlog_blocks);
+}
+
+/**
+ * @brief Повысить качество на один применимый уровень
+ * Restore quality by one applicable level
+ */
+static void restore_quality(struct audio_processor* proc) {
+    audio_quality_t next = proc->quality;
+    do {
+        next--;
+    } while (next > AUDIO_QUALITY_FULL && !quality_applies(proc, next));
+    
+    set_quality(proc, next);
+    proc->budget.restorations++;
+    proc->blocks_since_restore = 0;
+    proc->quiet_streak = 0;
+    
+    ESP_LOGI(TAG, "Quality restored to %d", (int)next);
+}
+
+/**
+ * @brief Накопленное время выполнения текущей задачи
+ * Accumulated run time of the current task
+ *
+ * Счетчик задачи растет только при переключении контекста, поэтому его
+ * изменение за блок значит, что задачу вытесняли.
+ * A task's counter only grows on a context switch, so a change over a block
+ * means the task was preempted.
+ */
+static uint32_t task_run_time(void) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    return (uint32_t)ulTaskGetRunTimeCounter(xTaskGetCurrentTaskHandle());
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Учесть такты блока и при необходимости сменить уровень
+ * Account a block's cycles and change the level if needed
+ *
+ * Такты вытесненного блока включают чужие задачи и в решениях не участвуют.
+ * A preempted block's cycles include other tasks and take no part in decisions.
+ */
+static void update_budget(struct audio_processor* proc, size_t length, uint32_t cycles, bool preempted) {
+    uint64_t block_us = (uint64_t)length * 1000000ULL / proc->config.sample_rate;
+    uint32_t budget = (uint32_t)(block_us * esp_rom_get_cpu_ticks_per_us() * proc->config.cpu_budget_percent / 100);
+    
+    proc->budget.budget_cycles = budget;
+    proc->blocks_since_restore++;
+    
+    bool over = false;
+    if (preempted) {
+        proc->budget.preempted_blocks++;
+    } else {
+        proc->budget.block_cycles = cycles;
+        if (cycles > proc->budget.max_block_cycles) {
+            proc->budget.max_block_cycles = cycles;
+        }
+        over = cycles > budget;
+        if (over) {
+            proc->budget.over_budget_blocks++;
+        }
+    }
+    
+    // Отставание I2S - сразу: запас DMA меньше пары блоков / I2S backlog at once: DMA holds under two blocks
+    if (proc->backlog_blocks > 0) {
+        proc->budget.backlog_blocks++;
+        proc->over_budget_streak = 0;
+        proc->quiet_streak = 0;
+        degrade_quality(proc, true);
+        return;
+    }
+    
+    // Серии не прерываются и не растут / Streaks neither break nor grow
+    if (preempted) {
+        return;
+    }
+    
+    if (over) {
+        proc->quiet_streak = 0;
+        if (++proc->over_budget_streak >= DEGRADE_AFTER_BLOCKS) {
+            proc->over_budget_streak = 0;
+            degrade_quality(proc, false);
+        }
+        return;
+    }
+    
+    proc->over_budget_streak = 0;
+    if ((uint64_t)cycles * 100 < (uint64_t)budget * RESTORE_HEADROOM_PERCENT) {
+        if (++proc->quiet_streak >= proc->restore_after && proc->quality > AUDIO_QUALITY_FULL) {
+            restore_quality(proc);
+        }
+    } else {
+        proc->quiet_streak = 0;
+    }
+}
+
 /**
  * @brief Обновить статистику
  * Update statistics
@@ -179,6 +439,20 @@ esp_err_t audio_processor_init(audio_processor_handle_t* handle, const audio_pro
     if ((*handle)->agc_release_time == 0.0f) {
         (*handle)->agc_release_time = 0.1f;
     }
+    if ((*handle)->config.cpu_budget_percent <= 0) {
+        (*handle)->config.cpu_budget_percent = BUDGET_DEFAULT_PERCENT;
+    }
+    
+    // Постоянные времени не меняются - коэффициенты считаются один раз
+    // The time constants do not change - the coefficients are computed once
+    float sample_rate = (float)(*handle)->config.sample_rate;
+    (*handle)->agc_attack_alpha = expf(-1.0f / ((*handle)->agc_attack_time * sample_rate));
+    (*handle)->agc_release_alpha = expf(-1.0f / ((*handle)->agc_release_time * sample_rate));
+    (*handle)->dc_coeff = 1.0f - 2.0f * M_PI * (*handle)->config.high_pass_cutoff / sample_rate;
+    
+    // Бюджет тактов / Cycle budget
+    (*handle)->quality = AUDIO_QUALITY_FULL;
+    (*handle)->restore_after = RESTORE_AFTER_BLOCKS;
     
     // Выделение памяти для фильтра / Allocate filter memory
     (*handle)->hp_coeffs = malloc(((*handle)->config.filter_order + 1) * sizeof(float));
@@ -246,6 +520,8 @@ esp_err_t audio_processor_process(audio_processor_handle_t handle, const int16_t
     }
     
     size_t sample_count = input_size / sizeof(int16_t);
+    uint32_t block_start = esp_cpu_get_cycle_count();
+    uint32_t run_time_start = task_run_time();
     
     // Проверка размера буфера / Check buffer size
     if (sample_count > handle->buffer_size) {
@@ -264,13 +540,27 @@ esp_err_t audio_processor_process(audio_processor_handle_t handle, const int16_t
         handle->float_buffer[i] = (float)input_data[i] / 32768.0f;
     }
     
-    // Обработка / Processing
+    // Обработка на текущем уровне качества / Processing at the current quality level
     if (handle->config.enable_noise_reduction) {
-        apply_high_pass_filter(handle, handle->float_buffer, sample_count);
+        uint32_t stage_start = esp_cpu_get_cycle_count();
+        if (handle->quality >= AUDIO_QUALITY_DC_FILTER) {
+            apply_dc_blocker(handle, handle->float_buffer, sample_count);
+        } else {
+            apply_high_pass_filter(handle, handle->float_buffer, sample_count);
+        }
+        handle->budget.filter_cycles = esp_cpu_get_cycle_count() - stage_start;
     }
     
     if (handle->config.enable_agc) {
-        apply_agc(handle, handle->float_buffer, sample_count);
+        uint32_t stage_start = esp_cpu_get_cycle_count();
+        if (handle->quality >= AUDIO_QUALITY_FIXED_GAIN) {
+            apply_fixed_gain(handle, handle->float_buffer, sample_count);
+        } else if (handle->quality >= AUDIO_QUALITY_BLOCK_AGC) {
+            apply_agc_block(handle, handle->float_buffer, sample_count);
+        } else {
+            apply_agc(handle, handle->float_buffer, sample_count);
+        }
+        handle->budget.agc_cycles = esp_cpu_get_cycle_count() - stage_start;
     }
     
     // Конвертация обратно в int16_t / Convert back to int16_t
@@ -283,6 +573,11 @@ esp_err_t audio_processor_process(audio_processor_handle_t handle, const int16_t
     // Обновление статистики / Update statistics
     update_stats(handle, input_data, sample_count);
     
+    // Блок уже выведен целиком; бюджет влияет только на следующие
+    // The block is already fully output; the budget only affects the next ones
+    uint32_t block_cycles = esp_cpu_get_cycle_count() - block_start;
+    update_budget(handle, sample_count, block_cycles, task_run_time() != run_time_start);
+    
     return ESP_OK;
 }
 
@@ -304,4 +599,36 @@ esp_err_t audio_processor_reset_stats(audio_processor_handle_t handle) {
     handle->samples_processed = 0;
     
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+esp_err_t audio_processor_report_backlog(audio_processor_handle_t handle, uint32_t backlog_blocks) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->backlog_blocks = backlog_blocks;
+    return ESP_OK;
+}
+
+esp_err_t audio_processor_restart(audio_processor_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(handle->hp_states, 0, handle->config.filter_order * sizeof(float));
+    handle->dc_input = 0.0f;
+    handle->dc_output = 0.0f;
+    handle->backlog_blocks = 0;
+    handle->over_budget_streak = 0;
+    
+    return ESP_OK;
+}
+
+esp_err_t audio_processor_get_budget_stats(audio_processor_handle_t handle, audio_budget_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *stats = handle->budget;
+    return ESP_OK;
+}
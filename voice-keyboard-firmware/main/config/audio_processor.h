@@ -6,6 +6,20 @@
  * 
  * Заголовочный файл компонента обработки аудио
  * Header file for audio processing component
+ *
+ * Необязательные этапы (ВЧ фильтр шумоподавления, AGC) работают в бюджете
+ * тактов на блок. Если бюджет превышен или захват I2S отстает, этапы
+ * упрощаются по одному в порядке audio_quality_t и возвращаются, когда
+ * появляется запас. Блоки никогда не пропускаются: меняется только качество.
+ * Optional stages (the noise-reduction high-pass filter, AGC) run within a
+ * cycle budget per block. When the budget is exceeded or I2S capture falls
+ * behind, stages are simplified one at a time in audio_quality_t order and
+ * restored when headroom returns. Blocks are never skipped: only quality changes.
+ *
+ * Такты считаются по esp_cpu_get_cycle_count(); блок, во время которого задачу
+ * вытесняли (вырос ее счетчик времени выполнения FreeRTOS), не учитывается.
+ * Cycles come from esp_cpu_get_cycle_count(); a block during which the task
+ * was preempted (its FreeRTOS run-time counter grew) is not counted.
  */
 
 #ifndef AUDIO_PROCESSOR_H
@@ -23,8 +37,18 @@ typedef struct {
     float target_rms;            // Целевой RMS уровень / Target RMS level
     int filter_order;            // Порядок фильтра / Filter order
     float high_pass_cutoff;      // Частота среза ВЧ фильтра / High-pass cutoff
+    int cpu_budget_percent;      // Доля реального времени блока на этапы (0 - 25%) / Share of a block's real time for the stages (0 - 25%)
 } audio_processor_config_t;
 
+// Уровни качества, от полного к самому дешевому / Quality levels, from full to cheapest
+typedef enum {
+    AUDIO_QUALITY_FULL,          // Все этапы полностью / All stages in full
+    AUDIO_QUALITY_BLOCK_AGC,     // Усиление AGC пересчитывается раз в блок / AGC gain recomputed once per block
+    AUDIO_QUALITY_DC_FILTER,     // ВЧ фильтр заменен отсечкой DC 1-го порядка / High-pass replaced by a 1st-order DC blocker
+    AUDIO_QUALITY_FIXED_GAIN,    // AGC заморожен на последнем усилении / AGC frozen at its last gain
+    AUDIO_QUALITY_COUNT
+} audio_quality_t;
+
 // Дескриптор аудио процессора / Audio processor handle
 typedef struct audio_processor* audio_processor_handle_t;
 
@@ -59,6 +83,52 @@ typedef struct {
 
 esp_err_t audio_processor_get_stats(audio_processor_handle_t handle, audio_stats_t* stats);
 
+// Статистика бюджета тактов / Cycle budget statistics
+typedef struct {
+    audio_quality_t quality;       // Текущий уровень / Current level
+    audio_quality_t worst_quality; // Самый дешевый достигнутый уровень / Cheapest level reached
+    uint32_t degradations;         // Понижений качества / Quality downgrades
+    uint32_t backlog_degradations; // Из них из-за отставания I2S / Of those, due to I2S backlog
+    uint32_t restorations;         // Повышений качества / Quality restorations
+    uint32_t over_budget_blocks;   // Блоков сверх бюджета / Blocks over budget
+    uint32_t backlog_blocks;       // Блоков, уже ждавших в DMA / Blocks already waiting in DMA
+    uint32_t preempted_blocks;     // Отброшено замеров: задачу вытесняли / Samples discarded: the task was preempted
+    uint32_t budget_cycles;        // Бюджет последнего блока / Budget of the last block
+    uint32_t block_cycles;         // Такты последнего блока / Cycles of the last block
+    uint32_t filter_cycles;        // Из них ВЧ фильтр / Of those, the high-pass filter
+    uint32_t agc_cycles;           // Из них AGC / Of those, AGC
+    uint32_t max_block_cycles;     // Худший блок / Worst block
+} audio_budget_stats_t;
+
+/**
+ * @brief Сообщить об отставании захвата
+ * Report capture backlog
+ *
+ * Вызывается задачей захвата перед обработкой блока: сколько блоков подряд
+ * уже лежали в DMA к моменту чтения. Учитывается при обработке следующего блока.
+ * Called by the capture task before processing a block: how many blocks in a
+ * row were already waiting in DMA when read. Applied when the next block is processed.
+ */
+esp_err_t audio_processor_report_backlog(audio_processor_handle_t handle, uint32_t backlog_blocks);
+
+/**
+ * @brief Начать новый захват
+ * Start a new capture
+ *
+ * Сбрасывает состояние фильтров и отставание; уровень качества сохраняется.
+ * Resets filter state and backlog; the quality level is kept.
+ */
+esp_err_t audio_processor_restart(audio_processor_handle_t handle);
+
+/**
+ * @brief Получить статистику бюджета тактов
+ * Get cycle budget statistics
+ *
+ * Снимок без блокировки, поля могут относиться к соседним блокам.
+ * A snapshot without locking; fields may come from adjacent blocks.
+ */
+esp_err_t audio_processor_get_budget_stats(audio_processor_handle_t handle, audio_budget_stats_t* stats);
+
 /**
  * @brief Сбросить статистику
  * Reset statistics
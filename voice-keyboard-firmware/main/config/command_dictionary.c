@@ -0,0 +1,387 @@
+/**
+ * @file command_dictionary.c
+ * @brief Flash-resident command dictionary implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация словаря команд во flash
+ * Implementation of the flash-resident command dictionary
+ */
+
+#include "command_dictionary.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "voice_commands.h"
+
+static const char* TAG = "CMD_DICT";
+
+// Число слотов / Slot count
+#define DICTIONARY_SLOTS        2
+// Размер сектора flash / Flash sector size
+#define DICTIONARY_SECTOR_SIZE  4096
+
+// Внутренняя структура словаря / Internal dictionary structure
+struct command_dictionary {
+    const esp_partition_t* partition;
+    uint32_t slot_size;
+
+    // Читатели держат lock на время поиска / Readers hold lock while matching
+    SemaphoreHandle_t lock;
+
+    // Отображения слотов / Slot mappings
+    const uint8_t* slot_data[DICTIONARY_SLOTS];
+    esp_partition_mmap_handle_t slot_map[DICTIONARY_SLOTS];
+    bool slot_mapped[DICTIONARY_SLOTS];
+
+    // Активный словарь / Active dictionary
+    int active;
+    command_dictionary_t view;
+
+    command_dictionary_info_t info;
+};
+
+/**
+ * @brief Проверить границы секции
+ * Check section bounds
+ */
+static bool section_ok(const command_dictionary_header_t* header, uint32_t offset, uint32_t size) {
+    return offset % 4 == 0 && offset >= header->header_size &&
+           offset <= header->total_size && size <= header->total_size - offset;
+}
+
+/**
+ * @brief Проверить образ словаря
+ * Verify a dictionary image
+ *
+ * Проверяются CRC и все индексы, чтобы поиск мог им доверять без проверок.
+ * CRC and every index are checked so matching can trust them without checks.
+ */
+static esp_err_t verify_image(const uint8_t* data, size_t capacity) {
+    const command_dictionary_header_t* h = (const command_dictionary_header_t*)data;
+
+    if (capacity < sizeof(*h) || h->magic != COMMAND_DICTIONARY_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (h->version != COMMAND_DICTIONARY_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (h->header_size != sizeof(*h) || h->total_size < h->header_size || h->total_size > capacity) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (esp_rom_crc32_le(0, data + h->header_size, h->total_size - h->header_size) != h->crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Секции / Sections
+    if (h->state_count == 0 || h->pattern_count == 0 || h->symbol_count == 0 || h->symbol_count > 256 ||
+        !section_ok(h, h->ascii_symbols_offset, 128) ||
+        !section_ok(h, h->cyrillic_symbols_offset, 32) ||
+        !section_ok(h, h->states_offset, h->state_count * sizeof(command_automaton_state_t)) ||
+        !section_ok(h, h->edges_offset, h->edge_count * sizeof(command_automaton_edge_t)) ||
+        !section_ok(h, h->pattern_chars_offset, h->pattern_count) ||
+        !section_ok(h, h->fuzzy_entries_offset, h->fuzzy_entry_count * sizeof(command_fuzzy_entry_t)) ||
+        !section_ok(h, h->fuzzy_symbol_first_offset, (h->symbol_count + 1) * sizeof(uint16_t)) ||
+        !section_ok(h, h->fuzzy_pattern_chars_offset, h->pattern_count) ||
+        !section_ok(h, h->entries_offset, h->pattern_count * sizeof(command_dictionary_entry_t)) ||
+        !section_ok(h, h->strings_offset, h->strings_size) ||
+        h->strings_size == 0 || data[h->strings_offset + h->strings_size - 1] != '\0') {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Индексы / Indices
+    for (int i = 0; i < 128 + 32; i++) {
+        uint8_t symbol = i < 128 ? data[h->ascii_symbols_offset + i] : data[h->cyrillic_symbols_offset + i - 128];
+        if (symbol >= h->symbol_count) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const command_automaton_state_t* states = (const command_automaton_state_t*)(data + h->states_offset);
+    for (uint16_t i = 0; i < h->state_count; i++) {
+        if (states[i].first_edge + states[i].edge_count > h->edge_count || states[i].fail >= h->state_count ||
+            states[i].output >= (int16_t)h->pattern_count) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const command_automaton_edge_t* edges = (const command_automaton_edge_t*)(data + h->edges_offset);
+    for (uint16_t i = 0; i < h->edge_count; i++) {
+        if (edges[i].target >= h->state_count) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    for (uint16_t i = 0; i < h->pattern_count; i++) {
+        if (data[h->pattern_chars_offset + i] > COMMAND_MATCHER_MAX_PATTERN_CHARS ||
+            data[h->fuzzy_pattern_chars_offset + i] > COMMAND_MATCHER_FUZZY_MAX_CHARS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const command_fuzzy_entry_t* fuzzy = (const command_fuzzy_entry_t*)(data + h->fuzzy_entries_offset);
+    for (uint16_t i = 0; i < h->fuzzy_entry_count; i++) {
+        if (fuzzy[i].pattern >= h->pattern_count) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const uint16_t* first = (const uint16_t*)(data + h->fuzzy_symbol_first_offset);
+    for (uint16_t i = 0; i < h->symbol_count; i++) {
+        if (first[i] > first[i + 1]) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (first[0] != 0 || first[h->symbol_count] != h->fuzzy_entry_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const command_dictionary_entry_t* entries = (const command_dictionary_entry_t*)(data + h->entries_offset);
+    for (uint16_t i = 0; i < h->pattern_count; i++) {
+        if (entries[i].pattern_offset >= h->strings_size || entries[i].command_offset >= h->strings_size ||
+            entries[i].type > CMD_TYPE_MEDIA || entries[i].action > CMD_ACTION_SYSTEM_WAKE ||
+            entries[i].binding >= HID_BINDING_COUNT) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Построить представление поверх отображенного образа
+ * Build a view over a mapped image
+ */
+static void build_view(const uint8_t* data, command_dictionary_t* view) {
+    const command_dictionary_header_t* h = (const command_dictionary_header_t*)data;
+
+    view->automaton.ascii_symbols = data + h->ascii_symbols_offset;
+    view->automaton.cyrillic_symbols = data + h->cyrillic_symbols_offset;
+    view->automaton.states = (const command_automaton_state_t*)(data + h->states_offset);
+    view->automaton.edges = (const command_automaton_edge_t*)(data + h->edges_offset);
+    view->automaton.pattern_chars = data + h->pattern_chars_offset;
+    view->automaton.state_count = h->state_count;
+    view->automaton.pattern_count = h->pattern_count;
+    view->automaton.fuzzy_entries = (const command_fuzzy_entry_t*)(data + h->fuzzy_entries_offset);
+    view->automaton.fuzzy_symbol_first = (const uint16_t*)(data + h->fuzzy_symbol_first_offset);
+    view->automaton.fuzzy_pattern_chars = data + h->fuzzy_pattern_chars_offset;
+    view->automaton.symbol_count = h->symbol_count;
+    view->entries = (const command_dictionary_entry_t*)(data + h->entries_offset);
+    view->strings = (const char*)(data + h->strings_offset);
+    view->generation = h->generation;
+}
+
+/**
+ * @brief Отобразить слот в адресное пространство
+ * Map a slot into the address space
+ */
+static esp_err_t map_slot(struct command_dictionary* dict, int slot) {
+    if (dict->slot_mapped[slot]) {
+        esp_partition_munmap(dict->slot_map[slot]);
+        dict->slot_mapped[slot] = false;
+    }
+
+    const void* ptr = NULL;
+    esp_err_t ret = esp_partition_mmap(dict->partition, slot * dict->slot_size, dict->slot_size,
+                                       ESP_PARTITION_MMAP_DATA, &ptr, &dict->slot_map[slot]);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map slot %d: %s", slot, esp_err_to_name(ret));
+        return ret;
+    }
+
+    dict->slot_data[slot] = ptr;
+    dict->slot_mapped[slot] = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief Сделать слот активным (под блокировкой)
+ * Make a slot active (lock held)
+ */
+static void activate_slot(struct command_dictionary* dict, int slot) {
+    const command_dictionary_header_t* h = (const command_dictionary_header_t*)dict->slot_data[slot];
+
+    dict->active = slot;
+    build_view(dict->slot_data[slot], &dict->view);
+    dict->info.active_slot = slot;
+    dict->info.generation = h->generation;
+    dict->info.pattern_count = h->pattern_count;
+    dict->info.image_size = h->total_size;
+}
+
+esp_err_t command_dictionary_init(command_dictionary_handle_t* handle, const char* partition_label) {
+    if (!handle || !partition_label) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (!partition) {
+        ESP_LOGE(TAG, "Partition '%s' not found", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (partition->size % (DICTIONARY_SLOTS * DICTIONARY_SECTOR_SIZE) != 0) {
+        ESP_LOGE(TAG, "Partition '%s' size is not a multiple of %d sectors", partition_label, DICTIONARY_SLOTS);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = malloc(sizeof(struct command_dictionary));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for command dictionary");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Инициализация структуры / Initialize structure
+    memset(*handle, 0, sizeof(struct command_dictionary));
+    (*handle)->partition = partition;
+    (*handle)->slot_size = partition->size / DICTIONARY_SLOTS;
+    (*handle)->active = -1;
+    (*handle)->info.active_slot = -1;
+    (*handle)->info.slot_size = (*handle)->slot_size;
+
+    (*handle)->lock = xSemaphoreCreateMutex();
+    if (!(*handle)->lock) {
+        ESP_LOGE(TAG, "Failed to create dictionary mutex");
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Выбор корректного слота с наибольшим поколением / Pick the valid slot with the highest generation
+    uint32_t best_generation = 0;
+    for (int slot = 0; slot < DICTIONARY_SLOTS; slot++) {
+        if (map_slot(*handle, slot) != ESP_OK) {
+            continue;
+        }
+        esp_err_t ret = verify_image((*handle)->slot_data[slot], (*handle)->slot_size);
+        if (ret != ESP_OK) {
+            if (ret != ESP_ERR_NOT_FOUND) {
+                ESP_LOGW(TAG, "Slot %d rejected: %s", slot, esp_err_to_name(ret));
+            }
+            continue;
+        }
+        const command_dictionary_header_t* h = (const command_dictionary_header_t*)(*handle)->slot_data[slot];
+        if ((*handle)->active < 0 || h->generation > best_generation) {
+            best_generation = h->generation;
+            activate_slot(*handle, slot);
+        }
+    }
+
+    if ((*handle)->active >= 0) {
+        ESP_LOGI(TAG, "Command dictionary generation %u: %u patterns, %u bytes (slot %d)",
+                 (*handle)->info.generation, (*handle)->info.pattern_count,
+                 (*handle)->info.image_size, (*handle)->active);
+    } else {
+        ESP_LOGI(TAG, "No command dictionary in '%s', using built-in commands", partition_label);
+    }
+    return ESP_OK;
+}
+
+esp_err_t command_dictionary_deinit(command_dictionary_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int slot = 0; slot < DICTIONARY_SLOTS; slot++) {
+        if (handle->slot_mapped[slot]) {
+            esp_partition_munmap(handle->slot_map[slot]);
+        }
+    }
+    vSemaphoreDelete(handle->lock);
+    free(handle);
+    ESP_LOGI(TAG, "Command dictionary deinitialized");
+
+    return ESP_OK;
+}
+
+esp_err_t command_dictionary_install(command_dictionary_handle_t handle, const void* image, size_t size) {
+    if (!handle || !image || size < sizeof(command_dictionary_header_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = verify_image(image, size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Dictionary image rejected: %s", esp_err_to_name(ret));
+        handle->info.rejected++;
+        return ret;
+    }
+
+    const command_dictionary_header_t* source = (const command_dictionary_header_t*)image;
+    if (source->total_size > handle->slot_size) {
+        ESP_LOGE(TAG, "Dictionary image too large: %u > %u", source->total_size, handle->slot_size);
+        handle->info.rejected++;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Неактивный слот никто не читает / Nobody reads the inactive slot
+    int target = handle->active == 0 ? 1 : 0;
+    uint32_t offset = target * handle->slot_size;
+    uint32_t erase_size = (source->total_size + DICTIONARY_SECTOR_SIZE - 1) / DICTIONARY_SECTOR_SIZE *
+                          DICTIONARY_SECTOR_SIZE;
+
+    command_dictionary_header_t header = *source;
+    header.generation = handle->info.generation + 1;
+
+    ret = esp_partition_erase_range(handle->partition, offset, erase_size);
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(handle->partition, offset + sizeof(header),
+                                  (const uint8_t*)image + sizeof(header), source->total_size - sizeof(header));
+    }
+    // Заголовок пишется последним: прерванная запись не даст корректного слота
+    // The header goes last: an interrupted write never yields a valid slot
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(handle->partition, offset, &header, sizeof(header));
+    }
+    if (ret == ESP_OK) {
+        ret = map_slot(handle, target);
+    }
+    if (ret == ESP_OK) {
+        ret = verify_image(handle->slot_data[target], handle->slot_size);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write dictionary to slot %d: %s", target, esp_err_to_name(ret));
+        handle->info.rejected++;
+        return ret;
+    }
+
+    // Подмена ждет завершения текущего поиска / The swap waits for an in-progress match
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    activate_slot(handle, target);
+    handle->info.installs++;
+    xSemaphoreGive(handle->lock);
+
+    ESP_LOGI(TAG, "Command dictionary generation %u installed: %u patterns (slot %d)",
+             header.generation, header.pattern_count, target);
+    return ESP_OK;
+}
+
+const command_dictionary_t* command_dictionary_acquire(command_dictionary_handle_t handle) {
+    if (!handle) {
+        return NULL;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    return handle->active >= 0 ? &handle->view : NULL;
+}
+
+void command_dictionary_release(command_dictionary_handle_t handle) {
+    if (handle) {
+        xSemaphoreGive(handle->lock);
+    }
+}
+
+esp_err_t command_dictionary_get_info(command_dictionary_handle_t handle, command_dictionary_info_t* info) {
+    if (!handle || !info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *info = handle->info;
+    xSemaphoreGive(handle->lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file command_dictionary.h
+ * @brief Flash-resident command dictionary header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл словаря команд во flash
+ * Header file for the flash-resident command dictionary
+ *
+ * Словарь - двоичный образ (tools/command_dict.py) с готовым автоматом,
+ * шаблонами, действиями и параметрами. Раздел "commands" делится на два слота;
+ * активен корректный слот с наибольшим поколением. Образ отображается в память
+ * без разбора и копирования, новый пишется в неактивный слот и подменяется атомарно.
+ * The dictionary is a binary image (tools/command_dict.py) holding a prebuilt
+ * automaton, patterns, actions and parameters. The "commands" partition is split
+ * into two slots; the valid slot with the highest generation is active. The image
+ * is memory-mapped without parsing or copying; a new one is written to the
+ * inactive slot and swapped in atomically.
+ */
+
+#ifndef COMMAND_DICTIONARY_H
+#define COMMAND_DICTIONARY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "command_matcher.h"
+
+// Сигнатура образа / Image signature
+#define COMMAND_DICTIONARY_MAGIC    0x44434B56  // "VKCD"
+// Версия формата / Format version
+#define COMMAND_DICTIONARY_VERSION  2
+
+// Заголовок образа (little-endian, секции выровнены на 4 байта)
+// Image header (little-endian, sections aligned to 4 bytes)
+typedef struct {
+    uint32_t magic;                       // COMMAND_DICTIONARY_MAGIC
+    uint16_t version;                     // COMMAND_DICTIONARY_VERSION
+    uint16_t header_size;                 // sizeof(command_dictionary_header_t)
+    uint32_t total_size;                  // Размер образа с заголовком / Image size including header
+    uint32_t crc32;                       // CRC32 байт [header_size, total_size) / CRC32 of bytes [header_size, total_size)
+    uint32_t generation;                  // Поколение (назначается при установке) / Generation (assigned on install)
+    uint16_t pattern_count;
+    uint16_t state_count;
+    uint16_t edge_count;
+    uint16_t symbol_count;
+    uint16_t fuzzy_entry_count;
+    uint16_t reserved;
+    uint32_t strings_size;
+    uint32_t ascii_symbols_offset;        // uint8_t[128]
+    uint32_t cyrillic_symbols_offset;     // uint8_t[32]
+    uint32_t states_offset;               // command_automaton_state_t[state_count]
+    uint32_t edges_offset;                // command_automaton_edge_t[edge_count]
+    uint32_t pattern_chars_offset;        // uint8_t[pattern_count]
+    uint32_t fuzzy_entries_offset;        // command_fuzzy_entry_t[fuzzy_entry_count]
+    uint32_t fuzzy_symbol_first_offset;   // uint16_t[symbol_count + 1]
+    uint32_t fuzzy_pattern_chars_offset;  // uint8_t[pattern_count]
+    uint32_t entries_offset;              // command_dictionary_entry_t[pattern_count]
+    uint32_t strings_offset;              // char[strings_size], строки с нулем / NUL-terminated strings
+} command_dictionary_header_t;
+
+// Запись словаря / Dictionary entry
+typedef struct {
+    uint32_t pattern_offset;   // Шаблон в таблице строк / Pattern in the string table
+    uint32_t command_offset;   // Параметр команды в таблице строк / Command parameter in the string table
+    uint8_t type;              // command_type_t
+    uint8_t action;            // command_action_t
+    uint16_t binding;          // hid_binding_id_t
+} command_dictionary_entry_t;
+
+// Отображенный словарь / Mapped dictionary
+typedef struct {
+    command_automaton_t automaton;              // Указывает в отображенный flash / Points into mapped flash
+    const command_dictionary_entry_t* entries;  // Записи по индексу шаблона / Entries by pattern index
+    const char* strings;                        // Таблица строк / String table
+    uint32_t generation;                        // Поколение / Generation
+} command_dictionary_t;
+
+// Дескриптор словаря / Dictionary handle
+typedef struct command_dictionary* command_dictionary_handle_t;
+
+/**
+ * @brief Инициализация словаря
+ * Initialize dictionary
+ *
+ * Без корректного образа словарь пуст, и acquire возвращает NULL.
+ * Without a valid image the dictionary is empty and acquire returns NULL.
+ */
+esp_err_t command_dictionary_init(command_dictionary_handle_t* handle, const char* partition_label);
+
+/**
+ * @brief Деинициализация словаря
+ * Deinitialize dictionary
+ */
+esp_err_t command_dictionary_deinit(command_dictionary_handle_t handle);
+
+/**
+ * @brief Установить новый образ (горячая замена)
+ * Install a new image (hot swap)
+ *
+ * Образ проверяется, пишется в неактивный слот с поколением на 1 больше
+ * и становится активным. Читатели видят либо старый, либо новый словарь.
+ * The image is verified, written to the inactive slot with the next generation
+ * and made active. Readers see either the old or the new dictionary.
+ *
+ * @param image Образ, выровненный на 4 байта / Image aligned to 4 bytes
+ */
+esp_err_t command_dictionary_install(command_dictionary_handle_t handle, const void* image, size_t size);
+
+/**
+ * @brief Захватить активный словарь для чтения
+ * Acquire the active dictionary for reading
+ *
+ * Каждый вызов парный с command_dictionary_release, даже при NULL.
+ * Every call pairs with command_dictionary_release, even on NULL.
+ *
+ * @return Словарь или NULL если образа нет / Dictionary or NULL if there is no image
+ */
+const command_dictionary_t* command_dictionary_acquire(command_dictionary_handle_t handle);
+
+/**
+ * @brief Освободить словарь
+ * Release the dictionary
+ */
+void command_dictionary_release(command_dictionary_handle_t handle);
+
+/**
+ * @brief Строка из таблицы строк
+ * String from the string table
+ */
+static inline const char* command_dictionary_string(const command_dictionary_t* dictionary, uint32_t offset) {
+    return dictionary->strings + offset;
+}
+
+/**
+ * @brief Получить информацию о словаре
+ * Get dictionary information
+ */
+typedef struct {
+    uint32_t generation;       // Активное поколение (0 - нет) / Active generation (0 - none)
+    uint32_t pattern_count;    // Шаблонов / Patterns
+    uint32_t image_size;       // Размер активного образа / Active image size
+    uint32_t slot_size;        // Размер слота / Slot size
+    int active_slot;           // Активный слот (-1 нет) / Active slot (-1 none)
+    uint32_t installs;         // Установлено образов / Images installed
+    uint32_t rejected;         // Отклонено образов / Images rejected
+} command_dictionary_info_t;
+
+esp_err_t command_dictionary_get_info(command_dictionary_handle_t handle, command_dictionary_info_t* info);
+
+#endif // COMMAND_DICTIONARY_H
@@ -0,0 +1,577 @@
+/**
+ * @file command_matcher.c
+ * @brief Voice command matcher implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация поиска команд автоматом Ахо-Корасик
+ * Implementation of Aho-Corasick command matching
+ */
+
+#include "command_matcher.h"
+
+// Код замены для некорректного UTF-8 / Replacement code for invalid UTF-8
+#define REPLACEMENT_CHARACTER   0xFFFD
+
+uint32_t command_matcher_fold(uint32_t code_point) {
+    if (code_point >= 'A' && code_point <= 'Z') {
+        return code_point + 0x20;
+    }
+    if (code_point >= 0x410 && code_point <= 0x42F) {
+        return code_point + 0x20;  // А-Я -> а-я
+    }
+    if (code_point == 0x401 || code_point == 0x451) {
+        return 0x435;  // Ё, ё -> е
+    }
+    return code_point;
+}
+
+uint32_t command_matcher_phonetic(uint32_t code_point) {
+    code_point = command_matcher_fold(code_point);
+
+    switch (code_point) {
+        case 0x43E:  // о
+        case 0x44F:  // я
+            return 0x430;  // а
+        case 0x435:  // е
+        case 0x44D:  // э
+        case 0x44B:  // ы
+        case 0x439:  // й
+            return 0x438;  // и
+        case 0x44E:  // ю
+            return 0x443;  // у
+        case 0x431:  // б
+            return 0x43F;  // п
+        case 0x432:  // в
+            return 0x444;  // ф
+        case 0x433:  // г
+            return 0x43A;  // к
+        case 0x434:  // д
+            return 0x442;  // т
+        case 0x436:  // ж
+        case 0x449:  // щ
+            return 0x448;  // ш
+        case 0x437:  // з
+        case 0x446:  // ц
+            return 0x441;  // с
+        case 0x44A:  // ъ
+        case 0x44C:  // ь
+            return 0;
+        default:
+            return code_point;
+    }
+}
+
+size_t command_matcher_decode_utf8(const char* text, size_t length, uint32_t* code_point) {
+    const uint8_t* s = (const uint8_t*)text;
+    size_t size;
+    uint32_t cp;
+
+    if (s[0] < 0x80) {
+        *code_point = s[0];
+        return 1;
+    } else if ((s[0] & 0xE0) == 0xC0) {
+        size = 2;
+        cp = s[0] & 0x1F;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        size = 3;
+        cp = s[0] & 0x0F;
+    } else if ((s[0] & 0xF8) == 0xF0) {
+        size = 4;
+        cp = s[0] & 0x07;
+    } else {
+        *code_point = REPLACEMENT_CHARACTER;
+        return 1;
+    }
+
+    if (size > length) {
+        *code_point = REPLACEMENT_CHARACTER;
+        return 1;
+    }
+    for (size_t i = 1; i < size; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *code_point = REPLACEMENT_CHARACTER;
+            return 1;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+
+    *code_point = cp;
+    return size;
+}
+
+/**
+ * @brief Символ алфавита автомата (0 - нет в словаре)
+ * Automaton alphabet symbol (0 - not in the dictionary)
+ */
+static uint8_t symbol_of(const command_automaton_t* automaton, uint32_t code_point) {
+    if (code_point < 0x80) {
+        return automaton->ascii_symbols[code_point];
+    }
+    if (code_point >= 0x430 && code_point <= 0x44F) {
+        return automaton->cyrillic_symbols[code_point - 0x430];
+    }
+    return 0;
+}
+
+/**
+ * @brief Переход по символу без суффиксных ссылок
+ * Transition by symbol without failure links
+ *
+ * @return Целевое состояние или 0 если перехода нет / Target state or 0 if there's no edge
+ */
+static uint16_t goto_state(const command_automaton_t* automaton, uint16_t state, uint8_t symbol) {
+    const command_automaton_state_t* s = &automaton->states[state];
+    const command_automaton_edge_t* edges = &automaton->edges[s->first_edge];
+
+    // Переходов мало, линейный поиск быстрее двоичного / Few edges, a linear scan beats binary search
+    for (int i = 0; i < s->edge_count && edges[i].symbol <= symbol; i++) {
+        if (edges[i].symbol == symbol) {
+            return edges[i].target;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Шаг автомата с суффиксными ссылками
+ * Automaton step following failure links
+ */
+static uint16_t step_state(const command_automaton_t* automaton, uint16_t state, uint8_t symbol) {
+    for (;;) {
+        uint16_t next = goto_state(automaton, state, symbol);
+        if (next != 0 || state == 0) {
+            return next;
+        }
+        state = automaton->states[state].fail;
+    }
+}
+
+/**
+ * @brief Является ли кодовая точка буквой или цифрой
+ * Whether a code point is a letter or a digit
+ *
+ * Вне ASCII буквами считается все, кроме знаков Latin-1, общей пунктуации и U+FFFD.
+ * Outside ASCII everything but Latin-1 signs, general punctuation and U+FFFD counts as a letter.
+ */
+static bool is_word_char(uint32_t code_point) {
+    if (code_point < 0x80) {
+        return (code_point >= '0' && code_point <= '9') ||
+               (code_point >= 'a' && code_point <= 'z') || (code_point >= 'A' && code_point <= 'Z');
+    }
+    return code_point >= 0xC0 && code_point != 0xD7 && code_point != 0xF7 &&
+           !(code_point >= 0x2000 && code_point <= 0x206F) && code_point != REPLACEMENT_CHARACTER;
+}
+
+/**
+ * @brief Граница слова перед смещением
+ * Word boundary before an offset
+ */
+static bool boundary_before(const char* text, size_t offset) {
+    if (offset == 0) {
+        return true;
+    }
+
+    // Назад через байты продолжения UTF-8 / Back over UTF-8 continuation bytes
+    size_t start = offset - 1;
+    while (start > 0 && offset - start < 4 && ((uint8_t)text[start] & 0xC0) == 0x80) {
+        start--;
+    }
+    uint32_t code_point;
+    command_matcher_decode_utf8(text + start, offset - start, &code_point);
+    return !is_word_char(code_point);
+}
+
+/**
+ * @brief Граница слова после смещения
+ * Word boundary after an offset
+ */
+static bool boundary_after(const char* text, size_t offset, size_t length) {
+    if (offset >= length || text[offset] == '\0') {
+        return true;
+    }
+
+    uint32_t code_point;
+    command_matcher_decode_utf8(text + offset, length - offset, &code_point);
+    return !is_word_char(code_point);
+}
+
+/**
+ * @brief Самый длинный шаблон, оканчивающийся в pos на границе слова
+ * Longest pattern ending at pos on word boundaries
+ *
+ * Если самый длинный шаблон состояния начинается внутри слова, проверяются
+ * более короткие по суффиксным ссылкам ("this" не дает "hi").
+ * If the state's longest pattern starts inside a word, shorter ones are tried
+ * along the failure links ("this" does not yield "hi").
+ *
+ * @return Индекс шаблона или -1 / Pattern index or -1
+ */
+static int bounded_output(const command_automaton_t* automaton, uint16_t state, const char* text, size_t length,
+                          size_t pos, const size_t* offsets, size_t chars, size_t* start) {
+    if (automaton->states[state].output < 0 || !boundary_after(text, pos, length)) {
+        return -1;
+    }
+
+    int16_t tried = -1;
+    for (; state != 0; state = automaton->states[state].fail) {
+        int16_t output = automaton->states[state].output;
+        if (output < 0) {
+            break;
+        }
+        if (output == tried) {
+            continue;
+        }
+        tried = output;
+        *start = offsets[(chars - automaton->pattern_chars[output]) % COMMAND_MATCHER_MAX_PATTERN_CHARS];
+        if (boundary_before(text, *start)) {
+            return output;
+        }
+    }
+
+    return -1;
+}
+
+bool command_matcher_find_longest(const command_automaton_t* automaton, const char* text, size_t length,
+                                  command_match_t* match) {
+    if (!automaton || !text || !match) {
+        return false;
+    }
+
+    // Смещения последних символов для определения начала совпадения
+    // Offsets of recent characters to locate the start of a match
+    size_t offsets[COMMAND_MATCHER_MAX_PATTERN_CHARS];
+    size_t chars = 0;
+    size_t best_chars = 0;
+    uint16_t state = 0;
+    size_t pos = 0;
+
+    match->pattern = -1;
+    match->errors = 0;
+
+    while (pos < length && text[pos] != '\0') {
+        uint32_t code_point;
+        size_t size = command_matcher_decode_utf8(text + pos, length - pos, &code_point);
+        offsets[chars % COMMAND_MATCHER_MAX_PATTERN_CHARS] = pos;
+        chars++;
+        pos += size;
+
+        uint8_t symbol = symbol_of(automaton, command_matcher_fold(code_point));
+        state = symbol ? step_state(automaton, state, symbol) : 0;
+
+        size_t start;
+        int output = bounded_output(automaton, state, text, length, pos, offsets, chars, &start);
+        if (output >= 0 && automaton->pattern_chars[output] > best_chars) {
+            best_chars = automaton->pattern_chars[output];
+            match->pattern = output;
+            match->start = start;
+            match->length = pos - match->start;
+        }
+    }
+
+    return match->pattern >= 0;
+}
+
+size_t command_matcher_find_all(const command_automaton_t* automaton, const char* text, size_t length,
+                                command_match_t* matches, size_t max_matches) {
+    if (!automaton || !text || !matches) {
+        return 0;
+    }
+
+    // Кандидаты: самый длинный шаблон на границах слова на каждой позиции конца
+    // Candidates: the longest word-bounded pattern at each end position
+    command_match_t candidates[COMMAND_MATCHER_MAX_CANDIDATES];
+    size_t candidate_count = 0;
+    size_t offsets[COMMAND_MATCHER_MAX_PATTERN_CHARS];
+    size_t chars = 0;
+    uint16_t state = 0;
+    size_t pos = 0;
+
+    while (pos < length && text[pos] != '\0' && candidate_count < COMMAND_MATCHER_MAX_CANDIDATES) {
+        uint32_t code_point;
+        size_t size = command_matcher_decode_utf8(text + pos, length - pos, &code_point);
+        offsets[chars % COMMAND_MATCHER_MAX_PATTERN_CHARS] = pos;
+        chars++;
+        pos += size;
+
+        uint8_t symbol = symbol_of(automaton, command_matcher_fold(code_point));
+        state = symbol ? step_state(automaton, state, symbol) : 0;
+
+        size_t start;
+        int output = bounded_output(automaton, state, text, length, pos, offsets, chars, &start);
+        if (output >= 0) {
+            command_match_t* candidate = &candidates[candidate_count++];
+            candidate->pattern = output;
+            candidate->start = start;
+            candidate->length = pos - candidate->start;
+            candidate->errors = 0;
+        }
+    }
+
+    // Выбор слева направо без пересечений / Left-to-right selection without overlaps
+    size_t count = 0;
+    size_t covered = 0;
+    while (count < max_matches) {
+        const command_match_t* next = NULL;
+        for (size_t i = 0; i < candidate_count; i++) {
+            const command_match_t* c = &candidates[i];
+            if (c->start >= covered &&
+                (!next || c->start < next->start || (c->start == next->start && c->length > next->length))) {
+                next = c;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        matches[count++] = *next;
+        covered = next->start + next->length;
+    }
+
+    return count;
+}
+
+bool command_matcher_can_extend(const command_automaton_t* automaton, const char* text, size_t length) {
+    if (!automaton || !text) {
+        return false;
+    }
+
+    uint16_t state = 0;
+    size_t pos = 0;
+
+    while (pos < length && text[pos] != '\0') {
+        uint32_t code_point;
+        pos += command_matcher_decode_utf8(text + pos, length - pos, &code_point);
+
+        uint8_t symbol = symbol_of(automaton, command_matcher_fold(code_point));
+        state = symbol ? goto_state(automaton, state, symbol) : 0;
+        if (state == 0) {
+            return false;
+        }
+    }
+
+    return automaton->states[state].edge_count > 0;
+}
+
+/**
+ * @brief Выставить маски Eq для символа
+ * Set Eq masks for a symbol
+ */
+static void set_fuzzy_eq(const command_automaton_t* automaton, command_fuzzy_state_t* workspace,
+                         uint8_t symbol, bool clear) {
+    if (symbol == 0 || symbol >= automaton->symbol_count) {
+        return;
+    }
+
+    for (uint16_t i = automaton->fuzzy_symbol_first[symbol]; i < automaton->fuzzy_symbol_first[symbol + 1]; i++) {
+        const command_fuzzy_entry_t* entry = &automaton->fuzzy_entries[i];
+        workspace[entry->pattern].eq = clear ? 0 : entry->mask;
+    }
+}
+
+/**
+ * @brief Следующая фонетическая кодовая точка в [*pos, end)
+ * Next phonetic code point in [*pos, end)
+ *
+ * Отброшенные буквы и удвоения пропускаются. / Dropped letters and doubles are skipped.
+ *
+ * @param previous Предыдущая кодовая точка (0 в начале) / Previous code point (0 at the start)
+ * @param start Смещение найденной кодовой точки / Offset of the code point found
+ * @return Кодовая точка или 0 в конце / Code point or 0 at the end
+ */
+static uint32_t next_phonetic(const char* text, size_t* pos, size_t end, uint32_t* previous, size_t* start) {
+    while (*pos < end && text[*pos] != '\0') {
+        uint32_t code_point;
+        *start = *pos;
+        *pos += command_matcher_decode_utf8(text + *pos, end - *pos, &code_point);
+
+        code_point = command_matcher_phonetic(code_point);
+        if (code_point != 0 && code_point != *previous) {
+            *previous = code_point;
+            return code_point;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Шаг Майерса для одного шаблона
+ * Myers step for one pattern
+ *
+ * @param carry 1 - начало совпадения закреплено, 0 - свободно / 1 - the match start is anchored, 0 - free
+ */
+static void myers_step(command_fuzzy_state_t* w, uint8_t m, uint32_t carry) {
+    uint32_t high = 1u << (m - 1);
+    uint32_t xv = w->eq | w->mv;
+    uint32_t xh = (((w->eq & w->pv) + w->pv) ^ w->pv) | w->eq;
+    uint32_t ph = w->mv | ~(xh | w->pv);
+    uint32_t mh = w->pv & xh;
+
+    if (ph & high) {
+        w->score++;
+    } else if (mh & high) {
+        w->score--;
+    }
+
+    ph = (ph << 1) | carry;
+    mh <<= 1;
+    w->pv = mh | ~(xv | ph);
+    w->mv = ph & xv;
+}
+
+/**
+ * @brief Расстояние редактирования шаблона до всего диапазона текста
+ * Edit distance from a pattern to the whole text range
+ */
+static uint8_t anchored_distance(const command_automaton_t* automaton, uint16_t pattern,
+                                 const char* text, size_t start, size_t end) {
+    uint8_t m = automaton->fuzzy_pattern_chars[pattern];
+    command_fuzzy_state_t w = {
+        .pv = m < 32 ? (1u << m) - 1 : UINT32_MAX,
+        .score = m,
+    };
+
+    uint32_t previous = 0;
+    size_t pos = start;
+    size_t char_start;
+    uint32_t code_point;
+    while ((code_point = next_phonetic(text, &pos, end, &previous, &char_start)) != 0) {
+        uint8_t symbol = symbol_of(automaton, code_point);
+        w.eq = 0;
+        if (symbol != 0 && symbol < automaton->symbol_count) {
+            for (uint16_t i = automaton->fuzzy_symbol_first[symbol]; i < automaton->fuzzy_symbol_first[symbol + 1]; i++) {
+                if (automaton->fuzzy_entries[i].pattern == pattern) {
+                    w.eq = automaton->fuzzy_entries[i].mask;
+                    break;
+                }
+            }
+        }
+        myers_step(&w, m, 1);
+        if (w.score == UINT8_MAX) {
+            break;
+        }
+    }
+
+    return w.score;
+}
+
+size_t command_matcher_count_phonetic(const char* text, size_t length) {
+    if (!text) {
+        return 0;
+    }
+
+    uint32_t previous = 0;
+    size_t pos = 0;
+    size_t char_start;
+    size_t count = 0;
+    while (next_phonetic(text, &pos, length, &previous, &char_start) != 0) {
+        count++;
+    }
+    return count;
+}
+
+bool command_matcher_find_fuzzy(const command_automaton_t* automaton, const char* text, size_t length,
+                                float max_error_ratio, command_fuzzy_state_t* workspace,
+                                command_match_t* match) {
+    if (!automaton || !text || !workspace || !match || !automaton->fuzzy_entries) {
+        return false;
+    }
+
+    // Начальное состояние: расстояние равно длине шаблона / Initial state: distance equals pattern length
+    for (uint16_t p = 0; p < automaton->pattern_count; p++) {
+        uint8_t m = automaton->fuzzy_pattern_chars[p];
+        workspace[p].pv = m < 32 ? (1u << m) - 1 : UINT32_MAX;
+        workspace[p].mv = 0;
+        workspace[p].eq = 0;
+        workspace[p].score = m;
+        workspace[p].best = m;
+        workspace[p].best_start = 0;
+        workspace[p].best_end = 0;
+    }
+
+    size_t offsets[COMMAND_MATCHER_MAX_PATTERN_CHARS];
+    size_t chars = 0;
+    uint32_t previous = 0;
+    uint8_t previous_symbol = 0;
+    size_t pos = 0;
+    size_t start;
+    uint32_t code_point;
+
+    while ((code_point = next_phonetic(text, &pos, length, &previous, &start)) != 0) {
+        offsets[chars % COMMAND_MATCHER_MAX_PATTERN_CHARS] = start;
+        chars++;
+
+        uint8_t symbol = symbol_of(automaton, code_point);
+        set_fuzzy_eq(automaton, workspace, previous_symbol, true);
+        set_fuzzy_eq(automaton, workspace, symbol, false);
+        previous_symbol = symbol;
+
+        // Шаг Майерса для всех шаблонов; начало совпадения свободно (Ph без переноса 1)
+        // Myers step for every pattern; the match may start anywhere (Ph shifts in no 1)
+        for (uint16_t p = 0; p < automaton->pattern_count; p++) {
+            uint8_t m = automaton->fuzzy_pattern_chars[p];
+            if (m == 0) {
+                continue;
+            }
+
+            command_fuzzy_state_t* w = &workspace[p];
+            myers_step(w, m, 0);
+
+            if (w->score < w->best) {
+                size_t span = m < chars ? m : chars;
+                w->best = w->score;
+                w->best_start = offsets[(chars - span) % COMMAND_MATCHER_MAX_PATTERN_CHARS];
+                w->best_end = pos;
+            }
+        }
+    }
+    set_fuzzy_eq(automaton, workspace, previous_symbol, true);
+
+    // Кандидат расширяется до границ слов и должен покрывать почти всю фразу;
+    // ошибки пересчитываются для всего расширенного диапазона
+    // A candidate is widened to word boundaries and must cover almost the whole
+    // utterance; errors are recounted over the whole widened span
+    size_t min_span_chars = (size_t)(chars * COMMAND_MATCHER_MIN_COVERAGE + 0.5f);
+
+    // Наименьшая доля ошибок, при равенстве - более длинный шаблон
+    // Lowest error ratio, the longer pattern on a tie
+    match->pattern = -1;
+    match->errors = 0;
+    uint8_t best_chars = 0;
+    for (uint16_t p = 0; p < automaton->pattern_count; p++) {
+        uint8_t m = automaton->fuzzy_pattern_chars[p];
+        uint8_t max_errors = (uint8_t)(m * max_error_ratio);
+        if (m < COMMAND_MATCHER_FUZZY_MIN_CHARS || workspace[p].best > max_errors) {
+            continue;
+        }
+
+        size_t span_start = workspace[p].best_start;
+        size_t span_end = workspace[p].best_end;
+        while (!boundary_before(text, span_start)) {
+            do {
+                span_start--;
+            } while (span_start > 0 && ((uint8_t)text[span_start] & 0xC0) == 0x80);
+        }
+        while (!boundary_after(text, span_end, length)) {
+            span_end += command_matcher_decode_utf8(text + span_end, length - span_end, &code_point);
+        }
+        if (command_matcher_count_phonetic(text + span_start, span_end - span_start) < min_span_chars) {
+            continue;
+        }
+
+        uint8_t errors = anchored_distance(automaton, p, text, span_start, span_end);
+        if (errors > max_errors) {
+            continue;
+        }
+        if (match->pattern < 0 || errors * best_chars < match->errors * m ||
+            (errors * best_chars == match->errors * m && m > best_chars)) {
+            match->pattern = p;
+            match->errors = errors;
+            match->start = span_start;
+            match->length = span_end - span_start;
+            best_chars = m;
+        }
+    }
+
+    return match->pattern >= 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file command_matcher.h
+ * @brief Voice command matcher header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл поиска команд автоматом Ахо-Корасик
+ * Header file for Aho-Corasick command matching
+ *
+ * Автомат строится при сборке (tools/gen_command_automaton.py) и хранится во
+ * flash. Поиск - один проход по UTF-8 без выделения памяти и копирования, с
+ * регистронезависимым сравнением для латиницы и кириллицы (ё = е).
+ * The automaton is built at compile time (tools/gen_command_automaton.py) and
+ * kept in flash. Matching is a single pass over UTF-8 with no allocation or
+ * copying, case-insensitive for Latin and Cyrillic (ё = е).
+ *
+ * Точное совпадение засчитывается только на границах слов: по обе стороны
+ * начало/конец текста или кодовая точка, не являющаяся буквой или цифрой
+ * ("this" не содержит "hi", "покажи" не содержит "пока").
+ * An exact match counts only on word boundaries: on both sides the start/end
+ * of the text or a code point that is not a letter or digit ("this" does not
+ * contain "hi", "покажи" does not contain "пока").
+ *
+ * Если точного совпадения нет, нечеткий поиск (битово-параллельный алгоритм
+ * Майерса) за один проход оценивает расстояние редактирования до всех шаблонов
+ * в фонетически нормализованной форме.
+ * When there is no exact match, fuzzy search (Myers' bit-parallel algorithm)
+ * scores the edit distance to every pattern in one pass, on phonetically
+ * normalized forms.
+ */
+
+#ifndef COMMAND_MATCHER_H
+#define COMMAND_MATCHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Максимальная длина шаблона в символах / Maximum pattern length in characters
+#define COMMAND_MATCHER_MAX_PATTERN_CHARS   64
+// Максимальная длина шаблона для нечеткого поиска (ширина маски) / Maximum fuzzy pattern length (mask width)
+#define COMMAND_MATCHER_FUZZY_MAX_CHARS     32
+// Максимум кандидатов при поиске всех команд / Maximum candidates when finding all commands
+#define COMMAND_MATCHER_MAX_CANDIDATES      32
+// Допустимая доля ошибок по умолчанию / Default allowed error ratio
+#define COMMAND_MATCHER_FUZZY_MAX_ERROR_RATIO   0.25f
+// Минимальная фонетическая длина шаблона для нечеткого поиска / Minimum phonetic pattern length for fuzzy search
+#define COMMAND_MATCHER_FUZZY_MIN_CHARS         4
+// Доля фразы, которую должны покрывать команды / Share of the utterance the commands must cover
+#define COMMAND_MATCHER_MIN_COVERAGE            0.8f
+
+// Состояние автомата / Automaton state
+typedef struct {
+    uint16_t first_edge;      // Первый переход / First edge
+    uint8_t edge_count;       // Число переходов / Edge count
+    uint8_t reserved;
+    uint16_t fail;            // Суффиксная ссылка / Failure link
+    int16_t output;           // Самый длинный шаблон, оканчивающийся здесь (-1 нет) / Longest pattern ending here (-1 none)
+} command_automaton_state_t;
+
+// Переход автомата (отсортированы по символу) / Automaton edge (sorted by symbol)
+typedef struct {
+    uint8_t symbol;           // Символ алфавита / Alphabet symbol
+    uint8_t reserved;
+    uint16_t target;          // Целевое состояние / Target state
+} command_automaton_edge_t;
+
+// Маска Eq шаблона для символа алфавита / Pattern Eq mask for an alphabet symbol
+typedef struct {
+    uint32_t mask;            // Позиции символа в шаблоне / Symbol positions in the pattern
+    uint16_t pattern;         // Индекс шаблона / Pattern index
+    uint16_t reserved;
+} command_fuzzy_entry_t;
+
+// Автомат Ахо-Корасик / Aho-Corasick automaton
+typedef struct {
+    const uint8_t* ascii_symbols;               // Символы для U+0000-U+007F / Symbols for U+0000-U+007F
+    const uint8_t* cyrillic_symbols;            // Символы для а-я / Symbols for а-я
+    const command_automaton_state_t* states;    // Состояния (0 - корень) / States (0 is the root)
+    const command_automaton_edge_t* edges;      // Переходы / Edges
+    const uint8_t* pattern_chars;               // Длины шаблонов в символах / Pattern lengths in characters
+    uint16_t state_count;                       // Число состояний / State count
+    uint16_t pattern_count;                     // Число шаблонов / Pattern count
+
+    // Нечеткий поиск / Fuzzy search
+    const command_fuzzy_entry_t* fuzzy_entries; // Маски, сгруппированные по символу / Masks grouped by symbol
+    const uint16_t* fuzzy_symbol_first;         // Первая маска символа (symbol_count + 1) / First mask of a symbol (symbol_count + 1)
+    const uint8_t* fuzzy_pattern_chars;         // Фонетическая длина (0 - без нечеткого поиска) / Phonetic length (0 - no fuzzy search)
+    uint16_t symbol_count;                      // Размер алфавита с символом 0 / Alphabet size including symbol 0
+} command_automaton_t;
+
+// Рабочее состояние нечеткого поиска на шаблон / Per-pattern fuzzy search workspace
+typedef struct {
+    uint32_t pv;              // Положительные вертикальные разности / Positive vertical deltas
+    uint32_t mv;              // Отрицательные вертикальные разности / Negative vertical deltas
+    uint32_t eq;              // Маска текущего символа / Current symbol mask
+    uint8_t score;            // Расстояние в текущей позиции / Distance at the current position
+    uint8_t best;             // Лучшее расстояние / Best distance
+    uint16_t reserved;
+    size_t best_start;        // Начало лучшего совпадения / Best match start
+    size_t best_end;          // Конец лучшего совпадения / Best match end
+} command_fuzzy_state_t;
+
+// Найденная команда / Found command
+typedef struct {
+    int pattern;              // Индекс шаблона / Pattern index
+    size_t start;             // Смещение в байтах / Byte offset
+    size_t length;            // Длина в байтах / Length in bytes
+    int errors;               // Ошибок редактирования (0 - точное) / Edit errors (0 - exact)
+} command_match_t;
+
+/**
+ * @brief Свернуть регистр кодовой точки (а-я, a-z, ё -> е)
+ * Fold the case of a code point (а-я, a-z, ё -> е)
+ */
+uint32_t command_matcher_fold(uint32_t code_point);
+
+/**
+ * @brief Фонетический класс кодовой точки для русского языка
+ * Phonetic class of a code point for Russian
+ *
+ * Редуцированные гласные сливаются (о/а/я, е/э/и/ы/й, у/ю), звонкие согласные
+ * оглушаются, ь и ъ отбрасываются (возвращается 0).
+ * Reduced vowels merge (о/а/я, е/э/и/ы/й, у/ю), voiced consonants are devoiced,
+ * ь and ъ are dropped (returns 0).
+ */
+uint32_t command_matcher_phonetic(uint32_t code_point);
+
+/**
+ * @brief Декодировать кодовую точку UTF-8
+ * Decode a UTF-8 code point
+ *
+ * @return Длина последовательности в байтах (некорректный байт - 1, код U+FFFD)
+ *         Sequence length in bytes (an invalid byte is 1, code U+FFFD)
+ */
+size_t command_matcher_decode_utf8(const char* text, size_t length, uint32_t* code_point);
+
+/**
+ * @brief Число фонетических символов текста
+ * Number of phonetic symbols in a text
+ *
+ * Считается, как в нечетком поиске: без ь/ъ и удвоений.
+ * Counted as in fuzzy search: without ь/ъ and doubles.
+ */
+size_t command_matcher_count_phonetic(const char* text, size_t length);
+
+/**
+ * @brief Найти самую длинную команду в тексте
+ * Find the longest command in the text
+ *
+ * При равной длине выигрывает более ранняя.
+ * On equal length the earlier one wins.
+ *
+ * @param length Длина текста в байтах / Text length in bytes
+ * @return true если команда найдена / true if a command was found
+ */
+bool command_matcher_find_longest(const command_automaton_t* automaton, const char* text, size_t length,
+                                  command_match_t* match);
+
+/**
+ * @brief Найти все команды в тексте по порядку
+ * Find all commands in the text in order
+ *
+ * Совпадения не пересекаются: выбирается самое левое, при равном начале - самое длинное.
+ * Matches don't overlap: the leftmost wins, the longest on an equal start.
+ *
+ * @return Число найденных команд / Number of commands found
+ */
+size_t command_matcher_find_all(const command_automaton_t* automaton, const char* text, size_t length,
+                                command_match_t* matches, size_t max_matches);
+
+/**
+ * @brief Может ли текст еще вырасти в более длинный шаблон
+ * Whether the text can still grow into a longer pattern
+ *
+ * Текст проходится по бору от корня без суффиксных ссылок: true, если путь
+ * существует и из его конца есть переходы ("кликни" -> "кликни правой").
+ * The text is walked through the trie from the root without failure links:
+ * true if the path exists and its end has outgoing edges ("кликни" ->
+ * "кликни правой").
+ */
+bool command_matcher_can_extend(const command_automaton_t* automaton, const char* text, size_t length);
+
+/**
+ * @brief Найти шаблон с наименьшей долей ошибок
+ * Find the pattern with the lowest error ratio
+ *
+ * Совпадение расширяется до границ слов и должно покрывать не меньше
+ * COMMAND_MATCHER_MIN_COVERAGE фонетических символов фразы; шаблоны короче
+ * COMMAND_MATCHER_FUZZY_MIN_CHARS не рассматриваются. Шаблон принимается, если
+ * расстояние до всего расширенного диапазона не больше floor(длина * max_error_ratio);
+ * при равной доле выигрывает более длинный. Так обычная диктовка ("сегодня
+ * хорошая погода") не превращается в команду ("пока").
+ * The match is widened to word boundaries and must cover at least
+ * COMMAND_MATCHER_MIN_COVERAGE of the utterance's phonetic symbols;
+ * patterns shorter than COMMAND_MATCHER_FUZZY_MIN_CHARS are not considered. A
+ * pattern is accepted when its distance to the whole widened span is at most
+ * floor(length * max_error_ratio); on an equal ratio the longer one wins. This
+ * keeps ordinary dictation ("сегодня хорошая погода") from turning into a
+ * command ("пока").
+ *
+ * @param workspace Массив из pattern_count элементов / Array of pattern_count entries
+ * @return true если шаблон найден / true if a pattern was found
+ */
+bool command_matcher_find_fuzzy(const command_automaton_t* automaton, const char* text, size_t length,
+                                float max_error_ratio, command_fuzzy_state_t* workspace,
+                                command_match_t* match);
+
+#endif // COMMAND_MATCHER_H
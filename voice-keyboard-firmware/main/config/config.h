@@ -1,6 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include "sdkconfig.h"
+#include "soc/soc_caps.h"
 #include "driver/gpio.h"
 
 // I2S Configuration
@@ -18,6 +20,19 @@
 #define I2S_SCK_PIN         GPIO_NUM_4  // Serial Clock
 #define BUTTON_PIN          GPIO_NUM_0  // External button
 #define LED_PIN             GPIO_NUM_1  // Status LED
+#define BUTTON_DEBOUNCE_MS  20          // Edges this soon after an accepted one are bounce
+
+// Task placement. On dual-core chips (ESP32-S3) capture and DSP run on core 1;
+// network (the Wi-Fi stack lives on core 0), recognition delivery and HID run on
+// core 0, and segments cross over through a lock-free SPSC queue. Single-core
+// chips (ESP32-C3) leave placement to the scheduler.
+#if CONFIG_FREERTOS_UNICORE || SOC_CPU_CORES_NUM < 2
+#define AUDIO_CORE              tskNO_AFFINITY
+#define IO_CORE                 tskNO_AFFINITY
+#else
+#define AUDIO_CORE              1
+#define IO_CORE                 0
+#endif
 
 // Task Configuration
 #define GPIO_TASK_STACK_SIZE    2048
@@ -26,8 +41,87 @@
 #define AUDIO_TASK_PRIORITY     5
 #define SPEECH_TASK_STACK_SIZE  4096
 #define SPEECH_TASK_PRIORITY    5
+#define SPEECH_LOCAL_TASK_STACK_SIZE    4096
+#define SPEECH_LOCAL_TASK_PRIORITY      4     // Below audio: local recognition never delays capture
+#define STT_CONNECTION_TASK_STACK_SIZE  8192  // TLS handshake needs a deep stack
+#define STT_CONNECTION_TASK_PRIORITY    4
+#define STT_CLIENT_TASK_STACK_SIZE      6144
+#define STT_CLIENT_TASK_PRIORITY        4
+#define HID_TASK_STACK_SIZE     3072
+#define HID_TASK_PRIORITY       6     // Above speech so output never waits on recognition
+#define SYSTEM_TASK_STACK_SIZE  3072
+#define SYSTEM_TASK_PRIORITY    9     // Below the button, above audio and HID: transitions never wait on processing
+
+// Wi-Fi station (wifi_config.h)
+#define WIFI_SSID               "voice-keyboard"
+#define WIFI_PASSWORD           "change-me"
+#define WIFI_AUTHMODE_THRESHOLD WIFI_AUTH_WPA2_PSK
+
+// Speech-to-text server
+#define STT_SERVER_HOST         "stt.example.com"
+#define STT_SERVER_PORT         443
+#define STT_SERVER_PATH         "/v1/recognize"
+#define STT_LANGUAGE            "ru"
+#define STT_CONNECT_TIMEOUT_MS  5000
+#define STT_IDLE_TIMEOUT_MS     60000   // Keep-alive between utterances
+#define STT_RESPONSE_TIMEOUT_MS 10000
+#define SPEECH_INTERIM_RESULTS  1       // Deliver the merged text after each segment (typed live, see dictation_output.h)
+
+// System state machine (tasks/system_state.h)
+#define SYSTEM_EVENT_QUEUE_LENGTH 16
+#define SYSTEM_TRACE_LENGTH     32    // Transitions kept for system_state_get_trace
+#define SYSTEM_UPLOAD_TIMEOUT_MS (STT_RESPONSE_TIMEOUT_MS + 2000)  // No result after release: back to idle
+#define SYSTEM_TYPING_GRACE_MS  500   // A result that produced no HID output
+#define SYSTEM_ERROR_HOLD_MS    2000  // Time in the error state before idle
+
+// Offline spool (flash partition "spool", see partitions.csv)
+#define STT_SPOOL_PARTITION     "spool"
+#define STT_SPOOL_POLICY        STT_SPOOL_TYPE_ON_ARRIVAL
+#define STT_SPOOL_DISCARD_AFTER_MS 30000  // Used by STT_SPOOL_DISCARD_AFTER_TIMEOUT
+#define STT_SPOOL_BACKOFF_INITIAL_MS 1000
+#define STT_SPOOL_BACKOFF_MAX_MS 60000
+
+// Command dictionary (flash partition "commands", two slots, see tools/command_dict.py)
+#define COMMAND_DICTIONARY_PARTITION "commands"
+
+// HID transport (hid_transport.h): USB where the chip has OTG, else BLE;
+// hid_transport_mock records reports with timestamps for benchmarks
+#if SOC_USB_OTG_SUPPORTED
+#define HID_TRANSPORT           hid_transport_usb
+#elif CONFIG_BT_NIMBLE_ENABLED
+#define HID_TRANSPORT           hid_transport_ble
+#else
+#define HID_TRANSPORT           hid_transport_mock
+#endif
+
+// HID output queue
+#define HID_TASK_QUEUE_LENGTH   64    // Lock-free slots, power of two
+#define HID_TASK_STAGING_LENGTH 16    // Reports expanded ahead of the USB interval
+
+// Host keyboard layouts for dictated text (text_layout_t, see text_planner.h)
+#define HID_HOST_LAYOUT         TEXT_LAYOUT_RU  // Assumed at start, then tracked
+#define HID_LAYOUT_SWITCH_MODIFIER (HID_MODIFIER_LEFT_ALT | HID_MODIFIER_LEFT_SHIFT)  // Windows default toggle
+#define HID_LAYOUT_SWITCH_KEY   0     // Key pressed with the modifier (0 - modifier only)
+#define HID_LAYOUT_SWITCH_DELAY_US 30000  // Host time to apply a switch
+#define HID_LAYOUT_LED          0     // LED lit while ЙЦУКЕН is active (e.g. HID_LED_SCROLL_LOCK with xkb grp_led:scroll), 0 - none
+
+// HID keystroke timing (see hid_timing_profile_t)
+#define HID_TASK_HOLD_US        4000  // Minimum key hold
+#define HID_TASK_GAP_US         2000  // Minimum gap after a release
+#define HID_AUTOTUNE_ON_CONNECT 1     // Probe the host with Caps Lock taps on every connect
+#define HID_AUTOTUNE_TAPS       8     // Even, so Caps Lock ends where it started
+#define HID_AUTOTUNE_SETTLE_MS  100   // Time for the host to echo the LEDs
+
+// Smooth mouse motion (see mouse_motion.h), speeds in mouse counts
+#define HID_MOTION_FRAME_US     1000  // One move per USB frame (HID_MOUSE_INTERVAL)
+#define HID_MOTION_START_SPEED  150   // Counts/s when a motion starts
+#define HID_MOTION_MAX_SPEED    1200  // Counts/s cruise speed
+#define HID_MOTION_ACCELERATION 1500  // Counts/s^2, also the braking before a target
+#define HID_MOTION_TIMEOUT_MS   8000  // An open-ended motion stops by itself
 
 // Audio Processing
 #define AUDIO_LEVEL_LOG_INTERVAL 100  // Log every N buffers
+#define AUDIO_DSP_BUDGET_PERCENT 25   // Share of each block's real time for optional DSP stages (audio_processor.h)
+#define AUDIO_BACKLOG_WAIT_US   1000  // An I2S read that waited less than this found the block already in DMA
 
 #endif // CONFIG_H
\ No newline at end of file
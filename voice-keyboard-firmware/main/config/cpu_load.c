@@ -0,0 +1,87 @@
+/**
+ * @file cpu_load.c
+ * @brief Per-core CPU load implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация измерения загрузки ядер
+ * Implementation of per-core CPU load measurement
+ */
+
+#include "cpu_load.h"
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+
+static const char* TAG = "CPU_LOAD";
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#define idle_task_for_core(core)    xTaskGetIdleTaskHandleForCore(core)
+#else
+#define idle_task_for_core(core)    xTaskGetIdleTaskHandleForCPU(core)
+#endif
+
+#define CORE_COUNT  (portNUM_PROCESSORS < CPU_LOAD_MAX_CORES ? portNUM_PROCESSORS : CPU_LOAD_MAX_CORES)
+
+// Прошлый замер (счетчики esp_timer, мкс) / Previous sample (esp_timer counters, us)
+static struct {
+    uint32_t idle_us[CPU_LOAD_MAX_CORES];
+    int64_t sample_us;
+} previous;
+
+esp_err_t cpu_load_sample(cpu_load_t* load) {
+    if (!load) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Запас на задачи, созданные между подсчетом и снимком / Room for tasks created between the count and the snapshot
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t* tasks = malloc(capacity * sizeof(TaskStatus_t));
+    if (!tasks) {
+        ESP_LOGE(TAG, "Failed to allocate task snapshot");
+        return ESP_ERR_NO_MEM;
+    }
+    UBaseType_t count = uxTaskGetSystemState(tasks, capacity, NULL);
+    int64_t now = esp_timer_get_time();
+
+    load->core_count = CORE_COUNT;
+    load->window_ms = (uint32_t)((now - previous.sample_us) / 1000);
+
+    for (int core = 0; core < CORE_COUNT; core++) {
+        TaskHandle_t idle = idle_task_for_core(core);
+        uint32_t idle_us = previous.idle_us[core];
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (tasks[i].xHandle == idle) {
+                idle_us = (uint32_t)tasks[i].ulRunTimeCounter;
+                break;
+            }
+        }
+
+        // Беззнаковая разность переживает переполнение счетчика / Unsigned difference survives counter wrap
+        uint32_t window_us = (uint32_t)(now - previous.sample_us);
+        uint32_t idle_delta = idle_us - previous.idle_us[core];
+        if (idle_delta > window_us) {
+            idle_delta = window_us;
+        }
+        load->busy_percent[core] = window_us ? (uint8_t)(100 - (uint64_t)idle_delta * 100 / window_us) : 0;
+        previous.idle_us[core] = idle_us;
+    }
+    previous.sample_us = now;
+
+    free(tasks);
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t cpu_load_sample(cpu_load_t* load) {
+    ESP_LOGD(TAG, "FreeRTOS run-time statistics are disabled");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @file cpu_load.h
+ * @brief Per-core CPU load header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл измерения загрузки ядер
+ * Header file for per-core CPU load measurement
+ *
+ * Загрузка ядра - доля времени вне его задачи простоя за окно между вызовами.
+ * Нужна статистика времени выполнения FreeRTOS (sdkconfig.defaults); без нее
+ * возвращается ESP_ERR_NOT_SUPPORTED.
+ * A core's load is the share of time outside its idle task over the window
+ * between calls. Needs FreeRTOS run-time statistics (sdkconfig.defaults);
+ * without them ESP_ERR_NOT_SUPPORTED is returned.
+ */
+
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define CPU_LOAD_MAX_CORES  2
+
+// Загрузка ядер / Core load
+typedef struct {
+    uint8_t core_count;
+    uint8_t busy_percent[CPU_LOAD_MAX_CORES];  // Загрузка за окно / Load over the window
+    uint32_t window_ms;                        // Окно (первый вызов - с загрузки) / Window (first call - since boot)
+} cpu_load_t;
+
+/**
+ * @brief Измерить загрузку ядер с прошлого вызова
+ * Measure core load since the previous call
+ *
+ * Вызывается из одной задачи.
+ * Called from a single task.
+ */
+esp_err_t cpu_load_sample(cpu_load_t* load);
+
+#endif // CPU_LOAD_H
@@ -0,0 +1,165 @@
+/**
+ * @file dictation_output.c
+ * @brief Dictation output engine implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация вывода диктовки
+ * Implementation of the dictation output engine
+ */
+
+#include "dictation_output.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+
+static const char* TAG = "DICTATION";
+
+// Внутренняя структура вывода диктовки / Internal dictation output structure
+struct dictation_output {
+    // Незафиксированный текст, как он напечатан / Unlocked text as typed
+    char shadow[DICTATION_OUTPUT_MAX_TEXT];
+    size_t shadow_length;
+
+    // Перед следующей фразой нужен пробел / The next utterance needs a space first
+    bool separate;
+
+    // Статистика / Statistics
+    dictation_stats_t stats;
+};
+
+static bool is_continuation(char byte) {
+    return ((unsigned char)byte & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Число символов UTF-8 (Backspace стирает символ, а не байт)
+ * Number of UTF-8 characters (Backspace erases a character, not a byte)
+ */
+static size_t count_characters(const char* text, size_t length) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (!is_continuation(text[i])) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Привести shadow к target минимальной правкой
+ * Bring shadow to target with the minimal edit
+ */
+static void apply_target(struct dictation_output* output, const char* target, size_t length,
+                         dictation_edit_t* edit) {
+    size_t prefix = 0;
+    while (prefix < length && prefix < output->shadow_length && target[prefix] == output->shadow[prefix]) {
+        prefix++;
+    }
+    // Префикс не режет символ / The prefix doesn't split a character
+    while (prefix > 0 && ((prefix < length && is_continuation(target[prefix])) ||
+                          (prefix < output->shadow_length && is_continuation(output->shadow[prefix])))) {
+        prefix--;
+    }
+
+    size_t erased = count_characters(output->shadow + prefix, output->shadow_length - prefix);
+    memcpy(output->shadow + prefix, target + prefix, length - prefix);
+    output->shadow_length = length;
+
+    edit->backspaces = erased;
+    edit->insert = output->shadow + prefix;
+    edit->insert_length = length - prefix;
+
+    size_t typed = count_characters(edit->insert, edit->insert_length);
+    output->stats.characters_erased += erased;
+    output->stats.characters_typed += typed;
+    output->stats.characters_kept += count_characters(output->shadow, prefix);
+}
+
+esp_err_t dictation_output_init(dictation_output_handle_t* handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = calloc(1, sizeof(struct dictation_output));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for dictation output");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Dictation output initialized");
+    return ESP_OK;
+}
+
+esp_err_t dictation_output_deinit(dictation_output_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    free(handle);
+    ESP_LOGI(TAG, "Dictation output deinitialized");
+    return ESP_OK;
+}
+
+esp_err_t dictation_output_update(dictation_output_handle_t handle, const char* text, bool is_final,
+                                  dictation_edit_t* edit) {
+    if (!handle || !text || !edit) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Цель: разделитель и текст, обрезанные по границе символа / Target: separator and text, cut at a character boundary
+    char target[DICTATION_OUTPUT_MAX_TEXT];
+    size_t length = 0;
+    if (handle->separate && text[0] != '\0') {
+        target[length++] = ' ';
+    }
+    size_t text_length = strlen(text);
+    if (text_length > sizeof(target) - length) {
+        text_length = sizeof(target) - length;
+        while (text_length > 0 && is_continuation(text[text_length])) {
+            text_length--;
+        }
+    }
+    memcpy(target + length, text, text_length);
+    length += text_length;
+
+    apply_target(handle, target, length, edit);
+
+    if (is_final) {
+        handle->stats.finals++;
+        if (length > 0) {
+            char last = target[length - 1];
+            handle->separate = last != ' ' && last != '\n' && last != '\t';
+        }
+        // Зафиксировано: больше не правится / Locked: never edited again
+        handle->shadow_length = 0;
+    } else {
+        handle->stats.hypotheses++;
+    }
+
+    ESP_LOGD(TAG, "Edit: %u backspace(s), %u byte(s) typed%s", edit->backspaces,
+             (unsigned)edit->insert_length, is_final ? ", locked" : "");
+    return ESP_OK;
+}
+
+esp_err_t dictation_output_discard(dictation_output_handle_t handle, dictation_edit_t* edit) {
+    if (!handle || !edit) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (handle->shadow_length > 0) {
+        handle->stats.discards++;
+    }
+    apply_target(handle, "", 0, edit);
+    return ESP_OK;
+}
+
+esp_err_t dictation_output_get_stats(dictation_output_handle_t handle, dictation_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = handle->stats;
+    return ESP_OK;
+}
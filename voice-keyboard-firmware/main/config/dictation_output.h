@@ -0,0 +1,88 @@
+/**
+ * @file dictation_output.h
+ * @brief Dictation output engine header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл вывода диктовки
+ * Header file for the dictation output engine
+ *
+ * Промежуточные гипотезы (is_final == false) печатаются сразу. Движок хранит
+ * теневую копию напечатанного и на каждую новую гипотезу выдает минимальную
+ * правку: общий префикс остается, лишний хвост стирается Backspace, новый
+ * хвост допечатывается. Финальный текст фиксируется и больше не правится.
+ * Interim hypotheses (is_final == false) are typed right away. The engine keeps
+ * a shadow copy of what was typed and turns each new hypothesis into the
+ * minimal edit: the common prefix stays, the stale tail is erased with
+ * Backspace, the new tail is typed. Final text is locked and never edited again.
+ *
+ * Правка верна, пока курсор хоста стоит в конце напечатанного.
+ * The edit is correct as long as the host cursor stays at the end of the text.
+ */
+
+#ifndef DICTATION_OUTPUT_H
+#define DICTATION_OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Максимальная длина незафиксированного текста в байтах / Maximum unlocked text length in bytes
+#define DICTATION_OUTPUT_MAX_TEXT   256
+
+// Дескриптор вывода диктовки / Dictation output handle
+typedef struct dictation_output* dictation_output_handle_t;
+
+// Правка для отправки / Edit to send
+typedef struct {
+    uint16_t backspaces;         // Стереть символов / Characters to erase
+    const char* insert;          // Допечатать (до следующего вызова) / Text to type (valid until the next call)
+    size_t insert_length;        // Длина в байтах / Length in bytes
+} dictation_edit_t;
+
+// Статистика вывода диктовки / Dictation output statistics
+typedef struct {
+    uint32_t hypotheses;         // Промежуточных гипотез / Interim hypotheses
+    uint32_t finals;             // Зафиксированных фраз / Locked utterances
+    uint32_t discards;           // Гипотез, оказавшихся командами / Hypotheses that turned out to be commands
+    uint32_t characters_typed;   // Напечатано символов / Characters typed
+    uint32_t characters_erased;  // Стерто символов / Characters erased
+    uint32_t characters_kept;    // Оставлено без перепечатки / Characters kept without retyping
+} dictation_stats_t;
+
+/**
+ * @brief Инициализация вывода диктовки
+ * Initialize dictation output
+ */
+esp_err_t dictation_output_init(dictation_output_handle_t* handle);
+
+/**
+ * @brief Деинициализация вывода диктовки
+ * Deinitialize dictation output
+ */
+esp_err_t dictation_output_deinit(dictation_output_handle_t handle);
+
+/**
+ * @brief Новая гипотеза текущей фразы
+ * New hypothesis for the current utterance
+ *
+ * Фразы разделяются пробелом. При is_final текст фиксируется.
+ * Utterances are separated by a space. With is_final the text is locked.
+ */
+esp_err_t dictation_output_update(dictation_output_handle_t handle, const char* text, bool is_final,
+                                  dictation_edit_t* edit);
+
+/**
+ * @brief Стереть незафиксированный текст (фраза оказалась командой)
+ * Erase the unlocked text (the utterance turned out to be a command)
+ */
+esp_err_t dictation_output_discard(dictation_output_handle_t handle, dictation_edit_t* edit);
+
+/**
+ * @brief Получить статистику вывода диктовки
+ * Get dictation output statistics
+ */
+esp_err_t dictation_output_get_stats(dictation_output_handle_t handle, dictation_stats_t* stats);
+
+#endif // DICTATION_OUTPUT_H
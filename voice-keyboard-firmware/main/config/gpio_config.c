@@ -1,17 +1,68 @@
 #include "gpio_config.h"
 #include "config.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char *TAG = "GPIO_CONFIG";
 
-// GPIO event queue
-static QueueHandle_t gpio_evt_queue = NULL;
+// Button state shared with the ISR.
+// Deadline filter: the first edge that changes the level is accepted at once
+// (no added latency) and opens a BUTTON_DEBOUNCE_MS window in which further
+// edges only count as bounce. If the contact settles on the other level inside
+// the window, the task accepts that level when the window closes.
+static struct {
+    portMUX_TYPE lock;
+    TaskHandle_t task;      // Task in wait_button_edge
+    int level;              // Accepted level
+    int64_t edge_us;        // Accepted edge time
+    int64_t last_edge_us;   // Last raw edge, bounces included
+    int64_t deadline_us;    // Edges before this are bounce
+    bool pending;           // Accepted edge not taken by the task yet
+    uint32_t bounces;       // Bounces since the last accepted edge
+} button = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .level = 1,
+};
 
-// GPIO interrupt handler
+// Accept a level change (lock held)
+static void IRAM_ATTR accept_edge(int level, int64_t edge_us)
+{
+    button.level = level;
+    button.edge_us = edge_us;
+    button.deadline_us = edge_us + BUTTON_DEBOUNCE_MS * 1000LL;
+    button.pending = true;
+}
+
+// GPIO interrupt handler: timestamp, debounce, notify the task
 static void IRAM_ATTR gpio_isr_handler(void* arg)
 {
-    uint32_t gpio_num = (uint32_t) arg;
-    xQueueSendFromISR(gpio_evt_queue, &gpio_num, NULL);
+    int64_t now = esp_timer_get_time();
+    int level = gpio_get_level(BUTTON_PIN);
+    bool notify = false;
+
+    portENTER_CRITICAL_ISR(&button.lock);
+    button.last_edge_us = now;
+    if (now >= button.deadline_us) {
+        if (level != button.level) {
+            accept_edge(level, now);
+        } else {
+            // A glitch, or the level flipped back before the read: re-check once it settles
+            button.deadline_us = now + BUTTON_DEBOUNCE_MS * 1000LL;
+            button.bounces++;
+        }
+        notify = true;
+    } else {
+        // Inside the window the task is already waiting for the deadline
+        button.bounces++;
+    }
+    TaskHandle_t task = button.task;
+    portEXIT_CRITICAL_ISR(&button.lock);
+
+    BaseType_t woken = pdFALSE;
+    if (task && notify) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
 }
 
 esp_err_t gpio_init(void)
@@ -39,12 +90,8 @@ esp_err_t gpio_init(void)
     // Turn LED off initially
     gpio_set_level(LED_PIN, 0);
     
-    // Create queue for GPIO events
-    gpio_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    if (gpio_evt_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create GPIO event queue");
-        return ESP_FAIL;
-    }
+    // Start from the current level so a button held at boot isn't reported
+    button.level = gpio_get_level(BUTTON_PIN);
     
     // Install GPIO interrupt service
     ESP_ERROR_CHECK(gpio_install_isr_service(0));
@@ -54,17 +101,52 @@ esp_err_t gpio_init(void)
     return ESP_OK;
 }
 
-QueueHandle_t get_gpio_evt_queue(void)
+void wait_button_edge(button_edge_t* edge)
 {
-    return gpio_evt_queue;
+    int64_t checked_us = 0;   // Window already checked for a settled level
+
+    portENTER_CRITICAL(&button.lock);
+    button.task = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&button.lock);
+
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        int level = gpio_get_level(BUTTON_PIN);
+
+        portENTER_CRITICAL(&button.lock);
+        // The window closed with the contact on the other level: accept it
+        // at the time of the last bounce, when the contact settled
+        if (!button.pending && button.deadline_us > checked_us && now >= button.deadline_us) {
+            checked_us = button.deadline_us;
+            if (level != button.level) {
+                accept_edge(level, button.last_edge_us);
+            }
+        }
+        bool pending = button.pending;
+        if (pending) {
+            edge->pressed = button.level == 0;
+            edge->time_us = button.edge_us;
+            edge->bounces = button.bounces;
+            button.pending = false;
+            button.bounces = 0;
+        }
+        int64_t deadline_us = button.deadline_us;
+        portEXIT_CRITICAL(&button.lock);
+
+        if (pending) {
+            return;
+        }
+
+        // Sleep until the next edge, or until the window closes if it's unchecked
+        TickType_t wait = portMAX_DELAY;
+        if (deadline_us > checked_us) {
+            wait = deadline_us > now ? pdMS_TO_TICKS((deadline_us - now + 999) / 1000) + 1 : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
 }
 
 void set_led_state(bool state)
 {
     gpio_set_level(LED_PIN, state ? 1 : 0);
 }
-
-int get_button_state(void)
-{
-    return gpio_get_level(BUTTON_PIN);
-}
\ No newline at end of file
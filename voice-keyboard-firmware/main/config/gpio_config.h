@@ -1,21 +1,26 @@
 #ifndef GPIO_CONFIG_H
 #define GPIO_CONFIG_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+
+// Debounced button edge
+typedef struct {
+    bool pressed;           // Button pressed (active LOW) or released
+    int64_t time_us;        // Physical edge time (esp_timer), taken in the ISR
+    uint32_t bounces;       // Bounce edges filtered since the previous edge
+} button_edge_t;
 
 // Initialize GPIO for button and LED
 esp_err_t gpio_init(void);
 
-// Get GPIO event queue handle
-QueueHandle_t get_gpio_evt_queue(void);
+// Wait for the next debounced button edge (one task only, blocks on a task notification)
+void wait_button_edge(button_edge_t* edge);
 
 // Set LED state
 void set_led_state(bool state);
 
-// Get button state
-int get_button_state(void);
-
-#endif // GPIO_CONFIG_H
\ No newline at end of file
+#endif // GPIO_CONFIG_H
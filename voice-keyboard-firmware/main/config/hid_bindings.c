@@ -0,0 +1,111 @@
+/**
+ * @file hid_bindings.c
+ * @brief Precompiled HID report bindings implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация таблицы готовых последовательностей HID отчетов
+ * Implementation of the table of precompiled HID report sequences
+ */
+
+#include "hid_bindings.h"
+
+#define KEY(code, mod)      {.type = HID_REPORT_KEYBOARD, .keyboard = {.modifier = (mod), .keycode = {(code)}}}
+#define KEYS_UP             {.type = HID_REPORT_KEYBOARD}
+#define MOUSE(b, dx, dy)    {.type = HID_REPORT_MOUSE, .mouse = {.buttons = (b), .x = (dx), .y = (dy)}}
+#define CONSUMER(u)         {.type = HID_REPORT_CONSUMER, .usage = (u)}
+#define SYSTEM(u)           {.type = HID_REPORT_SYSTEM, .usage = (u)}
+#define POINTER(px, py)     {.type = HID_REPORT_POINTER, .pointer = {.x = (px), .y = (py)}}
+
+// Области экрана - центры клеток сетки 3x3 / Screen regions are the cells of a 3x3 grid
+#define REGION_NEAR         (HID_POINTER_MAX / 6)
+#define REGION_MIDDLE       (HID_POINTER_MAX / 2)
+#define REGION_FAR          (HID_POINTER_MAX - HID_POINTER_MAX / 6)
+
+// Нажатие и отпускание / Press and release
+#define KEY_TAP(name, code, mod) \
+    static const hid_report_t name[] = {KEY(code, mod), KEYS_UP}
+#define CLICK(b)            MOUSE(b, 0, 0), MOUSE(0, 0, 0)
+
+KEY_TAP(key_space, HID_KEY_SPACE, 0);
+KEY_TAP(key_enter, HID_KEY_ENTER, 0);
+KEY_TAP(key_tab, HID_KEY_TAB, 0);
+KEY_TAP(key_escape, HID_KEY_ESCAPE, 0);
+KEY_TAP(key_backspace, HID_KEY_BACKSPACE, 0);
+
+static const hid_report_t mouse_left_click[] = {CLICK(HID_MOUSE_BUTTON_LEFT)};
+static const hid_report_t mouse_right_click[] = {CLICK(HID_MOUSE_BUTTON_RIGHT)};
+static const hid_report_t mouse_double_click[] = {CLICK(HID_MOUSE_BUTTON_LEFT), CLICK(HID_MOUSE_BUTTON_LEFT)};
+
+static const hid_report_t mouse_move_up[] = {MOUSE(0, 0, -HID_BINDING_MOUSE_STEP)};
+static const hid_report_t mouse_move_down[] = {MOUSE(0, 0, HID_BINDING_MOUSE_STEP)};
+static const hid_report_t mouse_move_left[] = {MOUSE(0, -HID_BINDING_MOUSE_STEP, 0)};
+static const hid_report_t mouse_move_right[] = {MOUSE(0, HID_BINDING_MOUSE_STEP, 0)};
+static const hid_report_t mouse_stop[] = {MOUSE(0, 0, 0)};
+
+static const hid_report_t pointer_center[] = {POINTER(REGION_MIDDLE, REGION_MIDDLE)};
+static const hid_report_t pointer_top[] = {POINTER(REGION_MIDDLE, REGION_NEAR)};
+static const hid_report_t pointer_bottom[] = {POINTER(REGION_MIDDLE, REGION_FAR)};
+static const hid_report_t pointer_left[] = {POINTER(REGION_NEAR, REGION_MIDDLE)};
+static const hid_report_t pointer_right[] = {POINTER(REGION_FAR, REGION_MIDDLE)};
+static const hid_report_t pointer_top_left[] = {POINTER(REGION_NEAR, REGION_NEAR)};
+static const hid_report_t pointer_top_right[] = {POINTER(REGION_FAR, REGION_NEAR)};
+static const hid_report_t pointer_bottom_left[] = {POINTER(REGION_NEAR, REGION_FAR)};
+static const hid_report_t pointer_bottom_right[] = {POINTER(REGION_FAR, REGION_FAR)};
+
+static const hid_report_t volume_up[] = {CONSUMER(HID_CONSUMER_VOLUME_UP), CONSUMER(0)};
+static const hid_report_t volume_down[] = {CONSUMER(HID_CONSUMER_VOLUME_DOWN), CONSUMER(0)};
+static const hid_report_t volume_mute[] = {CONSUMER(HID_CONSUMER_MUTE), CONSUMER(0)};
+static const hid_report_t media_play_pause[] = {CONSUMER(HID_CONSUMER_PLAY_PAUSE), CONSUMER(0)};
+static const hid_report_t media_next[] = {CONSUMER(HID_CONSUMER_SCAN_NEXT), CONSUMER(0)};
+static const hid_report_t media_prev[] = {CONSUMER(HID_CONSUMER_SCAN_PREV), CONSUMER(0)};
+
+static const hid_report_t system_lock[] = {CONSUMER(HID_CONSUMER_AL_LOCK), CONSUMER(0)};
+static const hid_report_t system_sleep[] = {SYSTEM(HID_SYSTEM_SLEEP), SYSTEM(0)};
+static const hid_report_t system_wake[] = {SYSTEM(HID_SYSTEM_WAKE_UP), SYSTEM(0)};
+
+#define BINDING(id, reports, flags) \
+    [id] = {(reports), sizeof(reports) / sizeof(hid_report_t), (flags), #id + sizeof("HID_BINDING_") - 1}
+
+// Таблица привязок по hid_binding_id_t / Binding table indexed by hid_binding_id_t
+static const hid_binding_t bindings[HID_BINDING_COUNT] = {
+    [HID_BINDING_NONE] = {NULL, 0, 0, "NONE"},
+    BINDING(HID_BINDING_KEY_SPACE, key_space, 0),
+    BINDING(HID_BINDING_KEY_ENTER, key_enter, 0),
+    BINDING(HID_BINDING_KEY_TAB, key_tab, 0),
+    BINDING(HID_BINDING_KEY_ESCAPE, key_escape, 0),
+    BINDING(HID_BINDING_KEY_BACKSPACE, key_backspace, 0),
+    BINDING(HID_BINDING_MOUSE_LEFT_CLICK, mouse_left_click, 0),
+    BINDING(HID_BINDING_MOUSE_RIGHT_CLICK, mouse_right_click, 0),
+    BINDING(HID_BINDING_MOUSE_DOUBLE_CLICK, mouse_double_click, 0),
+    BINDING(HID_BINDING_MOUSE_MOVE_UP, mouse_move_up, HID_BINDING_FLAG_DISTANCE | HID_BINDING_FLAG_MOTION),
+    BINDING(HID_BINDING_MOUSE_MOVE_DOWN, mouse_move_down, HID_BINDING_FLAG_DISTANCE | HID_BINDING_FLAG_MOTION),
+    BINDING(HID_BINDING_MOUSE_MOVE_LEFT, mouse_move_left, HID_BINDING_FLAG_DISTANCE | HID_BINDING_FLAG_MOTION),
+    BINDING(HID_BINDING_MOUSE_MOVE_RIGHT, mouse_move_right, HID_BINDING_FLAG_DISTANCE | HID_BINDING_FLAG_MOTION),
+    BINDING(HID_BINDING_VOLUME_UP, volume_up, 0),
+    BINDING(HID_BINDING_VOLUME_DOWN, volume_down, 0),
+    BINDING(HID_BINDING_VOLUME_MUTE, volume_mute, 0),
+    BINDING(HID_BINDING_MEDIA_PLAY_PAUSE, media_play_pause, 0),
+    BINDING(HID_BINDING_MEDIA_NEXT, media_next, 0),
+    BINDING(HID_BINDING_MEDIA_PREV, media_prev, 0),
+    BINDING(HID_BINDING_SYSTEM_SLEEP, system_sleep, 0),
+    BINDING(HID_BINDING_SYSTEM_LOCK, system_lock, 0),
+    BINDING(HID_BINDING_SYSTEM_WAKE, system_wake, 0),
+    BINDING(HID_BINDING_MOUSE_STOP, mouse_stop, HID_BINDING_FLAG_MOTION),
+    BINDING(HID_BINDING_POINTER_CENTER, pointer_center, 0),
+    BINDING(HID_BINDING_POINTER_TOP, pointer_top, 0),
+    BINDING(HID_BINDING_POINTER_BOTTOM, pointer_bottom, 0),
+    BINDING(HID_BINDING_POINTER_LEFT, pointer_left, 0),
+    BINDING(HID_BINDING_POINTER_RIGHT, pointer_right, 0),
+    BINDING(HID_BINDING_POINTER_TOP_LEFT, pointer_top_left, 0),
+    BINDING(HID_BINDING_POINTER_TOP_RIGHT, pointer_top_right, 0),
+    BINDING(HID_BINDING_POINTER_BOTTOM_LEFT, pointer_bottom_left, 0),
+    BINDING(HID_BINDING_POINTER_BOTTOM_RIGHT, pointer_bottom_right, 0),
+};
+
+const hid_binding_t* hid_binding_get(uint16_t binding) {
+    if (binding >= HID_BINDING_COUNT || !bindings[binding].name) {
+        return &bindings[HID_BINDING_NONE];
+    }
+    return &bindings[binding];
+}
@@ -0,0 +1,117 @@
+/**
+ * @file hid_bindings.h
+ * @brief Precompiled HID report bindings header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл таблицы готовых последовательностей HID отчетов
+ * Header file for the table of precompiled HID report sequences
+ *
+ * Каждый шаблон команды при сборке ссылается на привязку по индексу; привязка -
+ * последовательность готовых отчетов во flash. Выполнение команды - поиск в
+ * таблице и постановка отчетов в очередь, без сравнения строк.
+ * Every command pattern refers to a binding by index at build time; a binding
+ * is a sequence of ready-made reports in flash. Executing a command is a table
+ * lookup plus queueing the reports, with no string comparison.
+ */
+
+#ifndef HID_BINDINGS_H
+#define HID_BINDINGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hid_config.h"
+
+// Привязки команд (порядок - формат словаря, только добавлять в конец)
+// Command bindings (the order is part of the dictionary format, append only)
+typedef enum {
+    HID_BINDING_NONE,                // Нет действия / No action
+    HID_BINDING_KEY_SPACE,
+    HID_BINDING_KEY_ENTER,
+    HID_BINDING_KEY_TAB,
+    HID_BINDING_KEY_ESCAPE,
+    HID_BINDING_KEY_BACKSPACE,
+    HID_BINDING_MOUSE_LEFT_CLICK,
+    HID_BINDING_MOUSE_RIGHT_CLICK,
+    HID_BINDING_MOUSE_DOUBLE_CLICK,
+    HID_BINDING_MOUSE_MOVE_UP,
+    HID_BINDING_MOUSE_MOVE_DOWN,
+    HID_BINDING_MOUSE_MOVE_LEFT,
+    HID_BINDING_MOUSE_MOVE_RIGHT,
+    HID_BINDING_VOLUME_UP,
+    HID_BINDING_VOLUME_DOWN,
+    HID_BINDING_VOLUME_MUTE,
+    HID_BINDING_MEDIA_PLAY_PAUSE,
+    HID_BINDING_MEDIA_NEXT,
+    HID_BINDING_MEDIA_PREV,
+    HID_BINDING_SYSTEM_SLEEP,
+    HID_BINDING_SYSTEM_LOCK,
+    HID_BINDING_SYSTEM_WAKE,
+    HID_BINDING_MOUSE_STOP,
+    HID_BINDING_POINTER_CENTER,
+    HID_BINDING_POINTER_TOP,
+    HID_BINDING_POINTER_BOTTOM,
+    HID_BINDING_POINTER_LEFT,
+    HID_BINDING_POINTER_RIGHT,
+    HID_BINDING_POINTER_TOP_LEFT,
+    HID_BINDING_POINTER_TOP_RIGHT,
+    HID_BINDING_POINTER_BOTTOM_LEFT,
+    HID_BINDING_POINTER_BOTTOM_RIGHT,
+    HID_BINDING_COUNT
+} hid_binding_id_t;
+
+// Тип отчета / Report type
+typedef enum {
+    HID_REPORT_KEYBOARD,             // hid_keyboard_report_t
+    HID_REPORT_MOUSE,                // hid_mouse_report_t
+    HID_REPORT_CONSUMER,             // hid_consumer_usage_t (0 - отпущено / released)
+    HID_REPORT_SYSTEM,               // hid_system_usage_t (0 - отпущено / released)
+    HID_REPORT_POINTER               // hid_pointer_report_t
+} hid_report_type_t;
+
+// Готовый отчет / Ready-made report
+typedef struct {
+    uint8_t type;                    // hid_report_type_t
+    uint8_t flags;                   // HID_REPORT_FLAG_*
+    union {
+        hid_keyboard_report_t keyboard;
+        hid_mouse_report_t mouse;
+        hid_pointer_report_t pointer;
+        uint16_t usage;              // Consumer / System Control
+    };
+} hid_report_t;
+
+// Флаги отчета / Report flags
+#define HID_REPORT_FLAG_SETTLE      0x01    // После отчета хосту нужно время (смена раскладки) / The host needs time after the report (layout switch)
+
+// Флаги привязки / Binding flags
+#define HID_BINDING_FLAG_DISTANCE   0x01    // Параметр задает смещение мыши / The parameter sets the mouse distance
+#define HID_BINDING_FLAG_MOTION     0x02    // Плавное движение в направлении первого отчета (нулевое - стоп) / Smooth motion along the first report (zero - stop)
+
+// Привязка / Binding
+typedef struct {
+    const hid_report_t* reports;     // Отчеты во flash / Reports in flash
+    uint8_t report_count;            // Число отчетов / Report count
+    uint8_t flags;                   // HID_BINDING_FLAG_*
+    const char* name;                // Имя для журнала / Name for logging
+} hid_binding_t;
+
+// Команда для HID задачи (вместо voice_command_t) / Command for the HID task (instead of voice_command_t)
+typedef struct {
+    uint16_t binding;                // hid_binding_id_t
+    uint16_t repeat;                 // Число повторов / Repeat count
+    uint16_t param;                  // Числовой параметр (0 - нет) / Numeric parameter (0 - none)
+} hid_command_t;
+
+// Смещение мыши по умолчанию в пикселях / Default mouse distance in pixels
+#define HID_BINDING_MOUSE_STEP      20
+
+/**
+ * @brief Получить привязку по индексу
+ * Get a binding by index
+ *
+ * @return Привязка (HID_BINDING_NONE для неизвестного индекса) / Binding (HID_BINDING_NONE for an unknown index)
+ */
+const hid_binding_t* hid_binding_get(uint16_t binding);
+
+#endif // HID_BINDINGS_H
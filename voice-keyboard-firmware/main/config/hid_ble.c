@@ -0,0 +1,813 @@
+/**
+ * @file hid_ble.c
+ * @brief BLE HID transport implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация BLE транспорта HID
+ * Implementation of the BLE HID transport
+ */
+
+#include "hid_ble.h"
+#include <stdbool.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+#if CONFIG_BT_NIMBLE_ENABLED
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#endif
+
+static const char* TAG = "HID_BLE";
+
+#if CONFIG_BT_NIMBLE_ENABLED
+
+// Хранилище бондов NimBLE в NVS / NimBLE bond store in NVS
+void ble_store_config_init(void);
+
+// UUID сервисов и характеристик (Bluetooth Assigned Numbers) / Service and characteristic UUIDs (Bluetooth Assigned Numbers)
+#define UUID_SERVICE_HID            0x1812
+#define UUID_SERVICE_BATTERY        0x180F
+#define UUID_SERVICE_DEVICE_INFO    0x180A
+#define UUID_HID_INFORMATION        0x2A4A
+#define UUID_REPORT_MAP             0x2A4B
+#define UUID_HID_CONTROL_POINT      0x2A4C
+#define UUID_REPORT                 0x2A4D
+#define UUID_REPORT_REFERENCE       0x2908
+#define UUID_BATTERY_LEVEL          0x2A19
+#define UUID_MANUFACTURER_NAME      0x2A29
+#define UUID_PNP_ID                 0x2A50
+
+// Тип отчета в Report Reference / Report type in Report Reference
+#define REPORT_TYPE_INPUT           1
+#define REPORT_TYPE_OUTPUT          2
+
+// Максимальная длина отчета (клавиатура) / Maximum report length (keyboard)
+#define REPORT_MAX_LENGTH           8
+
+// Одна карта отчетов с ID: USB дескрипторы интерфейсов, собранные вместе
+// One report map with IDs: the USB interface descriptors put together
+static const uint8_t report_map[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x06,        // Usage (Keyboard)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_BLE_REPORT_ID_KEYBOARD, //   Report ID (1)
+    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+    0x19, 0xE0,        //   Usage Minimum (0xE0)
+    0x29, 0xE7,        //   Usage Maximum (0xE7)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x95, 0x08,        //   Report Count (8)
+    0x75, 0x01,        //   Report Size (1)
+    0x81, 0x02,        //   Input (Data,Var,Abs)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x08,        //   Report Size (8)
+    0x81, 0x03,        //   Input (Const,Var,Abs)
+    0x05, 0x08,        //   Usage Page (LEDs)
+    0x19, 0x01,        //   Usage Minimum (Num Lock)
+    0x29, 0x05,        //   Usage Maximum (Kana)
+    0x95, 0x05,        //   Report Count (5)
+    0x75, 0x01,        //   Report Size (1)
+    0x91, 0x02,        //   Output (Data,Var,Abs)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x03,        //   Report Size (3)
+    0x91, 0x03,        //   Output (Const,Var,Abs)
+    0x95, 0x06,        //   Report Count (6)
+    0x75, 0x08,        //   Report Size (8)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x65,        //   Logical Maximum (101)
+    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+    0x19, 0x00,        //   Usage Minimum (0x00)
+    0x29, 0x65,        //   Usage Maximum (0x65)
+    0x81, 0x00,        //   Input (Data,Array,Abs)
+    0xC0,              // End Collection
+
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_BLE_REPORT_ID_MOUSE, //   Report ID (2)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x05,        //     Report Size (5)
+    0x81, 0x03,        //     Input (Const,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x05, 0x0C,        //     Usage Page (Consumer)
+    0x0A, 0x38, 0x02,  //     Usage (AC Pan)
+    0x95, 0x01,        //     Report Count (1)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+
+    0x05, 0x0C,        // Usage Page (Consumer)
+    0x09, 0x01,        // Usage (Consumer Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_BLE_REPORT_ID_CONSUMER, //   Report ID (3)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xFF, 0x03,  //   Logical Maximum (1023)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x2A, 0xFF, 0x03,  //   Usage Maximum (1023)
+    0x75, 0x10,        //   Report Size (16)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x00,        //   Input (Data,Array,Abs)
+    0xC0,              // End Collection
+
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x80,        // Usage (Sys Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_BLE_REPORT_ID_SYSTEM, //   Report ID (4)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xB7, 0x00,  //   Logical Maximum (183)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0xB7,        //   Usage Maximum (0xB7)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x00,        //   Input (Data,Array,Abs)
+    0xC0,              // End Collection
+
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_BLE_REPORT_ID_POINTER, //   Report ID (5)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x05,        //     Report Size (5)
+    0x81, 0x03,        //     Input (Const,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0xC0,              //   End Collection
+    0xC0               // End Collection
+};
+
+// Быстрые интервалы от самого короткого, в единицах 1.25 мс: 7.5, 11.25, 15 мс
+// и 15-30 мс для хостов, требующих диапазон (iOS)
+// Fast intervals from the shortest, in 1.25 ms units: 7.5, 11.25, 15 ms and
+// 15-30 ms for hosts that require a range (iOS)
+static const struct {
+    uint16_t min;
+    uint16_t max;
+} fast_intervals[] = {
+    {6, 6},
+    {9, 9},
+    {12, 12},
+    {12, 24},
+};
+
+#define FAST_STEP_COUNT (sizeof(fast_intervals) / sizeof(fast_intervals[0]))
+
+// Характеристика Report / Report characteristic
+typedef struct {
+    uint8_t interface;           // HID_INTERFACE_*
+    uint8_t report_id;           // Логический ID (hid_transport.h) / Logical ID (hid_transport.h)
+    uint8_t reference[2];        // Report Reference: ID в карте, тип / ID in the map, type
+} ble_report_t;
+
+enum {
+    REPORT_KEYBOARD,
+    REPORT_MOUSE,
+    REPORT_CONSUMER,
+    REPORT_SYSTEM,
+    REPORT_POINTER,
+    REPORT_INPUT_COUNT,
+    REPORT_LEDS = REPORT_INPUT_COUNT,
+    REPORT_COUNT
+};
+
+static const ble_report_t ble_reports[REPORT_COUNT] = {
+    [REPORT_KEYBOARD] = {HID_INTERFACE_KEYBOARD, 0, {HID_BLE_REPORT_ID_KEYBOARD, REPORT_TYPE_INPUT}},
+    [REPORT_MOUSE] = {HID_INTERFACE_MOUSE, 0, {HID_BLE_REPORT_ID_MOUSE, REPORT_TYPE_INPUT}},
+    [REPORT_CONSUMER] = {HID_INTERFACE_CONTROL, HID_REPORT_ID_CONSUMER, {HID_BLE_REPORT_ID_CONSUMER, REPORT_TYPE_INPUT}},
+    [REPORT_SYSTEM] = {HID_INTERFACE_CONTROL, HID_REPORT_ID_SYSTEM, {HID_BLE_REPORT_ID_SYSTEM, REPORT_TYPE_INPUT}},
+    [REPORT_POINTER] = {HID_INTERFACE_CONTROL, HID_REPORT_ID_POINTER, {HID_BLE_REPORT_ID_POINTER, REPORT_TYPE_INPUT}},
+    [REPORT_LEDS] = {HID_INTERFACE_KEYBOARD, 0, {HID_BLE_REPORT_ID_KEYBOARD, REPORT_TYPE_OUTPUT}},
+};
+
+// Состояние BLE транспорта / BLE transport state
+typedef struct {
+    hid_transport_event_callback_t event_callback;
+    void* event_user_data;
+
+    uint8_t own_addr_type;
+    uint16_t conn_handle;        // BLE_HS_CONN_HANDLE_NONE без хоста / without a host
+    bool encrypted;
+    uint8_t subscribed;          // Биты подписок на входные отчеты / Input report subscription bits
+    bool ready;                  // Хост принимает отчеты / The host takes reports
+
+    // Параметры связи / Link parameters
+    volatile bool fast;          // Запрошен быстрый интервал / Fast interval requested
+    uint8_t fast_step;           // Ступень fast_intervals / fast_intervals step
+    volatile int64_t last_submit_us;
+    esp_timer_handle_t idle_timer;   // Проверка простоя / Idle check
+
+    // Уведомления пачками на событие связи / Notifications batched per connection event
+    hid_report_window_t window;
+    esp_timer_handle_t retry_timer;  // Пробуждение к следующему окну / Wake-up for the next window
+    uint8_t retry_interface;
+    hid_ble_stats_t stats;
+
+    // Последние отчеты для чтения хостом / Last reports for host reads
+    uint8_t last_report[REPORT_INPUT_COUNT][REPORT_MAX_LENGTH];
+    uint8_t last_length[REPORT_INPUT_COUNT];
+    uint8_t leds;
+} hid_ble_t;
+
+static hid_ble_t ble = {
+    .conn_handle = BLE_HS_CONN_HANDLE_NONE,
+    .window = {.limit = HID_BLE_NOTIFY_PER_EVENT},
+};
+
+static uint16_t report_handles[REPORT_COUNT];
+
+static void emit_event(hid_transport_event_t event, uint8_t value) {
+    if (ble.event_callback) {
+        ble.event_callback(event, value, ble.event_user_data);
+    }
+}
+
+/**
+ * @brief Пересчитать готовность хоста и сообщить об изменении
+ * Recompute host readiness and report a change
+ */
+static void update_ready(void) {
+    bool ready = ble.conn_handle != BLE_HS_CONN_HANDLE_NONE && ble.encrypted &&
+                 (ble.subscribed & (1u << REPORT_KEYBOARD));
+    if (ready == ble.ready) {
+        return;
+    }
+
+    ble.ready = ready;
+    ESP_LOGI(TAG, "Host %s", ready ? "ready" : "gone");
+    emit_event(ready ? HID_TRANSPORT_EVENT_CONNECTED : HID_TRANSPORT_EVENT_DISCONNECTED, 0);
+}
+
+/**
+ * @brief Запросить быстрый или медленный интервал связи
+ * Request the fast or the slow connection interval
+ */
+static void request_interval(bool fast) {
+    struct ble_gap_upd_params params = {
+        .itvl_min = fast ? fast_intervals[ble.fast_step].min : HID_BLE_SLOW_INTERVAL_MIN,
+        .itvl_max = fast ? fast_intervals[ble.fast_step].max : HID_BLE_SLOW_INTERVAL_MAX,
+        .latency = fast ? 0 : HID_BLE_SLOW_LATENCY,
+        .supervision_timeout = HID_BLE_SUPERVISION_TIMEOUT,
+    };
+
+    ble.fast = fast;
+    int rc = ble_gap_update_params(ble.conn_handle, &params);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "Failed to request %s interval: %d", fast ? "fast" : "slow", rc);
+    }
+}
+
+/**
+ * @brief Запомнить параметры связи, выбранные хостом
+ * Remember the link parameters chosen by the host
+ */
+static void apply_link_params(uint16_t conn_handle) {
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(conn_handle, &desc) != 0) {
+        return;
+    }
+
+    ble.window.interval_us = desc.conn_itvl * 1250u;
+    ble.stats.interval_us = ble.window.interval_us;
+    ble.stats.latency = desc.conn_latency;
+    ble.stats.updates++;
+    ESP_LOGI(TAG, "Connection interval %u.%02u ms, latency %u",
+             (unsigned)(ble.window.interval_us / 1000), (unsigned)(ble.window.interval_us % 1000 / 10),
+             desc.conn_latency);
+}
+
+/**
+ * @brief Таймер простоя: перейти на медленный интервал
+ * Idle timer: move to the slow interval
+ */
+static void idle_timer_callback(void* arg) {
+    if (ble.fast && ble.encrypted &&
+        esp_timer_get_time() - ble.last_submit_us >= HID_BLE_IDLE_MS * 1000LL) {
+        ESP_LOGD(TAG, "Idle, requesting the slow interval");
+        request_interval(false);
+    }
+}
+
+/**
+ * @brief Таймер повтора: окно открылось, задача HID может отправлять
+ * Retry timer: the window opened, the HID task may send
+ */
+static void retry_timer_callback(void* arg) {
+    emit_event(HID_TRANSPORT_EVENT_REPORT_COMPLETE, ble.retry_interface);
+}
+
+/**
+ * @brief Отложить отчет: задача HID повторит его по таймеру
+ * Defer a report: the HID task retries it on the timer
+ */
+static esp_err_t defer_report(uint8_t interface, int64_t delay_us) {
+    ble.stats.deferred++;
+    ble.retry_interface = interface;
+    esp_timer_stop(ble.retry_timer);
+    esp_timer_start_once(ble.retry_timer, delay_us > 0 ? delay_us : 1);
+    return ESP_ERR_NOT_FINISHED;
+}
+
+static int append_value(struct ble_gatt_access_ctxt* ctxt, const void* value, uint16_t length) {
+    return os_mbuf_append(ctxt->om, value, length) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/**
+ * @brief Доступ к характеристикам Report
+ * Access to Report characteristics
+ */
+static int report_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    size_t index = (const ble_report_t*)arg - ble_reports;
+
+    switch (ctxt->op) {
+        case BLE_GATT_ACCESS_OP_READ_CHR:
+            if (index == REPORT_LEDS) {
+                return append_value(ctxt, &ble.leds, sizeof(ble.leds));
+            }
+            return append_value(ctxt, ble.last_report[index], ble.last_length[index]);
+
+        case BLE_GATT_ACCESS_OP_WRITE_CHR: {
+            // Светодиоды клавиатуры - обратная связь для автонастройки темпа / Keyboard LEDs are feedback for timing auto-tune
+            uint16_t length;
+            if (index != REPORT_LEDS ||
+                ble_hs_mbuf_to_flat(ctxt->om, &ble.leds, sizeof(ble.leds), &length) != 0 || length < 1) {
+                return BLE_ATT_ERR_UNLIKELY;
+            }
+            emit_event(HID_TRANSPORT_EVENT_KEYBOARD_LEDS, ble.leds);
+            return 0;
+        }
+
+        default:
+            return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+static int report_reference_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt,
+                                   void* arg) {
+    const ble_report_t* report = (const ble_report_t*)arg;
+    return append_value(ctxt, report->reference, sizeof(report->reference));
+}
+
+/**
+ * @brief Доступ к остальным характеристикам HID, батареи и информации
+ * Access to the other HID, battery and device information characteristics
+ */
+static int static_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    static const uint8_t hid_information[] = {0x11, 0x01, 0x00, 0x02}; // HID 1.11, без страны, normally connectable / no country, normally connectable
+    static const uint8_t battery_level = 100;
+    static const uint8_t pnp_id[] = {
+        HID_BLE_VID_SOURCE,
+        HID_BLE_VID & 0xFF, HID_BLE_VID >> 8,
+        HID_BLE_PID & 0xFF, HID_BLE_PID >> 8,
+        HID_BLE_VERSION & 0xFF, HID_BLE_VERSION >> 8,
+    };
+
+    if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        // Control Point: suspend / exit suspend, отчеты и так идут по событию / reports are event-driven anyway
+        return 0;
+    }
+
+    switch (ble_uuid_u16(ctxt->chr->uuid)) {
+        case UUID_HID_INFORMATION:
+            return append_value(ctxt, hid_information, sizeof(hid_information));
+        case UUID_REPORT_MAP:
+            return append_value(ctxt, report_map, sizeof(report_map));
+        case UUID_BATTERY_LEVEL:
+            return append_value(ctxt, &battery_level, sizeof(battery_level));
+        case UUID_MANUFACTURER_NAME:
+            return append_value(ctxt, HID_BLE_MANUFACTURER, strlen(HID_BLE_MANUFACTURER));
+        case UUID_PNP_ID:
+            return append_value(ctxt, pnp_id, sizeof(pnp_id));
+        default:
+            return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+#define REPORT_REFERENCE(index) \
+    (struct ble_gatt_dsc_def[]){ \
+        {.uuid = BLE_UUID16_DECLARE(UUID_REPORT_REFERENCE), .att_flags = BLE_ATT_F_READ, \
+         .access_cb = report_reference_access, .arg = (void*)&ble_reports[index]}, \
+        {0}, \
+    }
+
+#define INPUT_REPORT(index) \
+    {.uuid = BLE_UUID16_DECLARE(UUID_REPORT), .access_cb = report_access, .arg = (void*)&ble_reports[index], \
+     .descriptors = REPORT_REFERENCE(index), .val_handle = &report_handles[index], \
+     .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_READ_ENC | BLE_GATT_CHR_F_NOTIFY}
+
+static const struct ble_gatt_svc_def gatt_services[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(UUID_SERVICE_HID),
+        .characteristics = (struct ble_gatt_chr_def[]){
+            {.uuid = BLE_UUID16_DECLARE(UUID_HID_INFORMATION), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_READ},
+            {.uuid = BLE_UUID16_DECLARE(UUID_REPORT_MAP), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_READ},
+            {.uuid = BLE_UUID16_DECLARE(UUID_HID_CONTROL_POINT), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_WRITE_NO_RSP},
+            INPUT_REPORT(REPORT_KEYBOARD),
+            INPUT_REPORT(REPORT_MOUSE),
+            INPUT_REPORT(REPORT_CONSUMER),
+            INPUT_REPORT(REPORT_SYSTEM),
+            INPUT_REPORT(REPORT_POINTER),
+            {.uuid = BLE_UUID16_DECLARE(UUID_REPORT), .access_cb = report_access,
+             .arg = (void*)&ble_reports[REPORT_LEDS], .descriptors = REPORT_REFERENCE(REPORT_LEDS),
+             .val_handle = &report_handles[REPORT_LEDS],
+             .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP |
+                      BLE_GATT_CHR_F_READ_ENC | BLE_GATT_CHR_F_WRITE_ENC},
+            {0},
+        },
+    },
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(UUID_SERVICE_BATTERY),
+        .characteristics = (struct ble_gatt_chr_def[]){
+            {.uuid = BLE_UUID16_DECLARE(UUID_BATTERY_LEVEL), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY},
+            {0},
+        },
+    },
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(UUID_SERVICE_DEVICE_INFO),
+        .characteristics = (struct ble_gatt_chr_def[]){
+            {.uuid = BLE_UUID16_DECLARE(UUID_MANUFACTURER_NAME), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_READ},
+            {.uuid = BLE_UUID16_DECLARE(UUID_PNP_ID), .access_cb = static_access,
+             .flags = BLE_GATT_CHR_F_READ},
+            {0},
+        },
+    },
+    {0},
+};
+
+static int gap_event(struct ble_gap_event* event, void* arg);
+
+/**
+ * @brief Начать рекламу HID устройства
+ * Start advertising the HID device
+ */
+static void start_advertising(void) {
+    struct ble_hs_adv_fields fields = {0};
+    static const ble_uuid16_t hid_uuid = BLE_UUID16_INIT(UUID_SERVICE_HID);
+
+    fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    fields.appearance = HID_BLE_APPEARANCE;
+    fields.appearance_is_present = 1;
+    fields.uuids16 = &hid_uuid;
+    fields.num_uuids16 = 1;
+    fields.uuids16_is_complete = 1;
+    fields.name = (const uint8_t*)HID_BLE_DEVICE_NAME;
+    fields.name_len = strlen(HID_BLE_DEVICE_NAME);
+    fields.name_is_complete = 1;
+
+    int rc = ble_gap_adv_set_fields(&fields);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Failed to set advertising data: %d", rc);
+        return;
+    }
+
+    struct ble_gap_adv_params params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+    };
+    rc = ble_gap_adv_start(ble.own_addr_type, NULL, BLE_HS_FOREVER, &params, gap_event, NULL);
+    if (rc != 0 && rc != BLE_HS_EALREADY) {
+        ESP_LOGE(TAG, "Failed to start advertising: %d", rc);
+    }
+}
+
+/**
+ * @brief События GAP (задача хоста NimBLE)
+ * GAP events (NimBLE host task)
+ */
+static int gap_event(struct ble_gap_event* event, void* arg) {
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONNECT:
+            if (event->connect.status != 0) {
+                start_advertising();
+                return 0;
+            }
+            ESP_LOGI(TAG, "Connected, handle %u", event->connect.conn_handle);
+            ble.conn_handle = event->connect.conn_handle;
+            apply_link_params(ble.conn_handle);
+            // Отчеты только по шифрованной связи / Reports only over an encrypted link
+            ble_gap_security_initiate(ble.conn_handle);
+            return 0;
+
+        case BLE_GAP_EVENT_DISCONNECT:
+            ESP_LOGI(TAG, "Disconnected, reason 0x%03X", event->disconnect.reason);
+            ble.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+            ble.encrypted = false;
+            ble.subscribed = 0;
+            ble.window.interval_us = 0;
+            esp_timer_stop(ble.idle_timer);
+            update_ready();
+            start_advertising();
+            return 0;
+
+        case BLE_GAP_EVENT_ENC_CHANGE:
+            if (event->enc_change.status != 0) {
+                ESP_LOGW(TAG, "Encryption failed: %d", event->enc_change.status);
+                ble_gap_terminate(event->enc_change.conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+                return 0;
+            }
+            ble.encrypted = true;
+            // Самый короткий интервал, какой примет хост / The shortest interval the host accepts
+            ble.fast_step = 0;
+            ble.last_submit_us = esp_timer_get_time();
+            request_interval(true);
+            esp_timer_stop(ble.idle_timer);
+            esp_timer_start_periodic(ble.idle_timer, HID_BLE_IDLE_MS * 1000ULL / 2);
+            update_ready();
+            return 0;
+
+        case BLE_GAP_EVENT_CONN_UPDATE:
+            if (event->conn_update.status == 0) {
+                apply_link_params(event->conn_update.conn_handle);
+                return 0;
+            }
+            ble.stats.rejected++;
+            if (!ble.fast) {
+                // Медленный не приняли - остаемся быстрыми / Slow was refused - stay fast
+                ble.fast = true;
+            } else if (ble.fast_step + 1u < FAST_STEP_COUNT) {
+                ble.fast_step++;
+                request_interval(true);
+            } else {
+                ESP_LOGW(TAG, "Host refused all fast intervals, keeping its own");
+            }
+            return 0;
+
+        case BLE_GAP_EVENT_SUBSCRIBE:
+            for (size_t i = 0; i < REPORT_INPUT_COUNT; i++) {
+                if (event->subscribe.attr_handle == report_handles[i]) {
+                    if (event->subscribe.cur_notify) {
+                        ble.subscribed |= 1u << i;
+                    } else {
+                        ble.subscribed &= ~(1u << i);
+                    }
+                }
+            }
+            update_ready();
+            return 0;
+
+        case BLE_GAP_EVENT_REPEAT_PAIRING: {
+            // Хост забыл бонд - удалить старый и сопрячь заново / The host lost the bond - drop ours and pair again
+            struct ble_gap_conn_desc desc;
+            if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0) {
+                ble_store_util_delete_peer(&desc.peer_id_addr);
+            }
+            return BLE_GAP_REPEAT_PAIRING_RETRY;
+        }
+
+        case BLE_GAP_EVENT_ADV_COMPLETE:
+            start_advertising();
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+static void on_sync(void) {
+    ble_hs_util_ensure_addr(0);
+    ble_hs_id_infer_auto(0, &ble.own_addr_type);
+    start_advertising();
+}
+
+static void on_reset(int reason) {
+    ESP_LOGW(TAG, "NimBLE host reset: %d", reason);
+}
+
+static void host_task(void* param) {
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+static esp_err_t ble_start(hid_transport_event_callback_t callback, void* user_data) {
+    // NVS - калибровка радио и бонды / NVS holds radio calibration and bonds
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        ret = nvs_flash_init();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nimble_port_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize NimBLE: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const esp_timer_create_args_t idle_args = {
+        .callback = idle_timer_callback,
+        .name = "ble_idle",
+    };
+    const esp_timer_create_args_t retry_args = {
+        .callback = retry_timer_callback,
+        .name = "ble_retry",
+    };
+    ret = esp_timer_create(&idle_args, &ble.idle_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_create(&retry_args, &ble.retry_timer);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create BLE timers: %s", esp_err_to_name(ret));
+        if (ble.idle_timer) {
+            esp_timer_delete(ble.idle_timer);
+            ble.idle_timer = NULL;
+        }
+        nimble_port_deinit();
+        return ret;
+    }
+
+    ble_hs_cfg.sync_cb = on_sync;
+    ble_hs_cfg.reset_cb = on_reset;
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+
+    // Just Works с бондингом и LE Secure Connections / Just Works with bonding and LE Secure Connections
+    ble_hs_cfg.sm_io_cap = BLE_SM_IO_CAP_NO_IO;
+    ble_hs_cfg.sm_bonding = 1;
+    ble_hs_cfg.sm_sc = 1;
+    ble_hs_cfg.sm_our_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+    ble_hs_cfg.sm_their_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+
+    ble_svc_gap_init();
+    ble_svc_gatt_init();
+
+    int rc = ble_gatts_count_cfg(gatt_services);
+    if (rc == 0) {
+        rc = ble_gatts_add_svcs(gatt_services);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Failed to register GATT services: %d", rc);
+        esp_timer_delete(ble.idle_timer);
+        esp_timer_delete(ble.retry_timer);
+        ble.idle_timer = NULL;
+        ble.retry_timer = NULL;
+        nimble_port_deinit();
+        return ESP_FAIL;
+    }
+
+    ble_svc_gap_device_name_set(HID_BLE_DEVICE_NAME);
+    ble_svc_gap_device_appearance_set(HID_BLE_APPEARANCE);
+    ble_store_config_init();
+
+    ble.event_callback = callback;
+    ble.event_user_data = user_data;
+    ble.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    ble.ready = false;
+    ble.window.interval_us = 0;
+    memset(&ble.stats, 0, sizeof(ble.stats));
+
+    nimble_port_freertos_init(host_task);
+
+    ESP_LOGI(TAG, "BLE HID device advertising as '%s'", HID_BLE_DEVICE_NAME);
+    return ESP_OK;
+}
+
+static void ble_stop(void) {
+    if (nimble_port_stop() == 0) {
+        nimble_port_deinit();
+    }
+    esp_timer_stop(ble.idle_timer);
+    esp_timer_stop(ble.retry_timer);
+    esp_timer_delete(ble.idle_timer);
+    esp_timer_delete(ble.retry_timer);
+    ble.idle_timer = NULL;
+    ble.retry_timer = NULL;
+    ble.event_callback = NULL;
+    ble.ready = false;
+}
+
+static esp_err_t ble_submit(uint8_t interface, uint8_t report_id, const void* report, uint16_t length) {
+    if (!ble.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t index = 0;
+    while (index < REPORT_INPUT_COUNT &&
+           (ble_reports[index].interface != interface || ble_reports[index].report_id != report_id)) {
+        index++;
+    }
+    if (index == REPORT_INPUT_COUNT || length > REPORT_MAX_LENGTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!(ble.subscribed & (1u << index))) {
+        // Хост не слушает этот отчет / The host isn't listening to this report
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now = esp_timer_get_time();
+    ble.last_submit_us = now;
+    if (!ble.fast) {
+        // Первый отчет после простоя возвращает быстрый интервал / The first report after idle brings back the fast interval
+        request_interval(true);
+    }
+
+    // Окно этого интервала полно - ждать следующего события связи / This interval's window is full - wait for the next connection event
+    int64_t open_us = hid_report_window_wait(&ble.window, now);
+    if (open_us > 0) {
+        return defer_report(interface, open_us - now);
+    }
+
+    struct os_mbuf* om = ble_hs_mbuf_from_flat(report, length);
+    if (!om) {
+        // Буферы стека заняты - повтор через интервал / Stack buffers busy - retry after an interval
+        return defer_report(interface, ble.window.interval_us);
+    }
+
+    int rc = ble_gatts_notify_custom(ble.conn_handle, report_handles[index], om);
+    if (rc != 0) {
+        return rc == BLE_HS_ENOMEM ? defer_report(interface, ble.window.interval_us) : ESP_FAIL;
+    }
+
+    memcpy(ble.last_report[index], report, length);
+    ble.last_length[index] = length;
+    ble.window.count++;
+    ble.stats.notifications++;
+
+    // Уведомление в очереди контроллера, можно отправлять следующее / The notification is queued in the controller, the next may go
+    emit_event(HID_TRANSPORT_EVENT_REPORT_COMPLETE, interface);
+    return ESP_OK;
+}
+
+void hid_ble_get_stats(hid_ble_stats_t* stats) {
+    if (stats) {
+        *stats = ble.stats;
+    }
+}
+
+#else // !CONFIG_BT_NIMBLE_ENABLED
+
+static esp_err_t ble_start(hid_transport_event_callback_t callback, void* user_data) {
+    ESP_LOGE(TAG, "NimBLE is disabled (CONFIG_BT_NIMBLE_ENABLED), use another HID transport");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static void ble_stop(void) {
+}
+
+static esp_err_t ble_submit(uint8_t interface, uint8_t report_id, const void* report, uint16_t length) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+void hid_ble_get_stats(hid_ble_stats_t* stats) {
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+#endif // CONFIG_BT_NIMBLE_ENABLED
+
+const hid_transport_t hid_transport_ble = {
+    .name = "BLE",
+    .start = ble_start,
+    .stop = ble_stop,
+    .submit = ble_submit,
+};
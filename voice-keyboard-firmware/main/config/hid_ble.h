@@ -0,0 +1,89 @@
+/**
+ * @file hid_ble.h
+ * @brief BLE HID transport header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл BLE транспорта HID
+ * Header file for the BLE HID transport
+ *
+ * hid_transport_ble - HID over GATT (HOGP) на NimBLE: сервисы HID, батареи и
+ * информации об устройстве, сопряжение Just Works с бондингом. Все отчеты
+ * описаны одной картой с ID отчетов; логические интерфейсы hid_transport.h
+ * отображаются на характеристики Report. Хост готов (CONNECTED), когда связь
+ * зашифрована и он подписан на отчеты клавиатуры; отчет завершен, когда
+ * уведомление ушло в контроллер. Собирается при CONFIG_BT_NIMBLE_ENABLED.
+ * hid_transport_ble is HID over GATT (HOGP) on NimBLE: HID, battery and device
+ * information services, Just Works pairing with bonding. All reports are
+ * described by one report map with report IDs; the logical interfaces of
+ * hid_transport.h map to Report characteristics. The host is ready (CONNECTED)
+ * once the link is encrypted and it subscribed to keyboard reports; a report
+ * completes once its notification went to the controller. Built with
+ * CONFIG_BT_NIMBLE_ENABLED.
+ *
+ * Скорость: после шифрования запрашивается самый короткий интервал связи,
+ * который примет хост (лестница от 7.5 мс; отказ - следующая ступень), и за
+ * каждый интервал в контроллер уходит до HID_BLE_NOTIFY_PER_EVENT уведомлений,
+ * которые он отправляет одним событием связи. Без отчетов HID_BLE_IDLE_MS связь
+ * переходит на медленный интервал с задержкой периферии; первый же отчет
+ * возвращает быстрый.
+ * Speed: after encryption the shortest connection interval the host accepts is
+ * requested (a ladder from 7.5 ms; a rejection moves to the next step), and each
+ * interval up to HID_BLE_NOTIFY_PER_EVENT notifications go to the controller,
+ * which sends them in one connection event. After HID_BLE_IDLE_MS without
+ * reports the link moves to a slow interval with peripheral latency; the next
+ * report brings the fast one back.
+ */
+
+#ifndef HID_BLE_H
+#define HID_BLE_H
+
+#include "hid_transport.h"
+
+// Устройство BLE / BLE device
+#define HID_BLE_DEVICE_NAME     "Voice Keyboard"
+#define HID_BLE_APPEARANCE      0x03C1    // HID Keyboard
+#define HID_BLE_MANUFACTURER    "Espressif"
+
+// PnP ID: источник VID - USB-IF / PnP ID: VID source - USB-IF
+#define HID_BLE_VID_SOURCE      0x02
+#define HID_BLE_VID             0x2E8A
+#define HID_BLE_PID             0x0001
+#define HID_BLE_VERSION         0x0100
+
+// ID отчетов в карте отчетов BLE / Report IDs in the BLE report map
+#define HID_BLE_REPORT_ID_KEYBOARD  1
+#define HID_BLE_REPORT_ID_MOUSE     2
+#define HID_BLE_REPORT_ID_CONSUMER  3
+#define HID_BLE_REPORT_ID_SYSTEM    4
+#define HID_BLE_REPORT_ID_POINTER   5
+
+// Уведомлений за интервал связи / Notifications per connection interval
+#define HID_BLE_NOTIFY_PER_EVENT    4
+// Простой до медленного интервала / Idle time before the slow interval
+#define HID_BLE_IDLE_MS             3000
+// Медленный интервал в единицах 1.25 мс: 30-50 мс / Slow interval in 1.25 ms units: 30-50 ms
+#define HID_BLE_SLOW_INTERVAL_MIN   24
+#define HID_BLE_SLOW_INTERVAL_MAX   40
+// Событий, которые периферия может пропустить в простое / Events the peripheral may skip while idle
+#define HID_BLE_SLOW_LATENCY        4
+// Таймаут связи в единицах 10 мс / Supervision timeout in 10 ms units
+#define HID_BLE_SUPERVISION_TIMEOUT 400
+
+// Статистика BLE транспорта / BLE transport statistics
+typedef struct {
+    uint32_t notifications;      // Отправлено уведомлений / Notifications sent
+    uint32_t deferred;           // Отложено до следующего интервала / Deferred to the next interval
+    uint32_t interval_us;        // Текущий интервал связи / Current connection interval
+    uint16_t latency;            // Текущая задержка периферии / Current peripheral latency
+    uint16_t updates;            // Примененных смен параметров / Parameter updates applied
+    uint16_t rejected;           // Запросов, отклоненных хостом / Requests rejected by the host
+} hid_ble_stats_t;
+
+/**
+ * @brief Получить статистику BLE транспорта
+ * Get BLE transport statistics
+ */
+void hid_ble_get_stats(hid_ble_stats_t* stats);
+
+#endif // HID_BLE_H
@@ -12,116 +12,77 @@
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
-#include "esp_usb_host.h"
-#include "usb/usb_host.h"
 
 static const char* TAG = "HID_CONFIG";
 
 // Внутренняя структура HID устройства / Internal HID device structure
 struct hid_device {
     bool initialized;
-    bool connected;
+    volatile bool connected;
+    const hid_transport_t* transport;
     
-    // USB хост / USB host
-    usb_host_client_handle_t usb_client;
-    
-    // Интерфейсы / Interfaces
-    uint8_t keyboard_interface;
-    uint8_t mouse_interface;
-    
-    // Эндпоинты / Endpoints
-    uint8_t keyboard_ep_in;
-    uint8_t mouse_ep_in;
+    // События / Events
+    hid_event_callback_t event_callback;
+    void* event_user_data;
+    volatile uint8_t keyboard_leds;
     
     // Текущие отчеты / Current reports
     hid_keyboard_report_t current_keyboard_report;
     hid_mouse_report_t current_mouse_report;
+    uint16_t current_consumer_usage;
+    uint8_t current_system_usage;
+    hid_pointer_report_t current_pointer_report;
 };
 
-// HID дескрипторы / HID descriptors
-static const uint8_t keyboard_hid_descriptor[] = {
-    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
-    0x09, 0x06,        // Usage (Keyboard)
-    0xA1, 0x01,        // Collection (Application)
-    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
-    0x19, 0xE0,        //   Usage Minimum (0xE0)
-    0x29, 0xE7,        //   Usage Maximum (0xE7)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x01,        //   Logical Maximum (1)
-    0x95, 0x08,        //   Report Count (8)
-    0x75, 0x01,        //   Report Size (1)
-    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x95, 0x01,        //   Report Count (1)
-    0x75, 0x08,        //   Report Size (8)
-    0x81, 0x03,        //   Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x95, 0x06,        //   Report Count (6)
-    0x75, 0x08,        //   Report Size (8)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x65,        //   Logical Maximum (101)
-    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
-    0x19, 0x00,        //   Usage Minimum (0x00)
-    0x29, 0x65,        //   Usage Maximum (0x65)
-    0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0xC0               // End Collection
-};
-
-static const uint8_t mouse_hid_descriptor[] = {
-    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
-    0x09, 0x02,        // Usage (Mouse)
-    0xA1, 0x01,        // Collection (Application)
-    0x09, 0x01,        //   Usage (Pointer)
-    0xA1, 0x00,        //   Collection (Physical)
-    0x05, 0x09,        //     Usage Page (Button)
-    0x19, 0x01,        //     Usage Minimum (0x01)
-    0x29, 0x03,        //     Usage Maximum (0x03)
-    0x15, 0x00,        //     Logical Minimum (0)
-    0x25, 0x01,        //     Logical Maximum (1)
-    0x95, 0x03,        //     Report Count (3)
-    0x75, 0x01,        //     Report Size (1)
-    0x81, 0x02,        //     Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x95, 0x01,        //     Report Count (1)
-    0x75, 0x05,        //     Report Size (5)
-    0x81, 0x03,        //     Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
-    0x09, 0x30,        //     Usage (X)
-    0x09, 0x31,        //     Usage (Y)
-    0x09, 0x38,        //     Usage (Wheel)
-    0x15, 0x81,        //     Logical Minimum (-127)
-    0x25, 0x7F,        //     Logical Maximum (127)
-    0x75, 0x08,        //     Report Size (8)
-    0x95, 0x03,        //     Report Count (3)
-    0x81, 0x06,        //     Input (Data,Var,Rel,No Wrap,Linear,Preferred State,No Null Position)
-    0xC0,              //   End Collection
-    0xC0               // End Collection
-};
+// Стек транспорта один, устройство тоже одно / There is one transport stack and so one device
+static struct hid_device* active_device = NULL;
 
 /**
- * @brief USB хост callback
- * USB host callback
+ * @brief Обработчик событий транспорта
+ * Transport event handler
  */
-static void usb_host_event_callback(const usb_host_client_event_msg_t* event_msg, void* arg) {
-    hid_device_handle_t handle = (hid_device_handle_t)arg;
-    
-    switch (event_msg->event) {
-        case USB_HOST_CLIENT_EVENT_NEW_DEV:
-            ESP_LOGI(TAG, "New USB device connected");
-            handle->connected = true;
+static void transport_event_callback(hid_transport_event_t event, uint8_t value, void* user_data) {
+    struct hid_device* device = (struct hid_device*)user_data;
+    hid_event_t hid_event;
+    
+    switch (event) {
+        case HID_TRANSPORT_EVENT_CONNECTED:
+            ESP_LOGI(TAG, "%s host connected", device->transport->name);
+            device->connected = true;
+            hid_event = HID_EVENT_CONNECTED;
             break;
             
-        case USB_HOST_CLIENT_EVENT_DEV_GONE:
-            ESP_LOGI(TAG, "USB device disconnected");
-            handle->connected = false;
+        case HID_TRANSPORT_EVENT_DISCONNECTED:
+            ESP_LOGI(TAG, "%s host disconnected", device->transport->name);
+            device->connected = false;
+            hid_event = HID_EVENT_DISCONNECTED;
             break;
             
-        default:
+        case HID_TRANSPORT_EVENT_REPORT_COMPLETE:
+            hid_event = HID_EVENT_REPORT_COMPLETE;
+            break;
+            
+        case HID_TRANSPORT_EVENT_KEYBOARD_LEDS:
+            device->keyboard_leds = value;
+            hid_event = HID_EVENT_KEYBOARD_LEDS;
             break;
+            
+        default:
+            return;
+    }
+    
+    if (device->event_callback) {
+        device->event_callback(hid_event, value, device->event_user_data);
     }
 }
 
-esp_err_t hid_init(hid_device_handle_t* handle) {
-    if (!handle) {
+esp_err_t hid_init(hid_device_handle_t* handle, const hid_transport_t* transport) {
+    if (!handle || !transport) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (active_device) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
     // Выделение памяти / Allocate memory
     *handle = malloc(sizeof(struct hid_device));
@@ -132,45 +93,20 @@ esp_err_t hid_init(hid_device_handle_t* handle) {
     
     // Инициализация структуры / Initialize structure
     memset(*handle, 0, sizeof(struct hid_device));
+    (*handle)->transport = transport;
+    active_device = *handle;
     
-    // Инициализация USB хоста / Initialize USB host
-    usb_host_config_t host_config = {
-        .skip_phy_setup = false,
-        .intr_flags = ESP_INTR_FLAG_LEVEL1,
-    };
-    
-    esp_err_t ret = usb_host_install(&host_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to install USB host: %s", esp_err_to_name(ret));
-        free(*handle);
-        return ret;
-    }
-    
-    // Регистрация клиента / Register client
-    const usb_host_client_config_t client_config = {
-        .is_synchronous = false,
-        .max_num_event_msg = 5,
-        .async = {
-            .client_event_callback = usb_host_event_callback,
-            .callback_arg = *handle,
-        }
-    };
-    
-    ret = usb_host_client_register(&client_config, &(*handle)->usb_client);
+    esp_err_t ret = transport->start(transport_event_callback, *handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register USB client: %s", esp_err_to_name(ret));
-        usb_host_uninstall();
+        ESP_LOGE(TAG, "Failed to start %s HID transport: %s", transport->name, esp_err_to_name(ret));
+        active_device = NULL;
         free(*handle);
         return ret;
     }
     
-    // Инициализация отчетов / Initialize reports
-    memset(&(*handle)->current_keyboard_report, 0, sizeof(hid_keyboard_report_t));
-    memset(&(*handle)->current_mouse_report, 0, sizeof(hid_mouse_report_t));
-    
     (*handle)->initialized = true;
     
-    ESP_LOGI(TAG, "HID device initialized successfully");
+    ESP_LOGI(TAG, "HID device initialized successfully (%s transport)", transport->name);
     return ESP_OK;
 }
 
@@ -180,21 +116,31 @@ esp_err_t hid_deinit(hid_device_handle_t handle) {
     }
     
     if (handle->initialized) {
-        // Дерегистрация клиента / Unregister client
-        if (handle->usb_client) {
-            usb_host_client_deregister(handle->usb_client);
-        }
-        
-        // Деинсталляция USB хоста / Uninstall USB host
-        usb_host_uninstall();
+        handle->transport->stop();
     }
     
+    active_device = NULL;
     free(handle);
     ESP_LOGI(TAG, "HID device deinitialized");
     
     return ESP_OK;
 }
 
+esp_err_t hid_set_event_callback(hid_device_handle_t handle, hid_event_callback_t callback, void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->event_callback = callback;
+    handle->event_user_data = user_data;
+    
+    return ESP_OK;
+}
+
+uint8_t hid_keyboard_get_leds(hid_device_handle_t handle) {
+    return handle ? handle->keyboard_leds : 0;
+}
+
 esp_err_t hid_keyboard_send_report(hid_device_handle_t handle, const hid_keyboard_report_t* report) {
     if (!handle || !report) {
         return ESP_ERR_INVALID_ARG;
@@ -205,8 +151,10 @@ esp_err_t hid_keyboard_send_report(hid_device_handle_t handle, const hid_keyboar
         return ESP_ERR_INVALID_STATE;
     }
     
-    // TODO: Реализация отправки отчета клавиатуры / TODO: Implement keyboard report sending
-    // Это требует реализации USB HID протокола / This requires USB HID protocol implementation
+    esp_err_t ret = handle->transport->submit(HID_INTERFACE_KEYBOARD, 0, report, sizeof(hid_keyboard_report_t));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     // Сохранение текущего отчета / Save current report
     handle->current_keyboard_report = *report;
@@ -228,8 +176,10 @@ esp_err_t hid_mouse_send_report(hid_device_handle_t handle, const hid_mouse_repo
         return ESP_ERR_INVALID_STATE;
     }
     
-    // TODO: Реализация отправки отчета мыши / TODO: Implement mouse report sending
-    // Это требует реализации USB HID протокола / This requires USB HID protocol implementation
+    esp_err_t ret = handle->transport->submit(HID_INTERFACE_MOUSE, 0, report, sizeof(hid_mouse_report_t));
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     // Сохранение текущего отчета / Save current report
     handle->current_mouse_report = *report;
@@ -240,59 +190,96 @@ esp_err_t hid_mouse_send_report(hid_device_handle_t handle, const hid_mouse_repo
     return ESP_OK;
 }
 
-esp_err_t hid_keyboard_press_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier) {
+esp_err_t hid_consumer_send_report(hid_device_handle_t handle, uint16_t usage) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    hid_keyboard_report_t report = {0};
-    report.modifier = modifier;
-    report.keycode[0] = key;
+    if (!handle->connected) {
+        ESP_LOGW(TAG, "HID device not connected");
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    return hid_keyboard_send_report(handle, &report);
+    // Отчет - 16-битный код, little-endian / The report is a 16-bit usage, little-endian
+    uint8_t report[2] = {usage & 0xFF, usage >> 8};
+    esp_err_t ret = handle->transport->submit(HID_INTERFACE_CONTROL, HID_REPORT_ID_CONSUMER, report, sizeof(report));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    handle->current_consumer_usage = usage;
+    
+    ESP_LOGD(TAG, "Consumer report sent: usage=0x%03X", usage);
+    
+    return ESP_OK;
 }
 
-esp_err_t hid_keyboard_release_key(hid_device_handle_t handle) {
+esp_err_t hid_system_send_report(hid_device_handle_t handle, uint8_t usage) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    hid_keyboard_report_t report = {0};
-    return hid_keyboard_send_report(handle, &report);
+    if (!handle->connected) {
+        ESP_LOGW(TAG, "HID device not connected");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = handle->transport->submit(HID_INTERFACE_CONTROL, HID_REPORT_ID_SYSTEM, &usage, sizeof(usage));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    handle->current_system_usage = usage;
+    
+    ESP_LOGD(TAG, "System report sent: usage=0x%02X", usage);
+    
+    return ESP_OK;
 }
 
-esp_err_t hid_keyboard_click_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier) {
-    if (!handle) {
+esp_err_t hid_pointer_send_report(hid_device_handle_t handle, const hid_pointer_report_t* report) {
+    if (!handle || !report) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    esp_err_t ret = hid_keyboard_press_key(handle, key, modifier);
-    if (ret == ESP_OK) {
-        vTaskDelay(pdMS_TO_TICKS(50)); // Задержка для эмуляции клика / Delay for click simulation
-        ret = hid_keyboard_release_key(handle);
+    if (!handle->connected) {
+        ESP_LOGW(TAG, "HID device not connected");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Кнопки (клики идут через относительную мышь), X, Y little-endian
+    // Buttons (clicks go through the relative mouse), X, Y little-endian
+    uint8_t data[5] = {0, report->x & 0xFF, report->x >> 8, report->y & 0xFF, report->y >> 8};
+    esp_err_t ret = handle->transport->submit(HID_INTERFACE_CONTROL, HID_REPORT_ID_POINTER, data, sizeof(data));
+    if (ret != ESP_OK) {
+        return ret;
     }
     
-    return ret;
+    handle->current_pointer_report = *report;
+    
+    ESP_LOGD(TAG, "Pointer report sent: x=%u, y=%u", report->x, report->y);
+    
+    return ESP_OK;
 }
 
-esp_err_t hid_mouse_click(hid_device_handle_t handle, hid_mouse_button_t button) {
+esp_err_t hid_keyboard_press_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    hid_mouse_report_t report = {0};
-    report.buttons = button;
-    
-    esp_err_t ret = hid_mouse_send_report(handle, &report);
-    if (ret == ESP_OK) {
-        vTaskDelay(pdMS_TO_TICKS(50)); // Задержка для эмуляции клика / Delay for click simulation
-        
-        // Отпускание кнопки / Release button
-        report.buttons = 0;
-        ret = hid_mouse_send_report(handle, &report);
+    hid_keyboard_report_t report = {0};
+    report.modifier = modifier;
+    report.keycode[0] = key;
+    
+    return hid_keyboard_send_report(handle, &report);
+}
+
+esp_err_t hid_keyboard_release_key(hid_device_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    return ret;
+    hid_keyboard_report_t report = {0};
+    return hid_keyboard_send_report(handle, &report);
 }
 
 esp_err_t hid_mouse_move(hid_device_handle_t handle, int8_t x, int8_t y) {
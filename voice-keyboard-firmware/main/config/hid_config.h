@@ -14,30 +14,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
-
-// HID интерфейсы / HID interfaces
-#define HID_INTERFACE_KEYBOARD    0
-#define HID_INTERFACE_MOUSE       1
-#define HID_INTERFACE_COUNT       2
-
-// HID конфигурация USB / HID USB configuration
-#define HID_USB_VID             0x2E8A    // Espressif VID
-#define HID_USB_PID             0x0001    // Custom PID
-#define HID_USB_MANUFACTURER    "Espressif"
-#define HID_USB_PRODUCT         "Voice Keyboard"
-#define HID_USB_SERIAL          "123456"
-
-// Клавиатура HID / Keyboard HID
-#define HID_KEYBOARD_EP_IN      0x81      // Endpoint IN
-#define HID_KEYBOARD_EP_OUT     0x01      // Endpoint OUT
-#define HID_KEYBOARD_EP_SIZE    8         // Endpoint size
-#define HID_KEYBOARD_INTERVAL   10        // Polling interval (ms)
-
-// Мышь HID / Mouse HID
-#define HID_MOUSE_EP_IN        0x82      // Endpoint IN
-#define HID_MOUSE_EP_OUT       0x02      // Endpoint OUT
-#define HID_MOUSE_EP_SIZE      4         // Endpoint size
-#define HID_MOUSE_INTERVAL     10        // Polling interval (ms)
+#include "hid_transport.h"
 
 // Модификаторы клавиатуры / Keyboard modifiers
 typedef enum {
@@ -94,6 +71,17 @@ typedef enum {
     HID_KEY_BACKSPACE = 0x2A,
     HID_KEY_TAB = 0x2B,
     HID_KEY_SPACE = 0x2C,
+    HID_KEY_MINUS = 0x2D,
+    HID_KEY_EQUAL = 0x2E,
+    HID_KEY_LEFT_BRACKET = 0x2F,
+    HID_KEY_RIGHT_BRACKET = 0x30,
+    HID_KEY_BACKSLASH = 0x31,
+    HID_KEY_SEMICOLON = 0x33,
+    HID_KEY_APOSTROPHE = 0x34,
+    HID_KEY_GRAVE = 0x35,
+    HID_KEY_COMMA = 0x36,
+    HID_KEY_PERIOD = 0x37,
+    HID_KEY_SLASH = 0x38,
     HID_KEY_CAPS_LOCK = 0x39,
     HID_KEY_F1 = 0x3A,
     HID_KEY_F2 = 0x3B,
@@ -113,6 +101,24 @@ typedef enum {
     HID_KEY_UP_ARROW = 0x52,
 } hid_keyboard_key_t;
 
+// Коды Consumer Control / Consumer Control usages
+typedef enum {
+    HID_CONSUMER_SCAN_NEXT    = 0x00B5,
+    HID_CONSUMER_SCAN_PREV    = 0x00B6,
+    HID_CONSUMER_PLAY_PAUSE   = 0x00CD,
+    HID_CONSUMER_MUTE         = 0x00E2,
+    HID_CONSUMER_VOLUME_UP    = 0x00E9,
+    HID_CONSUMER_VOLUME_DOWN  = 0x00EA,
+    HID_CONSUMER_AL_LOCK      = 0x019E   // AL Terminal Lock/Screensaver
+} hid_consumer_usage_t;
+
+// Коды System Control / System Control usages
+typedef enum {
+    HID_SYSTEM_POWER_DOWN     = 0x81,
+    HID_SYSTEM_SLEEP          = 0x82,
+    HID_SYSTEM_WAKE_UP        = 0x83
+} hid_system_usage_t;
+
 // Кнопки мыши / Mouse buttons
 typedef enum {
     HID_MOUSE_BUTTON_LEFT   = 0x01,
@@ -120,11 +126,14 @@ typedef enum {
     HID_MOUSE_BUTTON_MIDDLE = 0x04
 } hid_mouse_button_t;
 
+// Клавиш в отчете клавиатуры (6KRO) / Keys in a keyboard report (6KRO)
+#define HID_KEYBOARD_MAX_KEYS   6
+
 // Отчет клавиатуры / Keyboard report
 typedef struct {
     uint8_t modifier;      // Модификаторы / Modifiers
     uint8_t reserved;      // Зарезервировано / Reserved
-    uint8_t keycode[6];    // Коды клавиш / Key codes
+    uint8_t keycode[HID_KEYBOARD_MAX_KEYS]; // Коды клавиш / Key codes
 } hid_keyboard_report_t;
 
 // Отчет мыши / Mouse report
@@ -136,14 +145,47 @@ typedef struct {
     int8_t pan;            // Pan
 } hid_mouse_report_t;
 
+// Наибольшая абсолютная координата (край экрана) / Largest absolute coordinate (screen edge)
+#define HID_POINTER_MAX         32767
+
+// Абсолютная позиция указателя, доля экрана 0..HID_POINTER_MAX / Absolute pointer position, screen fraction 0..HID_POINTER_MAX
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} hid_pointer_report_t;
+
 // Дескриптор HID / HID handle
 typedef struct hid_device* hid_device_handle_t;
 
+// Светодиоды клавиатуры / Keyboard LEDs
+#define HID_LED_NUM_LOCK        0x01
+#define HID_LED_CAPS_LOCK       0x02
+#define HID_LED_SCROLL_LOCK     0x04
+
+// События HID устройства / HID device events
+typedef enum {
+    HID_EVENT_CONNECTED,         // Хост подключен / Host connected
+    HID_EVENT_DISCONNECTED,      // Хост отключен / Host disconnected
+    HID_EVENT_REPORT_COMPLETE,   // Хост забрал отчет (value - интерфейс) / The host took a report (value - interface)
+    HID_EVENT_KEYBOARD_LEDS      // Светодиоды от хоста (value - HID_LED_*) / LEDs from the host (value - HID_LED_*)
+} hid_event_t;
+
+/**
+ * @brief Callback событий HID устройства
+ * HID device event callback
+ *
+ * Вызывается из задачи стека транспорта, не из прерывания.
+ * Called from the transport stack task, not from an interrupt.
+ */
+typedef void (*hid_event_callback_t)(hid_event_t event, uint8_t value, void* user_data);
+
 /**
  * @brief Инициализация HID устройства
  * Initialize HID device
+ *
+ * @param transport Транспорт отчетов (hid_transport.h) / Report transport (hid_transport.h)
  */
-esp_err_t hid_init(hid_device_handle_t* handle);
+esp_err_t hid_init(hid_device_handle_t* handle, const hid_transport_t* transport);
 
 /**
  * @brief Деинициализация HID устройства
@@ -151,9 +193,27 @@ esp_err_t hid_init(hid_device_handle_t* handle);
  */
 esp_err_t hid_deinit(hid_device_handle_t handle);
 
+/**
+ * @brief Установить callback событий
+ * Set event callback
+ *
+ * Следующий отчет стоит отправлять после HID_EVENT_REPORT_COMPLETE предыдущего.
+ * The next report should be submitted after HID_EVENT_REPORT_COMPLETE of the previous one.
+ */
+esp_err_t hid_set_event_callback(hid_device_handle_t handle, hid_event_callback_t callback, void* user_data);
+
+/**
+ * @brief Светодиоды клавиатуры, заданные хостом
+ * Keyboard LEDs set by the host
+ */
+uint8_t hid_keyboard_get_leds(hid_device_handle_t handle);
+
 /**
  * @brief Отправить отчет клавиатуры
  * Send keyboard report
+ *
+ * @return ESP_ERR_NOT_FINISHED если эндпоинт занят предыдущим отчетом
+ *         ESP_ERR_NOT_FINISHED if the endpoint is busy with the previous report
  */
 esp_err_t hid_keyboard_send_report(hid_device_handle_t handle, const hid_keyboard_report_t* report);
 
@@ -164,28 +224,39 @@ esp_err_t hid_keyboard_send_report(hid_device_handle_t handle, const hid_keyboar
 esp_err_t hid_mouse_send_report(hid_device_handle_t handle, const hid_mouse_report_t* report);
 
 /**
- * @brief Нажать клавишу
- * Press key
+ * @brief Отправить отчет Consumer Control (0 - отпустить)
+ * Send Consumer Control report (0 - release)
  */
-esp_err_t hid_keyboard_press_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier);
+esp_err_t hid_consumer_send_report(hid_device_handle_t handle, uint16_t usage);
 
 /**
- * @brief Отпустить клавишу
- * Release key
+ * @brief Отправить отчет System Control (0 - отпустить)
+ * Send System Control report (0 - release)
  */
-esp_err_t hid_keyboard_release_key(hid_device_handle_t handle);
+esp_err_t hid_system_send_report(hid_device_handle_t handle, uint8_t usage);
 
 /**
- * @brief Нажать и отпустить клавишу
- * Press and release key
+ * @brief Поставить указатель в абсолютную позицию
+ * Put the pointer at an absolute position
+ *
+ * Отдельная коллекция абсолютного указателя; хост отображает ее на основной
+ * экран (или на весь рабочий стол).
+ * A separate absolute pointer collection; the host maps it to the primary
+ * screen (or to the whole desktop).
  */
-esp_err_t hid_keyboard_click_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier);
+esp_err_t hid_pointer_send_report(hid_device_handle_t handle, const hid_pointer_report_t* report);
 
 /**
- * @brief Кликнуть мышью
- * Click mouse
+ * @brief Нажать клавишу
+ * Press key
  */
-esp_err_t hid_mouse_click(hid_device_handle_t handle, hid_mouse_button_t button);
+esp_err_t hid_keyboard_press_key(hid_device_handle_t handle, hid_keyboard_key_t key, uint8_t modifier);
+
+/**
+ * @brief Отпустить клавишу
+ * Release key
+ */
+esp_err_t hid_keyboard_release_key(hid_device_handle_t handle);
 
 /**
  * @brief Двинуть мышью
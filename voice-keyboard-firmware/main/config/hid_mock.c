@@ -0,0 +1,261 @@
+/**
+ * @file hid_mock.c
+ * @brief Recording HID transport implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация записывающего транспорта HID
+ * Implementation of the recording HID transport
+ */
+
+#include "hid_mock.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char* TAG = "HID_MOCK";
+
+// Эмуляция светодиодов хоста / Host LED emulation
+#define MOCK_KEY_CAPS_LOCK  0x39
+#define MOCK_LED_CAPS_LOCK  0x02
+
+// Состояние эмулируемого хоста / Emulated host state
+typedef struct {
+    hid_transport_event_callback_t event_callback;
+    void* event_user_data;
+
+    // Завершение через интервал опроса / Completion after the polling interval
+    esp_timer_handle_t timer;
+    uint32_t interval_us;
+    volatile bool busy;
+    uint8_t interface;
+
+    // Эмуляция BLE: окно отчетов на событие связи / BLE emulation: report window per connection event
+    hid_report_window_t window;
+
+    // Светодиоды / LEDs
+    bool caps_down;
+    bool leds_changed;
+    uint8_t leds;
+
+    // Запись / Recording
+    SemaphoreHandle_t lock;
+    hid_mock_record_t* records;
+    size_t head;                 // Самая старая запись / Oldest record
+    size_t count;
+    hid_mock_stats_t stats;
+} hid_mock_t;
+
+static hid_mock_t mock = {.interval_us = HID_MOCK_INTERVAL_US};
+
+static void emit_event(hid_transport_event_t event, uint8_t value) {
+    if (mock.event_callback) {
+        mock.event_callback(event, value, mock.event_user_data);
+    }
+}
+
+/**
+ * @brief Таймер: хост "забрал" отчет
+ * Timer: the host "took" the report
+ */
+static void mock_timer_callback(void* arg) {
+    (void)arg;  // Состояние в mock / The state lives in mock
+
+    // В режиме BLE таймер будит отправителя к следующему окну / In BLE mode the timer wakes the sender for the next window
+    mock.busy = false;
+    emit_event(HID_TRANSPORT_EVENT_REPORT_COMPLETE, mock.interface);
+
+    if (mock.leds_changed) {
+        mock.leds_changed = false;
+        emit_event(HID_TRANSPORT_EVENT_KEYBOARD_LEDS, mock.leds);
+    }
+}
+
+/**
+ * @brief Записать отчет в кольцевой буфер
+ * Record a report in the ring buffer
+ */
+static void record_report(uint8_t interface, uint8_t report_id, const void* report, uint16_t length,
+                          int64_t timestamp_us, int64_t delivered_us) {
+    xSemaphoreTake(mock.lock, portMAX_DELAY);
+
+    if (mock.count == HID_MOCK_CAPACITY) {
+        mock.head = (mock.head + 1) % HID_MOCK_CAPACITY;
+        mock.count--;
+        mock.stats.overwritten++;
+    }
+
+    hid_mock_record_t* record = &mock.records[(mock.head + mock.count) % HID_MOCK_CAPACITY];
+    record->timestamp_us = timestamp_us;
+    record->delivered_us = delivered_us;
+    record->interface = interface;
+    record->report_id = report_id;
+    record->length = length < HID_MOCK_REPORT_MAX_LENGTH ? length : HID_MOCK_REPORT_MAX_LENGTH;
+    memcpy(record->data, report, record->length);
+    mock.count++;
+    mock.stats.recorded++;
+
+    xSemaphoreGive(mock.lock);
+}
+
+static esp_err_t mock_submit(uint8_t interface, uint8_t report_id, const void* report, uint16_t length) {
+    if (!mock.records) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t delivered_us;
+    bool ble = mock.window.interval_us > 0;
+
+    if (ble) {
+        // Окно полно - ждать следующего события связи / Window is full - wait for the next connection event
+        int64_t open_us = hid_report_window_wait(&mock.window, now);
+        if (open_us > 0) {
+            mock.stats.busy++;
+            mock.interface = interface;
+            esp_timer_stop(mock.timer);
+            esp_timer_start_once(mock.timer, open_us - now);
+            return ESP_ERR_NOT_FINISHED;
+        }
+        mock.window.count++;
+        delivered_us = mock.window.start_us + mock.window.interval_us;
+    } else {
+        if (mock.busy) {
+            mock.stats.busy++;
+            return ESP_ERR_NOT_FINISHED;
+        }
+        delivered_us = now + mock.interval_us;
+    }
+
+    if (interface == HID_INTERFACE_KEYBOARD && length >= 8) {
+        const uint8_t* keys = (const uint8_t*)report + 2;
+        bool caps_down = memchr(keys, MOCK_KEY_CAPS_LOCK, 6) != NULL;
+        if (caps_down && !mock.caps_down) {
+            mock.leds ^= MOCK_LED_CAPS_LOCK;
+            mock.leds_changed = true;
+        }
+        mock.caps_down = caps_down;
+    }
+
+    record_report(interface, report_id, report, length, now, delivered_us);
+
+    if (ble) {
+        // Уведомление ушло в очередь контроллера / The notification went to the controller queue
+        emit_event(HID_TRANSPORT_EVENT_REPORT_COMPLETE, interface);
+        if (mock.leds_changed) {
+            mock.leds_changed = false;
+            emit_event(HID_TRANSPORT_EVENT_KEYBOARD_LEDS, mock.leds);
+        }
+        return ESP_OK;
+    }
+
+    mock.busy = true;
+    mock.interface = interface;
+    esp_err_t ret = esp_timer_start_once(mock.timer, mock.interval_us);
+    if (ret != ESP_OK) {
+        mock.busy = false;
+    }
+    return ret;
+}
+
+static esp_err_t mock_start(hid_transport_event_callback_t callback, void* user_data) {
+    mock.records = calloc(HID_MOCK_CAPACITY, sizeof(hid_mock_record_t));
+    mock.lock = xSemaphoreCreateMutex();
+    if (!mock.records || !mock.lock) {
+        ESP_LOGE(TAG, "Failed to allocate the report recorder");
+        free(mock.records);
+        mock.records = NULL;
+        if (mock.lock) {
+            vSemaphoreDelete(mock.lock);
+            mock.lock = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = mock_timer_callback,
+        .name = "hid_mock",
+    };
+
+    esp_err_t ret = esp_timer_create(&timer_args, &mock.timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create mock timer: %s", esp_err_to_name(ret));
+        free(mock.records);
+        mock.records = NULL;
+        vSemaphoreDelete(mock.lock);
+        mock.lock = NULL;
+        return ret;
+    }
+
+    mock.event_callback = callback;
+    mock.event_user_data = user_data;
+    mock.busy = false;
+    mock.window.start_us = 0;
+    mock.window.count = 0;
+    mock.head = 0;
+    mock.count = 0;
+    memset(&mock.stats, 0, sizeof(mock.stats));
+
+    ESP_LOGW(TAG, "HID reports go to the recorder (%s, interval %u us)",
+             mock.window.interval_us ? "BLE" : "USB",
+             (unsigned)(mock.window.interval_us ? mock.window.interval_us : mock.interval_us));
+    emit_event(HID_TRANSPORT_EVENT_CONNECTED, 0);
+    return ESP_OK;
+}
+
+static void mock_stop(void) {
+    esp_timer_stop(mock.timer);
+    esp_timer_delete(mock.timer);
+    mock.timer = NULL;
+    mock.event_callback = NULL;
+
+    vSemaphoreDelete(mock.lock);
+    mock.lock = NULL;
+    free(mock.records);
+    mock.records = NULL;
+}
+
+size_t hid_mock_read(hid_mock_record_t* records, size_t max_records) {
+    if (!records || !mock.records) {
+        return 0;
+    }
+
+    xSemaphoreTake(mock.lock, portMAX_DELAY);
+
+    size_t count = mock.count < max_records ? mock.count : max_records;
+    for (size_t i = 0; i < count; i++) {
+        records[i] = mock.records[(mock.head + i) % HID_MOCK_CAPACITY];
+    }
+    mock.head = (mock.head + count) % HID_MOCK_CAPACITY;
+    mock.count -= count;
+
+    xSemaphoreGive(mock.lock);
+    return count;
+}
+
+void hid_mock_set_interval(uint32_t interval_us) {
+    mock.interval_us = interval_us > 0 ? interval_us : 1;
+}
+
+void hid_mock_set_connection(uint32_t interval_us, uint8_t reports_per_event) {
+    mock.window.interval_us = interval_us;
+    mock.window.limit = reports_per_event > 0 ? reports_per_event : 1;
+    mock.window.count = 0;
+}
+
+void hid_mock_get_stats(hid_mock_stats_t* stats) {
+    if (stats) {
+        *stats = mock.stats;
+    }
+}
+
+const hid_transport_t hid_transport_mock = {
+    .name = "mock",
+    .start = mock_start,
+    .stop = mock_stop,
+    .submit = mock_submit,
+};
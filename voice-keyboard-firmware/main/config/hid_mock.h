@@ -0,0 +1,90 @@
+/**
+ * @file hid_mock.h
+ * @brief Recording HID transport header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл записывающего транспорта HID
+ * Header file for the recording HID transport
+ *
+ * hid_transport_mock ведет себя как хост с интервалом опроса: отчет
+ * "забирается" через заданный интервал, Caps Lock переключает светодиод (для
+ * автонастройки темпа). Каждый отчет записывается в кольцевой буфер с меткой
+ * esp_timer_get_time(), поэтому задержку и пропускную способность вывода HID
+ * можно мерить без железа, в том числе на Linux хосте.
+ * hid_transport_mock behaves like a host with a polling interval: a report is
+ * "taken" after the configured interval, and Caps Lock toggles the LED (for
+ * timing auto-tune). Every report is recorded in a ring buffer with its
+ * esp_timer_get_time() stamp, so HID output latency and throughput can be
+ * measured without hardware, a Linux host included.
+ *
+ * В режиме BLE (hid_mock_set_connection) хост принимает не больше N отчетов
+ * за событие связи, как hid_transport_ble, и каждая запись получает время
+ * события, в которое отчет дошел бы до хоста.
+ * In BLE mode (hid_mock_set_connection) the host takes at most N reports per
+ * connection event, like hid_transport_ble, and every record gets the time of
+ * the event at which the report would reach the host.
+ */
+
+#ifndef HID_MOCK_H
+#define HID_MOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hid_transport.h"
+
+// Записей в кольцевом буфере (старые перезаписываются) / Ring buffer records (the oldest are overwritten)
+#define HID_MOCK_CAPACITY           256
+// Максимальная длина записанного отчета / Maximum recorded report length
+#define HID_MOCK_REPORT_MAX_LENGTH  8
+// Интервал опроса по умолчанию (как у USB) / Default polling interval (as on USB)
+#define HID_MOCK_INTERVAL_US        1000
+
+// Записанный отчет / Recorded report
+typedef struct {
+    int64_t timestamp_us;        // Время отправки / Submit time
+    int64_t delivered_us;        // Время доставки хосту / Delivery time at the host
+    uint8_t interface;           // HID_INTERFACE_*
+    uint8_t report_id;           // HID_REPORT_ID_* (0 - без ID / none)
+    uint8_t length;              // Байт в data / Bytes in data
+    uint8_t data[HID_MOCK_REPORT_MAX_LENGTH];
+} hid_mock_record_t;
+
+// Статистика записи / Recording statistics
+typedef struct {
+    uint32_t recorded;           // Записано отчетов / Reports recorded
+    uint32_t overwritten;        // Перезаписано непрочитанных / Unread records overwritten
+    uint32_t busy;               // Отказов: предыдущий не забран или окно полно / Rejections: previous not taken or window full
+} hid_mock_stats_t;
+
+/**
+ * @brief Забрать записанные отчеты (от старых к новым)
+ * Take the recorded reports (oldest first)
+ *
+ * @return Число записей в records / Number of records in records
+ */
+size_t hid_mock_read(hid_mock_record_t* records, size_t max_records);
+
+/**
+ * @brief Задать интервал опроса эмулируемого хоста
+ * Set the polling interval of the emulated host
+ */
+void hid_mock_set_interval(uint32_t interval_us);
+
+/**
+ * @brief Эмулировать связь BLE
+ * Emulate a BLE link
+ *
+ * @param interval_us Интервал связи (0 - обратно к опросу USB)
+ *                    Connection interval (0 - back to USB polling)
+ * @param reports_per_event Отчетов за событие связи / Reports per connection event
+ */
+void hid_mock_set_connection(uint32_t interval_us, uint8_t reports_per_event);
+
+/**
+ * @brief Получить статистику записи
+ * Get recording statistics
+ */
+void hid_mock_get_stats(hid_mock_stats_t* stats);
+
+#endif // HID_MOCK_H
@@ -0,0 +1,124 @@
+/**
+ * @file hid_transport.h
+ * @brief HID transport interface header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл интерфейса транспорта HID
+ * Header file for the HID transport interface
+ *
+ * Транспорт доставляет готовые отчеты хосту и сообщает о подключении и о
+ * завершении передачи. Отчет адресуется логическим интерфейсом и ID отчета
+ * (как у составного USB устройства); бэкенд сам отображает их на свои
+ * эндпоинты или характеристики GATT. Бэкенды: USB (TinyUSB), BLE (HID over
+ * GATT на NimBLE) и mock, который записывает отчеты с метками времени.
+ * A transport delivers ready reports to the host and reports connection state
+ * and transfer completion. A report is addressed by a logical interface and a
+ * report ID (as on the composite USB device); the backend maps them to its own
+ * endpoints or GATT characteristics. Backends: USB (TinyUSB), BLE (HID over
+ * GATT on NimBLE) and a mock that records reports with timestamps.
+ */
+
+#ifndef HID_TRANSPORT_H
+#define HID_TRANSPORT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Логические HID интерфейсы / Logical HID interfaces
+#define HID_INTERFACE_KEYBOARD    0
+#define HID_INTERFACE_MOUSE       1
+#define HID_INTERFACE_CONTROL     2
+#define HID_INTERFACE_COUNT       3
+
+// ID отчетов интерфейса управления / Control interface report IDs
+#define HID_REPORT_ID_CONSUMER    1
+#define HID_REPORT_ID_SYSTEM      2
+#define HID_REPORT_ID_POINTER     3
+
+// События транспорта / Transport events
+typedef enum {
+    HID_TRANSPORT_EVENT_CONNECTED,       // Хост готов принимать отчеты / The host is ready for reports
+    HID_TRANSPORT_EVENT_DISCONNECTED,    // Хост отключен / The host is gone
+    HID_TRANSPORT_EVENT_REPORT_COMPLETE, // Хост забрал отчет (value - интерфейс) / The host took a report (value - interface)
+    HID_TRANSPORT_EVENT_KEYBOARD_LEDS    // Хост прислал светодиоды клавиатуры (value - биты) / The host sent keyboard LEDs (value - bits)
+} hid_transport_event_t;
+
+/**
+ * @brief Callback событий транспорта (из задачи стека или таймера, не из прерывания)
+ * Transport event callback (from a stack or timer task, not from an interrupt)
+ */
+typedef void (*hid_transport_event_callback_t)(hid_transport_event_t event, uint8_t value, void* user_data);
+
+// Бэкенд транспорта / Transport backend
+typedef struct {
+    const char* name;
+
+    /**
+     * @brief Запустить транспорт
+     * Start the transport
+     */
+    esp_err_t (*start)(hid_transport_event_callback_t callback, void* user_data);
+
+    /**
+     * @brief Остановить транспорт
+     * Stop the transport
+     */
+    void (*stop)(void);
+
+    /**
+     * @brief Отправить отчет
+     * Submit a report
+     *
+     * report_id 0 - интерфейс без ID отчетов (клавиатура, мышь).
+     * report_id 0 - an interface without report IDs (keyboard, mouse).
+     *
+     * @return ESP_ERR_NOT_FINISHED если предыдущий отчет еще не забран или окно
+     *         интервала связи полно (REPORT_COMPLETE придет, когда можно повторить),
+     *         ESP_ERR_INVALID_STATE если хост не готов
+     *         ESP_ERR_NOT_FINISHED if the previous report wasn't taken yet or the
+     *         connection interval's window is full (REPORT_COMPLETE comes when a
+     *         retry may go), ESP_ERR_INVALID_STATE if the host is not ready
+     */
+    esp_err_t (*submit)(uint8_t interface, uint8_t report_id, const void* report, uint16_t length);
+} hid_transport_t;
+
+// Окно отчетов на интервал связи (BLE) / Report window per connection interval (BLE)
+typedef struct {
+    uint32_t interval_us;        // Интервал связи (0 - без окна) / Connection interval (0 - no window)
+    uint8_t limit;               // Отчетов на интервал / Reports per interval
+    uint8_t count;               // Отправлено в текущем окне / Sent in the current window
+    int64_t start_us;            // Начало текущего окна / Start of the current window
+} hid_report_window_t;
+
+/**
+ * @brief Есть ли место в окне текущего интервала
+ * Whether the current interval's window has room
+ *
+ * Окна идут по сетке интервала, так что за одно событие связи хост получает
+ * не больше limit отчетов, а очередь контроллера не растет. После отправки
+ * вызывающий увеличивает count.
+ * Windows follow the interval grid, so the host gets at most limit reports per
+ * connection event and the controller queue does not grow. After sending the
+ * caller increments count.
+ *
+ * @return 0 если место есть, иначе время открытия следующего окна
+ *         0 if there is room, otherwise the time the next window opens
+ */
+static inline int64_t hid_report_window_wait(hid_report_window_t* window, int64_t now_us) {
+    if (window->interval_us == 0) {
+        return 0;
+    }
+    if (now_us - window->start_us >= window->interval_us) {
+        window->start_us = now_us - (now_us - window->start_us) % window->interval_us;
+        window->count = 0;
+    }
+    return window->count < window->limit ? 0 : window->start_us + window->interval_us;
+}
+
+// Бэкенды (hid_usb.c, hid_ble.c, hid_mock.c) / Backends (hid_usb.c, hid_ble.c, hid_mock.c)
+extern const hid_transport_t hid_transport_usb;
+extern const hid_transport_t hid_transport_ble;
+extern const hid_transport_t hid_transport_mock;
+
+#endif // HID_TRANSPORT_H
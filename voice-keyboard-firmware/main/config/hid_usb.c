@@ -0,0 +1,301 @@
+/**
+ * @file hid_usb.c
+ * @brief USB HID transport implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация USB транспорта HID
+ * Implementation of the USB HID transport
+ */
+
+#include "hid_usb.h"
+#include <stdbool.h>
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+
+#if SOC_USB_OTG_SUPPORTED
+#include "tinyusb.h"
+#include "class/hid/hid_device.h"
+#endif
+
+static const char* TAG = "HID_USB";
+
+#if SOC_USB_OTG_SUPPORTED
+
+// Получатель событий / Event receiver
+static hid_transport_event_callback_t event_callback = NULL;
+static void* event_user_data = NULL;
+
+static void emit_event(hid_transport_event_t event, uint8_t value) {
+    if (event_callback) {
+        event_callback(event, value, event_user_data);
+    }
+}
+
+// HID дескрипторы / HID descriptors
+static const uint8_t keyboard_hid_descriptor[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x06,        // Usage (Keyboard)
+    0xA1, 0x01,        // Collection (Application)
+    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+    0x19, 0xE0,        //   Usage Minimum (0xE0)
+    0x29, 0xE7,        //   Usage Maximum (0xE7)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x95, 0x08,        //   Report Count (8)
+    0x75, 0x01,        //   Report Size (1)
+    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x08,        //   Report Size (8)
+    0x81, 0x03,        //   Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x05, 0x08,        //   Usage Page (LEDs)
+    0x19, 0x01,        //   Usage Minimum (Num Lock)
+    0x29, 0x05,        //   Usage Maximum (Kana)
+    0x95, 0x05,        //   Report Count (5)
+    0x75, 0x01,        //   Report Size (1)
+    0x91, 0x02,        //   Output (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x03,        //   Report Size (3)
+    0x91, 0x03,        //   Output (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+    0x95, 0x06,        //   Report Count (6)
+    0x75, 0x08,        //   Report Size (8)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x65,        //   Logical Maximum (101)
+    0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+    0x19, 0x00,        //   Usage Minimum (0x00)
+    0x29, 0x65,        //   Usage Maximum (0x65)
+    0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0xC0               // End Collection
+};
+
+static const uint8_t mouse_hid_descriptor[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x05,        //     Report Size (5)
+    0x81, 0x03,        //     Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x06,        //     Input (Data,Var,Rel,No Wrap,Linear,Preferred State,No Null Position)
+    0x05, 0x0C,        //     Usage Page (Consumer)
+    0x0A, 0x38, 0x02,  //     Usage (AC Pan)
+    0x95, 0x01,        //     Report Count (1)
+    0x81, 0x06,        //     Input (Data,Var,Rel,No Wrap,Linear,Preferred State,No Null Position)
+    0xC0,              //   End Collection
+    0xC0               // End Collection
+};
+
+// Массивы с кодом usage в отчете: действие - один отчет, 0 - отпущено
+// Arrays carrying the usage itself: an action is one report, 0 - released
+static const uint8_t control_hid_descriptor[] = {
+    0x05, 0x0C,        // Usage Page (Consumer)
+    0x09, 0x01,        // Usage (Consumer Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_REPORT_ID_CONSUMER, //   Report ID (1)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xFF, 0x03,  //   Logical Maximum (1023)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x2A, 0xFF, 0x03,  //   Usage Maximum (1023)
+    0x75, 0x10,        //   Report Size (16)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0xC0,              // End Collection
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x80,        // Usage (Sys Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_REPORT_ID_SYSTEM, //   Report ID (2)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xB7, 0x00,  //   Logical Maximum (183)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0xB7,        //   Usage Maximum (0xB7)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0xC0,              // End Collection
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, HID_REPORT_ID_POINTER, //   Report ID (3)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x05,        //     Report Size (5)
+    0x81, 0x03,        //     Input (Const,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0xC0,              //   End Collection
+    0xC0               // End Collection
+};
+
+// Составное устройство: клавиатура, мышь, управление / Composite device: keyboard, mouse, control
+#define HID_CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + HID_INTERFACE_COUNT * TUD_HID_DESC_LEN)
+
+static const tusb_desc_device_t device_descriptor = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00,               // Класс задан в интерфейсах / Class is set per interface
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = HID_USB_VID,
+    .idProduct = HID_USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = 1,
+    .iProduct = 2,
+    .iSerialNumber = 3,
+    .bNumConfigurations = 1,
+};
+
+static const char* string_descriptor[] = {
+    (const char[]){0x09, 0x04},         // Английский (США) / English (US)
+    HID_USB_MANUFACTURER,
+    HID_USB_PRODUCT,
+    HID_USB_SERIAL,
+    "Keyboard",
+    "Mouse",
+    "Media, System Control and Pointer",
+};
+
+static const uint8_t configuration_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, HID_INTERFACE_COUNT, 0, HID_CONFIG_TOTAL_LEN,
+                          TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+    TUD_HID_DESCRIPTOR(HID_INTERFACE_KEYBOARD, 4, HID_ITF_PROTOCOL_KEYBOARD, sizeof(keyboard_hid_descriptor),
+                       HID_KEYBOARD_EP_IN, HID_KEYBOARD_EP_SIZE, HID_KEYBOARD_INTERVAL),
+    TUD_HID_DESCRIPTOR(HID_INTERFACE_MOUSE, 5, HID_ITF_PROTOCOL_MOUSE, sizeof(mouse_hid_descriptor),
+                       HID_MOUSE_EP_IN, HID_MOUSE_EP_SIZE, HID_MOUSE_INTERVAL),
+    TUD_HID_DESCRIPTOR(HID_INTERFACE_CONTROL, 6, HID_ITF_PROTOCOL_NONE, sizeof(control_hid_descriptor),
+                       HID_CONTROL_EP_IN, HID_CONTROL_EP_SIZE, HID_CONTROL_INTERVAL),
+};
+
+// Колбэки TinyUSB / TinyUSB callbacks
+uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
+    switch (instance) {
+        case HID_INTERFACE_KEYBOARD:
+            return keyboard_hid_descriptor;
+        case HID_INTERFACE_MOUSE:
+            return mouse_hid_descriptor;
+        default:
+            return control_hid_descriptor;
+    }
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t* buffer, uint16_t reqlen) {
+    return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           uint8_t const* buffer, uint16_t bufsize) {
+    // Светодиоды клавиатуры - обратная связь для автонастройки темпа / Keyboard LEDs are feedback for timing auto-tune
+    if (instance == HID_INTERFACE_KEYBOARD && report_type == HID_REPORT_TYPE_OUTPUT && bufsize >= 1) {
+        emit_event(HID_TRANSPORT_EVENT_KEYBOARD_LEDS, buffer[0]);
+    }
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    emit_event(HID_TRANSPORT_EVENT_REPORT_COMPLETE, instance);
+}
+
+void tud_mount_cb(void) {
+    emit_event(HID_TRANSPORT_EVENT_CONNECTED, 0);
+}
+
+void tud_umount_cb(void) {
+    emit_event(HID_TRANSPORT_EVENT_DISCONNECTED, 0);
+}
+
+static esp_err_t usb_submit(uint8_t interface, uint8_t report_id, const void* report, uint16_t length) {
+    // Хост спит - разбудить, отчет повторится после возобновления / Host asleep - wake it, the report is retried on resume
+    if (tud_suspended()) {
+        tud_remote_wakeup();
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!tud_hid_n_ready(interface)) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    
+    return tud_hid_n_report(interface, report_id, report, length) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t usb_start(hid_transport_event_callback_t callback, void* user_data) {
+    event_callback = callback;
+    event_user_data = user_data;
+    
+    const tinyusb_config_t tusb_config = {
+        .device_descriptor = &device_descriptor,
+        .string_descriptor = string_descriptor,
+        .string_descriptor_count = sizeof(string_descriptor) / sizeof(string_descriptor[0]),
+        .external_phy = false,
+        .configuration_descriptor = configuration_descriptor,
+    };
+    
+    esp_err_t ret = tinyusb_driver_install(&tusb_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install TinyUSB driver: %s", esp_err_to_name(ret));
+        event_callback = NULL;
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "TinyUSB composite HID device installed (interval %d ms)", HID_KEYBOARD_INTERVAL);
+    return ESP_OK;
+}
+
+static void usb_stop(void) {
+    tinyusb_driver_uninstall();
+    event_callback = NULL;
+}
+
+#else // !SOC_USB_OTG_SUPPORTED
+
+static esp_err_t usb_start(hid_transport_event_callback_t callback, void* user_data) {
+    ESP_LOGE(TAG, "No USB OTG on this chip, use another HID transport");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static void usb_stop(void) {
+}
+
+static esp_err_t usb_submit(uint8_t interface, uint8_t report_id, const void* report, uint16_t length) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+#endif // SOC_USB_OTG_SUPPORTED
+
+const hid_transport_t hid_transport_usb = {
+    .name = "USB",
+    .start = usb_start,
+    .stop = usb_stop,
+    .submit = usb_submit,
+};
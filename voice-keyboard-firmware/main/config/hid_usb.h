@@ -0,0 +1,52 @@
+/**
+ * @file hid_usb.h
+ * @brief USB HID transport header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл USB транспорта HID
+ * Header file for the USB HID transport
+ *
+ * Составное устройство TinyUSB (hid_transport_usb): клавиатура, мышь и
+ * интерфейс управления (Consumer Control, System Control и абсолютный
+ * указатель с ID отчетов) с интервалом опроса 1 мс. Отчеты передаются как байты, поэтому заголовки
+ * TinyUSB (со своими hid_keyboard_report_t и HID_KEY_*) не пересекаются с
+ * hid_config.h. Есть только на чипах с USB OTG.
+ * A TinyUSB composite device (hid_transport_usb): keyboard, mouse and a control
+ * interface (Consumer Control, System Control and an absolute pointer behind
+ * report IDs) with a 1 ms polling interval. Reports are passed as bytes, so the TinyUSB headers (with
+ * their own hid_keyboard_report_t and HID_KEY_*) never meet hid_config.h. Only
+ * available on chips with USB OTG.
+ */
+
+#ifndef HID_USB_H
+#define HID_USB_H
+
+#include <stdint.h>
+#include "hid_transport.h"
+
+// HID конфигурация USB / HID USB configuration
+#define HID_USB_VID             0x2E8A    // Espressif VID
+#define HID_USB_PID             0x0001    // Custom PID
+#define HID_USB_MANUFACTURER    "Espressif"
+#define HID_USB_PRODUCT         "Voice Keyboard"
+#define HID_USB_SERIAL          "123456"
+
+// Клавиатура HID / Keyboard HID
+#define HID_KEYBOARD_EP_IN      0x81      // Endpoint IN
+#define HID_KEYBOARD_EP_OUT     0x01      // Endpoint OUT
+#define HID_KEYBOARD_EP_SIZE    8         // Endpoint size
+#define HID_KEYBOARD_INTERVAL   1         // Polling interval (ms), 1000 reports/s
+
+// Мышь HID / Mouse HID
+#define HID_MOUSE_EP_IN        0x82      // Endpoint IN
+#define HID_MOUSE_EP_OUT       0x02      // Endpoint OUT
+#define HID_MOUSE_EP_SIZE      8         // Endpoint size
+#define HID_MOUSE_INTERVAL     1         // Polling interval (ms)
+
+// Управление HID (Consumer + System Control + указатель) / Control HID (Consumer + System Control + pointer)
+#define HID_CONTROL_EP_IN      0x83      // Endpoint IN
+#define HID_CONTROL_EP_SIZE    8         // Endpoint size
+#define HID_CONTROL_INTERVAL   1         // Polling interval (ms)
+
+#endif // HID_USB_H
@@ -0,0 +1,361 @@
+/**
+ * @file keyword_spotter.c
+ * @brief On-device keyword spotter implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация локального детектора ключевых слов
+ * Implementation of the on-device keyword spotter
+ *
+ * Всё в целых числах: у C3 нет FPU. Кадр 20 мс дает 8 логарифмов энергий
+ * полос (фильтры Гёрцеля по 80 отсчетов, полоса ~200 Гц), из которых вычитается
+ * среднее по высказыванию, так что громкость и усиление микрофона не важны.
+ * Everything is integer: the C3 has no FPU. A 20 ms frame yields 8 band
+ * log-energies (80-sample Goertzel filters, ~200 Hz wide) minus the utterance
+ * mean, so loudness and microphone gain don't matter.
+ */
+
+#include "keyword_spotter.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "KEYWORD_SPOTTER";
+
+#define SPOTTER_FRAME_SAMPLES   320    // 20 мс при 16 кГц / 20 ms at 16 kHz
+#define SPOTTER_BLOCK_SAMPLES   80     // Блок Гёрцеля / Goertzel block
+#define SPOTTER_BANDS           8
+#define SPOTTER_MAX_FRAMES      (KEYWORD_SPOTTER_MAX_MS / 20)
+#define SPOTTER_MIN_FRAMES      10     // Минимум речи, 200 мс / Speech minimum, 200 ms
+#define SPOTTER_SILENCE_Q2      40     // Кадры на 30 дБ тише пика - тишина / Frames 30 dB below the peak are silence
+// Расстояние, при котором уверенность падает до нуля (по журналу last_distance)
+// Distance at which confidence drops to zero (tuned from the last_distance log)
+#define SPOTTER_REJECT_DISTANCE 120
+#define SPOTTER_INFINITY        UINT32_MAX
+
+// 2cos(2pi f / 16000) в Q14 для 250, 400, 630, 1000, 1600, 2500, 4000, 6300 Гц
+// 2cos(2pi f / 16000) in Q14 for 250, 400, 630, 1000, 1600, 2500, 4000, 6300 Hz
+static const int32_t band_coeffs[SPOTTER_BANDS] = {32610, 32365, 31770, 30274, 26510, 18205, 0, -25733};
+
+// Признаки высказывания, log2 в Q2 минус среднее / Utterance features, log2 in Q2 minus the mean
+typedef struct {
+    uint8_t frames;
+    int8_t bands[SPOTTER_MAX_FRAMES][SPOTTER_BANDS];
+} spotter_features_t;
+
+// Образец команды / Command sample
+typedef struct {
+    char text[KEYWORD_SPOTTER_MAX_TEXT];
+    uint32_t used;               // Метка последнего совпадения или записи / Last match or enrollment stamp
+    spotter_features_t features;
+} spotter_template_t;
+
+// Внутренняя структура детектора / Internal spotter structure
+struct keyword_spotter {
+    spotter_template_t templates[KEYWORD_SPOTTER_MAX_TEMPLATES];
+    uint32_t template_count;
+    uint32_t clock;
+
+    // Признаки последнего высказывания для обучения / Last utterance features for enrollment
+    spotter_features_t last;
+    bool last_valid;
+
+    keyword_spotter_stats_t stats;
+};
+
+/**
+ * @brief log2 в Q2 (целая часть и два бита мантиссы)
+ * log2 in Q2 (integer part and two mantissa bits)
+ */
+static int32_t log2_q2(uint64_t value) {
+    if (value < 4) {
+        return (int32_t)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    return msb * 4 + (int32_t)((value >> (msb - 2)) & 3);
+}
+
+/**
+ * @brief Мощность блока на частоте фильтра Гёрцеля
+ * Block power at the Goertzel filter frequency
+ */
+static uint64_t goertzel_power(const int16_t* samples, size_t count, int32_t coeff) {
+    int32_t s1 = 0;
+    int32_t s2 = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i] + (int32_t)(((int64_t)coeff * s1) >> 14) - s2;
+        s2 = s1;
+        s1 = s;
+    }
+
+    int64_t power = (int64_t)s1 * s1 + (int64_t)s2 * s2 - ((((int64_t)coeff * s1) >> 14) * s2);
+    return power > 0 ? (uint64_t)power : 0;
+}
+
+/**
+ * @brief Извлечь признаки: обрезать тишину по краям и вычесть среднее
+ * Extract features: trim silence at both ends and subtract the mean
+ *
+ * @return false если речи меньше SPOTTER_MIN_FRAMES / false if there is less than SPOTTER_MIN_FRAMES of speech
+ */
+static bool extract_features(const int16_t* samples, size_t sample_count, spotter_features_t* features) {
+    int16_t raw[SPOTTER_MAX_FRAMES][SPOTTER_BANDS];
+    int16_t energy[SPOTTER_MAX_FRAMES];
+    size_t frames = sample_count / SPOTTER_FRAME_SAMPLES;
+    int16_t peak = 0;
+
+    if (frames > SPOTTER_MAX_FRAMES) {
+        frames = SPOTTER_MAX_FRAMES;
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        const int16_t* frame = samples + f * SPOTTER_FRAME_SAMPLES;
+        uint64_t total = 0;
+
+        for (int b = 0; b < SPOTTER_BANDS; b++) {
+            uint64_t power = 0;
+            for (size_t block = 0; block < SPOTTER_FRAME_SAMPLES; block += SPOTTER_BLOCK_SAMPLES) {
+                power += goertzel_power(frame + block, SPOTTER_BLOCK_SAMPLES, band_coeffs[b]);
+            }
+            raw[f][b] = (int16_t)log2_q2(power + 1);
+            total += power;
+        }
+
+        energy[f] = (int16_t)log2_q2(total + 1);
+        if (energy[f] > peak) {
+            peak = energy[f];
+        }
+    }
+
+    // Речь - от первого до последнего громкого кадра / Speech spans the first to the last loud frame
+    size_t first = 0;
+    size_t end = frames;
+    while (first < end && energy[first] < peak - SPOTTER_SILENCE_Q2) {
+        first++;
+    }
+    while (end > first && energy[end - 1] < peak - SPOTTER_SILENCE_Q2) {
+        end--;
+    }
+    if (end - first < SPOTTER_MIN_FRAMES) {
+        return false;
+    }
+
+    features->frames = (uint8_t)(end - first);
+    for (int b = 0; b < SPOTTER_BANDS; b++) {
+        int32_t sum = 0;
+        for (size_t f = first; f < end; f++) {
+            sum += raw[f][b];
+        }
+        int32_t mean = sum / (int32_t)features->frames;
+
+        for (size_t f = first; f < end; f++) {
+            int32_t value = raw[f][b] - mean;
+            value = value > INT8_MAX ? INT8_MAX : value < INT8_MIN ? INT8_MIN : value;
+            features->bands[f - first][b] = (int8_t)value;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Расстояние DTW на шаг пути (L1 между кадрами)
+ * DTW distance per path step (L1 between frames)
+ *
+ * Высказывания, отличающиеся по длине больше чем вдвое, не сравниваются.
+ * Utterances more than twice as long as each other are not compared.
+ */
+static uint32_t dtw_distance(const spotter_features_t* a, const spotter_features_t* b) {
+    uint32_t rows[2][SPOTTER_MAX_FRAMES + 1];
+    size_t n = a->frames;
+    size_t m = b->frames;
+
+    if (n > 2 * m || m > 2 * n) {
+        return SPOTTER_INFINITY;
+    }
+
+    uint32_t* previous = rows[0];
+    uint32_t* current = rows[1];
+    previous[0] = 0;
+    for (size_t j = 1; j <= m; j++) {
+        previous[j] = SPOTTER_INFINITY;
+    }
+
+    for (size_t i = 1; i <= n; i++) {
+        current[0] = SPOTTER_INFINITY;
+        for (size_t j = 1; j <= m; j++) {
+            uint32_t best = previous[j - 1];
+            if (previous[j] < best) {
+                best = previous[j];
+            }
+            if (current[j - 1] < best) {
+                best = current[j - 1];
+            }
+            if (best == SPOTTER_INFINITY) {
+                current[j] = SPOTTER_INFINITY;
+                continue;
+            }
+
+            uint32_t cost = 0;
+            for (int k = 0; k < SPOTTER_BANDS; k++) {
+                int32_t diff = a->bands[i - 1][k] - b->bands[j - 1][k];
+                cost += (uint32_t)(diff < 0 ? -diff : diff);
+            }
+            current[j] = best + cost;
+        }
+
+        uint32_t* swap = previous;
+        previous = current;
+        current = swap;
+    }
+
+    return previous[m] == SPOTTER_INFINITY ? SPOTTER_INFINITY : previous[m] / (uint32_t)(n + m);
+}
+
+esp_err_t keyword_spotter_init(keyword_spotter_handle_t* handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *handle = calloc(1, sizeof(struct keyword_spotter));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate keyword spotter");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Keyword spotter initialized, %u bytes for %d samples",
+             (unsigned)sizeof(struct keyword_spotter), KEYWORD_SPOTTER_MAX_TEMPLATES);
+    return ESP_OK;
+}
+
+esp_err_t keyword_spotter_deinit(keyword_spotter_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t keyword_spotter_recognize(keyword_spotter_handle_t handle, const int16_t* samples, size_t sample_count,
+                                    speech_result_t* result) {
+    if (!handle || !samples || !result) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    handle->last_valid = extract_features(samples, sample_count, &handle->last);
+    if (!handle->last_valid) {
+        handle->stats.too_short++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t distances[KEYWORD_SPOTTER_MAX_TEMPLATES];
+    spotter_template_t* best = NULL;
+    uint32_t best_distance = SPOTTER_INFINITY;
+    for (uint32_t i = 0; i < handle->template_count; i++) {
+        distances[i] = dtw_distance(&handle->last, &handle->templates[i].features);
+        if (distances[i] < best_distance) {
+            best_distance = distances[i];
+            best = &handle->templates[i];
+        }
+    }
+
+    handle->stats.last_distance = best_distance;
+    handle->stats.last_compute_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    if (!best || best_distance >= SPOTTER_REJECT_DISTANCE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Ближайший образец другой команды / The nearest sample of another command
+    uint32_t rival_distance = SPOTTER_INFINITY;
+    for (uint32_t i = 0; i < handle->template_count; i++) {
+        if (distances[i] < rival_distance && strcmp(handle->templates[i].text, best->text) != 0) {
+            rival_distance = distances[i];
+        }
+    }
+
+    // Уверенность падает с расстоянием и когда другая команда почти так же близка
+    // Confidence falls with distance and when another command is almost as close
+    float confidence = 1.0f - (float)best_distance / SPOTTER_REJECT_DISTANCE;
+    if (rival_distance != SPOTTER_INFINITY && best_distance > 0) {
+        float margin = (float)(rival_distance - best_distance) / (float)best_distance;
+        if (margin < 1.0f) {
+            confidence *= margin;
+        }
+    }
+
+    best->used = ++handle->clock;
+    memset(result, 0, sizeof(*result));
+    strncpy(result->text, best->text, sizeof(result->text) - 1);
+    result->confidence = confidence;
+    result->is_final = true;
+
+    ESP_LOGD(TAG, "'%s' at distance %u in %u us", best->text, (unsigned)best_distance,
+             (unsigned)handle->stats.last_compute_us);
+    return ESP_OK;
+}
+
+esp_err_t keyword_spotter_learn(keyword_spotter_handle_t handle, const char* text) {
+    if (!handle || !text) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!handle->last_valid) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Вытесняемый: старейший образец той же команды или, без места, дольше всех не совпадавший
+    // Evicted: the oldest sample of the same command or, with no room, the one unmatched the longest
+    spotter_template_t* slot = NULL;
+    spotter_template_t* same_oldest = NULL;
+    spotter_template_t* oldest = NULL;
+    uint32_t same_count = 0;
+
+    for (uint32_t i = 0; i < handle->template_count; i++) {
+        spotter_template_t* candidate = &handle->templates[i];
+        if (strncmp(candidate->text, text, sizeof(candidate->text) - 1) == 0) {
+            same_count++;
+            if (!same_oldest || candidate->used < same_oldest->used) {
+                same_oldest = candidate;
+            }
+        }
+        if (!oldest || candidate->used < oldest->used) {
+            oldest = candidate;
+        }
+    }
+
+    if (same_count >= KEYWORD_SPOTTER_PER_COMMAND) {
+        slot = same_oldest;
+    } else if (handle->template_count < KEYWORD_SPOTTER_MAX_TEMPLATES) {
+        slot = &handle->templates[handle->template_count++];
+    } else {
+        slot = oldest;
+    }
+
+    memset(slot->text, 0, sizeof(slot->text));
+    strncpy(slot->text, text, sizeof(slot->text) - 1);
+    slot->features = handle->last;
+    slot->used = ++handle->clock;
+
+    // Одно аудио - один образец / One audio, one sample
+    handle->last_valid = false;
+    handle->stats.enrolled++;
+
+    ESP_LOGI(TAG, "Enrolled '%s' (%u frames, %u samples)", slot->text, slot->features.frames,
+             (unsigned)handle->template_count);
+    return ESP_OK;
+}
+
+esp_err_t keyword_spotter_get_stats(keyword_spotter_handle_t handle, keyword_spotter_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = handle->stats;
+    stats->templates = handle->template_count;
+    return ESP_OK;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file keyword_spotter.h
+ * @brief On-device keyword spotter header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл локального детектора ключевых слов
+ * Header file for the on-device keyword spotter
+ *
+ * Детектор сравнивает короткое высказывание с образцами команд (DTW по
+ * логарифмам энергий полос). Образцы не поставляются, а набираются по ходу
+ * работы: облачный ответ, признанный командой целиком, сохраняет признаки
+ * того же аудио под текстом команды. Образцы хранятся только в ОЗУ.
+ * The spotter compares a short utterance against command samples (DTW over
+ * band log-energies). Samples are not shipped but enrolled as the device is
+ * used: a cloud answer accepted as a whole command stores the features of the
+ * same audio under the command text. Samples live in RAM only.
+ *
+ * Не потокобезопасен: все вызовы из одной задачи.
+ * Not thread-safe: all calls come from one task.
+ */
+
+#ifndef KEYWORD_SPOTTER_H
+#define KEYWORD_SPOTTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "speech_recognition.h"
+
+#define KEYWORD_SPOTTER_MAX_MS          1500   // Длина сравниваемого аудио / Audio length compared
+#define KEYWORD_SPOTTER_MAX_TEMPLATES   16     // Образцов всего / Samples in total
+#define KEYWORD_SPOTTER_PER_COMMAND     2      // Образцов одной команды / Samples per command
+#define KEYWORD_SPOTTER_MAX_TEXT        48     // Текст команды с нулем / Command text including NUL
+
+// Дескриптор детектора / Spotter handle
+typedef struct keyword_spotter* keyword_spotter_handle_t;
+
+// Статистика детектора / Spotter statistics
+typedef struct {
+    uint32_t templates;          // Образцов сейчас / Samples held now
+    uint32_t enrolled;           // Записано образцов / Samples enrolled
+    uint32_t too_short;          // Высказываний короче минимума речи / Utterances below the speech minimum
+    uint32_t last_distance;      // Расстояние последнего сравнения / Last comparison distance
+    uint32_t last_compute_us;    // Время последнего сравнения / Last comparison time
+} keyword_spotter_stats_t;
+
+/**
+ * @brief Инициализация детектора
+ * Initialize the spotter
+ */
+esp_err_t keyword_spotter_init(keyword_spotter_handle_t* handle);
+
+/**
+ * @brief Деинициализация детектора
+ * Deinitialize the spotter
+ */
+esp_err_t keyword_spotter_deinit(keyword_spotter_handle_t handle);
+
+/**
+ * @brief Распознать короткое высказывание
+ * Recognize a short utterance
+ *
+ * Признаки аудио запоминаются для keyword_spotter_learn. При совпадении
+ * заполняет text и confidence и возвращает ESP_OK, иначе ESP_ERR_NOT_FOUND.
+ * The audio features are kept for keyword_spotter_learn. On a match fills
+ * text and confidence and returns ESP_OK, otherwise ESP_ERR_NOT_FOUND.
+ */
+esp_err_t keyword_spotter_recognize(keyword_spotter_handle_t handle, const int16_t* samples, size_t sample_count,
+                                    speech_result_t* result);
+
+/**
+ * @brief Записать последнее высказывание как образец команды
+ * Enroll the last utterance as a command sample
+ *
+ * Вытесняет самый старый образец той же команды, а без свободного места -
+ * дольше всех не совпадавший. Без признаков (высказывание слишком короткое)
+ * возвращает ESP_ERR_INVALID_STATE.
+ * Evicts the oldest sample of the same command, or with no free room the one
+ * unmatched the longest. Without features (the utterance was too short)
+ * returns ESP_ERR_INVALID_STATE.
+ */
+esp_err_t keyword_spotter_learn(keyword_spotter_handle_t handle, const char* text);
+
+/**
+ * @brief Получить статистику детектора
+ * Get spotter statistics
+ */
+esp_err_t keyword_spotter_get_stats(keyword_spotter_handle_t handle, keyword_spotter_stats_t* stats);
+
+#endif // KEYWORD_SPOTTER_H
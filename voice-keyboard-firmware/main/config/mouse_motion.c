@@ -0,0 +1,92 @@
+/**
+ * @file mouse_motion.c
+ * @brief Smooth mouse motion generator implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация генератора плавного движения мыши
+ * Implementation of the smooth mouse motion generator
+ */
+
+#include "mouse_motion.h"
+#include <math.h>
+
+// Наибольшее смещение в отчете мыши / Largest displacement in a mouse report
+#define MOTION_STEP_MAX     127
+
+static int8_t sign(int value) {
+    return value > 0 ? 1 : (value < 0 ? -1 : 0);
+}
+
+void mouse_motion_start(mouse_motion_t* motion, const mouse_motion_profile_t* profile,
+                        int dir_x, int dir_y, uint32_t distance, int64_t now_us) {
+    motion->profile = *profile;
+    motion->dir_x = sign(dir_x);
+    motion->dir_y = sign(dir_y);
+    motion->active = motion->dir_x != 0 || motion->dir_y != 0;
+    motion->bounded = distance > 0;
+    motion->remaining = distance;
+    motion->speed = profile->start_speed;
+    motion->fraction = 0.0f;
+    motion->start_us = now_us;
+    motion->last_us = now_us;
+}
+
+void mouse_motion_stop(mouse_motion_t* motion) {
+    motion->active = false;
+}
+
+bool mouse_motion_next(mouse_motion_t* motion, int64_t now_us, int8_t* x, int8_t* y) {
+    *x = 0;
+    *y = 0;
+    if (!motion->active) {
+        return false;
+    }
+
+    const mouse_motion_profile_t* profile = &motion->profile;
+    if (!motion->bounded && now_us - motion->start_us >= profile->timeout_ms * 1000LL) {
+        motion->active = false;
+        return false;
+    }
+
+    float dt = (now_us - motion->last_us) / 1e6f;
+    motion->last_us = now_us;
+
+    // Разгон до крейсерской / Accelerate to cruise
+    float speed = motion->speed + profile->acceleration * dt;
+    if (speed > profile->max_speed) {
+        speed = profile->max_speed;
+    }
+
+    // Скорость, с которой еще успеем затормозить до начальной к цели
+    // The speed from which we can still brake to the start speed at the target
+    if (motion->bounded) {
+        float braking = sqrtf((float)profile->start_speed * profile->start_speed +
+                              2.0f * profile->acceleration * motion->remaining);
+        if (speed > braking) {
+            speed = braking;
+        }
+    }
+    motion->speed = speed;
+
+    float travel = motion->fraction + speed * dt;
+    uint32_t step = (uint32_t)travel;
+    motion->fraction = travel - step;
+    if (step > MOTION_STEP_MAX) {
+        // Долгий кадр - лишнее не догоняем / A long frame - the excess isn't made up
+        step = MOTION_STEP_MAX;
+        motion->fraction = 0.0f;
+    }
+
+    if (motion->bounded) {
+        if (step >= motion->remaining) {
+            step = motion->remaining;
+            motion->active = false;
+        }
+        motion->remaining -= step;
+    }
+
+    *x = motion->dir_x * (int)step;
+    *y = motion->dir_y * (int)step;
+    return step > 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file mouse_motion.h
+ * @brief Smooth mouse motion generator header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл генератора плавного движения мыши
+ * Header file for the smooth mouse motion generator
+ *
+ * Движение разгоняется от начальной скорости до крейсерской с постоянным
+ * ускорением. Движение на заданное расстояние тормозит так, чтобы прийти
+ * ровно в цель; открытое движение идет до остановки или таймаута. Смещение
+ * считается по прошедшему времени с дробным остатком, поэтому скорость не
+ * зависит от частоты кадров (кадр USB 1 мс, интервал BLE) и от пропущенных
+ * кадров. Скорости в отсчетах мыши: на хосте их еще масштабирует его
+ * ускорение указателя.
+ * A motion accelerates from the start speed to the cruise speed at a constant
+ * rate. A motion over a given distance brakes so it lands exactly on target;
+ * an open-ended motion runs until stopped or timed out. The displacement is
+ * computed from elapsed time with a fractional remainder, so the speed doesn't
+ * depend on the frame rate (1 ms USB frame, BLE interval) or on missed frames.
+ * Speeds are in mouse counts: the host's pointer acceleration scales them on
+ * top.
+ */
+
+#ifndef MOUSE_MOTION_H
+#define MOUSE_MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Профиль движения / Motion profile
+typedef struct {
+    uint16_t start_speed;        // Начальная скорость, отсчетов/с / Start speed, counts/s
+    uint16_t max_speed;          // Крейсерская скорость, отсчетов/с / Cruise speed, counts/s
+    uint16_t acceleration;       // Разгон и торможение, отсчетов/с² / Acceleration and braking, counts/s²
+    uint16_t timeout_ms;         // Предел открытого движения / Open-ended motion limit
+} mouse_motion_profile_t;
+
+// Состояние движения / Motion state
+typedef struct {
+    mouse_motion_profile_t profile;
+    int8_t dir_x;                // Направление по X (-1, 0, 1) / X direction (-1, 0, 1)
+    int8_t dir_y;                // Направление по Y (-1, 0, 1) / Y direction (-1, 0, 1)
+    bool active;
+    bool bounded;                // Есть цель / Has a target
+    uint32_t remaining;          // Осталось до цели / Left to the target
+    float speed;                 // Текущая скорость / Current speed
+    float fraction;              // Дробный остаток смещения / Fractional displacement remainder
+    int64_t start_us;
+    int64_t last_us;             // Время прошлого кадра / Previous frame time
+} mouse_motion_t;
+
+/**
+ * @brief Начать движение
+ * Start a motion
+ *
+ * Нулевое направление останавливает текущее движение.
+ * A zero direction stops the current motion.
+ *
+ * @param dir_x Знак задает направление по X / The sign sets the X direction
+ * @param dir_y Знак задает направление по Y / The sign sets the Y direction
+ * @param distance Расстояние по каждой оси (0 - до остановки) / Distance along each axis (0 - until stopped)
+ */
+void mouse_motion_start(mouse_motion_t* motion, const mouse_motion_profile_t* profile,
+                        int dir_x, int dir_y, uint32_t distance, int64_t now_us);
+
+/**
+ * @brief Остановить движение
+ * Stop the motion
+ */
+void mouse_motion_stop(mouse_motion_t* motion);
+
+/**
+ * @brief Смещение кадра
+ * Frame displacement
+ *
+ * Смещение за время с прошлого кадра, не больше 127 по оси. После последнего
+ * кадра active сбрасывается.
+ * The displacement for the time since the previous frame, at most 127 per
+ * axis. After the last frame active is cleared.
+ *
+ * @return false если смещения в этом кадре нет / false if this frame has no displacement
+ */
+bool mouse_motion_next(mouse_motion_t* motion, int64_t now_us, int8_t* x, int8_t* y);
+
+#endif // MOUSE_MOTION_H
@@ -11,61 +11,558 @@
 #include "speech_recognition.h"
 #include "audio_processor.h"
 #include "vad_detector.h"
+#include "stt_client.h"
+#include "config.h"
 #include <stdlib.h>
 #include <math.h>
+#include <stdatomic.h>
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 static const char* TAG = "SPEECH_RECOGNITION";
 
+// Слот окна пересортировки / Re-sequencing window slot
+typedef enum {
+    REORDER_PENDING,   // Ответ еще не получен / No answer yet
+    REORDER_READY,     // Результат готов / Result ready
+    REORDER_FAILED     // Распознавание не удалось / Recognition failed
+} reorder_state_t;
+
+typedef struct {
+    reorder_state_t state;
+    uint32_t utterance;       // Номер высказывания / Utterance number
+    bool last;                // Последний сегмент высказывания / Last segment of the utterance
+    int64_t pressed_us;       // Нажатие кнопки высказывания / Utterance button press
+    int64_t released_us;      // Отпускание (только у последнего) / Release (last segment only)
+    size_t bytes;             // Копия аудио у клиента, пока сегмент в пути / Audio copy held by the client while in flight
+    speech_result_t result;
+} reorder_slot_t;
+
+// Работа задачи локального распознавания / Local recognition task job
+typedef struct {
+    uint32_t sequence;
+    int16_t* samples;             // NULL - облачный ответ для обучения / NULL - a cloud answer for learning
+    size_t sample_count;
+    char text[64];                // Облачный ответ (короткая команда) / Cloud answer (a short command)
+} local_job_t;
+
 // Внутренняя структура распознавателя / Internal recognizer structure
 struct speech_recognizer {
     speech_config_t config;
-    speech_state_t state;
+    atomic_int state;             // speech_state_t, читается без блокировки / speech_state_t, read without the lock
     speech_result_callback_t result_callback;
     void* user_data;
+    speech_vad_callback_t vad_callback;
+    void* vad_user_data;
     
     // Компоненты обработки / Processing components
     audio_processor_handle_t audio_processor;
     vad_detector_handle_t vad_detector;
     
-    // Буферы / Buffers
+    // Буфер захвата сегмента / Segment capture buffer
     int16_t* audio_buffer;
-    size_t buffer_size;
-    
-    // Очередь результатов / Result queue
+    size_t buffer_size;           // В сэмплах / In samples
+    size_t captured_samples;
+    SemaphoreHandle_t lock;       // Захват и окно пересортировки / Capture and re-sequencing window
+    
+    // Текущее высказывание (одно удержание кнопки) / Current utterance (one button hold)
+    uint32_t utterance_count;     // Номер текущего высказывания / Current utterance number
+    uint32_t segments_submitted;  // Сегментов отправлено во время удержания / Segments submitted during the hold
+    bool segment_has_voice;       // В текущем сегменте была речь / Speech seen in the current segment
+    int64_t pressed_us;           // Нажатие кнопки / Button press
+    int64_t released_us;          // Отпускание кнопки / Button release
+    
+    // Облачное распознавание / Cloud recognition
+    stt_client_handle_t stt_client;
+    uint32_t next_sequence;       // Номер следующего сегмента / Next segment number
+    uint32_t next_delivery;       // Номер следующего к сборке / Next segment to merge
+    reorder_slot_t reorder[SPEECH_REORDER_WINDOW];
+    size_t in_flight_bytes;       // Копии сегментов в пути / Segment copies in flight
+    size_t in_flight_budget;      // Предел копий по куче при запуске / Copy limit from the heap at init
+    
+    // Локальный распознаватель для коротких высказываний / Local recognizer for short utterances
+    speech_local_recognizer_t local_recognizer;
+    speech_local_learner_t local_learner;
+    void* local_user_data;
+    QueueHandle_t local_queue;
+    TaskHandle_t local_task;
+    uint32_t local_sequence;      // Сегмент у локального распознавателя / Segment at the local recognizer
+    bool local_busy;              // Локальный результат еще не готов / Local result not ready yet
+    bool local_learning;          // Облачный ответ на local_sequence нужен для обучения / The cloud answer to local_sequence is wanted for learning
+    speech_arbitration_stats_t arbitration_stats;
+    
+    // Сборка высказывания из сегментов / Utterance assembly from segments
+    speech_result_t merged;
+    float merged_confidence_sum;
+    uint32_t merged_segments;
+    
+    // Очереди результатов / Result queues
     QueueHandle_t result_queue;
+    QueueHandle_t delivery_queue;
+    TaskHandle_t delivery_task;
     
     // Статистика / Statistics
     uint32_t total_frames_processed;
     uint32_t voice_frames_detected;
 };
 
+static bool submit_segment(struct speech_recognizer* recognizer, bool last, uint32_t* submitted_sequence);
+
+/**
+ * @brief Свободных слотов в окне пересортировки (под блокировкой)
+ * Free re-sequencing window slots (lock held)
+ */
+static uint32_t free_slots(const struct speech_recognizer* recognizer) {
+    return SPEECH_REORDER_WINDOW - (recognizer->next_sequence - recognizer->next_delivery);
+}
+
+/**
+ * @brief Можно ли закрыть сегмент посреди удержания (под блокировкой)
+ * Whether a segment may be closed mid-hold (lock held)
+ *
+ * Один слот окна остается для последнего сегмента, а копия должна
+ * уложиться в бюджет кучи; иначе сегмент продолжает копиться.
+ * One window slot stays reserved for the last segment, and the copy must fit
+ * the heap budget; otherwise the segment keeps accumulating.
+ */
+static bool can_split(const struct speech_recognizer* recognizer) {
+    size_t bytes = recognizer->captured_samples * sizeof(int16_t);
+    if (free_slots(recognizer) < 2 || recognizer->in_flight_bytes + bytes > recognizer->in_flight_budget) {
+        ESP_LOGD(TAG, "Segment split deferred: %u bytes in flight, budget %u",
+                 (unsigned)recognizer->in_flight_bytes, (unsigned)recognizer->in_flight_budget);
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Обработчик обнаружения голосовой активности
  * Voice activity detection handler
+ *
+ * Конец речи во время удержания закрывает сегмент и сразу отправляет его,
+ * так что после отпускания кнопки остается распознать только последний.
+ * End of speech during a hold closes the segment and submits it at once,
+ * so only the last segment is left to recognize after release.
  */
 static void vad_event_handler(bool is_speaking, void* user_data) {
     speech_recognizer_handle_t handle = (speech_recognizer_handle_t)user_data;
+    int expected = is_speaking ? SPEECH_STATE_LISTENING : SPEECH_STATE_PROCESSING;
+    bool changed;
     
+    // Остановка из задачи кнопки не перезаписывается / A stop from the button task is never overwritten
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
     if (is_speaking) {
         ESP_LOGI(TAG, "Voice activity detected");
-        handle->state = SPEECH_STATE_PROCESSING;
+        changed = atomic_compare_exchange_strong(&handle->state, &expected, SPEECH_STATE_PROCESSING);
+        if (changed) {
+            handle->segment_has_voice = true;
+        }
     } else {
         ESP_LOGI(TAG, "Voice activity ended");
-        if (handle->state == SPEECH_STATE_PROCESSING) {
-            // Генерация результата / Generate result
-            speech_result_t result = {0};
-            strncpy(result.text, "voice command detected", sizeof(result.text) - 1);
-            result.confidence = 0.8f;
-            result.is_final = true;
-            
+        changed = atomic_compare_exchange_strong(&handle->state, &expected, SPEECH_STATE_LISTENING);
+        
+        if (changed && can_split(handle)) {
+            submit_segment(handle, false, NULL);
+        }
+    }
+    xSemaphoreGive(handle->lock);
+    
+    if (changed && handle->vad_callback) {
+        handle->vad_callback(is_speaking, handle->vad_user_data);
+    }
+}
+
+/**
+ * @brief Добавить сегмент к собираемому высказыванию
+ * Append a segment to the utterance being assembled
+ */
+static void merge_segment(struct speech_recognizer* recognizer, const speech_result_t* segment) {
+    if (segment->text[0] == '\0') {
+        return;
+    }
+    
+    size_t len = strlen(recognizer->merged.text);
+    size_t room = sizeof(recognizer->merged.text) - 1 - len;
+    if (len > 0 && room > 0) {
+        recognizer->merged.text[len++] = ' ';
+        recognizer->merged.text[len] = '\0';
+        room--;
+    }
+    strncat(recognizer->merged.text + len, segment->text, room);
+    
+    recognizer->merged_confidence_sum += segment->confidence;
+    recognizer->merged_segments++;
+}
+
+/**
+ * @brief Отдать собранное высказывание (под блокировкой)
+ * Deliver the assembled utterance (lock held)
+ */
+static void deliver_merged(struct speech_recognizer* recognizer, uint32_t utterance) {
+    if (recognizer->merged_segments > 0) {
+        recognizer->merged.sequence = utterance;
+        recognizer->merged.confidence = recognizer->merged_confidence_sum / recognizer->merged_segments;
+        recognizer->merged.is_final = true;
+        
+        ESP_LOGD(TAG, "Utterance #%u merged from %u segment(s)", utterance, recognizer->merged_segments);
+        
+        if (xQueueSend(recognizer->delivery_queue, &recognizer->merged, 0) != pdTRUE) {
+            ESP_LOGW(TAG, "Delivery queue full, result #%u dropped", utterance);
+        }
+        // Очередь для опроса через get_result / Queue for get_result polling
+        xQueueSend(recognizer->result_queue, &recognizer->merged, 0);
+    } else {
+        ESP_LOGW(TAG, "Utterance #%u produced no text", utterance);
+    }
+    
+    memset(&recognizer->merged, 0, sizeof(recognizer->merged));
+    recognizer->merged_confidence_sum = 0.0f;
+    recognizer->merged_segments = 0;
+}
+
+/**
+ * @brief Отдать промежуточную гипотезу высказывания (под блокировкой)
+ * Deliver an interim hypothesis of the utterance (lock held)
+ *
+ * Только в задачу доставки: опрос через get_result видит финальные результаты.
+ * Only to the delivery task: get_result polling sees final results.
+ */
+static void deliver_interim(struct speech_recognizer* recognizer, uint32_t utterance) {
+    speech_result_t interim = recognizer->merged;
+    interim.sequence = utterance;
+    interim.confidence = recognizer->merged_confidence_sum / recognizer->merged_segments;
+    interim.is_final = false;
+    
+    if (xQueueSend(recognizer->delivery_queue, &interim, 0) != pdTRUE) {
+        ESP_LOGD(TAG, "Delivery queue full, interim result #%u skipped", utterance);
+    }
+}
+
+/**
+ * @brief Собрать готовые сегменты по порядку (под блокировкой)
+ * Merge ready segments in order (lock held)
+ */
+static void release_in_order(struct speech_recognizer* recognizer) {
+    for (;;) {
+        reorder_slot_t* slot = &recognizer->reorder[recognizer->next_delivery % SPEECH_REORDER_WINDOW];
+        if (recognizer->next_delivery == recognizer->next_sequence || slot->state == REORDER_PENDING) {
+            break;
+        }
+        
+        if (slot->state == REORDER_READY) {
+            merge_segment(recognizer, &slot->result);
+        }
+        recognizer->merged.pressed_us = slot->pressed_us;
+        recognizer->merged.released_us = slot->released_us;
+        if (slot->last) {
+            deliver_merged(recognizer, slot->utterance);
+        } else if (SPEECH_INTERIM_RESULTS && slot->state == REORDER_READY && recognizer->merged_segments > 0) {
+            deliver_interim(recognizer, slot->utterance);
+        }
+        
+        slot->state = REORDER_PENDING;
+        slot->last = false;
+        recognizer->next_delivery++;
+    }
+}
+
+/**
+ * @brief Отметить результат сегмента (под блокировкой)
+ * Record a segment outcome (lock held)
+ */
+static void record_outcome(struct speech_recognizer* recognizer, uint32_t sequence, const speech_result_t* result) {
+    if (sequence - recognizer->next_delivery >= SPEECH_REORDER_WINDOW) {
+        ESP_LOGD(TAG, "Result #%u already delivered, ignored", sequence);
+        return;
+    }
+    
+    reorder_slot_t* slot = &recognizer->reorder[sequence % SPEECH_REORDER_WINDOW];
+    if (slot->state != REORDER_PENDING) {
+        // Исход сегмента уже записан / Segment outcome already recorded
+        return;
+    }
+    
+    // Клиент освобождает копию вместе с ответом / The client frees the copy along with the answer
+    recognizer->in_flight_bytes -= slot->bytes;
+    slot->bytes = 0;
+    
+    if (result) {
+        slot->result = *result;
+        slot->result.sequence = sequence;
+        slot->state = REORDER_READY;
+    } else {
+        slot->state = REORDER_FAILED;
+    }
+    
+    release_in_order(recognizer);
+}
+
+/**
+ * @brief Callback клиента STT (ответы могут приходить не по порядку)
+ * STT client callback (answers may arrive out of order)
+ */
+static void stt_result_handler(uint32_t sequence, esp_err_t status, const speech_result_t* result, void* user_data) {
+    speech_recognizer_handle_t handle = (speech_recognizer_handle_t)user_data;
+    
+    if (status == ESP_OK && result->is_replayed) {
+        // Окно давно ушло вперед - доставить отдельно / The window has long moved on - deliver on its own
+        ESP_LOGI(TAG, "Spooled segment #%u recognized: '%s'", sequence, result->text);
+        if (xQueueSend(handle->delivery_queue, result, 0) != pdTRUE) {
+            ESP_LOGW(TAG, "Delivery queue full, replayed segment #%u dropped", sequence);
+        }
+        xQueueSend(handle->result_queue, result, 0);
+        return;
+    }
+    
+    local_job_t job = {.sequence = sequence};
+    bool learn = false;
+    
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->local_learning && sequence == handle->local_sequence) {
+        handle->local_learning = false;
+        learn = status == ESP_OK && strlen(result->text) < sizeof(job.text);
+    }
+    record_outcome(handle, sequence, status == ESP_OK ? result : NULL);
+    xSemaphoreGive(handle->lock);
+    
+    // Встает в очередь за аудио этого же сегмента / Queues up behind the audio of the same segment
+    if (learn) {
+        strcpy(job.text, result->text);
+        xQueueSend(handle->local_queue, &job, 0);
+    }
+}
+
+/**
+ * @brief Занять номер сегмента в окне (под блокировкой)
+ * Claim a segment number in the window (lock held)
+ */
+static uint32_t claim_sequence(struct speech_recognizer* recognizer, bool last) {
+    uint32_t sequence = recognizer->next_sequence++;
+    reorder_slot_t* slot = &recognizer->reorder[sequence % SPEECH_REORDER_WINDOW];
+    
+    slot->state = REORDER_PENDING;
+    slot->utterance = recognizer->utterance_count;
+    slot->last = last;
+    slot->pressed_us = recognizer->pressed_us;
+    slot->released_us = last ? recognizer->released_us : 0;
+    slot->bytes = 0;
+    
+    return sequence;
+}
+
+/**
+ * @brief Отправить захваченный сегмент на распознавание (под блокировкой)
+ * Submit the captured segment for recognition (lock held)
+ *
+ * @param last Сегмент закрывает высказывание (кнопка отпущена) / Segment closes the utterance (button released)
+ * @param submitted_sequence Номер отправленного сегмента (может быть NULL) / Submitted segment number (may be NULL)
+ * @return true если аудио ушло на сервер / true if audio went to the server
+ */
+static bool submit_segment(struct speech_recognizer* recognizer, bool last, uint32_t* submitted_sequence) {
+    size_t samples = recognizer->captured_samples;
+    bool has_voice = recognizer->segment_has_voice;
+    recognizer->captured_samples = 0;
+    
+    // Принудительная граница посреди речи: следующий сегмент тоже с голосом,
+    // хотя VAD не покидал PROCESSING и нового начала речи не будет
+    // A forced boundary mid-speech: the next segment has voice too, even though
+    // the VAD never left PROCESSING and no new speech start will come
+    recognizer->segment_has_voice = atomic_load(&recognizer->state) == SPEECH_STATE_PROCESSING;
+    
+    bool worth_sending = recognizer->stt_client &&
+                         samples >= (size_t)SPEECH_SAMPLE_RATE * SPEECH_MIN_UTTERANCE_MS / 1000;
+    
+    // После уже отправленных сегментов хвост без речи не нужен / After earlier segments a silent tail is useless
+    if (recognizer->segments_submitted > 0 && !has_voice) {
+        worth_sending = false;
+    }
+    
+    if (!worth_sending) {
+        if (!recognizer->stt_client) {
+            ESP_LOGW(TAG, "No STT client attached, audio dropped");
+        }
+        if (last && recognizer->segments_submitted > 0) {
+            // Закрыть высказывание пустым сегментом / Close the utterance with an empty segment
+            record_outcome(recognizer, claim_sequence(recognizer, true), NULL);
+        }
+        return false;
+    }
+    
+    if (free_slots(recognizer) == 0) {
+        ESP_LOGW(TAG, "Too many segments in flight, audio dropped");
+        return false;
+    }
+    
+    uint32_t sequence = claim_sequence(recognizer, last);
+    if (!last) {
+        recognizer->segments_submitted++;
+    }
+    
+    // Копия точного размера, буфер захвата сразу свободен для следующего сегмента
+    // Exact-size copy so the capture buffer is free for the next segment at once
+    int16_t* samples_copy = malloc(samples * sizeof(int16_t));
+    if (!samples_copy) {
+        ESP_LOGE(TAG, "Failed to allocate segment #%u", sequence);
+        record_outcome(recognizer, sequence, NULL);
+        return false;
+    }
+    memcpy(samples_copy, recognizer->audio_buffer, samples * sizeof(int16_t));
+    
+    if (stt_client_submit(recognizer->stt_client, sequence, samples_copy, samples) != ESP_OK) {
+        free(samples_copy);
+        record_outcome(recognizer, sequence, NULL);
+        return false;
+    }
+    
+    reorder_slot_t* slot = &recognizer->reorder[sequence % SPEECH_REORDER_WINDOW];
+    slot->bytes = samples * sizeof(int16_t);
+    recognizer->in_flight_bytes += slot->bytes;
+    
+    ESP_LOGI(TAG, "Segment #%u of utterance #%u submitted (%u ms%s)", sequence, recognizer->utterance_count,
+             (unsigned)(samples * 1000 / SPEECH_SAMPLE_RATE), last ? ", last" : "");
+    
+    if (submitted_sequence) {
+        *submitted_sequence = sequence;
+    }
+    return true;
+}
+
+/**
+ * @brief Передать короткое высказывание локальному распознавателю (под блокировкой)
+ * Hand a short utterance to the local recognizer (lock held)
+ *
+ * Аудио копируется из буфера захвата: он свободен до следующего start.
+ * The audio is copied from the capture buffer, which stays put until the next start.
+ */
+static void start_local(struct speech_recognizer* recognizer, uint32_t sequence, size_t samples) {
+    size_t bytes = samples * sizeof(int16_t);
+    local_job_t job = {.sequence = sequence, .sample_count = samples};
+    
+    // Пока идет предыдущее сравнение, арбитража нет / No arbitration while the previous comparison runs
+    if (recognizer->local_busy || recognizer->in_flight_bytes + bytes > recognizer->in_flight_budget) {
+        recognizer->arbitration_stats.cloud_only++;
+        return;
+    }
+    
+    job.samples = malloc(bytes);
+    if (!job.samples) {
+        recognizer->arbitration_stats.cloud_only++;
+        return;
+    }
+    memcpy(job.samples, recognizer->audio_buffer, bytes);
+    
+    if (xQueueSend(recognizer->local_queue, &job, 0) != pdTRUE) {
+        free(job.samples);
+        recognizer->arbitration_stats.cloud_only++;
+        return;
+    }
+    
+    recognizer->in_flight_bytes += bytes;
+    recognizer->local_sequence = sequence;
+    recognizer->local_busy = true;
+    recognizer->local_learning = recognizer->local_learner != NULL;
+}
+
+/**
+ * @brief Сравнить локальный результат с облачным (под блокировкой)
+ * Arbitrate the local result against the cloud (lock held)
+ *
+ * Уверенный локальный результат занимает слот сегмента сразу; облачный запрос
+ * отменяется. Иначе ждем облако.
+ * A confident local result takes the segment slot at once; the cloud request is
+ * cancelled. Otherwise we wait for the cloud.
+ */
+static void arbitrate_local(struct speech_recognizer* recognizer, uint32_t sequence,
+                            esp_err_t local_status, const speech_result_t* local) {
+    speech_arbitration_stats_t* stats = &recognizer->arbitration_stats;
+    reorder_slot_t* slot = &recognizer->reorder[sequence % SPEECH_REORDER_WINDOW];
+    bool cloud_answered = sequence - recognizer->next_delivery >= SPEECH_REORDER_WINDOW ||
+                          slot->state != REORDER_PENDING;
+    
+    if (local_status != ESP_OK) {
+        stats->local_no_match++;
+        return;
+    }
+    
+    if (local->confidence < recognizer->config.confidence_threshold) {
+        stats->local_below_threshold++;
+        ESP_LOGD(TAG, "Local '%s' below threshold (%.2f < %.2f), waiting for cloud",
+                 local->text, local->confidence, recognizer->config.confidence_threshold);
+        return;
+    }
+    
+    if (cloud_answered) {
+        stats->cloud_first++;
+        return;
+    }
+    
+    stats->local_wins++;
+    recognizer->local_learning = false;
+    ESP_LOGI(TAG, "Local recognizer won for segment #%u: '%s' (confidence: %.2f)",
+             sequence, local->text, local->confidence);
+    
+    stt_client_cancel(recognizer->stt_client, sequence);
+    record_outcome(recognizer, sequence, local);
+}
+
+/**
+ * @brief Задача локального распознавания
+ * Local recognition task
+ *
+ * Сравнение и обучение идут здесь, не в задаче состояний, которая вызывает stop.
+ * Облачный ответ для обучения приходит в ту же очередь после аудио своего сегмента.
+ * Comparison and learning run here, not in the state task that calls stop. The
+ * cloud answer for learning arrives on the same queue after its segment's audio.
+ */
+static void local_recognition_task(void* arg) {
+    speech_recognizer_handle_t handle = (speech_recognizer_handle_t)arg;
+    uint32_t recognized = UINT32_MAX;
+    local_job_t job;
+    
+    for (;;) {
+        if (xQueueReceive(handle->local_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        if (!job.samples) {
+            // Только для последнего сравненного аудио / Only for the audio compared last
+            if (job.sequence == recognized && handle->local_learner) {
+                handle->local_learner(job.text, handle->local_user_data);
+            }
+            continue;
+        }
+        
+        speech_result_t local;
+        memset(&local, 0, sizeof(local));
+        esp_err_t status = handle->local_recognizer(job.samples, job.sample_count, &local, handle->local_user_data);
+        free(job.samples);
+        recognized = job.sequence;
+        
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        handle->in_flight_bytes -= job.sample_count * sizeof(int16_t);
+        handle->local_busy = false;
+        arbitrate_local(handle, job.sequence, status, &local);
+        xSemaphoreGive(handle->lock);
+    }
+}
+
+/**
+ * @brief Задача доставки результатов
+ * Result delivery task
+ *
+ * Callback выполняется здесь, чтобы ввод текста не задерживал запись и сеть.
+ * The callback runs here so typing never stalls recording or networking.
+ */
+static void result_delivery_task(void* arg) {
+    speech_recognizer_handle_t handle = (speech_recognizer_handle_t)arg;
+    speech_result_t result;
+    
+    for (;;) {
+        if (xQueueReceive(handle->delivery_queue, &result, portMAX_DELAY) == pdTRUE) {
             if (handle->result_callback) {
                 handle->result_callback(&result, handle->user_data);
             }
-            
-            // Отправка в очередь / Send to queue
-            xQueueSend(handle->result_queue, &result, pdMS_TO_TICKS(100));
-            
-            handle->state = SPEECH_STATE_LISTENING;
         }
     }
 }
@@ -85,21 +582,33 @@ esp_err_t speech_recognizer_init(speech_recognizer_handle_t* handle, const speec
     // Инициализация структуры / Initialize structure
     memset(*handle, 0, sizeof(struct speech_recognizer));
     (*handle)->config = *config;
-    (*handle)->state = SPEECH_STATE_IDLE;
+    atomic_init(&(*handle)->state, SPEECH_STATE_IDLE);
     
-    // Выделение аудио буфера / Allocate audio buffer
-    (*handle)->buffer_size = SPEECH_BUFFER_SIZE;
-    (*handle)->audio_buffer = malloc((*handle)->buffer_size);
+    // Выделение буфера захвата / Allocate capture buffer
+    (*handle)->buffer_size = (size_t)SPEECH_SAMPLE_RATE * SPEECH_CAPTURE_MAX_MS / 1000;
+    (*handle)->audio_buffer = malloc((*handle)->buffer_size * sizeof(int16_t));
     if (!(*handle)->audio_buffer) {
         ESP_LOGE(TAG, "Failed to allocate audio buffer");
         free(*handle);
         return ESP_ERR_NO_MEM;
     }
     
-    // Создание очереди результатов / Create result queue
+    (*handle)->lock = xSemaphoreCreateMutex();
+    if (!(*handle)->lock) {
+        ESP_LOGE(TAG, "Failed to create recognizer mutex");
+        free((*handle)->audio_buffer);
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Создание очередей результатов / Create result queues
     (*handle)->result_queue = xQueueCreate(5, sizeof(speech_result_t));
-    if (!(*handle)->result_queue) {
+    (*handle)->delivery_queue = xQueueCreate(SPEECH_REORDER_WINDOW, sizeof(speech_result_t));
+    if (!(*handle)->result_queue || !(*handle)->delivery_queue) {
         ESP_LOGE(TAG, "Failed to create result queue");
+        if ((*handle)->result_queue) vQueueDelete((*handle)->result_queue);
+        if ((*handle)->delivery_queue) vQueueDelete((*handle)->delivery_queue);
+        vSemaphoreDelete((*handle)->lock);
         free((*handle)->audio_buffer);
         free(*handle);
         return ESP_ERR_NO_MEM;
@@ -110,13 +619,16 @@ esp_err_t speech_recognizer_init(speech_recognizer_handle_t* handle, const speec
         .sample_rate = SPEECH_SAMPLE_RATE,
         .enable_noise_reduction = config->enable_noise_reduction,
         .enable_agc = config->enable_agc,
-        .target_rms = 0.1f
+        .target_rms = 0.1f,
+        .cpu_budget_percent = AUDIO_DSP_BUDGET_PERCENT
     };
     
     esp_err_t ret = audio_processor_init(&(*handle)->audio_processor, &audio_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize audio processor");
         vQueueDelete((*handle)->result_queue);
+        vQueueDelete((*handle)->delivery_queue);
+        vSemaphoreDelete((*handle)->lock);
         free((*handle)->audio_buffer);
         free(*handle);
         return ret;
@@ -135,6 +647,8 @@ esp_err_t speech_recognizer_init(speech_recognizer_handle_t* handle, const speec
         ESP_LOGE(TAG, "Failed to initialize VAD detector");
         audio_processor_deinit((*handle)->audio_processor);
         vQueueDelete((*handle)->result_queue);
+        vQueueDelete((*handle)->delivery_queue);
+        vSemaphoreDelete((*handle)->lock);
         free((*handle)->audio_buffer);
         free(*handle);
         return ret;
@@ -143,8 +657,32 @@ esp_err_t speech_recognizer_init(speech_recognizer_handle_t* handle, const speec
     // Установка callback для VAD / Set VAD callback
     vad_detector_set_callback((*handle)->vad_detector, vad_event_handler, *handle);
     
-    ESP_LOGI(TAG, "Speech recognizer initialized successfully");
-    (*handle)->state = SPEECH_STATE_IDLE;
+    // Задача доставки результатов / Result delivery task
+    // Доставка выполняет команды и печать - ядро сети и HID
+    // Delivery runs commands and typing - the network and HID core
+    if (xTaskCreatePinnedToCore(result_delivery_task, "speech_results", SPEECH_TASK_STACK_SIZE, *handle,
+                                SPEECH_TASK_PRIORITY, &(*handle)->delivery_task, IO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create result delivery task");
+        vad_detector_deinit((*handle)->vad_detector);
+        audio_processor_deinit((*handle)->audio_processor);
+        vQueueDelete((*handle)->result_queue);
+        vQueueDelete((*handle)->delivery_queue);
+        vSemaphoreDelete((*handle)->lock);
+        free((*handle)->audio_buffer);
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Копии сегментов в пути ограничены кучей: на C3 буфер захвата и семь полных
+    // копий не помещаются. Резерв - сеть и копия последнего сегмента.
+    // Segment copies in flight are limited by the heap: on the C3 the capture buffer
+    // and seven full copies do not fit. The reserve covers networking and the last segment's copy.
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t reserve = SPEECH_HEAP_RESERVE_BYTES + (*handle)->buffer_size * sizeof(int16_t);
+    (*handle)->in_flight_budget = free_heap > reserve ? free_heap - reserve : 0;
+    
+    ESP_LOGI(TAG, "Speech recognizer initialized successfully, %u KB for segments in flight",
+             (unsigned)((*handle)->in_flight_budget / 1024));
     
     return ESP_OK;
 }
@@ -155,7 +693,27 @@ esp_err_t speech_recognizer_deinit(speech_recognizer_handle_t handle) {
     }
     
     // Остановка распознавания / Stop recognition
-    speech_recognizer_stop(handle);
+    speech_recognizer_stop(handle, esp_timer_get_time());
+    
+    if (handle->stt_client) {
+        stt_client_set_callback(handle->stt_client, NULL, NULL);
+    }
+    
+    if (handle->delivery_task) {
+        vTaskDelete(handle->delivery_task);
+    }
+    
+    if (handle->local_task) {
+        vTaskDelete(handle->local_task);
+    }
+    
+    if (handle->local_queue) {
+        local_job_t job;
+        while (xQueueReceive(handle->local_queue, &job, 0) == pdTRUE) {
+            free(job.samples);
+        }
+        vQueueDelete(handle->local_queue);
+    }
     
     // Деинициализация компонентов / Deinitialize components
     if (handle->audio_processor) {
@@ -171,6 +729,14 @@ esp_err_t speech_recognizer_deinit(speech_recognizer_handle_t handle) {
         vQueueDelete(handle->result_queue);
     }
     
+    if (handle->delivery_queue) {
+        vQueueDelete(handle->delivery_queue);
+    }
+    
+    if (handle->lock) {
+        vSemaphoreDelete(handle->lock);
+    }
+    
     if (handle->audio_buffer) {
         free(handle->audio_buffer);
     }
@@ -181,38 +747,64 @@ esp_err_t speech_recognizer_deinit(speech_recognizer_handle_t handle) {
     return ESP_OK;
 }
 
-esp_err_t speech_recognizer_start(speech_recognizer_handle_t handle) {
+esp_err_t speech_recognizer_start(speech_recognizer_handle_t handle, int64_t pressed_us) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (handle->state != SPEECH_STATE_IDLE) {
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    int expected = SPEECH_STATE_IDLE;
+    if (!atomic_compare_exchange_strong(&handle->state, &expected, SPEECH_STATE_LISTENING)) {
+        xSemaphoreGive(handle->lock);
         ESP_LOGW(TAG, "Recognizer already started");
         return ESP_ERR_INVALID_STATE;
     }
-    
-    handle->state = SPEECH_STATE_LISTENING;
+    handle->captured_samples = 0;
+    handle->segments_submitted = 0;
+    handle->segment_has_voice = false;
+    handle->pressed_us = pressed_us;
+    handle->released_us = 0;
+    xSemaphoreGive(handle->lock);
     handle->total_frames_processed = 0;
     handle->voice_frames_detected = 0;
+    audio_processor_restart(handle->audio_processor);
     
     ESP_LOGI(TAG, "Speech recognition started");
     return ESP_OK;
 }
 
-esp_err_t speech_recognizer_stop(speech_recognizer_handle_t handle) {
+esp_err_t speech_recognizer_stop(speech_recognizer_handle_t handle, int64_t released_us) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (handle->state == SPEECH_STATE_IDLE) {
+    // Результаты предыдущих сегментов еще в пути - очередь не очищаем
+    // Earlier segments are still in flight - the result queue is kept
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (atomic_exchange(&handle->state, SPEECH_STATE_IDLE) == SPEECH_STATE_IDLE) {
+        xSemaphoreGive(handle->lock);
         ESP_LOGW(TAG, "Recognizer already stopped");
         return ESP_ERR_INVALID_STATE;
     }
-    
-    handle->state = SPEECH_STATE_IDLE;
-    
-    // Очистка очереди результатов / Clear result queue
-    xQueueReset(handle->result_queue);
+    handle->released_us = released_us;
+    
+    size_t samples = handle->captured_samples;
+    bool short_utterance = handle->segments_submitted == 0 &&
+                           samples <= (size_t)SPEECH_SAMPLE_RATE * SPEECH_ARBITRATION_MAX_MS / 1000;
+    
+    uint32_t sequence = 0;
+    if (submit_segment(handle, true, &sequence)) {
+        // Облачный запрос уже в пути - локальное сравнение идет параллельно
+        // The cloud request is already in flight - the local comparison runs alongside
+        if (handle->local_queue && short_utterance) {
+            start_local(handle, sequence, samples);
+        } else {
+            handle->arbitration_stats.cloud_only++;
+        }
+    }
+    handle->utterance_count++;
+    handle->segments_submitted = 0;
+    xSemaphoreGive(handle->lock);
     
     ESP_LOGI(TAG, "Speech recognition stopped");
     return ESP_OK;
@@ -224,7 +816,8 @@ esp_err_t speech_recognizer_process_audio(speech_recognizer_handle_t handle,
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (handle->state == SPEECH_STATE_IDLE || handle->state == SPEECH_STATE_ERROR) {
+    int state = atomic_load(&handle->state);
+    if (state == SPEECH_STATE_IDLE || state == SPEECH_STATE_ERROR) {
         return ESP_ERR_INVALID_STATE;
     }
     
@@ -236,7 +829,27 @@ esp_err_t speech_recognizer_process_audio(speech_recognizer_handle_t handle,
     }
     
     // Обнаружение голосовой активности / Voice activity detection
-    vad_detector_process_audio(handle->vad_detector, audio_data, audio_size / sizeof(int16_t));
+    size_t sample_count = audio_size / sizeof(int16_t);
+    vad_detector_process_audio(handle->vad_detector, audio_data, sample_count);
+    
+    // Накопление сегмента / Accumulate segment
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (atomic_load(&handle->state) != SPEECH_STATE_IDLE) {
+        // Буфер полон без паузы в речи - принудительная граница сегмента
+        // Buffer full without a pause in speech - force a segment boundary
+        if (handle->buffer_size - handle->captured_samples < sample_count && can_split(handle)) {
+            submit_segment(handle, false, NULL);
+        }
+        
+        size_t room = handle->buffer_size - handle->captured_samples;
+        size_t copy = sample_count < room ? sample_count : room;
+        memcpy(handle->audio_buffer + handle->captured_samples, audio_data, copy * sizeof(int16_t));
+        handle->captured_samples += copy;
+        if (copy < sample_count) {
+            ESP_LOGW(TAG, "Capture buffer full, %u samples truncated", (unsigned)(sample_count - copy));
+        }
+    }
+    xSemaphoreGive(handle->lock);
     
     handle->total_frames_processed++;
     
@@ -261,7 +874,7 @@ speech_state_t speech_recognizer_get_state(speech_recognizer_handle_t handle) {
         return SPEECH_STATE_ERROR;
     }
     
-    return handle->state;
+    return (speech_state_t)atomic_load(&handle->state);
 }
 
 esp_err_t speech_recognizer_set_callback(speech_recognizer_handle_t handle, 
@@ -274,4 +887,95 @@ esp_err_t speech_recognizer_set_callback(speech_recognizer_handle_t handle,
     handle->user_data = user_data;
     
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+esp_err_t speech_recognizer_set_vad_callback(speech_recognizer_handle_t handle,
+                                            speech_vad_callback_t callback, void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->vad_callback = callback;
+    handle->vad_user_data = user_data;
+    
+    return ESP_OK;
+}
+
+esp_err_t speech_recognizer_set_stt_client(speech_recognizer_handle_t handle, struct stt_client* client) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->stt_client = client;
+    if (client) {
+        return stt_client_set_callback(client, stt_result_handler, handle);
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t speech_recognizer_set_local_recognizer(speech_recognizer_handle_t handle,
+                                                 speech_local_recognizer_t recognizer,
+                                                 speech_local_learner_t learner, void* user_data) {
+    if (!handle || !recognizer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->local_task) {
+        ESP_LOGW(TAG, "Local recognizer already set");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    handle->local_recognizer = recognizer;
+    handle->local_learner = learner;
+    handle->local_user_data = user_data;
+    
+    // Аудио и облачный ответ на каждое из двух высказываний / Audio and the cloud answer for each of two utterances
+    handle->local_queue = xQueueCreate(4, sizeof(local_job_t));
+    if (!handle->local_queue) {
+        ESP_LOGE(TAG, "Failed to create local recognition queue");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Ниже аудио на ядре захвата: сравнение не отнимает время у сети и HID
+    // Below audio on the capture core: comparison takes no time from networking and HID
+    if (xTaskCreatePinnedToCore(local_recognition_task, "speech_local", SPEECH_LOCAL_TASK_STACK_SIZE, handle,
+                                SPEECH_LOCAL_TASK_PRIORITY, &handle->local_task, AUDIO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create local recognition task");
+        vQueueDelete(handle->local_queue);
+        handle->local_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Local recognizer set for utterances up to %d ms", SPEECH_ARBITRATION_MAX_MS);
+    return ESP_OK;
+}
+
+esp_err_t speech_recognizer_get_arbitration_stats(speech_recognizer_handle_t handle,
+                                                  speech_arbitration_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *stats = handle->arbitration_stats;
+    xSemaphoreGive(handle->lock);
+    
+    return ESP_OK;
+}
+
+esp_err_t speech_recognizer_report_backlog(speech_recognizer_handle_t handle, uint32_t backlog_blocks) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return audio_processor_report_backlog(handle->audio_processor, backlog_blocks);
+}
+
+esp_err_t speech_recognizer_get_audio_budget_stats(speech_recognizer_handle_t handle,
+                                                   audio_budget_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return audio_processor_get_budget_stats(handle->audio_processor, stats);
+}
@@ -19,6 +19,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "audio_processor.h"
 
 // Конфигурация распознавания речи / Speech recognition configuration
 #define SPEECH_SAMPLE_RATE        16000    // Частота дискретизации / Sample rate
@@ -28,6 +29,11 @@
 #define SPEECH_VAD_THRESHOLD      0.01f    // Порог VAD / VAD threshold
 #define SPEECH_MIN_VOICE_FRAMES   10       // Минимальное количество речевых кадров / Min voice frames
 #define SPEECH_SILENCE_FRAMES     20       // Порог тишины для завершения / Silence frames threshold
+#define SPEECH_CAPTURE_MAX_MS     3000     // Максимальная длина сегмента / Max segment length
+#define SPEECH_MIN_UTTERANCE_MS   200      // Более короткие сегменты отбрасываются / Shorter segments are dropped
+#define SPEECH_REORDER_WINDOW     16       // Окно пересортировки сегментов / Segment re-sequencing window
+#define SPEECH_ARBITRATION_MAX_MS 1500     // Длина высказывания для локального распознавания / Utterance length for local recognition
+#define SPEECH_HEAP_RESERVE_BYTES (48 * 1024) // Куча для TLS, Wi-Fi и HID сверх копий сегментов / Heap for TLS, Wi-Fi and HID beyond segment copies
 
 // Состояния распознавания / Recognition states
 typedef enum {
@@ -42,6 +48,10 @@ typedef struct {
     char text[256];           // Распознанный текст / Recognized text
     float confidence;         // Уверенность / Confidence
     bool is_final;           // Финальный результат / Final result
+    uint32_t sequence;       // Номер высказывания / Utterance sequence number
+    bool is_replayed;        // Распознано позже из офлайн-очереди / Recognized later from the offline spool
+    int64_t pressed_us;      // Нажатие кнопки высказывания, esp_timer (0 - неизвестно) / Utterance button press, esp_timer (0 - unknown)
+    int64_t released_us;     // Отпускание (0 - кнопку еще держат или неизвестно) / Release (0 - still held or unknown)
 } speech_result_t;
 
 // Конфигурация распознавания / Speech configuration
@@ -57,6 +67,39 @@ typedef struct {
 // Дескриптор распознавания / Speech recognizer handle
 typedef struct speech_recognizer* speech_recognizer_handle_t;
 
+// Клиент облачного распознавания (stt_client.h) / Cloud STT client (stt_client.h)
+struct stt_client;
+
+/**
+ * @brief Локальный распознаватель (детектор ключевых слов)
+ * On-device recognizer (keyword spotter)
+ *
+ * Получает PCM короткого высказывания; при совпадении заполняет result
+ * (text, confidence) и возвращает ESP_OK, иначе ESP_ERR_NOT_FOUND.
+ * Receives the PCM of a short utterance; on a match fills result
+ * (text, confidence) and returns ESP_OK, otherwise ESP_ERR_NOT_FOUND.
+ */
+typedef esp_err_t (*speech_local_recognizer_t)(const int16_t* samples, size_t sample_count,
+                                               speech_result_t* result, void* user_data);
+
+/**
+ * @brief Облачный ответ на аудио, которое последним видел локальный распознаватель
+ * Cloud answer for the audio the local recognizer saw last
+ *
+ * Позволяет локальному распознавателю учиться на облаке.
+ * Lets the local recognizer learn from the cloud.
+ */
+typedef void (*speech_local_learner_t)(const char* text, void* user_data);
+
+// Статистика арбитража локальный/облако / Local/cloud arbitration statistics
+typedef struct {
+    uint32_t local_wins;            // Уверенный локальный результат опередил облако / Confident local result beat the cloud
+    uint32_t local_below_threshold; // Локальный результат ниже порога / Local result below threshold
+    uint32_t local_no_match;        // Локальный распознаватель не нашел совпадений / Local recognizer found no match
+    uint32_t cloud_first;           // Облако ответило раньше / Cloud answered first
+    uint32_t cloud_only;            // Без арбитража (длинное высказывание или занято) / Not arbitrated (long utterance or busy)
+} speech_arbitration_stats_t;
+
 /**
  * @brief Инициализация распознавателя речи
  * Initialize speech recognizer
@@ -72,14 +115,23 @@ esp_err_t speech_recognizer_deinit(speech_recognizer_handle_t handle);
 /**
  * @brief Начать распознавание
  * Start recognition
+ *
+ * @param pressed_us Время нажатия кнопки (esp_timer), попадает в результат / Button press time (esp_timer), carried into the result
  */
-esp_err_t speech_recognizer_start(speech_recognizer_handle_t handle);
+esp_err_t speech_recognizer_start(speech_recognizer_handle_t handle, int64_t pressed_us);
 
 /**
  * @brief Остановить распознавание
  * Stop recognition
+ *
+ * @param released_us Время отпускания кнопки (esp_timer) / Button release time (esp_timer)
+ *
+ * Последний сегмент отправляется на распознавание; сегменты, закрытые VAD во время
+ * удержания, уже в пути. Собранный результат придет через callback.
+ * The last segment is submitted; segments closed by VAD during the hold are already
+ * in flight. The merged result arrives via the callback.
  */
-esp_err_t speech_recognizer_stop(speech_recognizer_handle_t handle);
+esp_err_t speech_recognizer_stop(speech_recognizer_handle_t handle, int64_t released_us);
 
 /**
  * @brief Обработать аудио данные
@@ -103,9 +155,75 @@ speech_state_t speech_recognizer_get_state(speech_recognizer_handle_t handle);
 /**
  * @brief Установить callback для результатов
  * Set result callback
+ *
+ * Вызывается из задачи доставки строго в порядке высказываний, один раз на удержание.
+ * С SPEECH_INTERIM_RESULTS перед финальным результатом приходят промежуточные
+ * (is_final == false) - текст, собранный из уже распознанных сегментов.
+ * Called from the delivery task, strictly in utterance order, once per hold.
+ * With SPEECH_INTERIM_RESULTS interim results (is_final == false) come before
+ * the final one - the text merged from the segments recognized so far.
  */
 typedef void (*speech_result_callback_t)(const speech_result_t* result, void* user_data);
 esp_err_t speech_recognizer_set_callback(speech_recognizer_handle_t handle, 
                                         speech_result_callback_t callback, void* user_data);
 
+/**
+ * @brief Установить callback смены голосовой активности
+ * Set voice activity change callback
+ *
+ * Вызывается из задачи аудио, когда во время удержания начинается или кончается речь.
+ * Called from the audio task when speech starts or ends during a hold.
+ */
+typedef void (*speech_vad_callback_t)(bool is_speaking, void* user_data);
+esp_err_t speech_recognizer_set_vad_callback(speech_recognizer_handle_t handle,
+                                            speech_vad_callback_t callback, void* user_data);
+
+/**
+ * @brief Подключить клиент облачного распознавания
+ * Attach cloud STT client
+ */
+esp_err_t speech_recognizer_set_stt_client(speech_recognizer_handle_t handle, struct stt_client* client);
+
+/**
+ * @brief Установить локальный распознаватель для коротких высказываний
+ * Set the local recognizer for short utterances
+ *
+ * Высказывание из одного сегмента не длиннее SPEECH_ARBITRATION_MAX_MS уходит в
+ * облако и одновременно в отдельную задачу локального распознавания. Результат
+ * с уверенностью не ниже confidence_threshold используется сразу, а облачный
+ * запрос отменяется; иначе ждем облако, и его ответ передается в learner.
+ * A single-segment utterance up to SPEECH_ARBITRATION_MAX_MS goes to the cloud
+ * and at the same time to a separate local recognition task. A result with
+ * confidence at or above confidence_threshold is used at once and the cloud
+ * request is cancelled; otherwise we wait for the cloud and pass its answer to
+ * learner.
+ *
+ * @param learner Может быть NULL / May be NULL
+ */
+esp_err_t speech_recognizer_set_local_recognizer(speech_recognizer_handle_t handle,
+                                                 speech_local_recognizer_t recognizer,
+                                                 speech_local_learner_t learner, void* user_data);
+
+/**
+ * @brief Получить статистику арбитража
+ * Get arbitration statistics
+ */
+esp_err_t speech_recognizer_get_arbitration_stats(speech_recognizer_handle_t handle,
+                                                  speech_arbitration_stats_t* stats);
+
+/**
+ * @brief Сообщить об отставании захвата I2S (задача захвата)
+ * Report I2S capture backlog (capture task)
+ *
+ * @param backlog_blocks Блоков подряд, уже лежавших в DMA к чтению / Blocks in a row already waiting in DMA when read
+ */
+esp_err_t speech_recognizer_report_backlog(speech_recognizer_handle_t handle, uint32_t backlog_blocks);
+
+/**
+ * @brief Получить статистику бюджета тактов предобработки
+ * Get the preprocessing cycle budget statistics
+ */
+esp_err_t speech_recognizer_get_audio_budget_stats(speech_recognizer_handle_t handle,
+                                                   audio_budget_stats_t* stats);
+
 #endif // SPEECH_RECOGNITION_H
\ No newline at end of file
@@ -0,0 +1,94 @@
+/**
+ * @file spsc_queue.h
+ * @brief Lock-free single-producer single-consumer queue
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Очередь без блокировок: один писатель, один читатель
+ * Lock-free queue: one producer, one consumer
+ *
+ * Кольцо фиксированных элементов с атомарными счетчиками записи и чтения.
+ * Писатель и читатель могут работать на разных ядрах: ни критических секций,
+ * ни мьютексов, только acquire/release. Пробуждение читателя - забота
+ * вызывающего (обычно уведомление задачи после push).
+ * A ring of fixed-size items with atomic write and read counters. The producer
+ * and the consumer may run on different cores: no critical sections or
+ * mutexes, only acquire/release. Waking the consumer is up to the caller
+ * (usually a task notification after push).
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+typedef struct {
+    uint8_t* storage;            // capacity * item_size байт / capacity * item_size bytes
+    size_t item_size;
+    uint32_t capacity;           // Степень двойки / Power of two
+    atomic_uint head;            // Следующая запись (писатель) / Next write (producer)
+    atomic_uint tail;            // Следующее чтение (читатель) / Next read (consumer)
+} spsc_queue_t;
+
+/**
+ * @brief Инициализировать очередь над готовым буфером
+ * Initialize the queue over a caller-owned buffer
+ */
+static inline void spsc_queue_init(spsc_queue_t* queue, void* storage, size_t item_size, uint32_t capacity) {
+    queue->storage = (uint8_t*)storage;
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+/**
+ * @brief Добавить элемент (только писатель)
+ * Push an item (producer only)
+ *
+ * @return false если очередь полна / false if the queue is full
+ */
+static inline bool spsc_queue_push(spsc_queue_t* queue, const void* item) {
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == queue->capacity) {
+        return false;
+    }
+
+    memcpy(queue->storage + (head & (queue->capacity - 1)) * queue->item_size, item, queue->item_size);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Забрать элемент (только читатель)
+ * Pop an item (consumer only)
+ *
+ * @return false если очередь пуста / false if the queue is empty
+ */
+static inline bool spsc_queue_pop(spsc_queue_t* queue, void* item) {
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    memcpy(item, queue->storage + (tail & (queue->capacity - 1)) * queue->item_size, queue->item_size);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Элементов в очереди (приблизительно, с любой стороны)
+ * Items in the queue (approximate, from either side)
+ */
+static inline uint32_t spsc_queue_count(spsc_queue_t* queue) {
+    return atomic_load_explicit(&queue->head, memory_order_acquire) -
+           atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,792 @@
+/**
+ * @file stt_client.c
+ * @brief Cloud speech-to-text client implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация клиента облачного распознавания речи
+ * Implementation of cloud speech-to-text client
+ */
+
+#include "stt_client.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "config.h"
+#include "spsc_queue.h"
+#include "lwip/sockets.h"
+
+static const char* TAG = "STT_CLIENT";
+
+// Размер буфера приема заголовков / Header receive buffer size
+#define STT_RX_BUFFER_SIZE        1024
+// Таймаут получения соединения / Connection acquire timeout
+#define STT_ACQUIRE_TIMEOUT_MS    5000
+// Глубина очереди новых запросов (степень двойки) / New request queue depth (power of two)
+#define STT_SUBMIT_QUEUE_DEPTH    4
+// Попыток на запрос / Attempts per request
+#define STT_MAX_ATTEMPTS          2
+// Период опроса сокета при ожидании ответа / Socket poll period while awaiting a response
+#define STT_POLL_INTERVAL_MS      20
+// Запомненных отмен / Remembered cancellations
+#define STT_CANCEL_SLOTS          (STT_MAX_IN_FLIGHT + STT_SUBMIT_QUEUE_DEPTH)
+
+// Запрос распознавания / Recognition request
+typedef struct {
+    uint32_t sequence;
+    int16_t* samples;
+    size_t sample_count;
+    int64_t submit_us;
+    int64_t sent_us;
+    uint8_t attempts;
+    bool sent;
+    bool replay;  // Повтор из офлайн-очереди / Replay from the offline spool
+} stt_request_t;
+
+_Static_assert((STT_SUBMIT_QUEUE_DEPTH & (STT_SUBMIT_QUEUE_DEPTH - 1)) == 0,
+               "STT_SUBMIT_QUEUE_DEPTH must be a power of two");
+
+// Буфер приема ответа / Response receive buffer
+typedef struct {
+    char data[STT_RX_BUFFER_SIZE];
+    size_t len;
+} stt_rx_buffer_t;
+
+// Внутренняя структура клиента / Internal client structure
+struct stt_client {
+    stt_client_config_t config;
+    stt_connection_pool_handle_t pool;
+    SemaphoreHandle_t lock;
+
+    stt_client_result_callback_t result_callback;
+    void* user_data;
+
+    // Новые запросы с ядра захвата, без блокировок / New requests from the capture core, lock-free
+    spsc_queue_t submit_queue;
+    stt_request_t submit_storage[STT_SUBMIT_QUEUE_DEPTH];
+    TaskHandle_t task;
+
+    // Отмененные запросы (защищены lock) / Cancelled requests (guarded by lock)
+    uint32_t cancelled[STT_CANCEL_SLOTS];
+    int cancelled_count;
+
+    // Офлайн-очередь / Offline spool
+    stt_spool_handle_t spool;
+    bool replay_in_flight;
+
+
+    // Окно конвейера (FIFO, ответы HTTP/1.1 приходят по порядку)
+    // Pipeline window (FIFO, HTTP/1.1 responses arrive in request order)
+    stt_request_t in_flight[STT_MAX_IN_FLIGHT];
+    int head;
+    int count;
+
+    // Текущее соединение / Current connection
+    esp_tls_t* tls;
+    stt_rx_buffer_t rx;
+
+    // Статистика / Statistics
+    stt_client_stats_t stats;
+};
+
+// Разобранный ответ / Parsed response
+typedef struct {
+    int status;
+    bool keep_alive;
+    float confidence;
+    char text[sizeof(((speech_result_t*)0)->text)];
+} stt_response_t;
+
+/**
+ * @brief Записать все данные в соединение
+ * Write all data to the connection
+ */
+static esp_err_t write_all(esp_tls_t* tls, const void* data, size_t length) {
+    const uint8_t* ptr = (const uint8_t*)data;
+
+    while (length > 0) {
+        ssize_t written = esp_tls_conn_write(tls, ptr, length);
+        if (written == ESP_TLS_ERR_SSL_WANT_READ || written == ESP_TLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (written <= 0) {
+            return ESP_FAIL;
+        }
+        ptr += written;
+        length -= written;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Сформировать WAV заголовок для PCM 16 бит моно
+ * Build WAV header for 16-bit mono PCM
+ */
+static void build_wav_header(uint8_t* header, uint32_t data_bytes) {
+    const uint32_t sample_rate = SPEECH_SAMPLE_RATE;
+    const uint32_t byte_rate = SPEECH_SAMPLE_RATE * SPEECH_CHANNELS * SPEECH_BITS_PER_SAMPLE / 8;
+    const uint16_t block_align = SPEECH_CHANNELS * SPEECH_BITS_PER_SAMPLE / 8;
+    const uint32_t riff_size = 36 + data_bytes;
+    const uint32_t fmt_size = 16;
+    const uint16_t format = 1;  // PCM
+    const uint16_t channels = SPEECH_CHANNELS;
+    const uint16_t bits = SPEECH_BITS_PER_SAMPLE;
+
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 4, &riff_size, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    memcpy(header + 16, &fmt_size, 4);
+    memcpy(header + 20, &format, 2);
+    memcpy(header + 22, &channels, 2);
+    memcpy(header + 24, &sample_rate, 4);
+    memcpy(header + 28, &byte_rate, 4);
+    memcpy(header + 32, &block_align, 2);
+    memcpy(header + 34, &bits, 2);
+    memcpy(header + 36, "data", 4);
+    memcpy(header + 40, &data_bytes, 4);
+}
+
+/**
+ * @brief Отправить запрос распознавания
+ * Send recognition request
+ */
+static esp_err_t send_request(struct stt_client* client, esp_tls_t* tls, const int16_t* samples, size_t sample_count) {
+    uint32_t data_bytes = sample_count * sizeof(int16_t);
+    uint8_t wav_header[44];
+    char request[256];
+
+    build_wav_header(wav_header, data_bytes);
+
+    int len = snprintf(request, sizeof(request),
+                       "POST %s?lang=%s HTTP/1.1\r\n"
+                       "Host: %s\r\n"
+                       "Content-Type: audio/wav\r\n"
+                       "Content-Length: %u\r\n"
+                       "Connection: keep-alive\r\n"
+                       "\r\n",
+                       client->config.path, client->config.language, client->config.host,
+                       (unsigned)(sizeof(wav_header) + data_bytes));
+    if (len < 0 || len >= (int)sizeof(request)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (write_all(tls, request, len) != ESP_OK ||
+        write_all(tls, wav_header, sizeof(wav_header)) != ESP_OK ||
+        write_all(tls, samples, data_bytes) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Дочитать данные в буфер приема
+ * Read more data into the receive buffer
+ *
+ * Последний байт буфера остается под завершающий ноль.
+ * The last buffer byte stays free for the terminating NUL.
+ */
+static esp_err_t fill_rx(esp_tls_t* tls, stt_rx_buffer_t* rx) {
+    if (rx->len >= sizeof(rx->data) - 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    for (;;) {
+        ssize_t ret = esp_tls_conn_read(tls, rx->data + rx->len, sizeof(rx->data) - 1 - rx->len);
+        if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret == ESP_TLS_ERR_SSL_TIMEOUT) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;  // Соединение закрыто / Connection closed
+        }
+        rx->len += ret;
+        return ESP_OK;
+    }
+}
+
+/**
+ * @brief Прочитать и разобрать ответ сервера
+ * Read and parse server response
+ */
+static esp_err_t read_response(esp_tls_t* tls, stt_rx_buffer_t* rx, stt_response_t* resp) {
+    char* header_end = NULL;
+
+    // Чтение заголовков / Read headers
+    for (;;) {
+        if (rx->len > 0) {
+            rx->data[rx->len] = '\0';
+            header_end = strstr(rx->data, "\r\n\r\n");
+            if (header_end) {
+                break;
+            }
+        }
+        if (rx->len >= sizeof(rx->data) - 1) {
+            ESP_LOGE(TAG, "Response headers too large");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        esp_err_t ret = fill_rx(tls, rx);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    size_t header_len = header_end - rx->data + 4;
+    *header_end = '\0';
+
+    // Строка статуса / Status line
+    memset(resp, 0, sizeof(*resp));
+    resp->keep_alive = true;
+    resp->confidence = 1.0f;
+    if (sscanf(rx->data, "HTTP/1.%*d %d", &resp->status) != 1) {
+        ESP_LOGE(TAG, "Malformed status line");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // Заголовки / Headers
+    long content_length = -1;
+    char* line = strstr(rx->data, "\r\n");
+    while (line) {
+        line += 2;
+        char* next = strstr(line, "\r\n");
+        if (next) {
+            *next = '\0';
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = strtol(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char* value = line + 11;
+            while (*value == ' ') {
+                value++;
+            }
+            resp->keep_alive = strncasecmp(value, "close", 5) != 0;
+        } else if (strncasecmp(line, "X-Confidence:", 13) == 0) {
+            resp->confidence = strtof(line + 13, NULL);
+        }
+        line = next;
+    }
+
+    if (content_length < 0) {
+        // Без длины тела соединение нельзя переиспользовать / Without a body length the connection can't be reused
+        ESP_LOGE(TAG, "Response without Content-Length");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Тело / Body
+    memmove(rx->data, rx->data + header_len, rx->len - header_len);
+    rx->len -= header_len;
+
+    size_t consumed = 0;
+    size_t text_len = 0;
+    while (consumed < (size_t)content_length) {
+        if (rx->len == 0) {
+            esp_err_t ret = fill_rx(tls, rx);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        size_t chunk = rx->len;
+        if (chunk > (size_t)content_length - consumed) {
+            chunk = content_length - consumed;
+        }
+        size_t room = sizeof(resp->text) - 1 - text_len;
+        size_t copy = chunk < room ? chunk : room;
+        memcpy(resp->text + text_len, rx->data, copy);
+        text_len += copy;
+
+        memmove(rx->data, rx->data + chunk, rx->len - chunk);
+        rx->len -= chunk;
+        consumed += chunk;
+    }
+    resp->text[text_len] = '\0';
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Запрос в окне по позиции от головы
+ * Window request by offset from head
+ */
+static stt_request_t* window_at(struct stt_client* client, int offset) {
+    return &client->in_flight[(client->head + offset) % STT_MAX_IN_FLIGHT];
+}
+
+/**
+ * @brief Завершить повтор из офлайн-очереди
+ * Complete a replay from the offline spool
+ *
+ * Ответ сервера (даже ошибочный) удаляет запись: повтор его не изменит.
+ * Any server answer (even an error) removes the record: a retry won't change it.
+ */
+static void complete_replay(struct stt_client* client, stt_request_t* req, esp_err_t status,
+                            const speech_result_t* result) {
+    bool answered = status == ESP_OK || status == ESP_ERR_INVALID_RESPONSE;
+
+    client->replay_in_flight = false;
+    if (stt_spool_complete(client->spool, req->sequence, answered) != ESP_OK || status != ESP_OK) {
+        return;
+    }
+
+    xSemaphoreTake(client->lock, portMAX_DELAY);
+    client->stats.requests_replayed++;
+    xSemaphoreGive(client->lock);
+
+    if (client->result_callback) {
+        speech_result_t replayed = *result;
+        replayed.is_replayed = true;
+        client->result_callback(req->sequence, status, &replayed, client->user_data);
+    }
+}
+
+/**
+ * @brief Проверить и снять отметку об отмене запроса
+ * Check and clear a request cancellation mark
+ */
+static bool take_cancelled(struct stt_client* client, uint32_t sequence) {
+    bool found = false;
+
+    xSemaphoreTake(client->lock, portMAX_DELAY);
+    for (int i = 0; i < client->cancelled_count; i++) {
+        if (client->cancelled[i] == sequence) {
+            client->cancelled[i] = client->cancelled[--client->cancelled_count];
+            found = true;
+            break;
+        }
+    }
+    if (found) {
+        client->stats.requests_cancelled++;
+    }
+    xSemaphoreGive(client->lock);
+
+    return found;
+}
+
+/**
+ * @brief Завершить головной запрос и вызвать callback
+ * Complete the head request and invoke the callback
+ */
+static void complete_head(struct stt_client* client, esp_err_t status, const speech_result_t* result) {
+    stt_request_t* req = window_at(client, 0);
+    uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - req->submit_us) / 1000);
+
+    xSemaphoreTake(client->lock, portMAX_DELAY);
+    if (status != ESP_OK) {
+        client->stats.requests_failed++;
+    }
+    client->stats.last_latency_ms = latency_ms;
+    xSemaphoreGive(client->lock);
+
+    if (status == ESP_OK) {
+        ESP_LOGI(TAG, "#%u recognized in %u ms: '%s' (confidence: %.2f)",
+                 req->sequence, latency_ms, result->text, result->confidence);
+    } else {
+        ESP_LOGE(TAG, "#%u recognition failed: %s", req->sequence, esp_err_to_name(status));
+    }
+
+    if (req->replay) {
+        complete_replay(client, req, status, result);
+    } else if (take_cancelled(client, req->sequence)) {
+        // Ответ уже не нужен, в офлайн-очередь тоже / The answer is no longer needed, nor is spooling
+        ESP_LOGD(TAG, "#%u was cancelled, result discarded", req->sequence);
+    } else {
+        if (status == ESP_OK && client->spool) {
+            // Сервер снова доступен - повторить очередь / Server is reachable again - replay the spool
+            stt_spool_notify_online(client->spool);
+        } else if (status != ESP_OK && status != ESP_ERR_INVALID_RESPONSE && client->spool &&
+                   stt_spool_store(client->spool, req->sequence, req->samples, req->sample_count) == ESP_OK) {
+            status = STT_CLIENT_ERR_SPOOLED;
+            xSemaphoreTake(client->lock, portMAX_DELAY);
+            client->stats.requests_spooled++;
+            xSemaphoreGive(client->lock);
+        }
+        if (client->result_callback) {
+            client->result_callback(req->sequence, status, result, client->user_data);
+        }
+    }
+
+    free(req->samples);
+    req->samples = NULL;
+    client->head = (client->head + 1) % STT_MAX_IN_FLIGHT;
+    client->count--;
+}
+
+/**
+ * @brief Закрыть текущее соединение; неотвеченные запросы будут отправлены заново
+ * Drop the current connection; unanswered requests will be resent
+ */
+static void drop_connection(struct stt_client* client, bool reusable) {
+    if (!client->tls) {
+        return;
+    }
+
+    stt_connection_pool_release(client->pool, client->tls, reusable);
+    client->tls = NULL;
+    client->rx.len = 0;
+
+    for (int i = 0; i < client->count; i++) {
+        window_at(client, i)->sent = false;
+    }
+}
+
+/**
+ * @brief Получить соединение и настроить таймаут ответа
+ * Acquire a connection and set the response timeout
+ */
+static esp_err_t ensure_connection(struct stt_client* client) {
+    if (client->tls) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = stt_connection_pool_acquire(client->pool, &client->tls, pdMS_TO_TICKS(STT_ACQUIRE_TIMEOUT_MS));
+    if (ret != ESP_OK) {
+        client->tls = NULL;
+        return ret;
+    }
+    client->rx.len = 0;
+
+    // Таймаут ответа больше таймаута подключения / Response timeout is longer than connect timeout
+    int sockfd = -1;
+    if (esp_tls_get_conn_sockfd(client->tls, &sockfd) == ESP_OK && sockfd >= 0) {
+        struct timeval tv = {
+            .tv_sec = client->config.response_timeout_ms / 1000,
+            .tv_usec = (client->config.response_timeout_ms % 1000) * 1000,
+        };
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Есть ли данные ответа для чтения
+ * Whether response data is ready to read
+ */
+static bool response_ready(struct stt_client* client, uint32_t wait_ms) {
+    if (client->rx.len > 0 || esp_tls_get_bytes_avail(client->tls) > 0) {
+        return true;
+    }
+
+    int sockfd = -1;
+    if (esp_tls_get_conn_sockfd(client->tls, &sockfd) != ESP_OK || sockfd < 0) {
+        return true;  // Чтение вернет ошибку / Read will report the error
+    }
+
+    fd_set readset;
+    FD_ZERO(&readset);
+    FD_SET(sockfd, &readset);
+    struct timeval tv = {
+        .tv_sec = 0,
+        .tv_usec = wait_ms * 1000,
+    };
+    return select(sockfd + 1, &readset, NULL, NULL, &tv) != 0;
+}
+
+/**
+ * @brief Обработать сбой соединения для головного запроса
+ * Handle a connection failure for the head request
+ */
+static void handle_connection_failure(struct stt_client* client, esp_err_t error) {
+    drop_connection(client, false);
+
+    stt_request_t* req = window_at(client, 0);
+    if (++req->attempts >= STT_MAX_ATTEMPTS || error == ESP_ERR_TIMEOUT) {
+        complete_head(client, error, NULL);
+    } else {
+        xSemaphoreTake(client->lock, portMAX_DELAY);
+        client->stats.stale_retries++;
+        xSemaphoreGive(client->lock);
+        ESP_LOGW(TAG, "Connection dropped with %d request(s) in flight, resending", client->count);
+    }
+}
+
+/**
+ * @brief Задача конвейерной отправки запросов
+ * Pipelined request task
+ *
+ * Одна задача владеет соединением: отправляет новые запросы, не дожидаясь
+ * ответов на предыдущие, и читает ответы по мере поступления.
+ * A single task owns the connection: it sends new requests without waiting
+ * for earlier responses and reads responses as they arrive.
+ */
+static void stt_client_task(void* arg) {
+    struct stt_client* client = (struct stt_client*)arg;
+
+    for (;;) {
+        // Прием новых запросов; в простое - до срока повтора из очереди
+        // Accept new requests; while idle, wait until the next spool replay is due
+        TickType_t wait = 0;
+        if (client->count == 0) {
+            uint32_t due_ms = client->spool ? stt_spool_next_due_ms(client->spool) : UINT32_MAX;
+            wait = due_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(due_ms);
+            // Стирание flash впрок по сектору за проход / Erase flash ahead one sector per pass
+            if (client->spool && stt_spool_pre_erase(client->spool) == ESP_ERR_NOT_FINISHED && wait > 1) {
+                wait = 1;
+            }
+        }
+        while (client->count < STT_MAX_IN_FLIGHT) {
+            stt_request_t req;
+            if (!spsc_queue_pop(&client->submit_queue, &req)) {
+                // Писатель будит задачу уведомлением / The producer wakes the task with a notification
+                if (wait == 0 || ulTaskNotifyTake(pdTRUE, wait) == 0) {
+                    break;
+                }
+                wait = 0;
+                continue;
+            }
+            wait = 0;
+            if (take_cancelled(client, req.sequence)) {
+                // Отменен до отправки / Cancelled before sending
+                free(req.samples);
+                continue;
+            }
+            *window_at(client, client->count) = req;
+            client->count++;
+        }
+
+        // Повтор самой старой записи очереди / Replay the oldest spooled record
+        if (client->spool && !client->replay_in_flight && client->count < STT_MAX_IN_FLIGHT &&
+            stt_spool_next_due_ms(client->spool) == 0) {
+            stt_request_t req = {
+                .submit_us = esp_timer_get_time(),
+                .replay = true,
+            };
+            esp_err_t ret = stt_spool_load_oldest(client->spool, &req.sequence, &req.samples, &req.sample_count);
+            if (ret == ESP_OK) {
+                ESP_LOGI(TAG, "Replaying spooled segment #%u", req.sequence);
+                *window_at(client, client->count) = req;
+                client->count++;
+                client->replay_in_flight = true;
+            } else if (ret == ESP_ERR_NO_MEM && client->count == 0) {
+                vTaskDelay(pdMS_TO_TICKS(STT_ACQUIRE_TIMEOUT_MS));
+            }
+        }
+
+        if (client->count == 0) {
+            // Вернуть соединение в пул на время простоя / Return the connection to the pool while idle
+            drop_connection(client, true);
+            continue;
+        }
+
+        esp_err_t conn_ret = ensure_connection(client);
+        if (conn_ret != ESP_OK) {
+            // Сервер недоступен - завершить все запросы / Server unreachable - fail all requests
+            while (client->count > 0) {
+                complete_head(client, conn_ret, NULL);
+            }
+            continue;
+        }
+
+        // Отправка всех неотправленных запросов окна / Send all unsent window requests
+        bool send_failed = false;
+        for (int i = 0; i < client->count; i++) {
+            stt_request_t* req = window_at(client, i);
+            if (req->sent) {
+                continue;
+            }
+            if (send_request(client, client->tls, req->samples, req->sample_count) != ESP_OK) {
+                send_failed = true;
+                break;
+            }
+            req->sent = true;
+            req->sent_us = esp_timer_get_time();
+
+            xSemaphoreTake(client->lock, portMAX_DELAY);
+            client->stats.requests_sent++;
+            if (i > 0) {
+                client->stats.pipelined_requests++;
+            }
+            if ((uint32_t)(i + 1) > client->stats.max_in_flight) {
+                client->stats.max_in_flight = i + 1;
+            }
+            xSemaphoreGive(client->lock);
+        }
+        if (send_failed) {
+            handle_connection_failure(client, ESP_FAIL);
+            continue;
+        }
+
+        // Ожидание ответа с периодической проверкой очереди / Await response, polling the queue
+        if (!response_ready(client, STT_POLL_INTERVAL_MS)) {
+            stt_request_t* req = window_at(client, 0);
+            if (esp_timer_get_time() - req->sent_us > (int64_t)client->config.response_timeout_ms * 1000) {
+                handle_connection_failure(client, ESP_ERR_TIMEOUT);
+            }
+            continue;
+        }
+
+        stt_response_t resp;
+        esp_err_t ret = read_response(client->tls, &client->rx, &resp);
+        if (ret != ESP_OK) {
+            handle_connection_failure(client, ret);
+            continue;
+        }
+
+        if (resp.status == 200) {
+            speech_result_t result = {0};
+            strncpy(result.text, resp.text, sizeof(result.text) - 1);
+            result.confidence = resp.confidence;
+            result.is_final = true;
+            complete_head(client, ESP_OK, &result);
+        } else {
+            ESP_LOGE(TAG, "STT server returned HTTP %d", resp.status);
+            complete_head(client, ESP_ERR_INVALID_RESPONSE, NULL);
+        }
+
+        if (!resp.keep_alive) {
+            drop_connection(client, false);
+        }
+    }
+}
+
+esp_err_t stt_client_init(stt_client_handle_t* handle, stt_connection_pool_handle_t pool,
+                          const stt_client_config_t* config) {
+    if (!handle || !pool || !config || !config->host || !config->path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = malloc(sizeof(struct stt_client));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for STT client");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Инициализация структуры / Initialize structure
+    memset(*handle, 0, sizeof(struct stt_client));
+    (*handle)->config = *config;
+    (*handle)->pool = pool;
+
+    // Установка параметров по умолчанию / Set default parameters
+    if (!(*handle)->config.language) {
+        (*handle)->config.language = "ru";
+    }
+    if ((*handle)->config.response_timeout_ms == 0) {
+        (*handle)->config.response_timeout_ms = 10000;
+    }
+
+    (*handle)->lock = xSemaphoreCreateMutex();
+    if (!(*handle)->lock) {
+        ESP_LOGE(TAG, "Failed to create client mutex");
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    spsc_queue_init(&(*handle)->submit_queue, (*handle)->submit_storage, sizeof(stt_request_t),
+                    STT_SUBMIT_QUEUE_DEPTH);
+
+    if (xTaskCreatePinnedToCore(stt_client_task, "stt_client", STT_CLIENT_TASK_STACK_SIZE, *handle,
+                                STT_CLIENT_TASK_PRIORITY, &(*handle)->task, IO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create STT client task");
+        vSemaphoreDelete((*handle)->lock);
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "STT client initialized: https://%s%s (lang=%s, pipeline depth %d)",
+             config->host, config->path, (*handle)->config.language, STT_MAX_IN_FLIGHT);
+    return ESP_OK;
+}
+
+esp_err_t stt_client_deinit(stt_client_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    vTaskDelete(handle->task);
+    drop_connection(handle, false);
+
+    // Освобождение неотправленных запросов / Free outstanding requests
+    for (int i = 0; i < handle->count; i++) {
+        free(window_at(handle, i)->samples);
+    }
+    stt_request_t req;
+    while (spsc_queue_pop(&handle->submit_queue, &req)) {
+        free(req.samples);
+    }
+
+    vSemaphoreDelete(handle->lock);
+    free(handle);
+    ESP_LOGI(TAG, "STT client deinitialized");
+
+    return ESP_OK;
+}
+
+esp_err_t stt_client_set_callback(stt_client_handle_t handle, stt_client_result_callback_t callback,
+                                  void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->result_callback = callback;
+    handle->user_data = user_data;
+
+    return ESP_OK;
+}
+
+esp_err_t stt_client_set_spool(stt_client_handle_t handle, stt_spool_handle_t spool) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->spool = spool;
+
+    return ESP_OK;
+}
+
+esp_err_t stt_client_submit(stt_client_handle_t handle, uint32_t sequence, int16_t* samples, size_t sample_count) {
+    if (!handle || !samples || sample_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stt_request_t req = {
+        .sequence = sequence,
+        .samples = samples,
+        .sample_count = sample_count,
+        .submit_us = esp_timer_get_time(),
+    };
+
+    // Не блокирует вызывающую задачу / Never blocks the caller
+    if (!spsc_queue_push(&handle->submit_queue, &req)) {
+        ESP_LOGW(TAG, "Submit queue full, request #%u rejected", sequence);
+        return ESP_ERR_NO_MEM;
+    }
+    xTaskNotifyGive(handle->task);
+
+    return ESP_OK;
+}
+
+esp_err_t stt_client_cancel(stt_client_handle_t handle, uint32_t sequence) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->cancelled_count == STT_CANCEL_SLOTS) {
+        // Самая старая отмена уже неактуальна / The oldest cancellation is stale by now
+        memmove(handle->cancelled, handle->cancelled + 1, (STT_CANCEL_SLOTS - 1) * sizeof(uint32_t));
+        handle->cancelled_count--;
+    }
+    handle->cancelled[handle->cancelled_count++] = sequence;
+    xSemaphoreGive(handle->lock);
+
+    return ESP_OK;
+}
+
+esp_err_t stt_client_get_stats(stt_client_handle_t handle, stt_client_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *stats = handle->stats;
+    xSemaphoreGive(handle->lock);
+    return ESP_OK;
+}
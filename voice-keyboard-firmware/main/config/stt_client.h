@@ -0,0 +1,127 @@
+/**
+ * @file stt_client.h
+ * @brief Cloud speech-to-text client header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл клиента облачного распознавания речи
+ * Header file for cloud speech-to-text client
+ *
+ * Протокол / Protocol:
+ *   POST <path>?lang=<language> HTTP/1.1
+ *   Content-Type: audio/wav
+ *   Тело - WAV, PCM 16 бит моно / Body is WAV, 16-bit mono PCM
+ *
+ *   Ответ: 200, text/plain; charset=utf-8 с Content-Length,
+ *   уверенность в заголовке X-Confidence (0.0 - 1.0)
+ *   Response: 200, text/plain; charset=utf-8 with Content-Length,
+ *   confidence in the X-Confidence header (0.0 - 1.0)
+ */
+
+#ifndef STT_CLIENT_H
+#define STT_CLIENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "speech_recognition.h"
+#include "stt_connection.h"
+#include "stt_spool.h"
+
+// Максимум запросов в конвейере / Maximum pipelined requests
+#define STT_MAX_IN_FLIGHT   3
+
+// Статус: сегмент сохранен в офлайн-очередь / Status: segment saved to the offline spool
+#define STT_CLIENT_ERR_SPOOLED  ESP_ERR_NOT_FINISHED
+
+// Конфигурация клиента / Client configuration
+typedef struct {
+    const char* host;              // Хост для заголовка Host / Host header value
+    const char* path;              // Путь запроса / Request path
+    const char* language;          // Язык распознавания / Recognition language
+    uint32_t response_timeout_ms;  // Таймаут ответа / Response timeout
+} stt_client_config_t;
+
+// Дескриптор клиента / Client handle
+typedef struct stt_client* stt_client_handle_t;
+
+/**
+ * @brief Инициализация клиента
+ * Initialize client
+ */
+esp_err_t stt_client_init(stt_client_handle_t* handle, stt_connection_pool_handle_t pool,
+                          const stt_client_config_t* config);
+
+/**
+ * @brief Деинициализация клиента
+ * Deinitialize client
+ */
+esp_err_t stt_client_deinit(stt_client_handle_t handle);
+
+/**
+ * @brief Callback завершения запроса
+ * Request completion callback
+ *
+ * Вызывается из задачи клиента; result равен NULL при ошибке.
+ * Повторенный из очереди сегмент приходит с result->is_replayed.
+ * Called from the client task; result is NULL on failure.
+ * A segment replayed from the spool arrives with result->is_replayed set.
+ */
+typedef void (*stt_client_result_callback_t)(uint32_t sequence, esp_err_t status,
+                                             const speech_result_t* result, void* user_data);
+
+esp_err_t stt_client_set_callback(stt_client_handle_t handle, stt_client_result_callback_t callback,
+                                  void* user_data);
+
+/**
+ * @brief Подключить офлайн-очередь
+ * Attach the offline spool
+ *
+ * Сегменты, не распознанные из-за сети, сохраняются и повторяются позже
+ * (статус STT_CLIENT_ERR_SPOOLED). NULL отключает очередь.
+ * Segments that failed because of the network are stored and replayed later
+ * (status STT_CLIENT_ERR_SPOOLED). NULL detaches the spool.
+ */
+esp_err_t stt_client_set_spool(stt_client_handle_t handle, stt_spool_handle_t spool);
+
+/**
+ * @brief Поставить фрагмент аудио в очередь распознавания (не блокирует)
+ * Queue an audio fragment for recognition (non-blocking)
+ *
+ * Клиент становится владельцем samples (выделенных malloc) и освобождает их.
+ * Очередь без блокировок с одним писателем: вызовы не должны пересекаться
+ * (распознаватель вызывает под своей блокировкой).
+ * The client takes ownership of samples (allocated with malloc) and frees them.
+ * The queue is lock-free with a single producer: calls must not overlap (the
+ * recognizer calls it under its own lock).
+ */
+esp_err_t stt_client_submit(stt_client_handle_t handle, uint32_t sequence, int16_t* samples, size_t sample_count);
+
+/**
+ * @brief Отменить запрос
+ * Cancel a request
+ *
+ * Неотправленный запрос не отправляется; ответ на отправленный отбрасывается без callback.
+ * An unsent request is not sent; the answer to a sent one is dropped without a callback.
+ */
+esp_err_t stt_client_cancel(stt_client_handle_t handle, uint32_t sequence);
+
+/**
+ * @brief Получить статистику клиента
+ * Get client statistics
+ */
+typedef struct {
+    uint32_t requests_sent;        // Отправлено запросов / Requests sent
+    uint32_t pipelined_requests;   // Отправлено до ответа на предыдущий / Sent before the previous response
+    uint32_t max_in_flight;        // Максимум одновременных запросов / Peak concurrent requests
+    uint32_t requests_failed;      // Неудачных запросов / Failed requests
+    uint32_t requests_cancelled;   // Отменено запросов / Requests cancelled
+    uint32_t stale_retries;        // Повторов после разрыва соединения / Retries after a dropped connection
+    uint32_t requests_spooled;     // Сохранено в офлайн-очередь / Saved to the offline spool
+    uint32_t requests_replayed;    // Распознано из офлайн-очереди / Recognized from the offline spool
+    uint32_t last_latency_ms;      // Задержка последнего ответа / Last response latency
+} stt_client_stats_t;
+
+esp_err_t stt_client_get_stats(stt_client_handle_t handle, stt_client_stats_t* stats);
+
+#endif // STT_CLIENT_H
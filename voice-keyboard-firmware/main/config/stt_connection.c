@@ -0,0 +1,603 @@
+/**
+ * @file stt_connection.c
+ * @brief STT server connection pool implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация пула соединений с сервером распознавания речи
+ * Implementation of speech-to-text server connection pool
+ */
+
+#include "stt_connection.h"
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+#include "mbedtls/ssl.h"
+#include "mbedtls/platform_util.h"
+#endif
+
+static const char* TAG = "STT_CONNECTION";
+
+// Период проверки простаивающих соединений / Idle sweep period
+#define STT_CONNECTION_SWEEP_INTERVAL_MS  1000
+// Длина мастер-секрета TLS 1.2 / TLS 1.2 master secret length
+#define STT_MASTER_SECRET_LEN             48
+
+// Состояние слота пула / Pool slot state
+typedef enum {
+    SLOT_EMPTY,      // Нет соединения / No connection
+    SLOT_OPENING,    // Идет рукопожатие / Handshake in progress
+    SLOT_IDLE,       // Открыто и свободно / Open and free
+    SLOT_IN_USE      // Выдано загрузчику / Handed to the uploader
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    esp_tls_t* tls;
+    int64_t last_used_us;
+} stt_connection_slot_t;
+
+// Внутренняя структура пула / Internal pool structure
+struct stt_connection_pool {
+    stt_connection_config_t config;
+    char host[64];
+
+    stt_connection_slot_t slots[STT_CONNECTION_POOL_SIZE];
+    SemaphoreHandle_t lock;            // Защита слотов и статистики / Guards slots and stats
+    SemaphoreHandle_t slot_event;      // Сигнал об изменении слотов / Slot change signal
+    SemaphoreHandle_t handshake_lock;  // Сериализует рукопожатия и билет / Serializes handshakes and the ticket
+
+    TaskHandle_t worker;
+
+    // Состояние сети (события Wi-Fi/IP) / Network state (Wi-Fi/IP events)
+    bool network_up;
+    bool prewarm_pending;              // Прогрев запрошен без сети / Prewarm requested while offline
+    esp_event_handler_instance_t got_ip_handler;
+    esp_event_handler_instance_t disconnected_handler;
+
+    // Сессионный билет TLS и мастер-секрет его сессии / TLS session ticket and its session's master secret
+    esp_tls_client_session_t* session;
+    unsigned char session_master[STT_MASTER_SECRET_LEN];
+
+    // Статистика / Statistics
+    stt_connection_stats_t stats;
+};
+
+/**
+ * @brief Проверить, что простаивающее соединение не закрыто сервером
+ * Check that an idle connection has not been closed by the server
+ */
+static bool connection_is_alive(esp_tls_t* tls) {
+    int sockfd = -1;
+    if (esp_tls_get_conn_sockfd(tls, &sockfd) != ESP_OK || sockfd < 0) {
+        return false;
+    }
+
+    char byte;
+    int ret = recv(sockfd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (ret == 0) {
+        return false;  // FIN от сервера / FIN from server
+    }
+    if (ret < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    // Ожидающие данные (например, NewSessionTicket) / Pending data (e.g. NewSessionTicket)
+    return true;
+}
+
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+/**
+ * @brief Мастер-секрет установленной сессии
+ * Master secret of the established session
+ *
+ * Сессия, возобновленная по билету, сохраняет мастер-секрет прошлой, а полное
+ * рукопожатие выводит новый; публичного признака возобновления у mbedtls нет.
+ * A session resumed from a ticket keeps the previous master secret while a full
+ * handshake derives a new one; mbedtls has no public resumption flag.
+ */
+static bool get_session_master(esp_tls_t* tls, unsigned char master[STT_MASTER_SECRET_LEN]) {
+    mbedtls_ssl_context* ssl = esp_tls_get_ssl_context(tls);
+    mbedtls_ssl_session session;
+    bool ok = false;
+
+    if (!ssl) {
+        return false;
+    }
+
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(ssl, &session) == 0) {
+        memcpy(master, session.MBEDTLS_PRIVATE(master), STT_MASTER_SECRET_LEN);
+        ok = true;
+    }
+    mbedtls_ssl_session_free(&session);
+    return ok;
+}
+
+/**
+ * @brief Забыть билет (под handshake_lock)
+ * Forget the ticket (handshake_lock held)
+ */
+static void drop_session(struct stt_connection_pool* pool) {
+    if (pool->session) {
+        esp_tls_free_client_session(pool->session);
+        pool->session = NULL;
+    }
+    mbedtls_platform_zeroize(pool->session_master, sizeof(pool->session_master));
+}
+#endif
+
+/**
+ * @brief Открыть TLS соединение с сервером
+ * Open TLS connection to the server
+ */
+static esp_tls_t* open_connection(struct stt_connection_pool* pool) {
+    xSemaphoreTake(pool->handshake_lock, portMAX_DELAY);
+
+    tls_keep_alive_cfg_t keep_alive = {
+        .keep_alive_enable = true,
+        .keep_alive_idle = 5,
+        .keep_alive_interval = 5,
+        .keep_alive_count = 3,
+    };
+
+    esp_tls_cfg_t cfg = {
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms = pool->config.connect_timeout_ms,
+        .keep_alive_cfg = &keep_alive,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .client_session = pool->session,
+#endif
+    };
+
+    bool with_ticket = false;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    with_ticket = pool->session != NULL;
+#endif
+
+    esp_tls_t* tls = esp_tls_init();
+    if (!tls) {
+        ESP_LOGE(TAG, "Failed to allocate TLS context");
+        xSemaphoreGive(pool->handshake_lock);
+        return NULL;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(pool->host, strlen(pool->host), pool->config.port, &cfg, tls);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    if (ret != 1) {
+        // Ошибка DNS, TCP или таймаут до рукопожатия билет не портит
+        // A DNS, TCP or timeout failure before the handshake says nothing about the ticket
+        esp_err_t last_error = ESP_FAIL;
+        int tls_code = 0;
+        int tls_flags = 0;
+        esp_tls_error_handle_t error_handle = NULL;
+        if (esp_tls_get_error_handle(tls, &error_handle) == ESP_OK && error_handle) {
+            last_error = esp_tls_get_and_clear_last_error(error_handle, &tls_code, &tls_flags);
+        }
+        ESP_LOGE(TAG, "Connection to %s:%d failed after %u ms: %s (TLS -0x%x)", pool->host, pool->config.port,
+                 elapsed_ms, esp_err_to_name(last_error), (unsigned)-tls_code);
+        esp_tls_conn_destroy(tls);
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        // Сервер отверг рукопожатие с билетом - билет больше не предлагаем
+        // The server rejected the handshake that offered the ticket - stop offering it
+        if (pool->session && last_error == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED) {
+            ESP_LOGW(TAG, "Handshake with session ticket rejected, dropping the ticket");
+            drop_session(pool);
+        }
+#endif
+        xSemaphoreGive(pool->handshake_lock);
+
+        xSemaphoreTake(pool->lock, portMAX_DELAY);
+        pool->stats.connect_failures++;
+        xSemaphoreGive(pool->lock);
+        return NULL;
+    }
+
+    bool resumed = false;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    unsigned char master[STT_MASTER_SECRET_LEN];
+    bool have_master = get_session_master(tls, master);
+    resumed = with_ticket && have_master && memcmp(master, pool->session_master, sizeof(master)) == 0;
+
+    // Сохранение билета для следующего подключения / Keep ticket for the next connect
+    esp_tls_client_session_t* session = esp_tls_get_client_session(tls);
+    if (session && have_master) {
+        drop_session(pool);
+        pool->session = session;
+        memcpy(pool->session_master, master, sizeof(master));
+    } else if (session) {
+        esp_tls_free_client_session(session);
+    }
+    mbedtls_platform_zeroize(master, sizeof(master));
+#endif
+    xSemaphoreGive(pool->handshake_lock);
+
+    ESP_LOGI(TAG, "TLS handshake with %s:%d took %u ms (%s)", pool->host, pool->config.port, elapsed_ms,
+             resumed ? "resumed" : with_ticket ? "full, ticket declined" : "full");
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    if (resumed) {
+        pool->stats.resumed_handshakes++;
+    } else {
+        pool->stats.full_handshakes++;
+        if (with_ticket) {
+            pool->stats.declined_tickets++;
+        }
+    }
+    pool->stats.last_handshake_ms = elapsed_ms;
+    xSemaphoreGive(pool->lock);
+
+    return tls;
+}
+
+/**
+ * @brief Закрыть соединение слота (под блокировкой)
+ * Close slot connection (lock held)
+ */
+static void close_slot(stt_connection_slot_t* slot) {
+    if (slot->tls) {
+        esp_tls_conn_destroy(slot->tls);
+    }
+    slot->tls = NULL;
+    slot->state = SLOT_EMPTY;
+}
+
+/**
+ * @brief Открыть соединение в фоне, если в пуле нет готового
+ * Open a connection in the background if none is ready
+ */
+static void prewarm_one(struct stt_connection_pool* pool) {
+    stt_connection_slot_t* target = NULL;
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    if (!pool->network_up) {
+        // Прогреем, когда появится IP / Prewarm once an IP is obtained
+        pool->prewarm_pending = true;
+        xSemaphoreGive(pool->lock);
+        return;
+    }
+    for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+        stt_connection_slot_t* slot = &pool->slots[i];
+        if (slot->state == SLOT_IDLE && !connection_is_alive(slot->tls)) {
+            close_slot(slot);
+            pool->stats.stale_closes++;
+        }
+        if (slot->state == SLOT_IDLE || slot->state == SLOT_OPENING) {
+            // Уже прогрето - продлеваем жизнь / Already warm - extend its lifetime
+            slot->last_used_us = now;
+            xSemaphoreGive(pool->lock);
+            return;
+        }
+        if (slot->state == SLOT_EMPTY && !target) {
+            target = slot;
+        }
+    }
+    if (target) {
+        target->state = SLOT_OPENING;
+    }
+    xSemaphoreGive(pool->lock);
+
+    if (!target) {
+        return;  // Все соединения заняты / All connections busy
+    }
+
+    esp_tls_t* tls = open_connection(pool);
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    target->tls = tls;
+    target->state = tls ? SLOT_IDLE : SLOT_EMPTY;
+    target->last_used_us = esp_timer_get_time();
+    xSemaphoreGive(pool->lock);
+    xSemaphoreGive(pool->slot_event);
+}
+
+/**
+ * @brief Закрыть соединения, простаивающие дольше таймаута
+ * Close connections idle for longer than the timeout
+ */
+static void sweep_idle(struct stt_connection_pool* pool) {
+    int64_t now = esp_timer_get_time();
+    int64_t idle_limit_us = (int64_t)pool->config.idle_timeout_ms * 1000;
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+        stt_connection_slot_t* slot = &pool->slots[i];
+        if (slot->state != SLOT_IDLE) {
+            continue;
+        }
+        if (now - slot->last_used_us > idle_limit_us) {
+            ESP_LOGI(TAG, "Closing idle connection (slot %d)", i);
+            close_slot(slot);
+            pool->stats.idle_closes++;
+        } else if (!connection_is_alive(slot->tls)) {
+            ESP_LOGI(TAG, "Server closed idle connection (slot %d)", i);
+            close_slot(slot);
+            pool->stats.stale_closes++;
+        }
+    }
+    xSemaphoreGive(pool->lock);
+}
+
+/**
+ * @brief Обработчик событий сети: соединения открываются только при наличии IP
+ * Network event handler: connections are opened only while an IP is held
+ */
+static void network_event_handler(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    struct stt_connection_pool* pool = (struct stt_connection_pool*)arg;
+    bool up = base == IP_EVENT && id == IP_EVENT_STA_GOT_IP;
+    bool prewarm = false;
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    pool->network_up = up;
+    if (up) {
+        prewarm = pool->prewarm_pending;
+        pool->prewarm_pending = false;
+    } else {
+        // Простаивающие соединения пережили обрыв только на бумаге / Idle connections did not survive the drop
+        for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+            if (pool->slots[i].state == SLOT_IDLE) {
+                close_slot(&pool->slots[i]);
+                pool->stats.stale_closes++;
+            }
+        }
+    }
+    xSemaphoreGive(pool->lock);
+
+    ESP_LOGI(TAG, "Network %s", up ? "up" : "down");
+
+    // Разбудить ждущих acquire / Wake up waiting acquirers
+    xSemaphoreGive(pool->slot_event);
+    if (prewarm) {
+        xTaskNotifyGive(pool->worker);
+    }
+}
+
+/**
+ * @brief Задача обслуживания пула
+ * Pool maintenance task
+ */
+static void connection_worker(void* arg) {
+    struct stt_connection_pool* pool = (struct stt_connection_pool*)arg;
+
+    for (;;) {
+        uint32_t prewarm = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STT_CONNECTION_SWEEP_INTERVAL_MS));
+        if (prewarm) {
+            prewarm_one(pool);
+        }
+        sweep_idle(pool);
+    }
+}
+
+esp_err_t stt_connection_pool_init(stt_connection_pool_handle_t* handle, const stt_connection_config_t* config) {
+    if (!handle || !config || !config->host) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (strlen(config->host) >= sizeof((*handle)->host)) {
+        ESP_LOGE(TAG, "Host name too long: %s", config->host);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = malloc(sizeof(struct stt_connection_pool));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for connection pool");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Инициализация структуры / Initialize structure
+    memset(*handle, 0, sizeof(struct stt_connection_pool));
+    (*handle)->config = *config;
+    strcpy((*handle)->host, config->host);
+    (*handle)->config.host = (*handle)->host;
+
+    // Установка параметров по умолчанию / Set default parameters
+    if ((*handle)->config.connect_timeout_ms == 0) {
+        (*handle)->config.connect_timeout_ms = 5000;
+    }
+    if ((*handle)->config.idle_timeout_ms == 0) {
+        (*handle)->config.idle_timeout_ms = 60000;
+    }
+
+    (*handle)->lock = xSemaphoreCreateMutex();
+    (*handle)->slot_event = xSemaphoreCreateBinary();
+    (*handle)->handshake_lock = xSemaphoreCreateMutex();
+    if (!(*handle)->lock || !(*handle)->slot_event || !(*handle)->handshake_lock) {
+        ESP_LOGE(TAG, "Failed to create pool semaphores");
+        if ((*handle)->lock) vSemaphoreDelete((*handle)->lock);
+        if ((*handle)->slot_event) vSemaphoreDelete((*handle)->slot_event);
+        if ((*handle)->handshake_lock) vSemaphoreDelete((*handle)->handshake_lock);
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreatePinnedToCore(connection_worker, "stt_conn", STT_CONNECTION_TASK_STACK_SIZE, *handle,
+                                STT_CONNECTION_TASK_PRIORITY, &(*handle)->worker, IO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create connection task");
+        vSemaphoreDelete((*handle)->lock);
+        vSemaphoreDelete((*handle)->slot_event);
+        vSemaphoreDelete((*handle)->handshake_lock);
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Соединения открываются после IP_EVENT_STA_GOT_IP (wifi_config.h) / Connections open after IP_EVENT_STA_GOT_IP (wifi_config.h)
+    esp_err_t ret = esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, network_event_handler,
+                                                        *handle, &(*handle)->got_ip_handler);
+    if (ret == ESP_OK) {
+        ret = esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, network_event_handler,
+                                                  *handle, &(*handle)->disconnected_handler);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register network event handlers: %s", esp_err_to_name(ret));
+        if ((*handle)->got_ip_handler) {
+            esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, (*handle)->got_ip_handler);
+        }
+        vTaskDelete((*handle)->worker);
+        vSemaphoreDelete((*handle)->lock);
+        vSemaphoreDelete((*handle)->slot_event);
+        vSemaphoreDelete((*handle)->handshake_lock);
+        free(*handle);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Connection pool initialized: %s:%d, idle timeout %u ms",
+             (*handle)->host, config->port, (*handle)->config.idle_timeout_ms);
+    return ESP_OK;
+}
+
+esp_err_t stt_connection_pool_deinit(stt_connection_pool_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, handle->got_ip_handler);
+    esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, handle->disconnected_handler);
+
+    // Дождаться завершения рукопожатия / Wait for any handshake to finish
+    xSemaphoreTake(handle->handshake_lock, portMAX_DELAY);
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    vTaskDelete(handle->worker);
+
+    for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+        close_slot(&handle->slots[i]);
+    }
+
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    drop_session(handle);
+#endif
+
+    vSemaphoreDelete(handle->lock);
+    vSemaphoreDelete(handle->slot_event);
+    vSemaphoreDelete(handle->handshake_lock);
+    free(handle);
+    ESP_LOGI(TAG, "Connection pool deinitialized");
+
+    return ESP_OK;
+}
+
+esp_err_t stt_connection_pool_prewarm(stt_connection_pool_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->stats.prewarm_requests++;
+    xSemaphoreGive(handle->lock);
+
+    xTaskNotifyGive(handle->worker);
+    return ESP_OK;
+}
+
+esp_err_t stt_connection_pool_acquire(stt_connection_pool_handle_t handle, esp_tls_t** conn, TickType_t timeout) {
+    if (!handle || !conn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;) {
+        stt_connection_slot_t* target = NULL;
+        bool opening = false;
+
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+            stt_connection_slot_t* slot = &handle->slots[i];
+            if (slot->state == SLOT_IDLE) {
+                if (connection_is_alive(slot->tls)) {
+                    slot->state = SLOT_IN_USE;
+                    handle->stats.reused_connections++;
+                    *conn = slot->tls;
+                    xSemaphoreGive(handle->lock);
+                    return ESP_OK;
+                }
+                close_slot(slot);
+                handle->stats.stale_closes++;
+            }
+            if (slot->state == SLOT_OPENING) {
+                opening = true;
+            }
+            if (slot->state == SLOT_EMPTY && !target) {
+                target = slot;
+            }
+        }
+
+        // Дождаться идущего прогрева быстрее, чем новое рукопожатие; без сети - ждать IP
+        // Waiting for an in-flight prewarm is faster than a new handshake; offline - wait for an IP
+        if (!opening && target && handle->network_up) {
+            target->state = SLOT_OPENING;
+            xSemaphoreGive(handle->lock);
+
+            esp_tls_t* tls = open_connection(handle);
+
+            xSemaphoreTake(handle->lock, portMAX_DELAY);
+            target->tls = tls;
+            target->state = tls ? SLOT_IN_USE : SLOT_EMPTY;
+            xSemaphoreGive(handle->lock);
+
+            if (!tls) {
+                return ESP_FAIL;
+            }
+            *conn = tls;
+            return ESP_OK;
+        }
+        xSemaphoreGive(handle->lock);
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreTake(handle->slot_event, timeout - elapsed);
+    }
+}
+
+esp_err_t stt_connection_pool_release(stt_connection_pool_handle_t handle, esp_tls_t* conn, bool reusable) {
+    if (!handle || !conn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    for (int i = 0; i < STT_CONNECTION_POOL_SIZE; i++) {
+        stt_connection_slot_t* slot = &handle->slots[i];
+        if (slot->state == SLOT_IN_USE && slot->tls == conn) {
+            if (reusable) {
+                slot->state = SLOT_IDLE;
+                slot->last_used_us = esp_timer_get_time();
+            } else {
+                close_slot(slot);
+            }
+            xSemaphoreGive(handle->lock);
+            xSemaphoreGive(handle->slot_event);
+            return ESP_OK;
+        }
+    }
+    xSemaphoreGive(handle->lock);
+
+    ESP_LOGW(TAG, "Released connection does not belong to the pool");
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t stt_connection_pool_get_stats(stt_connection_pool_handle_t handle, stt_connection_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *stats = handle->stats;
+    xSemaphoreGive(handle->lock);
+    return ESP_OK;
+}
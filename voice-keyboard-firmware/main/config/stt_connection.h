@@ -0,0 +1,98 @@
+/**
+ * @file stt_connection.h
+ * @brief STT server connection pool header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл пула соединений с сервером распознавания речи
+ * Header file for speech-to-text server connection pool
+ *
+ * Пул подписывается на события Wi-Fi и IP, поэтому создается после
+ * wifi_init(). До IP_EVENT_STA_GOT_IP прогрев откладывается, а acquire ждет.
+ * The pool subscribes to Wi-Fi and IP events, so it is created after
+ * wifi_init(). Until IP_EVENT_STA_GOT_IP, prewarm is deferred and acquire waits.
+ */
+
+#ifndef STT_CONNECTION_H
+#define STT_CONNECTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_tls.h"
+#include "freertos/FreeRTOS.h"
+
+// Размер пула соединений / Connection pool size
+#define STT_CONNECTION_POOL_SIZE   2
+
+// Конфигурация пула соединений / Connection pool configuration
+typedef struct {
+    const char* host;             // Хост сервера / Server host
+    int port;                     // Порт сервера / Server port
+    uint32_t connect_timeout_ms;  // Таймаут подключения / Connect timeout
+    uint32_t idle_timeout_ms;     // Время жизни простаивающего соединения / Idle connection lifetime
+} stt_connection_config_t;
+
+// Дескриптор пула соединений / Connection pool handle
+typedef struct stt_connection_pool* stt_connection_pool_handle_t;
+
+/**
+ * @brief Инициализация пула соединений
+ * Initialize connection pool
+ */
+esp_err_t stt_connection_pool_init(stt_connection_pool_handle_t* handle, const stt_connection_config_t* config);
+
+/**
+ * @brief Деинициализация пула соединений
+ * Deinitialize connection pool
+ */
+esp_err_t stt_connection_pool_deinit(stt_connection_pool_handle_t handle);
+
+/**
+ * @brief Заранее открыть соединение (не блокирует)
+ * Open a connection ahead of time (non-blocking)
+ *
+ * Вызывается по нажатию кнопки, чтобы TLS рукопожатие завершилось во время речи.
+ * Called on button press so the TLS handshake completes while the user speaks.
+ */
+esp_err_t stt_connection_pool_prewarm(stt_connection_pool_handle_t handle);
+
+/**
+ * @brief Получить соединение для загрузки
+ * Acquire a connection for upload
+ *
+ * Возвращает открытое соединение из пула или открывает новое.
+ * Returns an open pooled connection or opens a new one.
+ * Без сети ждет IP не дольше timeout (ESP_ERR_TIMEOUT).
+ * While offline, waits for an IP for at most timeout (ESP_ERR_TIMEOUT).
+ */
+esp_err_t stt_connection_pool_acquire(stt_connection_pool_handle_t handle, esp_tls_t** conn, TickType_t timeout);
+
+/**
+ * @brief Вернуть соединение в пул
+ * Return connection to the pool
+ *
+ * @param reusable false если соединение нельзя использовать повторно (ошибка, Connection: close)
+ *                 false if the connection must not be reused (error, Connection: close)
+ */
+esp_err_t stt_connection_pool_release(stt_connection_pool_handle_t handle, esp_tls_t* conn, bool reusable);
+
+/**
+ * @brief Получить статистику соединений
+ * Get connection statistics
+ */
+typedef struct {
+    uint32_t full_handshakes;      // Полных TLS рукопожатий / Full TLS handshakes
+    uint32_t resumed_handshakes;   // Сессий, возобновленных по билету / Sessions resumed from a ticket
+    uint32_t declined_tickets;     // Билет предложен, но рукопожатие полное / Ticket offered, yet the handshake was full
+    uint32_t reused_connections;   // Выдано уже открытых соединений / Already-open connections handed out
+    uint32_t prewarm_requests;     // Запросов прогрева / Prewarm requests
+    uint32_t idle_closes;          // Закрыто по таймауту простоя / Closed on idle timeout
+    uint32_t stale_closes;         // Закрыто сервером во время простоя / Closed by server while idle
+    uint32_t connect_failures;     // Ошибок подключения / Connect failures
+    uint32_t last_handshake_ms;    // Длительность последнего рукопожатия / Last handshake duration
+} stt_connection_stats_t;
+
+esp_err_t stt_connection_pool_get_stats(stt_connection_pool_handle_t handle, stt_connection_stats_t* stats);
+
+#endif // STT_CONNECTION_H
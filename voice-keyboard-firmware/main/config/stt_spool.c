@@ -0,0 +1,637 @@
+/**
+ * @file stt_spool.c
+ * @brief Offline utterance spool implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация офлайн-очереди высказываний во flash
+ * Implementation of the flash-backed offline utterance spool
+ */
+
+#include "stt_spool.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char* TAG = "STT_SPOOL";
+
+// Размер сектора flash / Flash sector size
+#define STT_SPOOL_SECTOR_SIZE   4096
+// Сигнатура записи / Record signature
+#define STT_SPOOL_MAGIC         0x4C4F4F53  // "SOOL"
+// Размер блока кодирования / Encoding chunk size
+#define STT_SPOOL_CHUNK_SIZE    256
+// Секторов, стираемых заранее в простое / Sectors erased ahead while idle
+#define STT_SPOOL_PRE_ERASE_SECTORS 8
+
+// Заголовок записи во flash / On-flash record header
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t sample_count;
+    uint32_t data_bytes;
+} spool_record_header_t;
+
+// Запись в индексе / Index entry
+typedef struct {
+    uint32_t sequence;
+    uint32_t start_sector;
+    uint32_t sectors;
+    uint32_t sample_count;
+    int64_t stored_us;
+} spool_record_t;
+
+// Состояние IMA ADPCM / IMA ADPCM state
+typedef struct {
+    int32_t predictor;
+    int index;
+} adpcm_state_t;
+
+// Внутренняя структура очереди / Internal spool structure
+struct stt_spool {
+    stt_spool_config_t config;
+    const esp_partition_t* partition;
+    uint32_t total_sectors;
+    SemaphoreHandle_t lock;
+
+    // Кольцо записей (FIFO) / Record ring (FIFO)
+    spool_record_t records[STT_SPOOL_MAX_RECORDS];
+    int head;
+    int count;
+    uint32_t write_sector;
+
+    // Заранее стертые секторы [erased_from, erased_to) от позиции записи
+    // Sectors erased ahead [erased_from, erased_to) from the write position
+    uint32_t erased_from;
+    uint32_t erased_to;
+
+    // Экспоненциальная задержка / Exponential backoff
+    uint32_t failures;
+    int64_t next_attempt_us;
+
+    // Статистика / Statistics
+    stt_spool_stats_t stats;
+};
+
+// Таблицы IMA ADPCM / IMA ADPCM tables
+static const int8_t ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int16_t ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+/**
+ * @brief Обновить предсказатель и индекс шага ADPCM
+ * Update ADPCM predictor and step index
+ */
+static void adpcm_update(adpcm_state_t* state, uint8_t code, int delta) {
+    state->predictor += (code & 8) ? -delta : delta;
+    if (state->predictor > 32767) {
+        state->predictor = 32767;
+    } else if (state->predictor < -32768) {
+        state->predictor = -32768;
+    }
+
+    state->index += ima_index_table[code];
+    if (state->index < 0) {
+        state->index = 0;
+    } else if (state->index > 88) {
+        state->index = 88;
+    }
+}
+
+/**
+ * @brief Закодировать сэмпл в 4 бита
+ * Encode a sample into 4 bits
+ */
+static uint8_t adpcm_encode_sample(adpcm_state_t* state, int16_t sample) {
+    int step = ima_step_table[state->index];
+    int diff = sample - state->predictor;
+    int delta = step >> 3;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+
+    adpcm_update(state, code, delta);
+    return code;
+}
+
+/**
+ * @brief Декодировать 4-битный код
+ * Decode a 4-bit code
+ */
+static int16_t adpcm_decode_sample(adpcm_state_t* state, uint8_t code) {
+    int step = ima_step_table[state->index];
+    int delta = step >> 3;
+
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+
+    adpcm_update(state, code, delta);
+    return (int16_t)state->predictor;
+}
+
+/**
+ * @brief Запись по позиции от головы
+ * Record by offset from head
+ */
+static spool_record_t* record_at(struct stt_spool* spool, int offset) {
+    return &spool->records[(spool->head + offset) % STT_SPOOL_MAX_RECORDS];
+}
+
+/**
+ * @brief Удалить самую старую запись (под блокировкой)
+ * Drop the oldest record (lock held)
+ */
+static void drop_oldest(struct stt_spool* spool) {
+    spool_record_t* record = record_at(spool, 0);
+    spool->stats.flash_bytes_used -= record->sectors * STT_SPOOL_SECTOR_SIZE;
+    spool->head = (spool->head + 1) % STT_SPOOL_MAX_RECORDS;
+    spool->count--;
+    spool->stats.queue_depth = spool->count;
+}
+
+/**
+ * @brief Пересекается ли диапазон секторов с записью
+ * Whether a sector range overlaps a record
+ */
+static bool overlaps(const spool_record_t* record, uint32_t start, uint32_t sectors) {
+    return record->start_sector < start + sectors && start < record->start_sector + record->sectors;
+}
+
+/**
+ * @brief Пересекается ли диапазон секторов с какой-либо записью (под блокировкой)
+ * Whether a sector range overlaps any record (lock held)
+ */
+static bool overlaps_any(struct stt_spool* spool, uint32_t start, uint32_t sectors) {
+    for (int i = 0; i < spool->count; i++) {
+        if (overlaps(record_at(spool, i), start, sectors)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Стерт ли сектор (все байты 0xFF)
+ * Whether a sector is blank (all bytes 0xFF)
+ */
+static bool sector_is_blank(struct stt_spool* spool, uint32_t sector) {
+    uint32_t chunk[STT_SPOOL_CHUNK_SIZE / sizeof(uint32_t)];
+    uint32_t offset = sector * STT_SPOOL_SECTOR_SIZE;
+    for (uint32_t done = 0; done < STT_SPOOL_SECTOR_SIZE; done += sizeof(chunk)) {
+        if (esp_partition_read(spool->partition, offset + done, chunk, sizeof(chunk)) != ESP_OK) {
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(chunk) / sizeof(chunk[0]); i++) {
+            if (chunk[i] != UINT32_MAX) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Отбросить устаревшие записи (под блокировкой)
+ * Discard expired records (lock held)
+ */
+static void expire_records(struct stt_spool* spool) {
+    if (spool->config.policy != STT_SPOOL_DISCARD_AFTER_TIMEOUT) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t lifetime_us = (int64_t)spool->config.discard_after_ms * 1000;
+    while (spool->count > 0 && now - record_at(spool, 0)->stored_us > lifetime_us) {
+        ESP_LOGW(TAG, "Segment #%u expired after %u ms, discarded",
+                 record_at(spool, 0)->sequence, spool->config.discard_after_ms);
+        drop_oldest(spool);
+        spool->stats.records_expired++;
+    }
+}
+
+/**
+ * @brief Задержка повтора с джиттером
+ * Retry delay with jitter
+ *
+ * Половина задержки фиксирована, половина случайна, чтобы устройства
+ * не повторяли запросы синхронно после восстановления точки доступа.
+ * Half of the delay is fixed and half random so devices don't retry in
+ * lockstep after the access point comes back.
+ */
+static uint32_t backoff_delay_ms(struct stt_spool* spool) {
+    uint32_t delay = spool->config.backoff_initial_ms;
+    for (uint32_t i = 0; i < spool->failures && delay < spool->config.backoff_max_ms; i++) {
+        delay *= 2;
+    }
+    if (delay > spool->config.backoff_max_ms) {
+        delay = spool->config.backoff_max_ms;
+    }
+
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+esp_err_t stt_spool_init(stt_spool_handle_t* handle, const stt_spool_config_t* config) {
+    if (!handle || !config || !config->partition_label) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY,
+                                                                config->partition_label);
+    if (!partition) {
+        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = malloc(sizeof(struct stt_spool));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for spool");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Инициализация структуры / Initialize structure
+    memset(*handle, 0, sizeof(struct stt_spool));
+    (*handle)->config = *config;
+    (*handle)->partition = partition;
+    (*handle)->total_sectors = partition->size / STT_SPOOL_SECTOR_SIZE;
+
+    // Установка параметров по умолчанию / Set default parameters
+    if ((*handle)->config.backoff_initial_ms == 0) {
+        (*handle)->config.backoff_initial_ms = 1000;
+    }
+    if ((*handle)->config.backoff_max_ms == 0) {
+        (*handle)->config.backoff_max_ms = 60000;
+    }
+    if ((*handle)->config.discard_after_ms == 0) {
+        (*handle)->config.discard_after_ms = 30000;
+    }
+
+    (*handle)->lock = xSemaphoreCreateMutex();
+    if (!(*handle)->lock) {
+        ESP_LOGE(TAG, "Failed to create spool mutex");
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    (*handle)->stats.queue_capacity = STT_SPOOL_MAX_RECORDS;
+    (*handle)->stats.flash_bytes_total = (*handle)->total_sectors * STT_SPOOL_SECTOR_SIZE;
+
+    ESP_LOGI(TAG, "Spool initialized: %u KB on '%s', policy=%s",
+             (*handle)->stats.flash_bytes_total / 1024, config->partition_label,
+             config->policy == STT_SPOOL_TYPE_ON_ARRIVAL ? "type-on-arrival" : "discard-after-timeout");
+    return ESP_OK;
+}
+
+esp_err_t stt_spool_deinit(stt_spool_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    vSemaphoreDelete(handle->lock);
+    free(handle);
+    ESP_LOGI(TAG, "Spool deinitialized");
+
+    return ESP_OK;
+}
+
+esp_err_t stt_spool_set_policy(stt_spool_handle_t handle, stt_spool_policy_t policy, uint32_t discard_after_ms) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->config.policy = policy;
+    if (discard_after_ms > 0) {
+        handle->config.discard_after_ms = discard_after_ms;
+    }
+    xSemaphoreGive(handle->lock);
+
+    return ESP_OK;
+}
+
+esp_err_t stt_spool_store(stt_spool_handle_t handle, uint32_t sequence, const int16_t* samples, size_t sample_count) {
+    if (!handle || !samples || sample_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    spool_record_header_t header = {
+        .magic = STT_SPOOL_MAGIC,
+        .sequence = sequence,
+        .sample_count = sample_count,
+        .data_bytes = (sample_count + 1) / 2,
+    };
+    uint32_t sectors = (sizeof(header) + header.data_bytes + STT_SPOOL_SECTOR_SIZE - 1) / STT_SPOOL_SECTOR_SIZE;
+    if (sectors > handle->total_sectors) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+
+    // Записи лежат подряд; не помещающаяся в конец начинается с нуля
+    // Records are contiguous; one that doesn't fit at the end starts at zero
+    uint32_t start = handle->write_sector;
+    if (start + sectors > handle->total_sectors) {
+        start = 0;
+    }
+
+    // Вытеснение самых старых записей / Evict the oldest records
+    while (handle->count == STT_SPOOL_MAX_RECORDS || overlaps_any(handle, start, sectors)) {
+        ESP_LOGW(TAG, "Spool full, evicting segment #%u", record_at(handle, 0)->sequence);
+        drop_oldest(handle);
+        handle->stats.records_evicted++;
+    }
+
+    // Резерв диапазона; секторы, стертые заранее, не стираются повторно
+    // Reserve the range; sectors erased ahead of time are not erased again
+    uint32_t end = start + sectors;
+    uint32_t erase_from = start;
+    if (start == handle->erased_from) {
+        erase_from = handle->erased_to < end ? handle->erased_to : end;
+    } else {
+        handle->erased_to = end;
+    }
+    handle->erased_from = end;
+    if (handle->erased_to < end) {
+        handle->erased_to = end;
+    }
+    handle->write_sector = end;
+
+    xSemaphoreGive(handle->lock);
+
+    // Стирание и запись без блокировки: store/load/complete вызывает только задача
+    // клиента, а статистику читают другие задачи
+    // Erase and write without the lock: only the client task calls
+    // store/load/complete, while other tasks read the statistics
+    uint32_t offset = start * STT_SPOOL_SECTOR_SIZE;
+    esp_err_t ret = ESP_OK;
+    if (erase_from < end) {
+        ret = esp_partition_erase_range(handle->partition, erase_from * STT_SPOOL_SECTOR_SIZE,
+                                        (end - erase_from) * STT_SPOOL_SECTOR_SIZE);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(handle->partition, offset, &header, sizeof(header));
+    }
+
+    // Потоковое сжатие небольшими блоками / Streaming compression in small chunks
+    uint8_t chunk[STT_SPOOL_CHUNK_SIZE];
+    adpcm_state_t state = {0};
+    uint32_t write_offset = offset + sizeof(header);
+    size_t i = 0;
+    while (ret == ESP_OK && i < sample_count) {
+        size_t len = 0;
+        while (len < sizeof(chunk) && i < sample_count) {
+            uint8_t code = adpcm_encode_sample(&state, samples[i++]);
+            if (i < sample_count) {
+                code |= adpcm_encode_sample(&state, samples[i++]) << 4;
+            }
+            chunk[len++] = code;
+        }
+        ret = esp_partition_write(handle->partition, write_offset, chunk, len);
+        write_offset += len;
+    }
+
+    if (ret != ESP_OK) {
+        // Зарезервированные секторы займет следующий круг / The next lap reuses the reserved sectors
+        ESP_LOGE(TAG, "Failed to write segment #%u: %s", sequence, esp_err_to_name(ret));
+        return ret;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+
+    if (handle->count == 0) {
+        // Первая запись: повтор после начальной задержки / First record: replay after the initial delay
+        handle->failures = 0;
+        handle->next_attempt_us = esp_timer_get_time() + (int64_t)backoff_delay_ms(handle) * 1000;
+    }
+
+    spool_record_t* record = record_at(handle, handle->count);
+    record->sequence = sequence;
+    record->start_sector = start;
+    record->sectors = sectors;
+    record->sample_count = sample_count;
+    record->stored_us = esp_timer_get_time();
+    handle->count++;
+
+    handle->stats.records_stored++;
+    handle->stats.queue_depth = handle->count;
+    handle->stats.flash_bytes_used += sectors * STT_SPOOL_SECTOR_SIZE;
+
+    ESP_LOGI(TAG, "Segment #%u spooled: %u samples -> %u bytes (%u queued)",
+             sequence, (unsigned)sample_count, header.data_bytes, handle->count);
+
+    xSemaphoreGive(handle->lock);
+    return ESP_OK;
+}
+
+esp_err_t stt_spool_pre_erase(stt_spool_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Следующий сектор после стертых, если он свободен и в пределах окна
+    // The sector after the erased ones, if it is free and within the window
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->erased_from != handle->write_sector) {
+        handle->erased_from = handle->write_sector;
+        handle->erased_to = handle->write_sector;
+    }
+    uint32_t sector = handle->erased_to;
+    bool pending = sector < handle->total_sectors &&
+                   sector - handle->write_sector < STT_SPOOL_PRE_ERASE_SECTORS &&
+                   !overlaps_any(handle, sector, 1);
+    xSemaphoreGive(handle->lock);
+
+    if (!pending) {
+        return ESP_OK;
+    }
+
+    // Чистый сектор не стирается повторно (износ flash) / A blank sector is not erased again (flash wear)
+    esp_err_t ret = ESP_OK;
+    if (!sector_is_blank(handle, sector)) {
+        ret = esp_partition_erase_range(handle->partition, sector * STT_SPOOL_SECTOR_SIZE, STT_SPOOL_SECTOR_SIZE);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to pre-erase sector %u: %s", sector, esp_err_to_name(ret));
+        return ret;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->erased_from == handle->write_sector && handle->erased_to == sector) {
+        handle->erased_to = sector + 1;
+    }
+    xSemaphoreGive(handle->lock);
+
+    return ESP_ERR_NOT_FINISHED;
+}
+
+uint32_t stt_spool_next_due_ms(stt_spool_handle_t handle) {
+    if (!handle) {
+        return UINT32_MAX;
+    }
+
+    uint32_t due_ms = 0;
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    expire_records(handle);
+    if (handle->count == 0) {
+        due_ms = UINT32_MAX;
+    } else {
+        int64_t remaining_us = handle->next_attempt_us - esp_timer_get_time();
+        due_ms = remaining_us > 0 ? (uint32_t)(remaining_us / 1000) : 0;
+    }
+    xSemaphoreGive(handle->lock);
+
+    return due_ms;
+}
+
+esp_err_t stt_spool_load_oldest(stt_spool_handle_t handle, uint32_t* sequence, int16_t** samples, size_t* sample_count) {
+    if (!handle || !sequence || !samples || !sample_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    expire_records(handle);
+    if (handle->count == 0) {
+        xSemaphoreGive(handle->lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    spool_record_t record = *record_at(handle, 0);
+    uint32_t offset = record.start_sector * STT_SPOOL_SECTOR_SIZE;
+
+    spool_record_header_t header;
+    esp_err_t ret = esp_partition_read(handle->partition, offset, &header, sizeof(header));
+    if (ret != ESP_OK || header.magic != STT_SPOOL_MAGIC || header.sequence != record.sequence) {
+        ESP_LOGE(TAG, "Segment #%u is corrupted, dropped", record.sequence);
+        drop_oldest(handle);
+        xSemaphoreGive(handle->lock);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    int16_t* pcm = malloc(record.sample_count * sizeof(int16_t));
+    if (!pcm) {
+        xSemaphoreGive(handle->lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Потоковое чтение и распаковка / Streaming read and decompression
+    uint8_t chunk[STT_SPOOL_CHUNK_SIZE];
+    adpcm_state_t state = {0};
+    uint32_t read_offset = offset + sizeof(header);
+    size_t decoded = 0;
+    while (ret == ESP_OK && decoded < record.sample_count) {
+        size_t remaining_bytes = (record.sample_count - decoded + 1) / 2;
+        size_t len = remaining_bytes < sizeof(chunk) ? remaining_bytes : sizeof(chunk);
+        ret = esp_partition_read(handle->partition, read_offset, chunk, len);
+        read_offset += len;
+
+        for (size_t j = 0; j < len && decoded < record.sample_count; j++) {
+            pcm[decoded++] = adpcm_decode_sample(&state, chunk[j] & 0x0F);
+            if (decoded < record.sample_count) {
+                pcm[decoded++] = adpcm_decode_sample(&state, chunk[j] >> 4);
+            }
+        }
+    }
+    xSemaphoreGive(handle->lock);
+
+    if (ret != ESP_OK) {
+        free(pcm);
+        return ret;
+    }
+
+    *sequence = record.sequence;
+    *samples = pcm;
+    *sample_count = record.sample_count;
+    return ESP_OK;
+}
+
+esp_err_t stt_spool_complete(stt_spool_handle_t handle, uint32_t sequence, bool delivered) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->count == 0 || record_at(handle, 0)->sequence != sequence) {
+        // Запись вытеснена во время повтора / Record was evicted during the replay
+        xSemaphoreGive(handle->lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (delivered) {
+        drop_oldest(handle);
+        handle->stats.records_replayed++;
+        handle->failures = 0;
+        handle->next_attempt_us = esp_timer_get_time();
+    } else {
+        handle->failures++;
+        handle->stats.replay_failures++;
+        uint32_t delay_ms = backoff_delay_ms(handle);
+        handle->next_attempt_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+        ESP_LOGI(TAG, "Replay of segment #%u failed, next attempt in %u ms", sequence, delay_ms);
+    }
+    xSemaphoreGive(handle->lock);
+
+    return ESP_OK;
+}
+
+void stt_spool_notify_online(stt_spool_handle_t handle) {
+    if (!handle) {
+        return;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    if (handle->count > 0 && handle->failures > 0) {
+        handle->failures = 0;
+        handle->next_attempt_us = esp_timer_get_time();
+    }
+    xSemaphoreGive(handle->lock);
+}
+
+esp_err_t stt_spool_get_stats(stt_spool_handle_t handle, stt_spool_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *stats = handle->stats;
+    xSemaphoreGive(handle->lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file stt_spool.h
+ * @brief Offline utterance spool header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл офлайн-очереди высказываний во flash
+ * Header file for the flash-backed offline utterance spool
+ *
+ * Сегменты, которые не удалось распознать из-за сети, сжимаются IMA ADPCM (4:1)
+ * и пишутся в кольцо на разделе "spool". Клиент STT повторяет их с
+ * экспоненциальной задержкой и джиттером. Очередь очищается при загрузке.
+ * Segments that failed to recognize because of the network are compressed with
+ * IMA ADPCM (4:1) and written to a ring on the "spool" partition. The STT client
+ * replays them with exponential backoff and jitter. The spool is cleared at boot.
+ */
+
+#ifndef STT_SPOOL_H
+#define STT_SPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Максимум записей в очереди / Maximum queued records
+#define STT_SPOOL_MAX_RECORDS   16
+
+// Политика доставки / Delivery policy
+typedef enum {
+    STT_SPOOL_TYPE_ON_ARRIVAL,       // Напечатать, когда бы ни пришел ответ / Type whenever the answer arrives
+    STT_SPOOL_DISCARD_AFTER_TIMEOUT  // Отбросить через discard_after_ms / Discard after discard_after_ms
+} stt_spool_policy_t;
+
+// Конфигурация очереди / Spool configuration
+typedef struct {
+    const char* partition_label;     // Метка раздела / Partition label
+    stt_spool_policy_t policy;       // Политика доставки / Delivery policy
+    uint32_t discard_after_ms;       // Срок жизни записи / Record lifetime
+    uint32_t backoff_initial_ms;     // Начальная задержка повтора / Initial retry delay
+    uint32_t backoff_max_ms;         // Максимальная задержка повтора / Maximum retry delay
+} stt_spool_config_t;
+
+// Дескриптор очереди / Spool handle
+typedef struct stt_spool* stt_spool_handle_t;
+
+/**
+ * @brief Инициализация очереди
+ * Initialize spool
+ */
+esp_err_t stt_spool_init(stt_spool_handle_t* handle, const stt_spool_config_t* config);
+
+/**
+ * @brief Деинициализация очереди
+ * Deinitialize spool
+ */
+esp_err_t stt_spool_deinit(stt_spool_handle_t handle);
+
+/**
+ * @brief Сменить политику доставки
+ * Change delivery policy
+ */
+esp_err_t stt_spool_set_policy(stt_spool_handle_t handle, stt_spool_policy_t policy, uint32_t discard_after_ms);
+
+/**
+ * @brief Сжать и сохранить сегмент
+ * Compress and store a segment
+ *
+ * При нехватке места вытесняются самые старые записи. Стирание и запись flash
+ * идут без блокировки; вызывается только из задачи клиента.
+ * The oldest records are evicted when space runs out. Flash erase and write run
+ * without the lock; call from the client task only.
+ */
+esp_err_t stt_spool_store(stt_spool_handle_t handle, uint32_t sequence, const int16_t* samples, size_t sample_count);
+
+/**
+ * @brief Стереть заранее один сектор впереди позиции записи
+ * Erase one sector ahead of the write position
+ *
+ * Вызывается в простое клиента, чтобы stt_spool_store не стирал flash во время
+ * захвата звука. Уже чистые секторы не стираются.
+ * Called while the client is idle so stt_spool_store doesn't erase flash during
+ * audio capture. Sectors that are already blank are not erased.
+ *
+ * @return ESP_ERR_NOT_FINISHED если сектор обработан и работа еще есть, ESP_OK если окно готово
+ *         ESP_ERR_NOT_FINISHED if a sector was handled and more remain, ESP_OK if the window is ready
+ */
+esp_err_t stt_spool_pre_erase(stt_spool_handle_t handle);
+
+/**
+ * @brief Время до следующего повтора
+ * Time until the next replay
+ *
+ * @return 0 если повтор пора выполнить, UINT32_MAX если очередь пуста
+ *         0 if a replay is due, UINT32_MAX if the spool is empty
+ */
+uint32_t stt_spool_next_due_ms(stt_spool_handle_t handle);
+
+/**
+ * @brief Загрузить самую старую запись
+ * Load the oldest record
+ *
+ * Вызывающий освобождает *samples через free().
+ * The caller releases *samples with free().
+ */
+esp_err_t stt_spool_load_oldest(stt_spool_handle_t handle, uint32_t* sequence, int16_t** samples, size_t* sample_count);
+
+/**
+ * @brief Завершить попытку повтора
+ * Complete a replay attempt
+ *
+ * @param delivered true - запись удаляется, false - задержка удваивается
+ *                  true - the record is removed, false - the delay doubles
+ */
+esp_err_t stt_spool_complete(stt_spool_handle_t handle, uint32_t sequence, bool delivered);
+
+/**
+ * @brief Сообщить о восстановлении связи (повтор без ожидания)
+ * Report connectivity is back (replay without waiting)
+ */
+void stt_spool_notify_online(stt_spool_handle_t handle);
+
+/**
+ * @brief Получить статистику очереди
+ * Get spool statistics
+ */
+typedef struct {
+    uint32_t queue_depth;        // Записей в очереди / Records queued
+    uint32_t queue_capacity;     // Максимум записей / Record capacity
+    uint32_t flash_bytes_used;   // Занято во flash / Flash bytes in use
+    uint32_t flash_bytes_total;  // Размер кольца / Ring size
+    uint32_t records_stored;     // Сохранено всего / Records stored
+    uint32_t records_replayed;   // Успешно повторено / Records replayed
+    uint32_t records_expired;    // Отброшено по сроку / Discarded by age
+    uint32_t records_evicted;    // Вытеснено при переполнении / Evicted on overflow
+    uint32_t replay_failures;    // Неудачных повторов / Failed replays
+} stt_spool_stats_t;
+
+esp_err_t stt_spool_get_stats(stt_spool_handle_t handle, stt_spool_stats_t* stats);
+
+#endif // STT_SPOOL_H
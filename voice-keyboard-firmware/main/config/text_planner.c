@@ -0,0 +1,179 @@
+/**
+ * @file text_planner.c
+ * @brief Typing planner implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация планировщика печати
+ * Implementation of the typing planner
+ */
+
+#include "text_planner.h"
+#include "command_matcher.h"
+
+#define ALL_LAYOUTS     ((1u << TEXT_LAYOUT_COUNT) - 1)
+#define COST_NONE       UINT16_MAX
+
+/**
+ * @brief Раскладки, в которых набирается символ
+ * Layouts that can type a character
+ */
+static unsigned layout_mask(uint32_t code_point) {
+    unsigned mask = 0;
+    text_key_t key;
+
+    for (unsigned layout = 0; layout < TEXT_LAYOUT_COUNT; layout++) {
+        if (text_layout_map(layout, code_point, &key)) {
+            mask |= 1u << layout;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Отчетов на отрезок в раскладке, без финального отпускания
+ * Reports for a segment in a layout, without the final release
+ *
+ * Считается тем же переводчиком, что и печатает, поэтому учитывается упаковка.
+ * Counted by the same transcoder that types, so packing is accounted for.
+ */
+static uint16_t segment_cost(const char* text, const text_segment_t* segment, text_layout_t layout) {
+    text_transcoder_t transcoder;
+    hid_keyboard_report_t report;
+    uint32_t reports = 0;
+
+    text_transcoder_init(&transcoder, layout, text + segment->start, segment->length);
+    while (text_transcoder_next(&transcoder, &report)) {
+        reports++;
+    }
+    if (reports > 0) {
+        reports--;
+    }
+    return reports < COST_NONE ? reports : COST_NONE - 1;
+}
+
+/**
+ * @brief Разбить текст на отрезки с одинаковым набором раскладок
+ * Split the text into segments with the same set of layouts
+ *
+ * Символы вне всех раскладок присоединяются к текущему отрезку.
+ * Characters outside every layout join the current segment.
+ *
+ * @return Разбито байт / Bytes split
+ */
+static size_t split_segments(text_planner_t* planner, const char* text, size_t length, size_t* segment_count) {
+    size_t count = 0;
+    size_t position = 0;
+    unsigned current = 0;
+
+    while (position < length) {
+        uint32_t code_point;
+        size_t size = command_matcher_decode_utf8(text + position, length - position, &code_point);
+        unsigned mask = layout_mask(code_point);
+
+        if (count == 0 || (mask != 0 && mask != current)) {
+            if (count == TEXT_PLANNER_MAX_SEGMENTS) {
+                break;
+            }
+            planner->segments[count].start = position;
+            planner->segments[count].length = 0;
+            count++;
+            current = mask ? mask : ALL_LAYOUTS;
+        }
+
+        planner->segments[count - 1].length += size;
+        position += size;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        text_segment_t* segment = &planner->segments[i];
+        uint32_t code_point;
+        command_matcher_decode_utf8(text + segment->start, segment->length, &code_point);
+        unsigned mask = layout_mask(code_point);
+
+        for (unsigned layout = 0; layout < TEXT_LAYOUT_COUNT; layout++) {
+            bool typeable = mask == 0 || (mask & (1u << layout));
+            segment->cost[layout] = typeable ? segment_cost(text, segment, layout) : COST_NONE;
+        }
+    }
+
+    *segment_count = count;
+    return position;
+}
+
+size_t text_planner_plan(text_planner_t* planner, const char* text, size_t length, text_layout_t layout,
+                         uint32_t switch_cost) {
+    size_t count;
+    size_t planned = split_segments(planner, text, length, &count);
+
+    planner->step_count = 0;
+    planner->cost = 0;
+    if (count == 0) {
+        return planned;
+    }
+
+    // Префикс из 0 отрезков: переключение до начала / An empty prefix: a switch before the start
+    for (unsigned to = 0; to < TEXT_LAYOUT_COUNT; to++) {
+        planner->best[0][to] = to == layout ? 0 : switch_cost;
+        planner->from[0][to] = layout;
+    }
+
+    // best[i + 1][to] - отрезки 0..i, последний в раскладке to / segments 0..i, the last one in layout to
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned to = 0; to < TEXT_LAYOUT_COUNT; to++) {
+            planner->best[i + 1][to] = UINT32_MAX;
+            if (planner->segments[i].cost[to] == COST_NONE) {
+                continue;
+            }
+
+            for (unsigned from = 0; from < TEXT_LAYOUT_COUNT; from++) {
+                if (planner->best[i][from] == UINT32_MAX) {
+                    continue;
+                }
+                uint32_t cost = planner->best[i][from] + planner->segments[i].cost[to] +
+                                (from == to ? 0 : switch_cost);
+                if (cost < planner->best[i + 1][to]) {
+                    planner->best[i + 1][to] = cost;
+                    planner->from[i + 1][to] = from;
+                }
+            }
+        }
+    }
+
+    unsigned last = layout;
+    for (unsigned to = 0; to < TEXT_LAYOUT_COUNT; to++) {
+        if (planner->best[count][to] < planner->best[count][last]) {
+            last = to;
+        }
+    }
+    // Финальное отпускание / The final release
+    planner->cost = planner->best[count][last] + 1;
+
+    // Обратный проход: соседние отрезки одной раскладки сливаются в шаг
+    // Backtrack: neighbouring segments in one layout merge into a step
+    size_t steps = 0;
+    unsigned current = last;
+    for (size_t i = count; i > 0; i--) {
+        const text_segment_t* segment = &planner->segments[i - 1];
+        if (steps > 0 && planner->steps[steps - 1].layout == current) {
+            planner->steps[steps - 1].start = segment->start;
+            planner->steps[steps - 1].length += segment->length;
+        } else {
+            planner->steps[steps].start = segment->start;
+            planner->steps[steps].length = segment->length;
+            planner->steps[steps].layout = current;
+            steps++;
+        }
+        current = planner->from[i][current];
+    }
+
+    // Шаги собраны с конца / Steps were collected from the end
+    for (size_t i = 0; i < steps / 2; i++) {
+        text_plan_step_t step = planner->steps[i];
+        planner->steps[i] = planner->steps[steps - 1 - i];
+        planner->steps[steps - 1 - i] = step;
+    }
+    planner->step_count = steps;
+
+    return planned;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file text_planner.h
+ * @brief Typing planner header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл планировщика печати
+ * Header file for the typing planner
+ *
+ * Текст делится на отрезки по тому, в каких раскладках набираются его
+ * символы (только US, только ЙЦУКЕН, в обеих). Динамическое программирование
+ * по отрезкам выбирает раскладку каждого отрезка так, чтобы сумма отчетов с
+ * учетом переключений раскладки была минимальной: "открой file.txt в
+ * редакторе" переключается дважды, а пробелы и точка набираются в той
+ * раскладке, которая уже включена.
+ * The text is split into segments by the layouts that can type its characters
+ * (US only, ЙЦУКЕН only, both). Dynamic programming over the segments picks
+ * each segment's layout so that the total number of reports, layout switches
+ * included, is minimal: "открой file.txt в редакторе" switches twice, and the
+ * spaces and the dot are typed in whichever layout is already active.
+ */
+
+#ifndef TEXT_PLANNER_H
+#define TEXT_PLANNER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "text_transcoder.h"
+
+// Максимум отрезков за один проход (остаток планируется следующим) / Maximum segments per pass (the rest is planned next)
+#define TEXT_PLANNER_MAX_SEGMENTS   48
+
+// Шаг плана: отрезок текста в одной раскладке / Plan step: a text span in one layout
+typedef struct {
+    uint16_t start;              // Смещение в байтах / Byte offset
+    uint16_t length;             // Длина в байтах / Length in bytes
+    uint8_t layout;              // text_layout_t
+} text_plan_step_t;
+
+// Отрезок текста / Text segment
+typedef struct {
+    uint16_t start;
+    uint16_t length;
+    uint16_t cost[TEXT_LAYOUT_COUNT]; // Отчетов в раскладке (UINT16_MAX - не набирается) / Reports in a layout (UINT16_MAX - can't type)
+} text_segment_t;
+
+// Планировщик и его рабочая память / Planner and its workspace
+typedef struct {
+    text_segment_t segments[TEXT_PLANNER_MAX_SEGMENTS];
+    uint32_t best[TEXT_PLANNER_MAX_SEGMENTS + 1][TEXT_LAYOUT_COUNT]; // Лучшая стоимость префикса / Best prefix cost
+    uint8_t from[TEXT_PLANNER_MAX_SEGMENTS + 1][TEXT_LAYOUT_COUNT];  // Раскладка предыдущего отрезка / Layout of the previous segment
+
+    // Результат / Result
+    text_plan_step_t steps[TEXT_PLANNER_MAX_SEGMENTS];
+    size_t step_count;
+    uint32_t cost;               // Отчетов по плану / Reports in the plan
+} text_planner_t;
+
+/**
+ * @brief Спланировать печать текста
+ * Plan typing a text
+ *
+ * Стоимость - число отчетов клавиатуры; переключение стоит switch_cost
+ * (отчеты сочетания плюс задержка хоста в отчетах).
+ * The cost is the number of keyboard reports; a switch costs switch_cost
+ * (the hotkey's reports plus the host delay in reports).
+ *
+ * @param layout Текущая раскладка хоста / Current host layout
+ * @return Спланировано байт (меньше length, если отрезков больше максимума)
+ *         Bytes planned (less than length if there are more segments than the maximum)
+ */
+size_t text_planner_plan(text_planner_t* planner, const char* text, size_t length, text_layout_t layout,
+                         uint32_t switch_cost);
+
+#endif // TEXT_PLANNER_H
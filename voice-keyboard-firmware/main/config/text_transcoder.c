@@ -0,0 +1,227 @@
+/**
+ * @file text_transcoder.c
+ * @brief Text-to-keystroke transcoder implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация перевода текста в нажатия клавиш
+ * Implementation of text-to-keystroke transcoding
+ */
+
+#include "text_transcoder.h"
+#include <string.h>
+#include "command_matcher.h"
+
+#define K(usage)        {(usage), 0}
+#define S(usage)        {(usage), HID_MODIFIER_LEFT_SHIFT}
+
+// Первая кодовая точка таблицы кириллицы / First code point of the Cyrillic table
+#define CYRILLIC_FIRST  0x400
+#define CYRILLIC_COUNT  0x60
+#define CYR(code_point) [(code_point) - CYRILLIC_FIRST]
+
+// Знак номера в ЙЦУКЕН на Shift+3 / The numero sign is Shift+3 in ЙЦУКЕН
+#define CODE_POINT_NUMERO   0x2116
+
+// Раскладка US / US layout
+static const text_key_t us_ascii[128] = {
+    ['\t'] = K(HID_KEY_TAB),
+    ['\n'] = K(HID_KEY_ENTER),
+    [' '] = K(HID_KEY_SPACE),
+    ['`'] = K(HID_KEY_GRAVE),           ['~'] = S(HID_KEY_GRAVE),
+    ['1'] = K(HID_KEY_1),               ['!'] = S(HID_KEY_1),
+    ['2'] = K(HID_KEY_2),               ['@'] = S(HID_KEY_2),
+    ['3'] = K(HID_KEY_3),               ['#'] = S(HID_KEY_3),
+    ['4'] = K(HID_KEY_4),               ['$'] = S(HID_KEY_4),
+    ['5'] = K(HID_KEY_5),               ['%'] = S(HID_KEY_5),
+    ['6'] = K(HID_KEY_6),               ['^'] = S(HID_KEY_6),
+    ['7'] = K(HID_KEY_7),               ['&'] = S(HID_KEY_7),
+    ['8'] = K(HID_KEY_8),               ['*'] = S(HID_KEY_8),
+    ['9'] = K(HID_KEY_9),               ['('] = S(HID_KEY_9),
+    ['0'] = K(HID_KEY_0),               [')'] = S(HID_KEY_0),
+    ['-'] = K(HID_KEY_MINUS),           ['_'] = S(HID_KEY_MINUS),
+    ['='] = K(HID_KEY_EQUAL),           ['+'] = S(HID_KEY_EQUAL),
+    ['['] = K(HID_KEY_LEFT_BRACKET),    ['{'] = S(HID_KEY_LEFT_BRACKET),
+    [']'] = K(HID_KEY_RIGHT_BRACKET),   ['}'] = S(HID_KEY_RIGHT_BRACKET),
+    ['\\'] = K(HID_KEY_BACKSLASH),      ['|'] = S(HID_KEY_BACKSLASH),
+    [';'] = K(HID_KEY_SEMICOLON),       [':'] = S(HID_KEY_SEMICOLON),
+    ['\''] = K(HID_KEY_APOSTROPHE),     ['"'] = S(HID_KEY_APOSTROPHE),
+    [','] = K(HID_KEY_COMMA),           ['<'] = S(HID_KEY_COMMA),
+    ['.'] = K(HID_KEY_PERIOD),          ['>'] = S(HID_KEY_PERIOD),
+    ['/'] = K(HID_KEY_SLASH),           ['?'] = S(HID_KEY_SLASH),
+    ['a'] = K(HID_KEY_A),               ['A'] = S(HID_KEY_A),
+    ['b'] = K(HID_KEY_B),               ['B'] = S(HID_KEY_B),
+    ['c'] = K(HID_KEY_C),               ['C'] = S(HID_KEY_C),
+    ['d'] = K(HID_KEY_D),               ['D'] = S(HID_KEY_D),
+    ['e'] = K(HID_KEY_E),               ['E'] = S(HID_KEY_E),
+    ['f'] = K(HID_KEY_F),               ['F'] = S(HID_KEY_F),
+    ['g'] = K(HID_KEY_G),               ['G'] = S(HID_KEY_G),
+    ['h'] = K(HID_KEY_H),               ['H'] = S(HID_KEY_H),
+    ['i'] = K(HID_KEY_I),               ['I'] = S(HID_KEY_I),
+    ['j'] = K(HID_KEY_J),               ['J'] = S(HID_KEY_J),
+    ['k'] = K(HID_KEY_K),               ['K'] = S(HID_KEY_K),
+    ['l'] = K(HID_KEY_L),               ['L'] = S(HID_KEY_L),
+    ['m'] = K(HID_KEY_M),               ['M'] = S(HID_KEY_M),
+    ['n'] = K(HID_KEY_N),               ['N'] = S(HID_KEY_N),
+    ['o'] = K(HID_KEY_O),               ['O'] = S(HID_KEY_O),
+    ['p'] = K(HID_KEY_P),               ['P'] = S(HID_KEY_P),
+    ['q'] = K(HID_KEY_Q),               ['Q'] = S(HID_KEY_Q),
+    ['r'] = K(HID_KEY_R),               ['R'] = S(HID_KEY_R),
+    ['s'] = K(HID_KEY_S),               ['S'] = S(HID_KEY_S),
+    ['t'] = K(HID_KEY_T),               ['T'] = S(HID_KEY_T),
+    ['u'] = K(HID_KEY_U),               ['U'] = S(HID_KEY_U),
+    ['v'] = K(HID_KEY_V),               ['V'] = S(HID_KEY_V),
+    ['w'] = K(HID_KEY_W),               ['W'] = S(HID_KEY_W),
+    ['x'] = K(HID_KEY_X),               ['X'] = S(HID_KEY_X),
+    ['y'] = K(HID_KEY_Y),               ['Y'] = S(HID_KEY_Y),
+    ['z'] = K(HID_KEY_Z),               ['Z'] = S(HID_KEY_Z),
+};
+
+// Раскладка ЙЦУКЕН: цифры и знаки / ЙЦУКЕН layout: digits and punctuation
+static const text_key_t ru_ascii[128] = {
+    ['\t'] = K(HID_KEY_TAB),
+    ['\n'] = K(HID_KEY_ENTER),
+    [' '] = K(HID_KEY_SPACE),
+    ['1'] = K(HID_KEY_1),               ['!'] = S(HID_KEY_1),
+    ['2'] = K(HID_KEY_2),               ['"'] = S(HID_KEY_2),
+    ['3'] = K(HID_KEY_3),
+    ['4'] = K(HID_KEY_4),               [';'] = S(HID_KEY_4),
+    ['5'] = K(HID_KEY_5),               ['%'] = S(HID_KEY_5),
+    ['6'] = K(HID_KEY_6),               [':'] = S(HID_KEY_6),
+    ['7'] = K(HID_KEY_7),               ['?'] = S(HID_KEY_7),
+    ['8'] = K(HID_KEY_8),               ['*'] = S(HID_KEY_8),
+    ['9'] = K(HID_KEY_9),               ['('] = S(HID_KEY_9),
+    ['0'] = K(HID_KEY_0),               [')'] = S(HID_KEY_0),
+    ['-'] = K(HID_KEY_MINUS),           ['_'] = S(HID_KEY_MINUS),
+    ['='] = K(HID_KEY_EQUAL),           ['+'] = S(HID_KEY_EQUAL),
+    ['\\'] = K(HID_KEY_BACKSLASH),      ['/'] = S(HID_KEY_BACKSLASH),
+    ['.'] = K(HID_KEY_SLASH),           [','] = S(HID_KEY_SLASH),
+};
+
+// Раскладка ЙЦУКЕН: буквы U+0400-U+045F / ЙЦУКЕН layout: letters U+0400-U+045F
+static const text_key_t ru_cyrillic[CYRILLIC_COUNT] = {
+    CYR(0x451) = K(HID_KEY_GRAVE),      CYR(0x401) = S(HID_KEY_GRAVE),        // ё Ё
+    CYR(0x439) = K(HID_KEY_Q),          CYR(0x419) = S(HID_KEY_Q),            // й Й
+    CYR(0x446) = K(HID_KEY_W),          CYR(0x426) = S(HID_KEY_W),            // ц Ц
+    CYR(0x443) = K(HID_KEY_E),          CYR(0x423) = S(HID_KEY_E),            // у У
+    CYR(0x43A) = K(HID_KEY_R),          CYR(0x41A) = S(HID_KEY_R),            // к К
+    CYR(0x435) = K(HID_KEY_T),          CYR(0x415) = S(HID_KEY_T),            // е Е
+    CYR(0x43D) = K(HID_KEY_Y),          CYR(0x41D) = S(HID_KEY_Y),            // н Н
+    CYR(0x433) = K(HID_KEY_U),          CYR(0x413) = S(HID_KEY_U),            // г Г
+    CYR(0x448) = K(HID_KEY_I),          CYR(0x428) = S(HID_KEY_I),            // ш Ш
+    CYR(0x449) = K(HID_KEY_O),          CYR(0x429) = S(HID_KEY_O),            // щ Щ
+    CYR(0x437) = K(HID_KEY_P),          CYR(0x417) = S(HID_KEY_P),            // з З
+    CYR(0x445) = K(HID_KEY_LEFT_BRACKET),CYR(0x425) = S(HID_KEY_LEFT_BRACKET),// х Х
+    CYR(0x44A) = K(HID_KEY_RIGHT_BRACKET),CYR(0x42A) = S(HID_KEY_RIGHT_BRACKET),// ъ Ъ
+    CYR(0x444) = K(HID_KEY_A),          CYR(0x424) = S(HID_KEY_A),            // ф Ф
+    CYR(0x44B) = K(HID_KEY_S),          CYR(0x42B) = S(HID_KEY_S),            // ы Ы
+    CYR(0x432) = K(HID_KEY_D),          CYR(0x412) = S(HID_KEY_D),            // в В
+    CYR(0x430) = K(HID_KEY_F),          CYR(0x410) = S(HID_KEY_F),            // а А
+    CYR(0x43F) = K(HID_KEY_G),          CYR(0x41F) = S(HID_KEY_G),            // п П
+    CYR(0x440) = K(HID_KEY_H),          CYR(0x420) = S(HID_KEY_H),            // р Р
+    CYR(0x43E) = K(HID_KEY_J),          CYR(0x41E) = S(HID_KEY_J),            // о О
+    CYR(0x43B) = K(HID_KEY_K),          CYR(0x41B) = S(HID_KEY_K),            // л Л
+    CYR(0x434) = K(HID_KEY_L),          CYR(0x414) = S(HID_KEY_L),            // д Д
+    CYR(0x436) = K(HID_KEY_SEMICOLON),  CYR(0x416) = S(HID_KEY_SEMICOLON),    // ж Ж
+    CYR(0x44D) = K(HID_KEY_APOSTROPHE), CYR(0x42D) = S(HID_KEY_APOSTROPHE),   // э Э
+    CYR(0x44F) = K(HID_KEY_Z),          CYR(0x42F) = S(HID_KEY_Z),            // я Я
+    CYR(0x447) = K(HID_KEY_X),          CYR(0x427) = S(HID_KEY_X),            // ч Ч
+    CYR(0x441) = K(HID_KEY_C),          CYR(0x421) = S(HID_KEY_C),            // с С
+    CYR(0x43C) = K(HID_KEY_V),          CYR(0x41C) = S(HID_KEY_V),            // м М
+    CYR(0x438) = K(HID_KEY_B),          CYR(0x418) = S(HID_KEY_B),            // и И
+    CYR(0x442) = K(HID_KEY_N),          CYR(0x422) = S(HID_KEY_N),            // т Т
+    CYR(0x44C) = K(HID_KEY_M),          CYR(0x42C) = S(HID_KEY_M),            // ь Ь
+    CYR(0x431) = K(HID_KEY_COMMA),      CYR(0x411) = S(HID_KEY_COMMA),        // б Б
+    CYR(0x44E) = K(HID_KEY_PERIOD),     CYR(0x42E) = S(HID_KEY_PERIOD),       // ю Ю
+};
+
+bool text_layout_map(text_layout_t layout, uint32_t code_point, text_key_t* key) {
+    const text_key_t* entry = NULL;
+
+    if (layout == TEXT_LAYOUT_US) {
+        if (code_point < 128) {
+            entry = &us_ascii[code_point];
+        }
+    } else if (layout == TEXT_LAYOUT_RU) {
+        if (code_point < 128) {
+            entry = &ru_ascii[code_point];
+        } else if (code_point - CYRILLIC_FIRST < CYRILLIC_COUNT) {
+            entry = &ru_cyrillic[code_point - CYRILLIC_FIRST];
+        } else if (code_point == CODE_POINT_NUMERO) {
+            static const text_key_t numero = S(HID_KEY_3);
+            entry = &numero;
+        }
+    }
+
+    if (!entry || entry->usage == 0) {
+        return false;
+    }
+
+    *key = *entry;
+    return true;
+}
+
+void text_transcoder_init(text_transcoder_t* transcoder, text_layout_t layout, const char* text, size_t length) {
+    memset(transcoder, 0, sizeof(*transcoder));
+    transcoder->text = text;
+    transcoder->length = length;
+    transcoder->layout = layout;
+}
+
+static bool is_held(const text_transcoder_t* transcoder, uint8_t usage) {
+    for (uint8_t i = 0; i < transcoder->key_count; i++) {
+        if (transcoder->report.keycode[i] == usage) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool release(text_transcoder_t* transcoder, hid_keyboard_report_t* report) {
+    memset(&transcoder->report, 0, sizeof(transcoder->report));
+    transcoder->key_count = 0;
+    *report = transcoder->report;
+    return true;
+}
+
+bool text_transcoder_next(text_transcoder_t* transcoder, hid_keyboard_report_t* report) {
+    while (transcoder->position < transcoder->length) {
+        uint32_t code_point;
+        size_t size = command_matcher_decode_utf8(transcoder->text + transcoder->position,
+                                                  transcoder->length - transcoder->position, &code_point);
+        text_key_t key;
+        if (!text_layout_map(transcoder->layout, code_point, &key)) {
+            transcoder->position += size;
+            transcoder->unmapped++;
+            continue;
+        }
+
+        // Повтор удерживаемой клавиши - сначала отпустить / Repeating a held key - release first
+        if (is_held(transcoder, key.usage)) {
+            return release(transcoder, report);
+        }
+
+        if (transcoder->key_count > 0 && transcoder->key_count < HID_KEYBOARD_MAX_KEYS &&
+            transcoder->report.modifier == key.modifier) {
+            // Добавить клавишу к удерживаемым / Add the key to those held
+            transcoder->report.keycode[transcoder->key_count++] = key.usage;
+        } else {
+            // Новая серия: прежние клавиши отпускаются в том же отчете
+            // New run: the previous keys are released in the same report
+            memset(&transcoder->report, 0, sizeof(transcoder->report));
+            transcoder->report.modifier = key.modifier;
+            transcoder->report.keycode[0] = key.usage;
+            transcoder->key_count = 1;
+        }
+
+        transcoder->position += size;
+        transcoder->characters++;
+        *report = transcoder->report;
+        return true;
+    }
+
+    if (transcoder->key_count > 0) {
+        return release(transcoder, report);
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file text_transcoder.h
+ * @brief Text-to-keystroke transcoder header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл перевода текста в нажатия клавиш
+ * Header file for text-to-keystroke transcoding
+ *
+ * Символы UTF-8 переводятся в (код клавиши, модификатор) по таблицам раскладок
+ * US и ЙЦУКЕН за постоянное время. Подряд идущие разные символы с одним
+ * модификатором упаковываются в отчеты 6KRO: каждый следующий отчет добавляет
+ * ровно одну клавишу к уже нажатым, поэтому хост видит нажатия в порядке текста,
+ * а на n символов уходит n + 1 отчет вместо 2n.
+ * UTF-8 characters map to (usage, modifier) through the US and ЙЦУКЕН layout
+ * tables in constant time. Consecutive distinct characters with the same
+ * modifier are packed into 6KRO reports: each report adds exactly one key to
+ * those already held, so the host sees the presses in text order, and n
+ * characters take n + 1 reports instead of 2n.
+ */
+
+#ifndef TEXT_TRANSCODER_H
+#define TEXT_TRANSCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hid_config.h"
+
+// Раскладка хоста / Host keyboard layout
+typedef enum {
+    TEXT_LAYOUT_US,              // QWERTY (US)
+    TEXT_LAYOUT_RU,              // ЙЦУКЕН (Windows "Русская")
+    TEXT_LAYOUT_COUNT
+} text_layout_t;
+
+// Клавиша символа / Character key
+typedef struct {
+    uint8_t usage;               // hid_keyboard_key_t (0 - нет в раскладке / not in the layout)
+    uint8_t modifier;            // hid_keyboard_modifier_t
+} text_key_t;
+
+// Состояние перевода одного текста / Transcoding state of one text
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t position;             // Смещение следующего символа / Offset of the next character
+    text_layout_t layout;
+    hid_keyboard_report_t report; // Последний выданный отчет / Last report emitted
+    uint8_t key_count;           // Удерживаемых клавиш / Keys held
+    uint32_t characters;         // Напечатано символов / Characters typed
+    uint32_t unmapped;           // Пропущено символов вне раскладки / Characters skipped outside the layout
+} text_transcoder_t;
+
+/**
+ * @brief Найти клавишу символа в раскладке
+ * Look up the key for a character in a layout
+ *
+ * @return false если символа нет в раскладке / false if the layout lacks the character
+ */
+bool text_layout_map(text_layout_t layout, uint32_t code_point, text_key_t* key);
+
+/**
+ * @brief Начать перевод текста
+ * Start transcoding a text
+ *
+ * Текст не копируется и должен жить, пока выдаются отчеты.
+ * The text is not copied and must outlive the reports.
+ */
+void text_transcoder_init(text_transcoder_t* transcoder, text_layout_t layout, const char* text, size_t length);
+
+/**
+ * @brief Следующий отчет клавиатуры
+ * Next keyboard report
+ *
+ * Последним выдается отчет с отпущенными клавишами.
+ * The last report releases all keys.
+ *
+ * @return false если текст закончился / false when the text is done
+ */
+bool text_transcoder_next(text_transcoder_t* transcoder, hid_keyboard_report_t* report);
+
+#endif // TEXT_TRANSCODER_H
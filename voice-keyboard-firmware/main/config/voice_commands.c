@@ -11,15 +11,39 @@
 #include "voice_commands.h"
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <stdio.h>
 #include "esp_log.h"
+#include "command_matcher.h"
 
 static const char* TAG = "VOICE_COMMANDS";
 
+// Автомат, собранный из command_patterns[] при сборке / Automaton built from command_patterns[] at compile time
+#include "command_automaton.h"
+
 // Внутренняя структура процессора команд / Internal command processor structure
 struct voice_command_processor {
     command_execution_callback_t execution_callback;
     void* user_data;
+    command_batch_callback_t batch_callback;
+    void* batch_user_data;
+    dictation_callback_t dictation_callback;
+    void* dictation_user_data;
+    
+    // Команды текущей фразы / Commands of the current utterance
+    voice_command_t batch[VOICE_COMMAND_MAX_BATCH];
+    
+    // Команды, уже выполненные по промежуточным гипотезам / Commands already run from interim hypotheses
+    uint32_t utterance;
+    hid_command_t fired[VOICE_COMMAND_MAX_BATCH];
+    size_t fired_count;
+    bool diverged;               // Гипотеза разошлась с выполненным / The hypothesis diverged from what ran
+    
+    // Словарь из flash (NULL - встроенные команды) / Flash dictionary (NULL - built-in commands)
+    command_dictionary_handle_t dictionary;
+    
+    // Рабочая память нечеткого поиска / Fuzzy search workspace
+    command_fuzzy_state_t* fuzzy_workspace;
+    uint16_t fuzzy_capacity;
     
     // Статистика / Statistics
     command_stats_t stats;
@@ -33,204 +57,597 @@ typedef struct {
     command_type_t type;         // Тип / Type
     command_action_t action;     // Действие / Action
     const char* command;         // Команда / Command
+    hid_binding_id_t binding;    // Привязка HID / HID binding
 } command_pattern_t;
 
 // Словарь команд / Command dictionary
 static const command_pattern_t command_patterns[] = {
     // Приветствия / Greetings
-    {"привет", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello"},
-    {"здравствуй", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello"},
-    {"hello", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello"},
-    {"hi", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello"},
+    {"привет", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello", HID_BINDING_NONE},
+    {"здравствуй", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello", HID_BINDING_NONE},
+    {"hello", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello", HID_BINDING_NONE},
+    {"hi", CMD_TYPE_GREETING, CMD_ACTION_NONE, "hello", HID_BINDING_NONE},
     
     // Прощания / Goodbyes
-    {"пока", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye"},
-    {"до свидания", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye"},
-    {"goodbye", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye"},
-    {"bye", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye"},
+    {"пока", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye", HID_BINDING_NONE},
+    {"до свидания", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye", HID_BINDING_NONE},
+    {"goodbye", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye", HID_BINDING_NONE},
+    {"bye", CMD_TYPE_GOODBYE, CMD_ACTION_NONE, "goodbye", HID_BINDING_NONE},
     
     // Команды клавиатуры / Keyboard commands
-    {"нажми пробел", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "space"},
-    {"нажми ввод", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "enter"},
-    {"нажми таб", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "tab"},
-    {"нажми эскейп", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "escape"},
-    {"нажми бэкспейс", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "backspace"},
-    {"press space", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "space"},
-    {"press enter", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "enter"},
-    {"press tab", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "tab"},
-    {"press escape", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "escape"},
-    {"press backspace", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "backspace"},
+    {"нажми пробел", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "space", HID_BINDING_KEY_SPACE},
+    {"нажми ввод", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "enter", HID_BINDING_KEY_ENTER},
+    {"нажми таб", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "tab", HID_BINDING_KEY_TAB},
+    {"нажми эскейп", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "escape", HID_BINDING_KEY_ESCAPE},
+    {"нажми бэкспейс", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "backspace", HID_BINDING_KEY_BACKSPACE},
+    {"press space", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "space", HID_BINDING_KEY_SPACE},
+    {"press enter", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "enter", HID_BINDING_KEY_ENTER},
+    {"press tab", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "tab", HID_BINDING_KEY_TAB},
+    {"press escape", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "escape", HID_BINDING_KEY_ESCAPE},
+    {"press backspace", CMD_TYPE_KEYBOARD, CMD_ACTION_KEY_PRESS, "backspace", HID_BINDING_KEY_BACKSPACE},
     
     // Команды мыши / Mouse commands
-    {"кликни", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left"},
-    {"кликни правой", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "right"},
-    {"кликни левой", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left"},
-    {"двойной клик", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "double_left"},
-    {"click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left"},
-    {"right click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "right"},
-    {"left click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left"},
-    {"double click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "double_left"},
-    {"двигай вверх", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_up"},
-    {"двигай вниз", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_down"},
-    {"двигай влево", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_left"},
-    {"двигай вправо", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_right"},
-    {"move up", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_up"},
-    {"move down", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_down"},
-    {"move left", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_left"},
-    {"move right", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_right"},
+    {"кликни", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left", HID_BINDING_MOUSE_LEFT_CLICK},
+    {"кликни правой", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "right", HID_BINDING_MOUSE_RIGHT_CLICK},
+    {"кликни левой", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left", HID_BINDING_MOUSE_LEFT_CLICK},
+    {"двойной клик", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "double_left", HID_BINDING_MOUSE_DOUBLE_CLICK},
+    {"click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left", HID_BINDING_MOUSE_LEFT_CLICK},
+    {"right click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "right", HID_BINDING_MOUSE_RIGHT_CLICK},
+    {"left click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "left", HID_BINDING_MOUSE_LEFT_CLICK},
+    {"double click", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_CLICK, "double_left", HID_BINDING_MOUSE_DOUBLE_CLICK},
+    {"двигай вверх", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_up", HID_BINDING_MOUSE_MOVE_UP},
+    {"двигай вниз", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_down", HID_BINDING_MOUSE_MOVE_DOWN},
+    {"двигай влево", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_left", HID_BINDING_MOUSE_MOVE_LEFT},
+    {"двигай вправо", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_right", HID_BINDING_MOUSE_MOVE_RIGHT},
+    {"move up", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_up", HID_BINDING_MOUSE_MOVE_UP},
+    {"move down", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_down", HID_BINDING_MOUSE_MOVE_DOWN},
+    {"move left", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_left", HID_BINDING_MOUSE_MOVE_LEFT},
+    {"move right", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_MOVE, "move_right", HID_BINDING_MOUSE_MOVE_RIGHT},
+    {"стоп", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_STOP, "stop", HID_BINDING_MOUSE_STOP},
+    {"stop", CMD_TYPE_MOUSE, CMD_ACTION_MOUSE_STOP, "stop", HID_BINDING_MOUSE_STOP},
+    {"курсор в центр", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "center", HID_BINDING_POINTER_CENTER},
+    {"курсор вверх", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top", HID_BINDING_POINTER_TOP},
+    {"курсор вниз", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom", HID_BINDING_POINTER_BOTTOM},
+    {"курсор влево", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "left", HID_BINDING_POINTER_LEFT},
+    {"курсор вправо", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "right", HID_BINDING_POINTER_RIGHT},
+    {"курсор в левый верхний угол", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top_left", HID_BINDING_POINTER_TOP_LEFT},
+    {"курсор в правый верхний угол", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top_right", HID_BINDING_POINTER_TOP_RIGHT},
+    {"курсор в левый нижний угол", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom_left", HID_BINDING_POINTER_BOTTOM_LEFT},
+    {"курсор в правый нижний угол", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom_right", HID_BINDING_POINTER_BOTTOM_RIGHT},
+    {"cursor to center", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "center", HID_BINDING_POINTER_CENTER},
+    {"cursor to top", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top", HID_BINDING_POINTER_TOP},
+    {"cursor to bottom", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom", HID_BINDING_POINTER_BOTTOM},
+    {"cursor to left", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "left", HID_BINDING_POINTER_LEFT},
+    {"cursor to right", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "right", HID_BINDING_POINTER_RIGHT},
+    {"cursor to top left", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top_left", HID_BINDING_POINTER_TOP_LEFT},
+    {"cursor to top right", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "top_right", HID_BINDING_POINTER_TOP_RIGHT},
+    {"cursor to bottom left", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom_left", HID_BINDING_POINTER_BOTTOM_LEFT},
+    {"cursor to bottom right", CMD_TYPE_MOUSE, CMD_ACTION_POINTER_MOVE, "bottom_right", HID_BINDING_POINTER_BOTTOM_RIGHT},
     
     // Команды громкости / Volume commands
-    {"громче", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up"},
-    {"тише", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down"},
-    {"выклюши звук", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_MUTE, "mute"},
-    {"увеличь громкость", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up"},
-    {"уменьши громкость", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down"},
-    {"volume up", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up"},
-    {"volume down", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down"},
-    {"mute", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_MUTE, "mute"},
-    {"louder", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up"},
-    {"quieter", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down"},
+    {"громче", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up", HID_BINDING_VOLUME_UP},
+    {"тише", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down", HID_BINDING_VOLUME_DOWN},
+    {"выключи звук", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_MUTE, "mute", HID_BINDING_VOLUME_MUTE},
+    {"увеличь громкость", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up", HID_BINDING_VOLUME_UP},
+    {"уменьши громкость", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down", HID_BINDING_VOLUME_DOWN},
+    {"volume up", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up", HID_BINDING_VOLUME_UP},
+    {"volume down", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down", HID_BINDING_VOLUME_DOWN},
+    {"mute", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_MUTE, "mute", HID_BINDING_VOLUME_MUTE},
+    {"louder", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_UP, "up", HID_BINDING_VOLUME_UP},
+    {"quieter", CMD_TYPE_VOLUME, CMD_ACTION_VOLUME_DOWN, "down", HID_BINDING_VOLUME_DOWN},
     
     // Медиа команды / Media commands
-    {"играй", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "play"},
-    {"пауза", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "pause"},
-    {"следующий трек", CMD_TYPE_MEDIA, CMD_ACTION_NEXT_TRACK, "next"},
-    {"предыдущий трек", CMD_TYPE_MEDIA, CMD_ACTION_PREV_TRACK, "previous"},
-    {"play", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "play"},
-    {"pause", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "pause"},
-    {"next track", CMD_TYPE_MEDIA, CMD_ACTION_NEXT_TRACK, "next"},
-    {"previous track", CMD_TYPE_MEDIA, CMD_ACTION_PREV_TRACK, "previous"},
+    {"играй", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "play", HID_BINDING_MEDIA_PLAY_PAUSE},
+    {"пауза", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "pause", HID_BINDING_MEDIA_PLAY_PAUSE},
+    {"следующий трек", CMD_TYPE_MEDIA, CMD_ACTION_NEXT_TRACK, "next", HID_BINDING_MEDIA_NEXT},
+    {"предыдущий трек", CMD_TYPE_MEDIA, CMD_ACTION_PREV_TRACK, "previous", HID_BINDING_MEDIA_PREV},
+    {"play", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "play", HID_BINDING_MEDIA_PLAY_PAUSE},
+    {"pause", CMD_TYPE_MEDIA, CMD_ACTION_PLAY_PAUSE, "pause", HID_BINDING_MEDIA_PLAY_PAUSE},
+    {"next track", CMD_TYPE_MEDIA, CMD_ACTION_NEXT_TRACK, "next", HID_BINDING_MEDIA_NEXT},
+    {"previous track", CMD_TYPE_MEDIA, CMD_ACTION_PREV_TRACK, "previous", HID_BINDING_MEDIA_PREV},
     
     // Системные команды / System commands
-    {"сон", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep"},
-    {"блокировка", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_LOCK, "lock"},
-    {"спящий режим", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep"},
-    {"sleep", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep"},
-    {"lock", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_LOCK, "lock"},
-    {"hibernate", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep"},
+    {"сон", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep", HID_BINDING_SYSTEM_SLEEP},
+    {"блокировка", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_LOCK, "lock", HID_BINDING_SYSTEM_LOCK},
+    {"спящий режим", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep", HID_BINDING_SYSTEM_SLEEP},
+    {"sleep", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep", HID_BINDING_SYSTEM_SLEEP},
+    {"lock", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_LOCK, "lock", HID_BINDING_SYSTEM_LOCK},
+    {"hibernate", CMD_TYPE_SYSTEM, CMD_ACTION_SYSTEM_SLEEP, "sleep", HID_BINDING_SYSTEM_SLEEP},
 };
 
 static const int num_patterns = sizeof(command_patterns) / sizeof(command_pattern_t);
 
+// Привязки действий, индекс - command_action_t / Action bindings, indexed by command_action_t
+static const hid_binding_id_t action_bindings[] = {
+    [CMD_ACTION_VOLUME_UP] = HID_BINDING_VOLUME_UP,
+    [CMD_ACTION_VOLUME_DOWN] = HID_BINDING_VOLUME_DOWN,
+    [CMD_ACTION_VOLUME_MUTE] = HID_BINDING_VOLUME_MUTE,
+    [CMD_ACTION_PLAY_PAUSE] = HID_BINDING_MEDIA_PLAY_PAUSE,
+    [CMD_ACTION_NEXT_TRACK] = HID_BINDING_MEDIA_NEXT,
+    [CMD_ACTION_PREV_TRACK] = HID_BINDING_MEDIA_PREV,
+    [CMD_ACTION_SYSTEM_SLEEP] = HID_BINDING_SYSTEM_SLEEP,
+    [CMD_ACTION_SYSTEM_LOCK] = HID_BINDING_SYSTEM_LOCK,
+    [CMD_ACTION_SYSTEM_WAKE] = HID_BINDING_SYSTEM_WAKE,
+    [CMD_ACTION_MOUSE_STOP] = HID_BINDING_MOUSE_STOP,
+};
+
+_Static_assert(HID_BINDING_NONE == 0, "unlisted actions must map to HID_BINDING_NONE");
+
+hid_binding_id_t voice_command_action_binding(command_action_t action) {
+    if ((unsigned)action >= sizeof(action_bindings) / sizeof(action_bindings[0])) {
+        return HID_BINDING_NONE;
+    }
+    return action_bindings[action];
+}
+
+_Static_assert(COMMAND_AUTOMATON_PATTERN_COUNT == sizeof(command_patterns) / sizeof(command_pattern_t),
+               "command_automaton.h is out of date");
+
+/**
+ * @brief Рабочая память нечеткого поиска не меньше pattern_count
+ * Fuzzy search workspace of at least pattern_count entries
+ */
+static command_fuzzy_state_t* get_fuzzy_workspace(struct voice_command_processor* processor, uint16_t pattern_count) {
+    if (pattern_count > processor->fuzzy_capacity) {
+        command_fuzzy_state_t* workspace = realloc(processor->fuzzy_workspace,
+                                                   pattern_count * sizeof(command_fuzzy_state_t));
+        if (!workspace) {
+            ESP_LOGE(TAG, "Failed to grow fuzzy workspace to %u patterns", pattern_count);
+            return NULL;
+        }
+        processor->fuzzy_workspace = workspace;
+        processor->fuzzy_capacity = pattern_count;
+    }
+    
+    return processor->fuzzy_workspace;
+}
+
+/**
+ * @brief Шаблон по индексу в активном словаре
+ * Pattern by index in the active dictionary
+ */
+static command_pattern_t get_pattern(const command_dictionary_t* dictionary, int index) {
+    if (!dictionary) {
+        return command_patterns[index];
+    }
+    
+    const command_dictionary_entry_t* entry = &dictionary->entries[index];
+    command_pattern_t pattern = {
+        .pattern = command_dictionary_string(dictionary, entry->pattern_offset),
+        .type = (command_type_t)entry->type,
+        .action = (command_action_t)entry->action,
+        .command = command_dictionary_string(dictionary, entry->command_offset),
+        .binding = (hid_binding_id_t)entry->binding,
+    };
+    return pattern;
+}
+
+// Числительное / Number word
+typedef struct {
+    const char* word;            // В нижнем регистре, ё как е / Lowercase, ё as е
+    uint16_t value;
+} number_word_t;
+
+static const number_word_t number_words[] = {
+    {"ноль", 0}, {"один", 1}, {"одна", 1}, {"одну", 1}, {"одно", 1}, {"два", 2}, {"две", 2},
+    {"три", 3}, {"четыре", 4}, {"пять", 5}, {"шесть", 6}, {"семь", 7}, {"восемь", 8},
+    {"девять", 9}, {"десять", 10}, {"одиннадцать", 11}, {"двенадцать", 12}, {"тринадцать", 13},
+    {"четырнадцать", 14}, {"пятнадцать", 15}, {"шестнадцать", 16}, {"семнадцать", 17},
+    {"восемнадцать", 18}, {"девятнадцать", 19}, {"двадцать", 20}, {"тридцать", 30},
+    {"сорок", 40}, {"пятьдесят", 50}, {"шестьдесят", 60}, {"семьдесят", 70},
+    {"восемьдесят", 80}, {"девяносто", 90}, {"сто", 100}, {"двести", 200}, {"триста", 300},
+    {"четыреста", 400}, {"пятьсот", 500},
+    {"zero", 0}, {"one", 1}, {"two", 2}, {"three", 3}, {"four", 4}, {"five", 5}, {"six", 6},
+    {"seven", 7}, {"eight", 8}, {"nine", 9}, {"ten", 10}, {"eleven", 11}, {"twelve", 12},
+    {"thirteen", 13}, {"fourteen", 14}, {"fifteen", 15}, {"sixteen", 16}, {"seventeen", 17},
+    {"eighteen", 18}, {"nineteen", 19}, {"twenty", 20}, {"thirty", 30}, {"forty", 40},
+    {"fifty", 50}, {"sixty", 60}, {"seventy", 70}, {"eighty", 80}, {"ninety", 90},
+};
+
+// Наречия повтора / Repeat adverbs
+static const number_word_t repeat_words[] = {
+    {"однажды", 1}, {"дважды", 2}, {"трижды", 3}, {"once", 1}, {"twice", 2}, {"thrice", 3},
+};
+
+// Слова "раз" после числа / "Times" words after a number
+static const char* const times_words[] = {"раз", "раза", "times", "time"};
+
+// Предлоги перед параметром / Prepositions before a parameter
+static const char* const filler_words[] = {"на", "by"};
+
+// Связки между командами, не входящие в покрытие / Connectives between commands, left out of the coverage
+static const char* const connective_words[] = {"и", "потом", "затем", "пожалуйста", "and", "then", "please"};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/**
+ * @brief Сравнить слово текста с литералом без учета регистра
+ * Compare a text word with a literal, case-insensitive
+ */
+static bool word_equals(const char* word, size_t length, const char* literal) {
+    size_t literal_length = strlen(literal);
+    size_t i = 0;
+    size_t j = 0;
+    
+    while (i < length && j < literal_length) {
+        uint32_t a;
+        uint32_t b;
+        i += command_matcher_decode_utf8(word + i, length - i, &a);
+        j += command_matcher_decode_utf8(literal + j, literal_length - j, &b);
+        if (command_matcher_fold(a) != b) {
+            return false;
+        }
+    }
+    
+    return i == length && j == literal_length;
+}
+
+static bool word_in(const char* word, size_t length, const char* const* list, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (word_equals(word, length, list[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const number_word_t* find_number_word(const char* word, size_t length,
+                                             const number_word_t* table, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (word_equals(word, length, table[i].word)) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
 /**
- * @brief Преобразовать строку в нижний регистр
- * Convert string to lowercase
+ * @brief Следующее слово в [*pos, end)
+ * Next word in [*pos, end)
+ *
+ * Разделители - пробелы и знаки препинания ASCII; байты UTF-8 с ними не совпадают.
+ * Separators are ASCII spaces and punctuation; UTF-8 bytes never collide with them.
  */
-static void to_lowercase(char* str) {
-    for (int i = 0; str[i]; i++) {
-        str[i] = tolower(str[i]);
+static bool next_word(const char* text, size_t* pos, size_t end, size_t* word_start, size_t* word_length) {
+    size_t i = *pos;
+    while (i < end && strchr(" \t,.!?;:-", text[i])) {
+        i++;
+    }
+    if (i >= end) {
+        return false;
     }
+    
+    *word_start = i;
+    while (i < end && !strchr(" \t,.!?;:-", text[i])) {
+        i++;
+    }
+    *word_length = i - *word_start;
+    *pos = i;
+    return true;
 }
 
 /**
- * @brief Проверить совпадение с шаблоном
- * Check pattern match
+ * @brief Извлечь числовой параметр после команды
+ * Extract the numeric parameter following a command
+ *
+ * Разбирает "двадцать пять", "two hundred", "42", затем необязательное
+ * "раз"/"times"; "дважды"/"twice" сразу задают повтор.
+ * Parses "двадцать пять", "two hundred", "42", then an optional "раз"/"times";
+ * "дважды"/"twice" set the repeat count directly.
+ *
+ * @return Конец разобранного параметра (from если его нет) / End of the parsed parameter (from if none)
  */
-static bool match_pattern(const char* text, const char* pattern) {
-    char text_lower[256];
-    char pattern_lower[256];
+static size_t extract_number(const char* text, size_t from, size_t to, voice_command_t* command) {
+    size_t pos = from;
+    size_t word;
+    size_t length;
+    
+    if (!next_word(text, &pos, to, &word, &length)) {
+        return from;
+    }
+    if (word_in(text + word, length, filler_words, ARRAY_SIZE(filler_words))) {
+        if (!next_word(text, &pos, to, &word, &length)) {
+            return from;
+        }
+    }
     
-    strncpy(text_lower, text, sizeof(text_lower) - 1);
-    strncpy(pattern_lower, pattern, sizeof(pattern_lower) - 1);
+    const number_word_t* adverb = find_number_word(text + word, length, repeat_words, ARRAY_SIZE(repeat_words));
+    if (adverb) {
+        command->repeat = adverb->value;
+        return pos;
+    }
+    
+    // Сумма числительных, "hundred" умножает / Sum of number words, "hundred" multiplies
+    uint32_t value = 0;
+    size_t end = from;
+    bool found = false;
+    for (;;) {
+        const number_word_t* number = find_number_word(text + word, length, number_words, ARRAY_SIZE(number_words));
+        if (number) {
+            value += number->value;
+        } else if (word_equals(text + word, length, "hundred")) {
+            value = (value ? value : 1) * 100;
+        } else if (!found && length <= 5 && strspn(text + word, "0123456789") == length) {
+            value = strtoul(text + word, NULL, 10);
+        } else {
+            break;
+        }
+        found = true;
+        end = pos;
+        if (value > 0xFFFF || !next_word(text, &pos, to, &word, &length)) {
+            break;
+        }
+    }
+    if (!found) {
+        return from;
+    }
     
-    text_lower[sizeof(text_lower) - 1] = '\0';
-    pattern_lower[sizeof(pattern_lower) - 1] = '\0';
+    snprintf(command->param, sizeof(command->param), "%lu", (unsigned long)value);
+    command->value = value > 0xFFFF ? 0xFFFF : value;
     
-    to_lowercase(text_lower);
-    to_lowercase(pattern_lower);
+    pos = end;
+    if (next_word(text, &pos, to, &word, &length) &&
+        word_in(text + word, length, times_words, ARRAY_SIZE(times_words))) {
+        command->repeat = value < 1 ? 1 : (value > VOICE_COMMAND_MAX_REPEAT ? VOICE_COMMAND_MAX_REPEAT : value);
+        end = pos;
+    }
     
-    return strstr(text_lower, pattern_lower) != NULL;
+    return end;
 }
 
 /**
- * @brief Распарсить команду
- * Parse command
+ * @brief Покрывают ли команды почти всю фразу
+ * Whether the commands cover almost the whole utterance
+ *
+ * Считаются фонетические символы слов вне связок; слово покрыто, если лежит
+ * внутри команды с ее параметром. Иначе фраза - диктовка с командным словом
+ * ("I'll stop by later").
+ * Phonetic symbols of words other than connectives are counted; a word is
+ * covered when it lies inside a command with its parameter. Otherwise the
+ * utterance is dictation containing a command word ("I'll stop by later").
+ *
+ * @param spans Пары [начало, конец) команд / Command [start, end) pairs
  */
-static bool parse_command(const char* text, voice_command_t* command) {
-    for (int i = 0; i < num_patterns; i++) {
-        if (match_pattern(text, command_patterns[i].pattern)) {
-            command->type = command_patterns[i].type;
-            command->action = command_patterns[i].action;
-            strncpy(command->command, command_patterns[i].command, sizeof(command->command) - 1);
-            command->command[sizeof(command->command) - 1] = '\0';
-            
-            // Извлечение параметров / Extract parameters
-            // TODO: Добавить извлечение числовых параметров / TODO: Add numeric parameter extraction
-            
-            return true;
+static bool commands_cover(const char* text, size_t length, const size_t (*spans)[2], size_t count) {
+    size_t total = 0;
+    size_t covered = 0;
+    size_t pos = 0;
+    size_t word;
+    size_t word_length;
+    
+    while (next_word(text, &pos, length, &word, &word_length)) {
+        if (word_in(text + word, word_length, connective_words, ARRAY_SIZE(connective_words))) {
+            continue;
+        }
+        size_t symbols = command_matcher_count_phonetic(text + word, word_length);
+        total += symbols;
+        for (size_t i = 0; i < count; i++) {
+            if (word >= spans[i][0] && word + word_length <= spans[i][1]) {
+                covered += symbols;
+                break;
+            }
         }
     }
     
-    return false;
+    return covered >= total * COMMAND_MATCHER_MIN_COVERAGE;
+}
+
+/**
+ * @brief Привязка шаблона: своя или по действию
+ * Pattern binding: its own or by action
+ */
+static hid_binding_id_t pattern_binding(const command_pattern_t* pattern) {
+    // Словарь может задать только действие / A dictionary may give the action alone
+    return pattern->binding != HID_BINDING_NONE ? pattern->binding : voice_command_action_binding(pattern->action);
+}
+
+/**
+ * @brief Распарсить команды фразы по порядку
+ * Parse the commands of an utterance in order
+ *
+ * Совпадения не пересекаются, самое длинное выигрывает: "кликни правой" важнее
+ * "кликни". Без точного совпадения используется нечеткий поиск одной команды,
+ * только если она по границам слов покрывает почти всю фразу; уверенность
+ * снижается пропорционально доле ошибок.
+ * Matches don't overlap and the longest wins: "кликни правой" beats "кликни".
+ * Without an exact match fuzzy search finds a single command, only if it covers
+ * almost the whole utterance on word boundaries; confidence drops by the error
+ * ratio.
+ *
+ * Совпадения без привязки HID (приветствия) отбрасываются. Если оставшиеся
+ * команды не покрывают почти всю фразу (commands_cover), команд нет и фраза
+ * печатается.
+ * Matches with no HID binding (greetings) are dropped. If the remaining
+ * commands don't cover almost the whole utterance (commands_cover), there are
+ * no commands and the utterance is typed.
+ *
+ * Для промежуточной гипотезы (stable != NULL) нечеткий поиск не используется,
+ * а последняя команда не считается устойчивой, пока текст от ее начала еще
+ * может вырасти в более длинный шаблон или пока не прозвучало смещение мыши.
+ * For an interim hypothesis (stable != NULL) fuzzy search is skipped, and the
+ * last command is not stable while the text from its start can still grow into
+ * a longer pattern or while a mouse distance may still follow.
+ *
+ * @param stable Устойчивых команд в начале (может быть NULL) / Stable leading commands (may be NULL)
+ * @return Число команд / Number of commands
+ */
+static size_t parse_commands(struct voice_command_processor* processor, const char* text, float confidence,
+                             voice_command_t* commands, size_t max_commands, size_t* stable) {
+    command_match_t matches[VOICE_COMMAND_MAX_BATCH];
+    size_t length = strlen(text);
+    
+    if (max_commands > VOICE_COMMAND_MAX_BATCH) {
+        max_commands = VOICE_COMMAND_MAX_BATCH;
+    }
+    
+    // Словарь удерживается до копирования строк / The dictionary is held until strings are copied
+    const command_dictionary_t* dictionary = command_dictionary_acquire(processor->dictionary);
+    const command_automaton_t* automaton = dictionary ? &dictionary->automaton : &command_automaton;
+    
+    size_t count = command_matcher_find_all(automaton, text, length, matches, max_commands);
+    if (count == 0 && !stable) {
+        command_fuzzy_state_t* workspace = get_fuzzy_workspace(processor, automaton->pattern_count);
+        if (workspace && command_matcher_find_fuzzy(automaton, text, length, COMMAND_MATCHER_FUZZY_MAX_ERROR_RATIO,
+                                                    workspace, &matches[0])) {
+            uint8_t chars = automaton->fuzzy_pattern_chars[matches[0].pattern];
+            confidence *= 1.0f - (float)matches[0].errors / chars;
+            processor->stats.fuzzy_commands++;
+            ESP_LOGI(TAG, "Fuzzy match '%.*s' ~ '%s' (%d error(s))", (int)matches[0].length,
+                     text + matches[0].start, get_pattern(dictionary, matches[0].pattern).pattern, matches[0].errors);
+            count = 1;
+        }
+    }
+    
+    // Совпадения без действия не становятся командами / Matches with no action don't become commands
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        command_pattern_t pattern = get_pattern(dictionary, matches[i].pattern);
+        if (pattern_binding(&pattern) != HID_BINDING_NONE) {
+            matches[kept++] = matches[i];
+        }
+    }
+    count = kept;
+    
+    size_t spans[VOICE_COMMAND_MAX_BATCH][2];
+    for (size_t i = 0; i < count; i++) {
+        const command_match_t* match = &matches[i];
+        voice_command_t* command = &commands[i];
+        command_pattern_t pattern = get_pattern(dictionary, match->pattern);
+        
+        memset(command, 0, sizeof(voice_command_t));
+        command->type = pattern.type;
+        command->action = pattern.action;
+        command->binding = pattern_binding(&pattern);
+        command->confidence = confidence;
+        command->repeat = 1;
+        strncpy(command->command, pattern.command, sizeof(command->command) - 1);
+        
+        // Параметр ищется до следующей команды / The parameter is searched up to the next command
+        size_t match_end = match->start + match->length;
+        size_t gap_end = i + 1 < count ? matches[i + 1].start : length;
+        size_t end = extract_number(text, match_end, gap_end, command);
+        spans[i][0] = match->start;
+        spans[i][1] = end;
+        
+        size_t span = end - match->start;
+        if (span > sizeof(command->text) - 1) {
+            span = sizeof(command->text) - 1;
+        }
+        memcpy(command->text, text + match->start, span);
+    }
+    
+    // Командное слово внутри диктовки / A command word inside dictation
+    if (count > 0 && !commands_cover(text, length, spans, count)) {
+        count = 0;
+    }
+    
+    if (stable) {
+        *stable = count;
+        if (count > 0) {
+            const command_match_t* last = &matches[count - 1];
+            if (command_matcher_can_extend(automaton, text + last->start, length - last->start) ||
+                (hid_binding_get(commands[count - 1].binding)->flags & HID_BINDING_FLAG_DISTANCE)) {
+                *stable = count - 1;
+            }
+        }
+    }
+    
+    command_dictionary_release(processor->dictionary);
+    return count;
 }
 
 /**
  * @brief Выполнить команду
  * Execute command
+ *
+ * Без HID задачи только журналирует готовую последовательность отчетов.
+ * Without the HID task only logs the precompiled report sequence.
  */
-static void execute_command(const voice_command_t* command, void* user_data) {
-    ESP_LOGI(TAG, "🎯 Executing command: type=%d, action=%d, command='%s'", 
-             command->type, command->action, command->command);
-    
-    switch (command->action) {
-        case CMD_ACTION_KEY_PRESS:
-            ESP_LOGI(TAG, "⌨️  Pressing key: %s", command->command);
-            // TODO: Отправить HID команду клавиатуры / TODO: Send keyboard HID command
-            break;
-            
-        case CMD_ACTION_MOUSE_CLICK:
-            ESP_LOGI(TAG, "🖱️  Mouse click: %s", command->command);
-            // TODO: Отправить HID команду мыши / TODO: Send mouse HID command
-            break;
-            
-        case CMD_ACTION_MOUSE_MOVE:
-            ESP_LOGI(TAG, "🖱️  Mouse move: %s", command->command);
-            // TODO: Отправить HID команду движения мыши / TODO: Send mouse move HID command
-            break;
-            
-        case CMD_ACTION_VOLUME_UP:
-            ESP_LOGI(TAG, "🔊 Volume up");
-            // TODO: Отправить команду громкости / TODO: Send volume command
-            break;
-            
-        case CMD_ACTION_VOLUME_DOWN:
-            ESP_LOGI(TAG, "🔉 Volume down");
-            // TODO: Отправить команду громкости / TODO: Send volume command
-            break;
-            
-        case CMD_ACTION_VOLUME_MUTE:
-            ESP_LOGI(TAG, "🔇 Volume mute");
-            // TODO: Отправить команду громкости / TODO: Send volume command
-            break;
-            
-        case CMD_ACTION_PLAY_PAUSE:
-            ESP_LOGI(TAG, "⏯️  Play/Pause");
-            // TODO: Отправить медиа команду / TODO: Send media command
-            break;
-            
-        case CMD_ACTION_NEXT_TRACK:
-            ESP_LOGI(TAG, "⏭️  Next track");
-            // TODO: Отправить медиа команду / TODO: Send media command
-            break;
-            
-        case CMD_ACTION_PREV_TRACK:
-            ESP_LOGI(TAG, "⏮️  Previous track");
-            // TODO: Отправить медиа команду / TODO: Send media command
-            break;
-            
-        case CMD_ACTION_SYSTEM_SLEEP:
-            ESP_LOGI(TAG, "😴 System sleep");
-            // TODO: Отправить системную команду / TODO: Send system command
-            break;
-            
-        case CMD_ACTION_SYSTEM_LOCK:
-            ESP_LOGI(TAG, "🔒 System lock");
-            // TODO: Отправить системную команду / TODO: Send system command
-            break;
-            
-        default:
-            ESP_LOGW(TAG, "Unknown command action: %d", command->action);
-            break;
+static void execute_command(const voice_command_t* command) {
+    const hid_binding_t* binding = hid_binding_get(command->binding);
+    
+    ESP_LOGI(TAG, "🎯 Executing command '%s': %s (%u report(s) x%u)", 
+             command->command, binding->name, binding->report_count, command->repeat);
+}
+
+/**
+ * @brief Убрать из пакета то, что уже выполнено по промежуточным гипотезам
+ * Drop from the batch what already ran from interim hypotheses
+ *
+ * Команды сравниваются по позиции: та же привязка (и смещение) значат ту же
+ * команду, и выполняются только недостающие повторы ("таб" -> "таб три раза").
+ * После расхождения промежуточные гипотезы больше ничего не выполняют, а
+ * финальный результат выполняет все команды начиная с расхождения.
+ * Commands are compared by position: the same binding (and distance) mean the
+ * same command, and only the missing repeats run ("таб" -> "таб три раза").
+ * After a divergence interim hypotheses run nothing more, and the final result
+ * runs every command from the divergence on.
+ *
+ * @return Команд к выполнению в начале batch / Commands to run at the start of batch
+ */
+static size_t drop_fired(struct voice_command_processor* processor, size_t count, bool interim) {
+    size_t run = 0;
+    
+    if (interim && processor->diverged) {
+        return 0;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        voice_command_t* command = &processor->batch[i];
+        
+        if (i < processor->fired_count) {
+            hid_command_t* fired = &processor->fired[i];
+            // Параметр важен только для смещения мыши / The parameter only matters for a mouse distance
+            bool distance = hid_binding_get(command->binding)->flags & HID_BINDING_FLAG_DISTANCE;
+            if (fired->binding != command->binding || (distance && fired->param != command->value)) {
+                ESP_LOGW(TAG, "Utterance #%u changed at '%s' after %u early command(s)",
+                         processor->utterance, command->text, (unsigned)i);
+                processor->diverged = true;
+                if (interim) {
+                    break;
+                }
+                processor->fired_count = i;
+            } else if (command->repeat <= fired->repeat) {
+                if (!interim) {
+                    ESP_LOGD(TAG, "Command '%s' already ran", command->text);
+                    processor->stats.deduplicated_commands++;
+                }
+                continue;
+            } else {
+                uint16_t done = fired->repeat;
+                fired->repeat = command->repeat;
+                command->repeat -= done;
+            }
+        } else if (interim) {
+            processor->fired[processor->fired_count++] = voice_command_to_hid(command);
+            processor->stats.early_commands++;
+        }
+        
+        if (run != i) {
+            processor->batch[run] = *command;
+        }
+        run++;
+    }
+    
+    return run;
+}
+
+/**
+ * @brief Передать команды на выполнение
+ * Hand the commands over for execution
+ */
+static void dispatch_commands(struct voice_command_processor* processor, size_t count) {
+    if (processor->batch_callback) {
+        processor->batch_callback(processor->batch, count, processor->batch_user_data);
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (processor->execution_callback) {
+            processor->execution_callback(&processor->batch[i], processor->user_data);
+        } else {
+            execute_command(&processor->batch[i]);
+        }
     }
 }
 
@@ -248,6 +665,12 @@ esp_err_t voice_command_processor_init(voice_command_processor_handle_t* handle)
     
     // Инициализация структуры / Initialize structure
     memset(*handle, 0, sizeof(struct voice_command_processor));
+    (*handle)->utterance = UINT32_MAX;
+    
+    if (!get_fuzzy_workspace(*handle, COMMAND_AUTOMATON_PATTERN_COUNT)) {
+        free(*handle);
+        return ESP_ERR_NO_MEM;
+    }
     
     ESP_LOGI(TAG, "Voice command processor initialized with %d command patterns", num_patterns);
     return ESP_OK;
@@ -258,6 +681,7 @@ esp_err_t voice_command_processor_deinit(voice_command_processor_handle_t handle
         return ESP_ERR_INVALID_ARG;
     }
     
+    free(handle->fuzzy_workspace);
     free(handle);
     ESP_LOGI(TAG, "Voice command processor deinitialized");
     
@@ -270,36 +694,99 @@ esp_err_t voice_command_processor_process_result(voice_command_processor_handle_
         return ESP_ERR_INVALID_ARG;
     }
     
+    bool interim = !speech_result->is_final;
+    
+    // Поздние результаты из офлайн-очереди не сверяются с текущей фразой
+    // Late results from the offline spool are not checked against the current utterance
+    bool tracked = !speech_result->is_replayed;
+    if (tracked && speech_result->sequence != handle->utterance) {
+        handle->utterance = speech_result->sequence;
+        handle->fired_count = 0;
+        handle->diverged = false;
+    }
+    
     // Обновление статистики / Update statistics
-    handle->stats.total_commands++;
-    handle->confidence_sum += speech_result->confidence;
-    handle->confidence_count++;
-    handle->stats.average_confidence = handle->confidence_sum / handle->confidence_count;
-    
-    // Создание команды / Create command
-    voice_command_t command = {0};
-    strncpy(command.text, speech_result->text, sizeof(command.text) - 1);
-    command.confidence = speech_result->confidence;
-    
-    // Парсинг команды / Parse command
-    if (parse_command(speech_result->text, &command)) {
-        handle->stats.recognized_commands++;
-        
-        ESP_LOGI(TAG, "✅ Command recognized: '%s' -> %s (confidence: %.2f)", 
-                 speech_result->text, command.command, command.confidence);
+    if (!interim) {
+        handle->stats.total_commands++;
+        handle->confidence_sum += speech_result->confidence;
+        handle->confidence_count++;
+        handle->stats.average_confidence = handle->confidence_sum / handle->confidence_count;
+    }
+    
+    // Парсинг команд / Parse commands
+    size_t stable = 0;
+    size_t count = parse_commands(handle, speech_result->text, speech_result->confidence,
+                                  handle->batch, VOICE_COMMAND_MAX_BATCH, interim ? &stable : NULL);
+    if (count == 0) {
+        if (interim) {
+            // Пока команды не выполнялись, гипотеза печатается / Until a command has run the hypothesis is typed
+            if (handle->dictation_callback && !(tracked && handle->fired_count > 0)) {
+                handle->dictation_callback(speech_result->text, false, handle->dictation_user_data);
+            }
+            return ESP_OK;
+        }
         
-        // Выполнение команды / Execute command
-        if (handle->execution_callback) {
-            handle->execution_callback(&command, handle->user_data);
+        handle->stats.unknown_commands++;
+        if (tracked && handle->fired_count > 0) {
+            ESP_LOGW(TAG, "Utterance #%u has no commands, %u early command(s) already ran",
+                     handle->utterance, (unsigned)handle->fired_count);
+        }
+        if (handle->dictation_callback) {
+            ESP_LOGI(TAG, "📝 Dictation: '%s'", speech_result->text);
+            handle->dictation_callback(speech_result->text, true, handle->dictation_user_data);
         } else {
-            execute_command(&command, handle->user_data);
+            ESP_LOGW(TAG, "❓ Unknown command: '%s' (confidence: %.2f)", 
+                     speech_result->text, speech_result->confidence);
         }
+        return ESP_OK;
+    }
+    
+    if (interim) {
+        count = stable;
     } else {
-        handle->stats.unknown_commands++;
-        ESP_LOGW(TAG, "❓ Unknown command: '%s' (confidence: %.2f)", 
-                 speech_result->text, speech_result->confidence);
+        handle->stats.recognized_commands += count;
+        for (size_t i = 0; i < count; i++) {
+            const voice_command_t* command = &handle->batch[i];
+            ESP_LOGI(TAG, "✅ Command recognized: '%s' -> %s param='%s' x%u (confidence: %.2f)", 
+                     command->text, command->command, command->param, command->repeat, command->confidence);
+        }
+    }
+    
+    // Уже выполненное по гипотезам не повторяется / What already ran from hypotheses is not repeated
+    if (tracked) {
+        count = drop_fired(handle, count, interim);
+    }
+    if (interim) {
+        for (size_t i = 0; i < count; i++) {
+            ESP_LOGI(TAG, "⚡ Early command: '%s' -> %s x%u", handle->batch[i].text,
+                     handle->batch[i].command, handle->batch[i].repeat);
+        }
+    }
+    
+    // Выполнение команд / Execute commands
+    if (count > 0) {
+        dispatch_commands(handle, count);
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t voice_command_processor_whole_command(voice_command_processor_handle_t handle, const char* text,
+                                                char* command_text, size_t size) {
+    if (!handle || !text || !command_text || size == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
     
+    // Разбор как у гипотезы: без нечеткого поиска и его рабочей памяти
+    // Parsed like a hypothesis: without fuzzy search and its workspace
+    voice_command_t command;
+    size_t stable;
+    if (parse_commands(handle, text, 1.0f, &command, 1, &stable) != 1) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    strncpy(command_text, command.text, size - 1);
+    command_text[size - 1] = '\0';
     return ESP_OK;
 }
 
@@ -316,6 +803,43 @@ esp_err_t voice_command_processor_set_callback(voice_command_processor_handle_t
     return ESP_OK;
 }
 
+esp_err_t voice_command_processor_set_batch_callback(voice_command_processor_handle_t handle,
+                                                     command_batch_callback_t callback,
+                                                     void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->batch_callback = callback;
+    handle->batch_user_data = user_data;
+    
+    return ESP_OK;
+}
+
+esp_err_t voice_command_processor_set_dictation_callback(voice_command_processor_handle_t handle,
+                                                         dictation_callback_t callback,
+                                                         void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->dictation_callback = callback;
+    handle->dictation_user_data = user_data;
+    
+    return ESP_OK;
+}
+
+esp_err_t voice_command_processor_set_dictionary(voice_command_processor_handle_t handle,
+                                                 command_dictionary_handle_t dictionary) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->dictionary = dictionary;
+    
+    return ESP_OK;
+}
+
 esp_err_t voice_command_processor_get_stats(voice_command_processor_handle_t handle, 
                                             command_stats_t* stats) {
     if (!handle || !stats) {
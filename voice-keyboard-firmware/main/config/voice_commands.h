@@ -13,8 +13,11 @@
 
 #include "speech_recognition.h"
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "command_dictionary.h"
+#include "hid_bindings.h"
 
 // Типы команд / Command types
 typedef enum {
@@ -44,9 +47,16 @@ typedef enum {
     CMD_ACTION_PREV_TRACK,    // Предыдущий трек / Previous track
     CMD_ACTION_SYSTEM_SLEEP,  // Сон / Sleep
     CMD_ACTION_SYSTEM_LOCK,   // Блокировка / Lock
-    CMD_ACTION_SYSTEM_WAKE    // Пробуждение / Wake
+    CMD_ACTION_SYSTEM_WAKE,   // Пробуждение / Wake
+    CMD_ACTION_MOUSE_STOP,    // Остановить движение мыши / Stop the mouse motion
+    CMD_ACTION_POINTER_MOVE   // Указатель в область экрана / Pointer to a screen region
 } command_action_t;
 
+// Максимум команд в одной фразе / Maximum commands in one utterance
+#define VOICE_COMMAND_MAX_BATCH     8
+// Максимум повторов команды / Maximum command repeats
+#define VOICE_COMMAND_MAX_REPEAT    100
+
 // Голосовая команда / Voice command
 typedef struct {
     command_type_t type;      // Тип команды / Command type
@@ -54,6 +64,9 @@ typedef struct {
     char text[64];            // Распознанный текст / Recognized text
     char command[32];         // Команда / Command
     char param[32];           // Параметр / Parameter
+    uint16_t value;           // Числовой параметр (0 - нет) / Numeric parameter (0 - none)
+    uint16_t binding;         // Привязка HID (hid_binding_id_t) / HID binding (hid_binding_id_t)
+    uint16_t repeat;          // Число повторов (1 - однократно) / Repeat count (1 - once)
     float confidence;         // Уверенность / Confidence
 } voice_command_t;
 
@@ -66,6 +79,53 @@ typedef struct voice_command_processor* voice_command_processor_handle_t;
  */
 typedef void (*command_execution_callback_t)(const voice_command_t* command, void* user_data);
 
+/**
+ * @brief Callback для выполнения пакета команд одной фразы
+ * Callback executing the batch of commands from one utterance
+ *
+ * Команды передаются в порядке произнесения.
+ * Commands are passed in spoken order.
+ */
+typedef void (*command_batch_callback_t)(const voice_command_t* commands, size_t count, void* user_data);
+
+/**
+ * @brief Callback диктовки: фраза без команд
+ * Dictation callback: an utterance with no commands
+ *
+ * При is_final == false это промежуточная гипотеза, которая еще изменится.
+ * With is_final == false this is an interim hypothesis that will still change.
+ */
+typedef void (*dictation_callback_t)(const char* text, bool is_final, void* user_data);
+
+/**
+ * @brief Команда для HID задачи
+ * Command for the HID task
+ *
+ * Только индекс привязки и числа - строки в очередь не копируются.
+ * Only the binding index and numbers - strings are not copied into queues.
+ */
+static inline hid_command_t voice_command_to_hid(const voice_command_t* command) {
+    hid_command_t hid_command = {
+        .binding = command->binding,
+        .repeat = command->repeat,
+        .param = command->value,
+    };
+    return hid_command;
+}
+
+/**
+ * @brief Привязка действия громкости, медиа или системы
+ * Binding of a volume, media or system action
+ *
+ * Таблица индексируется действием; каждое такое действие - один отчет Consumer
+ * или System Control и его отпускание.
+ * The table is indexed by the action; each such action is one Consumer or
+ * System Control report and its release.
+ *
+ * @return HID_BINDING_NONE для действий без своей привязки / HID_BINDING_NONE for actions without one
+ */
+hid_binding_id_t voice_command_action_binding(command_action_t action);
+
 /**
  * @brief Инициализация процессора голосовых команд
  * Initialize voice command processor
@@ -81,6 +141,32 @@ esp_err_t voice_command_processor_deinit(voice_command_processor_handle_t handle
 /**
  * @brief Обработать результат распознавания речи
  * Process speech recognition result
+ *
+ * Фраза делится на команды по порядку ("нажми таб три раза и нажми ввод");
+ * числительные после команды становятся параметром, а с "раз"/"times" - повтором.
+ * The utterance is split into commands in order ("press tab three times and
+ * press enter"); number words after a command become its parameter, and with
+ * "раз"/"times" its repeat count.
+ *
+ * Командами фраза считается, только если команды покрывают почти всю ее
+ * (COMMAND_MATCHER_MIN_COVERAGE без связок "и"/"потом"/"then"); иначе, как и
+ * фраза без команд, она уходит в callback диктовки. Приветствия и прощания без
+ * привязки HID командами не считаются.
+ * The utterance counts as commands only when they cover almost all of it
+ * (COMMAND_MATCHER_MIN_COVERAGE, connectives like "и"/"потом"/"then" aside);
+ * otherwise, like an utterance with no commands, it goes to the dictation
+ * callback. Greetings and goodbyes with no HID binding don't count as commands.
+ *
+ * Промежуточные гипотезы (is_final == false) разбираются без нечеткого поиска,
+ * и команда выполняется сразу, как только совпадение однозначно: за ней уже
+ * есть другая команда или текст не может вырасти в более длинный шаблон
+ * ("кликни" ждет, не будет ли "кликни правой"). Финальный результат той же
+ * фразы не выполняет их повторно.
+ * Interim hypotheses (is_final == false) are parsed without fuzzy search, and a
+ * command runs as soon as its match is unambiguous: another command already
+ * follows it or the text can no longer grow into a longer pattern ("кликни"
+ * waits for a possible "кликни правой"). The final result of the same utterance
+ * does not run them again.
  */
 esp_err_t voice_command_processor_process_result(voice_command_processor_handle_t handle, 
                                                  const speech_result_t* speech_result);
@@ -93,6 +179,53 @@ esp_err_t voice_command_processor_set_callback(voice_command_processor_handle_t
                                                command_execution_callback_t callback, 
                                                void* user_data);
 
+/**
+ * @brief Установить callback для выполнения пакета команд
+ * Set command batch execution callback
+ *
+ * Если задан, вызывается вместо callback отдельных команд.
+ * When set it is called instead of the per-command callback.
+ */
+esp_err_t voice_command_processor_set_batch_callback(voice_command_processor_handle_t handle,
+                                                     command_batch_callback_t callback,
+                                                     void* user_data);
+
+/**
+ * @brief Установить callback диктовки
+ * Set dictation callback
+ *
+ * Если задан, фраза без команд печатается как текст, а не отбрасывается.
+ * When set, an utterance with no commands is typed as text instead of dropped.
+ */
+esp_err_t voice_command_processor_set_dictation_callback(voice_command_processor_handle_t handle,
+                                                         dictation_callback_t callback,
+                                                         void* user_data);
+
+/**
+ * @brief Использовать словарь команд из flash
+ * Use the command dictionary from flash
+ *
+ * Пока в словаре нет образа (или при NULL), используются встроенные команды.
+ * While the dictionary has no image (or with NULL) the built-in commands are used.
+ */
+esp_err_t voice_command_processor_set_dictionary(voice_command_processor_handle_t handle,
+                                                 command_dictionary_handle_t dictionary);
+
+/**
+ * @brief Текст команды, если фраза целиком из одной команды
+ * Command text when the utterance is one whole command
+ *
+ * Правила те же, что в process_result, но без нечеткого поиска и статистики,
+ * так что функцию можно вызывать из любой задачи.
+ * The same rules as process_result, but without fuzzy search or statistics, so
+ * the function may be called from any task.
+ *
+ * @param command_text Совпавший текст команды с параметром / Matched command text with its parameter
+ * @return ESP_OK или ESP_ERR_NOT_FOUND / ESP_OK or ESP_ERR_NOT_FOUND
+ */
+esp_err_t voice_command_processor_whole_command(voice_command_processor_handle_t handle, const char* text,
+                                                char* command_text, size_t size);
+
 /**
  * @brief Получить статистику обработки команд
  * Get command processing statistics
@@ -101,6 +234,9 @@ typedef struct {
     uint32_t total_commands;      // Всего команд обработано / Total commands processed
     uint32_t recognized_commands; // Распознано команд / Commands recognized
     uint32_t unknown_commands;    // Неизвестных команд / Unknown commands
+    uint32_t fuzzy_commands;      // Распознано нечетким поиском / Recognized by fuzzy search
+    uint32_t early_commands;      // Выполнено по промежуточной гипотезе / Run from an interim hypothesis
+    uint32_t deduplicated_commands; // Не повторено в финальном результате / Not repeated by the final result
     float average_confidence;     // Средняя уверенность / Average confidence
 } command_stats_t;
 
@@ -0,0 +1,73 @@
+#include "wifi_config.h"
+#include "config.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+
+static const char *TAG = "WIFI_CONFIG";
+
+// Reconnect on every drop; IP events tell the rest of the firmware when the link is usable
+static void wifi_event_handler(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+    } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*)data;
+        ESP_LOGW(TAG, "Disconnected from %s (reason %d), reconnecting", WIFI_SSID, event->reason);
+        esp_wifi_connect();
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*)data;
+        ESP_LOGI(TAG, "Got IP " IPSTR, IP2STR(&event->ip_info.ip));
+    }
+}
+
+esp_err_t wifi_init(void)
+{
+    ESP_LOGI(TAG, "Initializing Wi-Fi station");
+
+    // NVS holds radio calibration (and BLE bonds, see hid_ble.c)
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t init_cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&init_cfg));
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL, NULL));
+
+    wifi_config_t wifi_cfg = {
+        .sta = {
+            .threshold.authmode = WIFI_AUTHMODE_THRESHOLD,
+        },
+    };
+    strncpy((char*)wifi_cfg.sta.ssid, WIFI_SSID, sizeof(wifi_cfg.sta.ssid));
+    strncpy((char*)wifi_cfg.sta.password, WIFI_PASSWORD, sizeof(wifi_cfg.sta.password));
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_cfg));
+
+    ESP_LOGI(TAG, "Wi-Fi station initialized");
+    return ESP_OK;
+}
+
+esp_err_t wifi_start(void)
+{
+    esp_err_t ret = esp_wifi_start();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Wi-Fi started, connecting to %s", WIFI_SSID);
+    } else {
+        ESP_LOGE(TAG, "Failed to start Wi-Fi: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
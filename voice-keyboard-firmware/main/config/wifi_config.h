@@ -0,0 +1,14 @@
+#ifndef WIFI_CONFIG_H
+#define WIFI_CONFIG_H
+
+#include "esp_err.h"
+
+// Initialize NVS, the network interface, the default event loop and the Wi-Fi
+// station. The radio is not started yet, so modules created afterwards can
+// subscribe to IP_EVENT_STA_GOT_IP before the first connection comes up.
+esp_err_t wifi_init(void);
+
+// Start the station; it connects and reconnects on its own
+esp_err_t wifi_start(void);
+
+#endif // WIFI_CONFIG_H
@@ -4,19 +4,42 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "config/config.h"
 #include "config/i2s_config.h"
+#include "config/wifi_config.h"
 #include "config/gpio_config.h"
 #include "config/hid_config.h"
+#include "config/speech_recognition.h"
 #include "config/voice_commands.h"
+#include "config/command_dictionary.h"
+#include "config/dictation_output.h"
+#include "config/keyword_spotter.h"
+#include "config/stt_connection.h"
+#include "config/stt_client.h"
+#include "config/stt_spool.h"
+#include "config/cpu_load.h"
 #include "tasks/gpio_task.h"
 #include "tasks/audio_task.h"
 #include "tasks/hid_task.h"
+#include "tasks/system_state.h"
 
 static const char *TAG = "VOICE_KEYBOARD";
 
-// Флаг состояния I2S / I2S state flag
-bool is_i2s_enabled = false;
+// Автомат состояний системы / System state machine
+static system_state_handle_t system_state = NULL;
+
+// Пул соединений с сервером распознавания / STT server connection pool
+static stt_connection_pool_handle_t stt_connection_pool = NULL;
+
+// Клиент облачного распознавания / Cloud STT client
+static stt_client_handle_t stt_client = NULL;
+
+// Офлайн-очередь нераспознанных сегментов / Offline spool of unrecognized segments
+static stt_spool_handle_t stt_spool = NULL;
+
+// Распознаватель речи / Speech recognizer
+speech_recognizer_handle_t speech_recognizer = NULL;
 
 // Дескриптор задачи HID / HID task handle
 static hid_task_handle_t hid_task = NULL;
@@ -24,6 +47,33 @@ static hid_task_handle_t hid_task = NULL;
 // Дескриптор процессора команд / Command processor handle
 static voice_command_processor_handle_t command_processor = NULL;
 
+// Словарь команд из flash / Command dictionary from flash
+command_dictionary_handle_t command_dictionary = NULL;
+
+// Вывод диктовки / Dictation output
+static dictation_output_handle_t dictation_output = NULL;
+
+// Локальный детектор команд / On-device command spotter
+static keyword_spotter_handle_t keyword_spotter = NULL;
+
+/**
+ * @brief Отправить правку диктовки в HID задачу
+ * Send a dictation edit to the HID task
+ */
+static void send_dictation_edit(const dictation_edit_t* edit) {
+    if (!hid_task) {
+        return;
+    }
+    
+    if (edit->backspaces > 0) {
+        hid_command_t backspace = {.binding = HID_BINDING_KEY_BACKSPACE, .repeat = edit->backspaces};
+        hid_task_send_command(hid_task, &backspace);
+    }
+    if (edit->insert_length > 0) {
+        hid_task_send_text(hid_task, edit->insert, edit->insert_length);
+    }
+}
+
 /**
  * @brief Callback для выполнения команд
  * Command execution callback
@@ -32,12 +82,109 @@ static void command_execution_callback(const voice_command_t* command, void* use
     ESP_LOGI(TAG, "🎯 Executing command: '%s' -> %s (type: %d, action: %d)", 
              command->text, command->command, command->type, command->action);
     
-    // Отправка команды в HID задачу / Send command to HID task
+    // В HID задачу уходит только индекс привязки / Only the binding index goes to the HID task
+    if (hid_task) {
+        hid_command_t hid_command = voice_command_to_hid(command);
+        hid_task_send_command(hid_task, &hid_command);
+    }
+}
+
+/**
+ * @brief Callback для выполнения пакета команд одной фразы
+ * Batch execution callback for the commands of one utterance
+ */
+static void command_batch_callback(const voice_command_t* commands, size_t count, void* user_data) {
+    hid_command_t hid_commands[VOICE_COMMAND_MAX_BATCH];
+    dictation_edit_t edit;
+    
+    // Пакет приходит, только если команды покрывают фразу (COMMAND_MATCHER_MIN_COVERAGE),
+    // поэтому напечатанные гипотезы - это сама команда и стираются
+    // A batch only arrives when the commands cover the utterance (COMMAND_MATCHER_MIN_COVERAGE),
+    // so the typed hypotheses are the command itself and are erased
+    if (dictation_output_discard(dictation_output, &edit) == ESP_OK) {
+        send_dictation_edit(&edit);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "🎯 Executing command %u/%u: '%s' -> %s x%u", (unsigned)(i + 1), (unsigned)count,
+                 commands[i].text, commands[i].command, commands[i].repeat);
+        hid_commands[i] = voice_command_to_hid(&commands[i]);
+    }
+    
+    // Пакет ставится в очередь целиком, не дожидаясь USB / The batch is queued at once without waiting on USB
     if (hid_task) {
-        hid_task_send_command(hid_task, command);
+        hid_task_send_commands(hid_task, hid_commands, count);
+    }
+}
+
+/**
+ * @brief Callback диктовки: фраза без команд печатается
+ * Dictation callback: an utterance with no commands is typed
+ */
+static void dictation_callback(const char* text, bool is_final, void* user_data) {
+    dictation_edit_t edit;
+    
+    // Допечатывается только отличие от последней гипотезы / Only the difference from the last hypothesis is typed
+    if (dictation_output_update(dictation_output, text, is_final, &edit) == ESP_OK) {
+        send_dictation_edit(&edit);
     }
 }
 
+/**
+ * @brief Callback результатов распознавания (по порядку фрагментов)
+ * Recognition result callback (in utterance order)
+ */
+static void speech_result_callback(const speech_result_t* result, void* user_data) {
+    // Промежуточная гипотеза печатается или сразу выполняет однозначные команды
+    // An interim hypothesis is typed or runs unambiguous commands right away
+    if (result->is_final) {
+        ESP_LOGI(TAG, "🗣️  Utterance #%u: '%s' (confidence: %.2f)", result->sequence, result->text, result->confidence);
+        
+        // Задержка от физических нажатия и отпускания / Latency from the physical press and release
+        if (result->released_us) {
+            int64_t now = esp_timer_get_time();
+            ESP_LOGI(TAG, "Utterance #%u latency: %u ms after release, %u ms after press", result->sequence,
+                     (unsigned)((now - result->released_us) / 1000), (unsigned)((now - result->pressed_us) / 1000));
+        }
+        system_state_post(system_state, SYSTEM_EVENT_RESULT);
+    } else {
+        ESP_LOGD(TAG, "Utterance #%u so far: '%s'", result->sequence, result->text);
+    }
+    
+    if (command_processor) {
+        voice_command_processor_process_result(command_processor, result);
+    }
+}
+
+/**
+ * @brief Локальное распознавание короткого высказывания (задача speech_local)
+ * Local recognition of a short utterance (speech_local task)
+ */
+static esp_err_t local_recognizer(const int16_t* samples, size_t sample_count, speech_result_t* result,
+                                  void* user_data) {
+    return keyword_spotter_recognize(keyword_spotter, samples, sample_count, result);
+}
+
+/**
+ * @brief Облачный ответ на то же аудио: команда целиком становится образцом
+ * Cloud answer for the same audio: a whole command becomes a sample
+ */
+static void local_learner(const char* text, void* user_data) {
+    char command[KEYWORD_SPOTTER_MAX_TEXT];
+    
+    if (voice_command_processor_whole_command(command_processor, text, command, sizeof(command)) == ESP_OK) {
+        keyword_spotter_learn(keyword_spotter, command);
+    }
+}
+
+/**
+ * @brief Callback активности HID: конец вывода завершает ввод
+ * HID activity callback: the end of output finishes typing
+ */
+static void hid_activity_callback(bool busy, void* user_data) {
+    system_state_post(system_state, busy ? SYSTEM_EVENT_OUTPUT_BUSY : SYSTEM_EVENT_OUTPUT_IDLE);
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "Voice Keyboard starting... / Голосовая клавиатура запускается...");
@@ -54,12 +201,91 @@ void app_main(void)
     // Инициализация процессора команд / Initialize command processor
     ESP_ERROR_CHECK(voice_command_processor_init(&command_processor));
     ESP_ERROR_CHECK(voice_command_processor_set_callback(command_processor, command_execution_callback, NULL));
+    ESP_ERROR_CHECK(voice_command_processor_set_batch_callback(command_processor, command_batch_callback, NULL));
+    ESP_ERROR_CHECK(voice_command_processor_set_dictation_callback(command_processor, dictation_callback, NULL));
+    ESP_ERROR_CHECK(dictation_output_init(&dictation_output));
+    
+    // Словарь необязателен: без раздела работают встроенные команды
+    // The dictionary is optional: without the partition the built-in commands are used
+    if (command_dictionary_init(&command_dictionary, COMMAND_DICTIONARY_PARTITION) == ESP_OK) {
+        ESP_ERROR_CHECK(voice_command_processor_set_dictionary(command_processor, command_dictionary));
+    } else {
+        ESP_LOGW(TAG, "Command dictionary unavailable, using built-in commands");
+    }
+    
+    // Сеть: NVS, netif, цикл событий и Wi-Fi станция; радио стартует после подписки пула на IP
+    // Networking: NVS, netif, the event loop and the Wi-Fi station; the radio starts after the pool subscribes to IP events
+    ESP_ERROR_CHECK(wifi_init());
+    
+    // Инициализация соединения с сервером распознавания / Initialize STT server connection
+    stt_connection_config_t connection_config = {
+        .host = STT_SERVER_HOST,
+        .port = STT_SERVER_PORT,
+        .connect_timeout_ms = STT_CONNECT_TIMEOUT_MS,
+        .idle_timeout_ms = STT_IDLE_TIMEOUT_MS,
+    };
+    ESP_ERROR_CHECK(stt_connection_pool_init(&stt_connection_pool, &connection_config));
+    ESP_ERROR_CHECK(wifi_start());
+    
+    stt_client_config_t client_config = {
+        .host = STT_SERVER_HOST,
+        .path = STT_SERVER_PATH,
+        .language = STT_LANGUAGE,
+        .response_timeout_ms = STT_RESPONSE_TIMEOUT_MS,
+    };
+    ESP_ERROR_CHECK(stt_client_init(&stt_client, stt_connection_pool, &client_config));
+    
+    // Офлайн-очередь необязательна: без раздела распознавание работает как раньше
+    // The offline spool is optional: without the partition recognition works as before
+    stt_spool_config_t spool_config = {
+        .partition_label = STT_SPOOL_PARTITION,
+        .policy = STT_SPOOL_POLICY,
+        .discard_after_ms = STT_SPOOL_DISCARD_AFTER_MS,
+        .backoff_initial_ms = STT_SPOOL_BACKOFF_INITIAL_MS,
+        .backoff_max_ms = STT_SPOOL_BACKOFF_MAX_MS,
+    };
+    if (stt_spool_init(&stt_spool, &spool_config) == ESP_OK) {
+        ESP_ERROR_CHECK(stt_client_set_spool(stt_client, stt_spool));
+    } else {
+        ESP_LOGW(TAG, "Offline spool unavailable, failed utterances will be lost");
+    }
+    
+    // Инициализация распознавателя речи / Initialize speech recognizer
+    speech_config_t speech_config = {
+        .sensitivity = 0.5f,
+        .max_recording_time = 30,
+        .language = STT_LANGUAGE,
+        .enable_noise_reduction = true,
+        .enable_agc = true,
+        .confidence_threshold = 0.6f,
+    };
+    ESP_ERROR_CHECK(speech_recognizer_init(&speech_recognizer, &speech_config));
+    ESP_ERROR_CHECK(speech_recognizer_set_stt_client(speech_recognizer, stt_client));
+    ESP_ERROR_CHECK(speech_recognizer_set_callback(speech_recognizer, speech_result_callback, NULL));
+    
+    // Короткие команды распознаются на устройстве, пока облако не ответило
+    // Short commands are recognized on the device before the cloud answers
+    if (keyword_spotter_init(&keyword_spotter) == ESP_OK) {
+        ESP_ERROR_CHECK(speech_recognizer_set_local_recognizer(speech_recognizer, local_recognizer,
+                                                               local_learner, NULL));
+    } else {
+        ESP_LOGW(TAG, "Keyword spotter unavailable, every utterance waits for the cloud");
+    }
+    
+    // Автомат состояний управляет захватом; кнопка, VAD, результаты и HID - его события
+    // The state machine drives capture; the button, VAD, results and HID are its events
+    system_state_config_t state_config = {
+        .recognizer = speech_recognizer,
+        .connection_pool = stt_connection_pool,
+    };
+    ESP_ERROR_CHECK(system_state_init(&system_state, &state_config));
+    ESP_ERROR_CHECK(hid_task_set_activity_callback(hid_task, hid_activity_callback, NULL));
     
     // Создаем задачу GPIO / Create GPIO task
-    create_gpio_task();
+    create_gpio_task(system_state);
     
     // Создаем задачу обработки аудио / Create audio processing task
-    create_audio_task();
+    create_audio_task(system_state);
     
     // Запускаем HID задачу / Start HID task
     ESP_ERROR_CHECK(hid_task_start(hid_task));
@@ -69,6 +295,8 @@ void app_main(void)
     ESP_LOGI(TAG, "Press and hold button to record audio / Нажмите и удерживайте кнопку для записи аудио");
     
     // Основной цикл / Main loop
+    static system_transition_t trace[SYSTEM_TRACE_LENGTH];
+    int64_t traced_until_us = 0;
     while(1) {
         vTaskDelay(pdMS_TO_TICKS(5000));
         
@@ -80,12 +308,96 @@ void app_main(void)
             // Получение статистики / Get statistics
             hid_stats_t stats;
             if (hid_task_get_stats(hid_task, &stats) == ESP_OK) {
-                ESP_LOGD(TAG, "HID stats: processed=%d, keyboard=%d, mouse=%d, media=%d, system=%d", 
+                ESP_LOGD(TAG, "HID stats: processed=%u, keyboard=%u, mouse=%u, media=%u, system=%u, "
+                         "reports=%u, coalesced=%u, overflows=%u, errors=%u, typed=%u, unmapped=%u", 
                          stats.commands_processed, stats.keyboard_commands, stats.mouse_commands,
-                         stats.media_commands, stats.system_commands);
+                         stats.media_commands, stats.system_commands, stats.reports_sent,
+                         stats.reports_coalesced, stats.queue_overflows, stats.send_errors,
+                         stats.characters_typed, stats.characters_unmapped);
+            }
+        }
+        
+        // Статистика соединений STT / STT connection statistics
+        stt_connection_stats_t conn_stats;
+        if (stt_connection_pool_get_stats(stt_connection_pool, &conn_stats) == ESP_OK) {
+            ESP_LOGD(TAG, "STT connections: full=%u, resumed=%u (declined %u), reused=%u, idle_closed=%u, "
+                     "last_handshake=%u ms", conn_stats.full_handshakes, conn_stats.resumed_handshakes,
+                     conn_stats.declined_tickets, conn_stats.reused_connections, conn_stats.idle_closes,
+                     conn_stats.last_handshake_ms);
+        }
+        
+        // Статистика арбитража локальный/облако / Local/cloud arbitration statistics
+        speech_arbitration_stats_t arb_stats;
+        keyword_spotter_stats_t spotter_stats;
+        if (keyword_spotter && speech_recognizer_get_arbitration_stats(speech_recognizer, &arb_stats) == ESP_OK &&
+            keyword_spotter_get_stats(keyword_spotter, &spotter_stats) == ESP_OK) {
+            ESP_LOGD(TAG, "Arbitration: local_wins=%u, below_threshold=%u, no_match=%u, cloud_first=%u, "
+                     "cloud_only=%u, samples=%u (enrolled %u, too_short %u), last=%u in %u us",
+                     arb_stats.local_wins, arb_stats.local_below_threshold, arb_stats.local_no_match,
+                     arb_stats.cloud_first, arb_stats.cloud_only, spotter_stats.templates, spotter_stats.enrolled,
+                     spotter_stats.too_short, spotter_stats.last_distance, spotter_stats.last_compute_us);
+        }
+        
+        // Статистика офлайн-очереди / Offline spool statistics
+        stt_spool_stats_t spool_stats;
+        if (stt_spool && stt_spool_get_stats(stt_spool, &spool_stats) == ESP_OK) {
+            ESP_LOGD(TAG, "STT spool: depth=%u/%u, flash=%u/%u bytes, stored=%u, replayed=%u, expired=%u, evicted=%u",
+                     spool_stats.queue_depth, spool_stats.queue_capacity, spool_stats.flash_bytes_used,
+                     spool_stats.flash_bytes_total, spool_stats.records_stored, spool_stats.records_replayed,
+                     spool_stats.records_expired, spool_stats.records_evicted);
+        }
+        
+        // Статистика автомата состояний / State machine statistics
+        system_state_stats_t state_stats;
+        if (system_state_get_stats(system_state, &state_stats) == ESP_OK) {
+            ESP_LOGD(TAG, "State %s: transitions=%u, ignored=%u, dropped=%u, timeouts=%u, max_latency=%u us, "
+                     "pre_roll=%llu ms, recording=%llu ms, uploading=%llu ms, typing=%llu ms",
+                     system_state_name(system_state_get(system_state)), state_stats.transitions,
+                     state_stats.ignored, state_stats.dropped, state_stats.timeouts, state_stats.max_latency_us,
+                     state_stats.time_us[SYSTEM_STATE_PRE_ROLL] / 1000, state_stats.time_us[SYSTEM_STATE_RECORDING] / 1000,
+                     state_stats.time_us[SYSTEM_STATE_UPLOADING] / 1000, state_stats.time_us[SYSTEM_STATE_TYPING] / 1000);
+        }
+        
+        // Переходы с прошлого отчета (старше SYSTEM_TRACE_LENGTH уже вытеснены)
+        // Transitions since the last report (older than SYSTEM_TRACE_LENGTH are already overwritten)
+        size_t trace_count = 0;
+        if (system_state_get_trace(system_state, trace, SYSTEM_TRACE_LENGTH, &trace_count) == ESP_OK) {
+            for (size_t i = 0; i < trace_count; i++) {
+                if (trace[i].time_us <= traced_until_us) {
+                    continue;
+                }
+                ESP_LOGD(TAG, "Transition at %lld ms: %s -> %s on %s, latency=%u us, after %u ms",
+                         trace[i].time_us / 1000, system_state_name(trace[i].from), system_state_name(trace[i].to),
+                         system_event_name(trace[i].event), trace[i].latency_us, trace[i].duration_us / 1000);
+            }
+            if (trace_count > 0) {
+                traced_until_us = trace[trace_count - 1].time_us;
             }
         }
         
+        // Загрузка ядер: захват на AUDIO_CORE, сеть и HID на IO_CORE / Core load: capture on AUDIO_CORE, network and HID on IO_CORE
+        cpu_load_t cpu_load;
+        if (cpu_load_sample(&cpu_load) == ESP_OK) {
+            if (cpu_load.core_count > 1) {
+                ESP_LOGD(TAG, "CPU load over %u ms: core0=%u%%, core1=%u%%", cpu_load.window_ms,
+                         cpu_load.busy_percent[0], cpu_load.busy_percent[1]);
+            } else {
+                ESP_LOGD(TAG, "CPU load over %u ms: %u%%", cpu_load.window_ms, cpu_load.busy_percent[0]);
+            }
+        }
+        
+        // Бюджет тактов предобработки / Preprocessing cycle budget
+        audio_budget_stats_t budget_stats;
+        if (speech_recognizer_get_audio_budget_stats(speech_recognizer, &budget_stats) == ESP_OK) {
+            ESP_LOGD(TAG, "Audio budget: quality=%d (worst %d), degradations=%u (backlog %u), restorations=%u, "
+                     "over_budget=%u, backlog=%u, preempted=%u, block=%u/%u cycles (filter %u, agc %u), max=%u",
+                     budget_stats.quality, budget_stats.worst_quality, budget_stats.degradations,
+                     budget_stats.backlog_degradations, budget_stats.restorations, budget_stats.over_budget_blocks,
+                     budget_stats.backlog_blocks, budget_stats.preempted_blocks,
+                     budget_stats.block_cycles, budget_stats.budget_cycles,
+                     budget_stats.filter_cycles, budget_stats.agc_cycles, budget_stats.max_block_cycles);
+        }
+        
         ESP_LOGD(TAG, "System running... / Система работает...");
     }
 }
\ No newline at end of file
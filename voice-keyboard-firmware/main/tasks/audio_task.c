@@ -1,12 +1,14 @@
 #include "audio_task.h"
 #include "config/config.h"
 #include "config/i2s_config.h"
+#include "config/speech_recognition.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char *TAG = "AUDIO_TASK";
 
-// Внешний флаг состояния I2S / External I2S state flag
-extern bool is_i2s_enabled;
+// Внешний распознаватель речи / External speech recognizer
+extern speech_recognizer_handle_t speech_recognizer;
 
 // Аудиобуфер / Audio buffer
 static int16_t audio_buffer[I2S_BUFFER_SIZE];
@@ -14,47 +16,63 @@ static int16_t audio_buffer[I2S_BUFFER_SIZE];
 // Задача обработки аудио / Audio processing task
 static void audio_task_impl(void* arg)
 {
+    system_state_handle_t system_state = (system_state_handle_t)arg;
     size_t bytes_read;
     esp_err_t ret;
     i2s_chan_handle_t rx_handle = get_i2s_rx_handle();
+    uint32_t backlog_blocks = 0;
     
     ESP_LOGI(TAG, "Audio processing task started / Задача обработки аудио запущена");
     
     for(;;) {
-        // Проверить включен ли I2S (запись) / Check if I2S is enabled (recording)
-        if(is_i2s_enabled) {
-            // Чтение аудиоданных из I2S / Read audio data from I2S
-            ret = i2s_channel_read(rx_handle, audio_buffer, sizeof(audio_buffer), &bytes_read, portMAX_DELAY);
+        // Ждать начала захвата без опроса / Wait for capture to start without polling
+        system_state_wait_capture(system_state);
+        
+        // Чтение аудиоданных из I2S / Read audio data from I2S
+        int64_t read_start = esp_timer_get_time();
+        ret = i2s_channel_read(rx_handle, audio_buffer, sizeof(audio_buffer), &bytes_read, portMAX_DELAY);
+        
+        if(ret == ESP_OK && bytes_read > 0) {
+            // Чтение без ожидания - блок уже лежал в DMA, обработка отстает
+            // A read that did not wait found the block already in DMA: processing is behind
+            if (esp_timer_get_time() - read_start < AUDIO_BACKLOG_WAIT_US) {
+                backlog_blocks++;
+            } else {
+                backlog_blocks = 0;
+            }
+            
+            // Обработка аудио сэмплов / Process audio samples
+            int samples_read = bytes_read / sizeof(int16_t);
+            
+            // Простое определение уровня аудио для отладки / Simple audio level detection for debugging
+            int32_t sum = 0;
+            for(int i = 0; i < samples_read; i++) {
+                sum += abs(audio_buffer[i]);
+            }
+            int avg_level = sum / samples_read;
+            
+            // Логирование уровня аудио каждые N буферов / Log audio level every N buffers
+            static int buffer_count = 0;
+            if(++buffer_count >= AUDIO_LEVEL_LOG_INTERVAL) {
+                ESP_LOGI(TAG, "Audio level: %d (samples: %d) / Уровень аудио: %d (сэмплов: %d)", avg_level, samples_read);
+                buffer_count = 0;
+            }
             
-            if(ret == ESP_OK && bytes_read > 0) {
-                // Обработка аудио сэмплов / Process audio samples
-                int samples_read = bytes_read / sizeof(int16_t);
-                
-                // Простое определение уровня аудио для отладки / Simple audio level detection for debugging
-                int32_t sum = 0;
-                for(int i = 0; i < samples_read; i++) {
-                    sum += abs(audio_buffer[i]);
-                }
-                int avg_level = sum / samples_read;
-                
-                // Логирование уровня аудио каждые N буферов / Log audio level every N buffers
-                static int buffer_count = 0;
-                if(++buffer_count >= AUDIO_LEVEL_LOG_INTERVAL) {
-                    ESP_LOGI(TAG, "Audio level: %d (samples: %d) / Уровень аудио: %d (сэмплов: %d)", avg_level, samples_read);
-                    buffer_count = 0;
-                }
-                
-                // TODO: Отправить аудиоданные в задачу распознавания речи / TODO: Send audio data to speech recognition task
-                // Сейчас просто обрабатываем и отбрасываем / For now, we just process and discard
+            // Отправить аудиоданные в распознаватель / Send audio data to the recognizer
+            if (speech_recognizer) {
+                speech_recognizer_report_backlog(speech_recognizer, backlog_blocks);
+                speech_recognizer_process_audio(speech_recognizer, audio_buffer, bytes_read);
             }
-        } else {
-            // Не записываем, немного ждем / Not recording, wait a bit
-            vTaskDelay(pdMS_TO_TICKS(10));
+        } else if(ret != ESP_OK && system_state_is_capturing(system_state)) {
+            // Сбой во время захвата, а не остановка / A failure during capture rather than a stop
+            ESP_LOGE(TAG, "I2S read failed: %s", esp_err_to_name(ret));
+            system_state_post(system_state, SYSTEM_EVENT_ERROR);
         }
     }
 }
 
-void create_audio_task(void)
+void create_audio_task(system_state_handle_t system_state)
 {
-    xTaskCreate(audio_task_impl, "audio_task", AUDIO_TASK_STACK_SIZE, NULL, AUDIO_TASK_PRIORITY, NULL);
+    xTaskCreatePinnedToCore(audio_task_impl, "audio_task", AUDIO_TASK_STACK_SIZE, system_state, AUDIO_TASK_PRIORITY,
+                            NULL, AUDIO_CORE);
 }
\ No newline at end of file
@@ -3,8 +3,9 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "system_state.h"
 
-// Создать задачу обработки аудио / Create audio processing task
-void create_audio_task(void);
+// Создать задачу обработки аудио: читает I2S, пока идет захват / Create audio processing task: reads I2S while capture runs
+void create_audio_task(system_state_handle_t system_state);
 
 #endif // AUDIO_TASK_H
\ No newline at end of file
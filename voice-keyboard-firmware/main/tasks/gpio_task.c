@@ -1,53 +1,31 @@
 #include "gpio_task.h"
 #include "config/config.h"
 #include "config/gpio_config.h"
-#include "config/i2s_config.h"
 #include "esp_log.h"
 
 static const char *TAG = "GPIO_TASK";
 
-// Внешний флаг состояния I2S / External I2S state flag
-extern bool is_i2s_enabled;
-
 // Задача GPIO для обработки событий кнопки / GPIO task to handle button events
 static void gpio_task_impl(void* arg)
 {
-    uint32_t io_num;
-    bool is_recording = false;
-    QueueHandle_t gpio_evt_queue = get_gpio_evt_queue();
-    
+    system_state_handle_t system_state = (system_state_handle_t)arg;
+    button_edge_t edge;
+
     for(;;) {
-        if(xQueueReceive(gpio_evt_queue, &io_num, portMAX_DELAY)) {
-            // Нажатие кнопки (активный LOW) / Button pressed (active LOW)
-            if(io_num == BUTTON_PIN) {
-                int level = get_button_state();
-                
-                if(level == 0 && !is_recording) {
-                    // Начать запись / Start recording
-                    is_recording = true;
-                    is_i2s_enabled = true;
-                    set_led_state(true);  // Включить LED / Turn LED on
-                    ESP_LOGI(TAG, "Recording started / Запись начата");
-                    
-                    // Включить I2S / Enable I2S
-                    i2s_enable();
-                    
-                } else if(level == 1 && is_recording) {
-                    // Остановить запись / Stop recording
-                    is_recording = false;
-                    is_i2s_enabled = false;
-                    set_led_state(false);  // Выключить LED / Turn LED off
-                    ESP_LOGI(TAG, "Recording stopped / Запись остановлена");
-                    
-                    // Выключить I2S / Disable I2S
-                    i2s_disable();
-                }
-            }
-        }
+        // Фронт уже отфильтрован от дребезга и помечен временем в прерывании
+        // The edge is already debounced and timestamped in the interrupt
+        wait_button_edge(&edge);
+        ESP_LOGD(TAG, "Button %s, %u bounce(s) filtered / Кнопка %s", edge.pressed ? "down" : "up",
+                 (unsigned)edge.bounces, edge.pressed ? "нажата" : "отпущена");
+
+        // Задержка переходов считается от физического фронта / Transition latency counts from the physical edge
+        system_state_post_at(system_state, edge.pressed ? SYSTEM_EVENT_BUTTON_DOWN : SYSTEM_EVENT_BUTTON_UP,
+                             edge.time_us);
     }
 }
 
-void create_gpio_task(void)
+void create_gpio_task(system_state_handle_t system_state)
 {
-    xTaskCreate(gpio_task_impl, "gpio_task", GPIO_TASK_STACK_SIZE, NULL, GPIO_TASK_PRIORITY, NULL);
-}
\ No newline at end of file
+    xTaskCreatePinnedToCore(gpio_task_impl, "gpio_task", GPIO_TASK_STACK_SIZE, system_state, GPIO_TASK_PRIORITY,
+                            NULL, IO_CORE);
+}
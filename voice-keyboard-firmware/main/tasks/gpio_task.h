@@ -3,8 +3,9 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "system_state.h"
 
-// Создать задачу GPIO / Create GPIO task
-void create_gpio_task(void);
+// Создать задачу GPIO: кнопка публикует события автомата / Create GPIO task: the button posts state machine events
+void create_gpio_task(system_state_handle_t system_state);
 
 #endif // GPIO_TASK_H
\ No newline at end of file
@@ -0,0 +1,1121 @@
+/**
+ * @file hid_task.c
+ * @brief HID output task implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация задачи вывода HID
+ * Implementation of the HID output task
+ */
+
+#include "hid_task.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config/config.h"
+#include "config/hid_config.h"
+#include "config/text_planner.h"
+#include "config/mouse_motion.h"
+
+static const char* TAG = "HID_TASK";
+
+// Биты уведомлений задачи / Task notification bits
+#define HID_TASK_NOTIFY_QUEUE       0x01    // В очереди новые элементы / New items in the queue
+#define HID_TASK_NOTIFY_COMPLETE    0x02    // Хост забрал отчет / The host took a report
+#define HID_TASK_NOTIFY_TIMER       0x04    // Подошел срок отчета / A report is due
+
+// Ожидание завершения, после которого хост считается неактивным / Completion wait after which the host is considered idle
+#define HID_TASK_COMPLETE_TIMEOUT_MS    20
+
+_Static_assert((HID_TASK_QUEUE_LENGTH & (HID_TASK_QUEUE_LENGTH - 1)) == 0,
+               "HID_TASK_QUEUE_LENGTH must be a power of two");
+
+// Число типов отчетов / Number of report types
+#define HID_REPORT_TYPE_COUNT       (HID_REPORT_POINTER + 1)
+
+// Лестница профилей автоподбора, от быстрого к надежному / Auto-tune profile ladder, fastest to safest
+static const hid_timing_profile_t autotune_ladder[] = {
+    {.hold_us = 1000,  .gap_us = 1000},
+    {.hold_us = 2000,  .gap_us = 1000},
+    {.hold_us = 4000,  .gap_us = 2000},
+    {.hold_us = 8000,  .gap_us = 4000},
+    {.hold_us = 16000, .gap_us = 8000},
+    {.hold_us = 32000, .gap_us = 16000},
+};
+
+#define AUTOTUNE_STEPS  (sizeof(autotune_ladder) / sizeof(autotune_ladder[0]))
+#define AUTOTUNE_SAFEST (AUTOTUNE_STEPS - 1)
+
+_Static_assert(HID_AUTOTUNE_TAPS % 2 == 0, "HID_AUTOTUNE_TAPS must be even");
+
+// Нажатие Caps Lock для автоподбора (не команда словаря) / Caps Lock tap for auto-tune (not a dictionary command)
+static const hid_report_t caps_tap_reports[] = {
+    {.type = HID_REPORT_KEYBOARD, .keyboard = {.keycode = {HID_KEY_CAPS_LOCK}}},
+    {.type = HID_REPORT_KEYBOARD},
+};
+
+static const hid_binding_t caps_tap_binding = {
+    .reports = caps_tap_reports,
+    .report_count = 2,
+    .name = "caps_tap",
+};
+
+// Сочетание переключения раскладки / Layout switch hotkey
+static const hid_report_t layout_switch_reports[] = {
+    {.type = HID_REPORT_KEYBOARD, .keyboard = {.modifier = HID_LAYOUT_SWITCH_MODIFIER, .keycode = {HID_LAYOUT_SWITCH_KEY}}},
+    {.type = HID_REPORT_KEYBOARD, .flags = HID_REPORT_FLAG_SETTLE},
+};
+
+static const hid_binding_t layout_switch_binding = {
+    .reports = layout_switch_reports,
+    .report_count = 2,
+    .name = "layout_switch",
+};
+
+// Профиль плавного движения мыши / Smooth mouse motion profile
+static const mouse_motion_profile_t motion_profile = {
+    .start_speed = HID_MOTION_START_SPEED,
+    .max_speed = HID_MOTION_MAX_SPEED,
+    .acceleration = HID_MOTION_ACCELERATION,
+    .timeout_ms = HID_MOTION_TIMEOUT_MS,
+};
+
+// Тип элемента очереди / Queue item kind
+typedef enum {
+    HID_ITEM_COMMAND,
+    HID_ITEM_REPORT,
+    HID_ITEM_TIMING,
+    HID_ITEM_AUTOTUNE,
+    HID_ITEM_TEXT,
+    HID_ITEM_LAYOUT
+} hid_item_kind_t;
+
+// Текст в куче, освобождает HID задача / Heap text, freed by the HID task
+typedef struct {
+    char* data;
+    size_t length;
+} hid_text_t;
+
+// Элемент очереди / Queue item
+typedef struct {
+    uint8_t kind;                 // hid_item_kind_t
+    union {
+        hid_command_t command;
+        hid_report_t report;
+        hid_timing_profile_t timing;
+        hid_text_t text;
+        uint8_t layout;
+    };
+} hid_item_t;
+
+// Состояние автоподбора / Auto-tune state
+typedef enum {
+    AUTOTUNE_IDLE,
+    AUTOTUNE_PENDING,             // Ждем отправки поставленного раньше / Waiting for earlier items to go out
+    AUTOTUNE_PROBING,             // Нажатия пробы в буфере / Probe taps are being sent
+    AUTOTUNE_SETTLING             // Ждем светодиоды от хоста / Waiting for the host's LEDs
+} autotune_state_t;
+
+// Ячейка очереди с номером последовательности / Queue slot with a sequence number
+typedef struct {
+    atomic_uint sequence;
+    hid_item_t item;
+} hid_slot_t;
+
+// Внутренняя структура HID задачи / Internal HID task structure
+struct hid_task {
+    hid_device_handle_t device;
+    TaskHandle_t task;
+
+    // Очередь без блокировок: много писателей, один читатель (Вьюков)
+    // Lock-free queue: many producers, one consumer (Vyukov)
+    hid_slot_t slots[HID_TASK_QUEUE_LENGTH];
+    atomic_uint enqueue_pos;
+    unsigned dequeue_pos;
+
+    // Разворачиваемая команда / Command being expanded
+    const hid_binding_t* binding;
+    hid_command_t command;
+    uint16_t repeat_left;
+    uint8_t report_index;
+    uint16_t distance_left;
+
+    // Плавное движение мыши, идет рядом с очередью / Smooth mouse motion, runs alongside the queue
+    mouse_motion_t motion;
+    int64_t motion_due_us;        // Срок следующего кадра / Next frame deadline
+
+    // Печатаемый текст / Text being typed
+    char* text;
+    size_t text_length;
+    size_t text_base;             // Начало спланированной части / Start of the planned part
+    size_t text_planned;          // Спланировано байт / Bytes planned
+    size_t step_index;            // Следующий шаг плана / Next plan step
+    text_planner_t planner;
+    text_transcoder_t transcoder;
+    bool transcoding;
+    uint8_t layout;               // Раскладка хоста (кэш) / Host layout (cached)
+    atomic_int led_layout;        // Раскладка по светодиоду (-1 неизвестна) / Layout from the LED (-1 unknown)
+
+    // Отчеты, готовые к отправке / Reports ready to send
+    hid_report_t staging[HID_TASK_STAGING_LENGTH];
+    uint8_t staging_head;
+    uint8_t staging_count;
+    bool in_flight;               // Ждем завершения IN передачи / Waiting for IN transfer completion
+
+    // Планирование по профилю времени / Scheduling by the timing profile
+    hid_timing_profile_t timing;
+    int64_t ready_us[HID_REPORT_TYPE_COUNT];  // Раньше этого времени тип не отправляется / No report of a type goes out before this
+    uint8_t mouse_buttons;        // Последние отправленные кнопки / Last buttons sent
+    esp_timer_handle_t timer;
+
+    // Автоподбор / Auto-tune
+    struct {
+        uint8_t state;            // autotune_state_t
+        uint8_t step;             // Ступень лестницы / Ladder step
+        bool verified;            // Самая надежная ступень прошла / The safest step passed
+        bool fixing;              // Проба - лишнее нажатие для Caps Lock / The probe is an extra tap for Caps Lock
+        bool finished;
+        int64_t settle_us;
+        hid_timing_profile_t saved;
+        hid_timing_profile_t result;
+    } autotune;
+    uint8_t leds;                 // Последние светодиоды (задача USB) / Last LEDs (USB task)
+    atomic_uint led_toggles;      // Переключений Caps Lock / Caps Lock toggles
+
+    // Активность вывода / Output activity
+    bool busy;
+    hid_task_activity_callback_t activity_callback;
+    void* activity_user_data;
+
+    // Статистика / Statistics
+    hid_stats_t stats;
+};
+
+/**
+ * @brief Поставить элемент в очередь
+ * Push an item to the queue
+ *
+ * @return false если очередь полна / false if the queue is full
+ */
+static bool queue_push(struct hid_task* task, const hid_item_t* item) {
+    unsigned pos = atomic_load_explicit(&task->enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        hid_slot_t* slot = &task->slots[pos & (HID_TASK_QUEUE_LENGTH - 1)];
+        unsigned sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int diff = (int)(sequence - pos);
+
+        if (diff == 0) {
+            // Ячейка свободна - занять позицию / The slot is free - claim the position
+            if (atomic_compare_exchange_weak_explicit(&task->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->item = *item;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&task->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Забрать элемент из очереди (только HID задача)
+ * Pop an item from the queue (HID task only)
+ */
+static bool queue_pop(struct hid_task* task, hid_item_t* item) {
+    unsigned pos = task->dequeue_pos;
+    hid_slot_t* slot = &task->slots[pos & (HID_TASK_QUEUE_LENGTH - 1)];
+    unsigned sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+    if ((int)(sequence - (pos + 1)) < 0) {
+        return false;
+    }
+
+    *item = slot->item;
+    atomic_store_explicit(&slot->sequence, pos + HID_TASK_QUEUE_LENGTH, memory_order_release);
+    task->dequeue_pos = pos + 1;
+    return true;
+}
+
+static esp_err_t push_item(struct hid_task* task, const hid_item_t* item) {
+    if (!queue_push(task, item)) {
+        task->stats.queue_overflows++;
+        ESP_LOGW(TAG, "HID queue full, dropping item");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (task->task) {
+        xTaskNotify(task->task, HID_TASK_NOTIFY_QUEUE, eSetBits);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Учесть команду по категории
+ * Count a command by category
+ */
+static void count_command(struct hid_task* task, const hid_binding_t* binding) {
+    task->stats.commands_processed++;
+
+    switch (binding->reports[0].type) {
+        case HID_REPORT_KEYBOARD:
+            task->stats.keyboard_commands++;
+            break;
+        case HID_REPORT_MOUSE:
+        case HID_REPORT_POINTER:
+            task->stats.mouse_commands++;
+            break;
+        case HID_REPORT_CONSUMER:
+            task->stats.media_commands++;
+            break;
+        case HID_REPORT_SYSTEM:
+            task->stats.system_commands++;
+            break;
+        default:
+            break;
+    }
+}
+
+static int8_t scale_axis(int8_t value, uint8_t step) {
+    return value > 0 ? (int8_t)step : (value < 0 ? -(int8_t)step : 0);
+}
+
+/**
+ * @brief Стоимость переключения раскладки в отчетах
+ * Layout switch cost in reports
+ *
+ * Отпускание, нажатие и отпускание сочетания плюс задержка хоста, пересчитанная
+ * в отчеты по текущему профилю времени.
+ * The release, the hotkey press and release, plus the host delay converted to
+ * reports at the current timing profile.
+ */
+static uint32_t layout_switch_cost(const struct hid_task* task) {
+    uint32_t report_us = (task->timing.hold_us + task->timing.gap_us) / 2;
+    return 3 + HID_LAYOUT_SWITCH_DELAY_US / (report_us ? report_us : 1);
+}
+
+/**
+ * @brief Следующий отчет печатаемого текста
+ * Next report of the text being typed
+ *
+ * Текст планируется кусками по TEXT_PLANNER_MAX_SEGMENTS отрезков; перед
+ * шагом в другой раскладке запускается привязка переключения.
+ * The text is planned in chunks of TEXT_PLANNER_MAX_SEGMENTS segments; before
+ * a step in another layout the switch binding is started.
+ *
+ * @return false если текст напечатан или началось переключение
+ *         false when the text is done or a switch has started
+ */
+static bool next_text_report(struct hid_task* task, hid_report_t* report) {
+    for (;;) {
+        if (task->transcoding) {
+            *report = (hid_report_t){.type = HID_REPORT_KEYBOARD};
+            if (text_transcoder_next(&task->transcoder, &report->keyboard)) {
+                return true;
+            }
+            task->stats.characters_typed += task->transcoder.characters;
+            task->stats.characters_unmapped += task->transcoder.unmapped;
+            task->transcoding = false;
+        }
+
+        if (task->step_index == task->planner.step_count) {
+            if (task->text_planned == task->text_length) {
+                return false;
+            }
+
+            // Светодиод точнее кэша / The LED is more accurate than the cache
+            int led_layout = atomic_load_explicit(&task->led_layout, memory_order_relaxed);
+            if (led_layout >= 0) {
+                task->layout = led_layout;
+            }
+
+            task->text_base = task->text_planned;
+            task->text_planned += text_planner_plan(&task->planner, task->text + task->text_base,
+                                                    task->text_length - task->text_base, task->layout,
+                                                    layout_switch_cost(task));
+            task->step_index = 0;
+            continue;
+        }
+
+        const text_plan_step_t* step = &task->planner.steps[task->step_index++];
+        text_transcoder_init(&task->transcoder, step->layout, task->text + task->text_base + step->start,
+                             step->length);
+        task->transcoding = true;
+
+        if (step->layout != task->layout) {
+            task->layout = step->layout;
+            atomic_store_explicit(&task->led_layout, -1, memory_order_relaxed);
+            task->stats.layout_switches++;
+
+            task->binding = &layout_switch_binding;
+            task->command = (hid_command_t){0};
+            task->repeat_left = 1;
+            task->report_index = 0;
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Закончить печать текста
+ * Finish typing a text
+ */
+static void finish_text(struct hid_task* task) {
+    free(task->text);
+    task->text = NULL;
+}
+
+/**
+ * @brief Начать или остановить плавное движение по команде
+ * Start or stop a smooth motion from a command
+ *
+ * Направление - знаки смещения первого отчета привязки, расстояние - параметр
+ * команды, умноженный на повторы; без параметра движение идет до "стоп".
+ * The direction is the signs of the binding's first report, the distance is
+ * the command parameter times the repeats; without a parameter the motion runs
+ * until "stop".
+ */
+static void start_motion(struct hid_task* task, const hid_binding_t* binding, const hid_command_t* command) {
+    const hid_mouse_report_t* direction = &binding->reports[0].mouse;
+    uint32_t distance = (uint32_t)command->param * (command->repeat ? command->repeat : 1);
+    int64_t now = esp_timer_get_time();
+
+    mouse_motion_start(&task->motion, &motion_profile, direction->x, direction->y, distance, now);
+    if (task->motion.active) {
+        task->motion_due_us = now;
+        task->stats.motions++;
+    }
+}
+
+/**
+ * @brief Следующий отчет: из разворачиваемой команды или из очереди
+ * Next report: from the command being expanded or from the queue
+ *
+ * Команда разворачивается лениво, поэтому "сто раз" не занимает очередь.
+ * Commands expand lazily, so "a hundred times" doesn't occupy the queue.
+ */
+static bool next_report(struct hid_task* task, hid_report_t* report) {
+    while (!task->binding) {
+        // Текст тоже переводится лениво / Text is transcoded lazily too
+        if (task->text) {
+            if (next_text_report(task, report)) {
+                return true;
+            }
+            if (!task->binding) {
+                finish_text(task);
+            }
+            continue;
+        }
+
+
+        // Пока идет автоподбор, очередь ждет / While auto-tuning, the queue waits
+        if (task->autotune.state != AUTOTUNE_IDLE) {
+            return false;
+        }
+
+        hid_item_t item;
+        if (!queue_pop(task, &item)) {
+            return false;
+        }
+
+        if (item.kind == HID_ITEM_REPORT) {
+            *report = item.report;
+            return true;
+        }
+        if (item.kind == HID_ITEM_TIMING) {
+            task->timing = item.timing;
+            continue;
+        }
+        if (item.kind == HID_ITEM_AUTOTUNE) {
+            task->autotune.state = AUTOTUNE_PENDING;
+            return false;
+        }
+        if (item.kind == HID_ITEM_TEXT) {
+            task->text = item.text.data;
+            task->text_length = item.text.length;
+            task->text_planned = 0;
+            task->step_index = 0;
+            task->planner.step_count = 0;
+            continue;
+        }
+        if (item.kind == HID_ITEM_LAYOUT) {
+            task->layout = item.layout;
+            continue;
+        }
+
+        const hid_binding_t* binding = hid_binding_get(item.command.binding);
+        if (binding->report_count == 0) {
+            continue;
+        }
+
+        count_command(task, binding);
+        if (binding->flags & HID_BINDING_FLAG_MOTION) {
+            start_motion(task, binding, &item.command);
+            continue;
+        }
+
+        // Другая команда останавливает движение: клик попадает туда, где указатель сейчас
+        // Any other command stops the motion: a click lands where the pointer is now
+        mouse_motion_stop(&task->motion);
+        task->binding = binding;
+        task->command = item.command;
+        task->repeat_left = item.command.repeat ? item.command.repeat : 1;
+        task->report_index = 0;
+        task->distance_left = item.command.param ? item.command.param : HID_BINDING_MOUSE_STEP;
+    }
+
+    const hid_binding_t* binding = task->binding;
+    *report = binding->reports[task->report_index];
+
+    // Смещение из параметра, шагами не больше 127 / Distance from the parameter, in steps of at most 127
+    if ((binding->flags & HID_BINDING_FLAG_DISTANCE) && report->type == HID_REPORT_MOUSE) {
+        uint8_t step = task->distance_left > 127 ? 127 : task->distance_left;
+        report->mouse.x = scale_axis(report->mouse.x, step);
+        report->mouse.y = scale_axis(report->mouse.y, step);
+        task->distance_left -= step;
+        if (task->distance_left > 0) {
+            return true;
+        }
+        task->distance_left = task->command.param ? task->command.param : HID_BINDING_MOUSE_STEP;
+    }
+
+    if (++task->report_index >= binding->report_count) {
+        task->report_index = 0;
+        if (--task->repeat_left == 0) {
+            task->binding = NULL;
+        }
+    }
+
+    return true;
+}
+
+static bool is_pure_move(const hid_report_t* report) {
+    return report->type == HID_REPORT_MOUSE && report->mouse.buttons == 0;
+}
+
+static bool fits_int8(int value) {
+    return value >= -127 && value <= 127;
+}
+
+/**
+ * @brief Слить отчет с последним неотправленным
+ * Merge a report into the last unsent one
+ *
+ * Движения мыши без кнопок складываются, повтор того же отчета клавиатуры
+ * отбрасывается.
+ * Button-less mouse moves are summed, a repeat of the same keyboard report is
+ * dropped.
+ */
+static bool coalesce(hid_report_t* last, const hid_report_t* report) {
+    if (is_pure_move(last) && is_pure_move(report)) {
+        int x = last->mouse.x + report->mouse.x;
+        int y = last->mouse.y + report->mouse.y;
+        int wheel = last->mouse.wheel + report->mouse.wheel;
+        int pan = last->mouse.pan + report->mouse.pan;
+        if (!fits_int8(x) || !fits_int8(y) || !fits_int8(wheel) || !fits_int8(pan)) {
+            return false;
+        }
+        last->mouse.x = x;
+        last->mouse.y = y;
+        last->mouse.wheel = wheel;
+        last->mouse.pan = pan;
+        return true;
+    }
+
+    return last->type == HID_REPORT_KEYBOARD && report->type == HID_REPORT_KEYBOARD &&
+           memcmp(&last->keyboard, &report->keyboard, sizeof(hid_keyboard_report_t)) == 0;
+}
+
+/**
+ * @brief Положить отчет в буфер, слив с последним, если можно
+ * Put a report into staging, merged with the last one when possible
+ */
+static void stage_report(struct hid_task* task, const hid_report_t* report) {
+    if (task->staging_count > 0) {
+        uint8_t last = (task->staging_head + task->staging_count - 1) % HID_TASK_STAGING_LENGTH;
+        if (coalesce(&task->staging[last], report)) {
+            task->stats.reports_coalesced++;
+            return;
+        }
+    }
+
+    task->staging[(task->staging_head + task->staging_count) % HID_TASK_STAGING_LENGTH] = *report;
+    task->staging_count++;
+}
+
+/**
+ * @brief Пополнить буфер отчетов из очереди
+ * Refill the report staging buffer from the queue
+ */
+static void fill_staging(struct hid_task* task) {
+    hid_report_t report;
+
+    while (task->staging_count < HID_TASK_STAGING_LENGTH && next_report(task, &report)) {
+        stage_report(task, &report);
+    }
+}
+
+/**
+ * @brief Кадр плавного движения: смещение за прошедшее время в буфер
+ * Smooth motion frame: the displacement for the elapsed time goes to staging
+ *
+ * Пока передача идет, кадры сливаются с ждущим движением; при полном буфере
+ * кадр откладывается, и смещение накапливается по времени.
+ * While a transfer is in flight frames merge into the waiting move; with
+ * staging full the frame is put off and the displacement accrues with time.
+ *
+ * @return Срок следующего кадра (0 - движения нет) / Deadline of the next frame (0 - no motion)
+ */
+static int64_t motion_frame(struct hid_task* task, int64_t now) {
+    if (!task->motion.active) {
+        return 0;
+    }
+    if (now < task->motion_due_us) {
+        return task->motion_due_us;
+    }
+
+    task->motion_due_us = now + HID_MOTION_FRAME_US;
+    if (task->staging_count == HID_TASK_STAGING_LENGTH) {
+        return task->motion_due_us;
+    }
+
+    hid_report_t report = {.type = HID_REPORT_MOUSE};
+    if (mouse_motion_next(&task->motion, now, &report.mouse.x, &report.mouse.y)) {
+        stage_report(task, &report);
+    }
+    return task->motion.active ? task->motion_due_us : 0;
+}
+
+static esp_err_t send_report(struct hid_task* task, const hid_report_t* report) {
+    // Без хоста отчеты отбрасываются молча / Without a host reports are dropped quietly
+    if (!hid_is_connected(task->device)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    switch (report->type) {
+        case HID_REPORT_KEYBOARD:
+            return hid_keyboard_send_report(task->device, &report->keyboard);
+        case HID_REPORT_MOUSE:
+            return hid_mouse_send_report(task->device, &report->mouse);
+        case HID_REPORT_CONSUMER:
+            return hid_consumer_send_report(task->device, report->usage);
+        case HID_REPORT_SYSTEM:
+            return hid_system_send_report(task->device, report->usage);
+        case HID_REPORT_POINTER:
+            return hid_pointer_send_report(task->device, &report->pointer);
+        default:
+            ESP_LOGD(TAG, "Report type %u not supported by the HID device", report->type);
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+static bool keyboard_pressed(const hid_keyboard_report_t* report) {
+    if (report->modifier) {
+        return true;
+    }
+    for (int i = 0; i < HID_KEYBOARD_MAX_KEYS; i++) {
+        if (report->keycode[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Назначить срок следующего отчета того же типа
+ * Set the deadline for the next report of the same type
+ *
+ * После нажатия ждем удержание, после отпускания - паузу. У мыши учитываются
+ * только смены кнопок, движения идут каждый кадр.
+ * After a press we wait the hold, after a release the gap. For the mouse only
+ * button changes count, moves go out every frame.
+ */
+static void schedule_next(struct hid_task* task, const hid_report_t* report, int64_t now) {
+    bool pressed;
+
+    switch (report->type) {
+        case HID_REPORT_KEYBOARD:
+            pressed = keyboard_pressed(&report->keyboard);
+            break;
+        case HID_REPORT_MOUSE:
+            if (report->mouse.buttons == task->mouse_buttons) {
+                return;
+            }
+            task->mouse_buttons = report->mouse.buttons;
+            pressed = report->mouse.buttons != 0;
+            break;
+        case HID_REPORT_CONSUMER:
+        case HID_REPORT_SYSTEM:
+            pressed = report->usage != 0;
+            break;
+        default:
+            return;
+    }
+
+    uint32_t delay_us = pressed ? task->timing.hold_us : task->timing.gap_us;
+    if ((report->flags & HID_REPORT_FLAG_SETTLE) && delay_us < HID_LAYOUT_SWITCH_DELAY_US) {
+        delay_us = HID_LAYOUT_SWITCH_DELAY_US;
+    }
+    task->ready_us[report->type] = now + delay_us;
+}
+
+/**
+ * @brief Разбудить задачу таймером
+ * Wake the task with the timer
+ */
+static void arm_timer(struct hid_task* task, int64_t delay_us) {
+    esp_timer_stop(task->timer);
+    esp_timer_start_once(task->timer, delay_us > 0 ? delay_us : 1);
+}
+
+/**
+ * @brief Начать пробу: нажатия Caps Lock с заданным профилем
+ * Start a probe: Caps Lock taps with the given profile
+ */
+static void autotune_probe(struct hid_task* task, const hid_timing_profile_t* timing, uint16_t taps) {
+    task->timing = *timing;
+    atomic_store_explicit(&task->led_toggles, 0, memory_order_relaxed);
+
+    task->binding = &caps_tap_binding;
+    task->command = (hid_command_t){0};
+    task->repeat_left = taps;
+    task->report_index = 0;
+    task->autotune.state = AUTOTUNE_PROBING;
+}
+
+/**
+ * @brief Оценить пробу и выбрать следующую
+ * Evaluate a probe and choose the next one
+ *
+ * Сначала проверяется самая надежная ступень: если и она теряет переключения,
+ * хост не возвращает светодиоды, и профиль остается прежним. Затем ступени
+ * проверяются от быстрой, и берется первая без потерь.
+ * The safest step is checked first: if even it loses toggles, the host doesn't
+ * echo the LEDs and the profile stays as it was. Then steps are checked from
+ * the fastest, and the first lossless one is taken.
+ */
+static void autotune_evaluate(struct hid_task* task) {
+    unsigned toggles = atomic_exchange_explicit(&task->led_toggles, 0, memory_order_relaxed);
+    bool connected = hid_is_connected(task->device);
+
+    if (!task->autotune.fixing) {
+        bool passed = connected && toggles == HID_AUTOTUNE_TAPS;
+
+        if (!task->autotune.verified) {
+            if (passed) {
+                task->autotune.verified = true;
+                task->autotune.step = 0;
+            } else {
+                ESP_LOGW(TAG, "Auto-tune: host echoed %u of %d Caps Lock toggles, keeping timing",
+                         toggles, HID_AUTOTUNE_TAPS);
+                task->autotune.result = task->autotune.saved;
+                task->autotune.finished = true;
+            }
+        } else if (passed || ++task->autotune.step == AUTOTUNE_SAFEST) {
+            task->autotune.result = autotune_ladder[task->autotune.step];
+            task->autotune.finished = true;
+        }
+
+        // Caps Lock остался переключен - еще одно нажатие / Caps Lock was left toggled - one more tap
+        if ((toggles & 1) && connected) {
+            task->autotune.fixing = true;
+            autotune_probe(task, &autotune_ladder[AUTOTUNE_SAFEST], 1);
+            return;
+        }
+    }
+    task->autotune.fixing = false;
+
+    if (task->autotune.finished) {
+        task->timing = task->autotune.result;
+        task->autotune.state = AUTOTUNE_IDLE;
+        ESP_LOGI(TAG, "Auto-tune done: hold %u us, gap %u us",
+                 (unsigned)task->timing.hold_us, (unsigned)task->timing.gap_us);
+        return;
+    }
+
+    autotune_probe(task, &autotune_ladder[task->autotune.step], HID_AUTOTUNE_TAPS);
+}
+
+/**
+ * @brief Шаг автоподбора, когда буфер пуст
+ * Auto-tune step once staging is empty
+ *
+ * @return Срок следующего шага (0 - сразу) / Deadline of the next step (0 - now)
+ */
+static int64_t autotune_run(struct hid_task* task, int64_t now) {
+    switch (task->autotune.state) {
+        case AUTOTUNE_PENDING:
+            // Первое ожидание - как проба без оценки: хост успевает прислать текущие светодиоды
+            // The first wait acts as an unscored probe: the host gets to send its current LEDs
+            task->autotune.saved = task->timing;
+            task->autotune.step = AUTOTUNE_SAFEST;
+            task->autotune.verified = false;
+            task->autotune.finished = false;
+            task->autotune.fixing = true;
+            task->autotune.settle_us = now + HID_AUTOTUNE_SETTLE_MS * 1000LL;
+            task->autotune.state = AUTOTUNE_SETTLING;
+            ESP_LOGI(TAG, "Auto-tune started");
+            return task->autotune.settle_us;
+
+        case AUTOTUNE_PROBING:
+            // Все нажатия отправлены / All taps are sent
+            task->autotune.settle_us = now + HID_AUTOTUNE_SETTLE_MS * 1000LL;
+            task->autotune.state = AUTOTUNE_SETTLING;
+            return task->autotune.settle_us;
+
+        case AUTOTUNE_SETTLING:
+            if (now < task->autotune.settle_us) {
+                return task->autotune.settle_us;
+            }
+            autotune_evaluate(task);
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Callback событий HID устройства
+ * HID device event callback
+ */
+static void device_event_callback(hid_event_t event, uint8_t value, void* user_data) {
+    struct hid_task* task = (struct hid_task*)user_data;
+
+    switch (event) {
+        case HID_EVENT_REPORT_COMPLETE:
+            if (task->task) {
+                xTaskNotify(task->task, HID_TASK_NOTIFY_COMPLETE, eSetBits);
+            }
+            break;
+
+        case HID_EVENT_KEYBOARD_LEDS:
+            if ((value ^ task->leds) & HID_LED_CAPS_LOCK) {
+                atomic_fetch_add_explicit(&task->led_toggles, 1, memory_order_relaxed);
+            }
+            task->leds = value;
+#if HID_LAYOUT_LED
+            atomic_store_explicit(&task->led_layout, (value & HID_LAYOUT_LED) ? TEXT_LAYOUT_RU : TEXT_LAYOUT_US,
+                                  memory_order_relaxed);
+#endif
+            break;
+
+        case HID_EVENT_CONNECTED:
+#if HID_AUTOTUNE_ON_CONNECT
+            hid_task_autotune(task);
+#endif
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void timer_callback(void* arg) {
+    struct hid_task* task = (struct hid_task*)arg;
+
+    if (task->task) {
+        xTaskNotify(task->task, HID_TASK_NOTIFY_TIMER, eSetBits);
+    }
+}
+
+/**
+ * @brief Задача вывода HID
+ * HID output task
+ *
+ * Следующий отчет уходит по завершении предыдущего, но не раньше срока из
+ * профиля времени; до срока задачу будит таймер. Пока передача идет, новые
+ * движения сливаются в буфере.
+ * The next report goes out once the previous one completes, but not before
+ * the timing profile's deadline; the timer wakes the task when it is due.
+ * While a transfer is in flight new moves merge in staging.
+ */
+static void hid_task_impl(void* arg) {
+    struct hid_task* task = (struct hid_task*)arg;
+
+    for (;;) {
+        fill_staging(task);
+
+        int64_t now = esp_timer_get_time();
+        int64_t motion_us = motion_frame(task, now);
+        int64_t wake_us = 0;
+
+        if (task->staging_count > 0 && !task->in_flight) {
+            const hid_report_t* report = &task->staging[task->staging_head];
+
+            if (report->type < HID_REPORT_TYPE_COUNT && now < task->ready_us[report->type]) {
+                // Рано - ждем таймер / Too early - wait for the timer
+                wake_us = task->ready_us[report->type];
+            } else {
+                esp_err_t ret = send_report(task, report);
+
+                if (ret == ESP_ERR_NOT_FINISHED) {
+                    // Эндпоинт занят - отчет остается первым / Endpoint busy - the report stays first
+                    task->in_flight = true;
+                } else {
+                    if (ret == ESP_OK) {
+                        task->stats.reports_sent++;
+                        task->in_flight = true;
+                        schedule_next(task, report, now);
+                    } else {
+                        task->stats.send_errors++;
+                    }
+                    task->staging_head = (task->staging_head + 1) % HID_TASK_STAGING_LENGTH;
+                    task->staging_count--;
+                    continue;
+                }
+            }
+        } else if (task->staging_count == 0 && !task->in_flight && task->autotune.state != AUTOTUNE_IDLE) {
+            wake_us = autotune_run(task, now);
+            if (wake_us == 0) {
+                continue;
+            }
+        }
+
+        bool busy = task->staging_count > 0 || task->in_flight || task->motion.active ||
+                    task->autotune.state != AUTOTUNE_IDLE;
+        if (busy != task->busy) {
+            task->busy = busy;
+            if (task->activity_callback) {
+                task->activity_callback(busy, task->activity_user_data);
+            }
+        }
+
+        if (motion_us > 0 && (wake_us == 0 || motion_us < wake_us)) {
+            wake_us = motion_us;
+        }
+        if (wake_us > 0) {
+            arm_timer(task, wake_us - now);
+        }
+
+        uint32_t events = 0;
+        TickType_t timeout = task->in_flight ? pdMS_TO_TICKS(HID_TASK_COMPLETE_TIMEOUT_MS) : portMAX_DELAY;
+        if (xTaskNotifyWait(0, UINT32_MAX, &events, timeout) != pdTRUE || (events & HID_TASK_NOTIFY_COMPLETE)) {
+            // Завершение или хост перестал опрашивать / Completion, or the host stopped polling
+            task->in_flight = false;
+        }
+    }
+}
+
+esp_err_t hid_task_init(hid_task_handle_t* handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = calloc(1, sizeof(struct hid_task));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for HID task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (unsigned i = 0; i < HID_TASK_QUEUE_LENGTH; i++) {
+        atomic_init(&(*handle)->slots[i].sequence, i);
+    }
+    atomic_init(&(*handle)->enqueue_pos, 0);
+    atomic_init(&(*handle)->led_toggles, 0);
+    atomic_init(&(*handle)->led_layout, -1);
+    (*handle)->layout = HID_HOST_LAYOUT;
+    (*handle)->timing = (hid_timing_profile_t){.hold_us = HID_TASK_HOLD_US, .gap_us = HID_TASK_GAP_US};
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_callback,
+        .arg = *handle,
+        .name = "hid_schedule",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &(*handle)->timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create HID timer: %s", esp_err_to_name(ret));
+        free(*handle);
+        *handle = NULL;
+        return ret;
+    }
+
+    ret = hid_init(&(*handle)->device, &HID_TRANSPORT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize HID device: %s", esp_err_to_name(ret));
+        esp_timer_delete((*handle)->timer);
+        free(*handle);
+        *handle = NULL;
+        return ret;
+    }
+
+    hid_set_event_callback((*handle)->device, device_event_callback, *handle);
+
+    ESP_LOGI(TAG, "HID task initialized (queue %d, staging %d, hold %d us, gap %d us)",
+             HID_TASK_QUEUE_LENGTH, HID_TASK_STAGING_LENGTH, HID_TASK_HOLD_US, HID_TASK_GAP_US);
+    return ESP_OK;
+}
+
+esp_err_t hid_task_deinit(hid_task_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (handle->task) {
+        vTaskDelete(handle->task);
+    }
+    hid_deinit(handle->device);
+
+    // Тексты, оставшиеся в очереди / Texts left in the queue
+    hid_item_t item;
+    while (queue_pop(handle, &item)) {
+        if (item.kind == HID_ITEM_TEXT) {
+            free(item.text.data);
+        }
+    }
+    free(handle->text);
+    esp_timer_stop(handle->timer);
+    esp_timer_delete(handle->timer);
+    free(handle);
+
+    ESP_LOGI(TAG, "HID task deinitialized");
+    return ESP_OK;
+}
+
+esp_err_t hid_task_start(hid_task_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xTaskCreatePinnedToCore(hid_task_impl, "hid_task", HID_TASK_STACK_SIZE, handle,
+                                HID_TASK_PRIORITY, &handle->task, IO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create HID task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hid_task_send_command(hid_task_handle_t handle, const hid_command_t* command) {
+    if (!handle || !command) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_item_t item = {.kind = HID_ITEM_COMMAND, .command = *command};
+    return push_item(handle, &item);
+}
+
+esp_err_t hid_task_send_commands(hid_task_handle_t handle, const hid_command_t* commands, size_t count) {
+    if (!handle || (!commands && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        esp_err_t ret = hid_task_send_command(handle, &commands[i]);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hid_task_send_report(hid_task_handle_t handle, const hid_report_t* report) {
+    if (!handle || !report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_item_t item = {.kind = HID_ITEM_REPORT, .report = *report};
+    return push_item(handle, &item);
+}
+
+esp_err_t hid_task_send_text(hid_task_handle_t handle, const char* text, size_t length) {
+    if (!handle || !text) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (length == 0) {
+        return ESP_OK;
+    }
+    if (length > UINT16_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char* copy = malloc(length);
+    if (!copy) {
+        ESP_LOGE(TAG, "Failed to allocate memory for text");
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, text, length);
+
+    hid_item_t item = {.kind = HID_ITEM_TEXT, .text = {.data = copy, .length = length}};
+    esp_err_t ret = push_item(handle, &item);
+    if (ret != ESP_OK) {
+        free(copy);
+    }
+    return ret;
+}
+
+esp_err_t hid_task_set_layout(hid_task_handle_t handle, text_layout_t layout) {
+    if (!handle || layout >= TEXT_LAYOUT_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_item_t item = {.kind = HID_ITEM_LAYOUT, .layout = layout};
+    return push_item(handle, &item);
+}
+
+esp_err_t hid_task_set_timing(hid_task_handle_t handle, const hid_timing_profile_t* timing) {
+    if (!handle || !timing) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_item_t item = {.kind = HID_ITEM_TIMING, .timing = *timing};
+    return push_item(handle, &item);
+}
+
+esp_err_t hid_task_get_timing(hid_task_handle_t handle, hid_timing_profile_t* timing) {
+    if (!handle || !timing) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *timing = handle->timing;
+    return ESP_OK;
+}
+
+esp_err_t hid_task_autotune(hid_task_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_item_t item = {.kind = HID_ITEM_AUTOTUNE};
+    return push_item(handle, &item);
+}
+
+esp_err_t hid_task_set_activity_callback(hid_task_handle_t handle,
+                                         hid_task_activity_callback_t callback, void* user_data) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->activity_callback = callback;
+    handle->activity_user_data = user_data;
+    return ESP_OK;
+}
+
+bool hid_task_is_connected(hid_task_handle_t handle) {
+    if (!handle) {
+        return false;
+    }
+
+    return hid_is_connected(handle->device);
+}
+
+esp_err_t hid_task_get_stats(hid_task_handle_t handle, hid_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = handle->stats;
+    return ESP_OK;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file hid_task.h
+ * @brief HID output task header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл задачи вывода HID
+ * Header file for the HID output task
+ *
+ * Команды и отчеты ставятся в очередь без блокировок и без ожидания USB;
+ * задача разворачивает привязки в отчеты, сливает совместимые (подряд идущие
+ * движения мыши складываются) и отправляет их с интервалом опроса.
+ * Commands and reports are queued lock-free without waiting on USB; the task
+ * expands bindings into reports, merges compatible ones (consecutive mouse
+ * moves are summed) and sends them at the polling interval.
+ *
+ * Нажатия и отпускания выдаются по таймеру высокого разрешения с профилем
+ * времени хоста (минимальное удержание и пауза между клавишами); задача ничего
+ * не ждет через vTaskDelay. Автоподбор находит самый быстрый профиль, при
+ * котором хост не теряет нажатия: он стучит Caps Lock и считает переключения
+ * светодиода, которые хост присылает обратно.
+ * Presses and releases are emitted on a high-resolution timer with the host's
+ * timing profile (minimum hold and inter-key gap); the task never waits in
+ * vTaskDelay. Auto-tune finds the fastest profile at which the host drops no
+ * keys: it taps Caps Lock and counts the LED toggles the host echoes back.
+ */
+
+#ifndef HID_TASK_H
+#define HID_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "config/hid_bindings.h"
+#include "config/text_transcoder.h"
+
+// Дескриптор HID задачи / HID task handle
+typedef struct hid_task* hid_task_handle_t;
+
+// Статистика HID задачи / HID task statistics
+typedef struct {
+    uint32_t commands_processed;  // Команд выполнено / Commands processed
+    uint32_t keyboard_commands;   // Команд клавиатуры / Keyboard commands
+    uint32_t mouse_commands;      // Команд мыши / Mouse commands
+    uint32_t media_commands;      // Медиа команд / Media commands
+    uint32_t system_commands;     // Системных команд / System commands
+    uint32_t reports_sent;        // Отчетов отправлено / Reports sent
+    uint32_t reports_coalesced;   // Отчетов слито / Reports coalesced
+    uint32_t queue_overflows;     // Отклонено при полной очереди / Rejected on a full queue
+    uint32_t send_errors;         // Ошибок отправки / Send errors
+    uint32_t characters_typed;    // Напечатано символов / Characters typed
+    uint32_t characters_unmapped; // Символов вне раскладки / Characters outside the layout
+    uint32_t layout_switches;     // Переключений раскладки / Layout switches
+    uint32_t motions;             // Плавных движений мыши / Smooth mouse motions
+} hid_stats_t;
+
+// Профиль времени хоста / Host timing profile
+typedef struct {
+    uint32_t hold_us;             // Минимальное удержание нажатия / Minimum press hold
+    uint32_t gap_us;              // Минимальная пауза после отпускания / Minimum gap after a release
+} hid_timing_profile_t;
+
+// Готовые профили / Preset profiles
+#define HID_TIMING_PROFILE_FAST     ((hid_timing_profile_t){.hold_us = 1000, .gap_us = 1000})
+#define HID_TIMING_PROFILE_DEFAULT  ((hid_timing_profile_t){.hold_us = 4000, .gap_us = 2000})
+#define HID_TIMING_PROFILE_SAFE     ((hid_timing_profile_t){.hold_us = 20000, .gap_us = 10000})
+
+/**
+ * @brief Инициализация HID задачи
+ * Initialize HID task
+ */
+esp_err_t hid_task_init(hid_task_handle_t* handle);
+
+/**
+ * @brief Деинициализация HID задачи
+ * Deinitialize HID task
+ */
+esp_err_t hid_task_deinit(hid_task_handle_t handle);
+
+/**
+ * @brief Запустить HID задачу
+ * Start HID task
+ */
+esp_err_t hid_task_start(hid_task_handle_t handle);
+
+/**
+ * @brief Поставить команду в очередь (не блокирует)
+ * Queue a command (non-blocking)
+ *
+ * Можно вызывать из нескольких задач одновременно.
+ * Safe to call from several tasks at once.
+ *
+ * @return ESP_ERR_NO_MEM если очередь полна / ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t hid_task_send_command(hid_task_handle_t handle, const hid_command_t* command);
+
+/**
+ * @brief Поставить пакет команд в очередь (не блокирует)
+ * Queue a batch of commands (non-blocking)
+ *
+ * При переполнении оставшиеся команды отбрасываются.
+ * On overflow the remaining commands are dropped.
+ */
+esp_err_t hid_task_send_commands(hid_task_handle_t handle, const hid_command_t* commands, size_t count);
+
+/**
+ * @brief Поставить готовый отчет в очередь (не блокирует)
+ * Queue a ready-made report (non-blocking)
+ */
+esp_err_t hid_task_send_report(hid_task_handle_t handle, const hid_report_t* report);
+
+/**
+ * @brief Поставить текст на печать (не блокирует)
+ * Queue text for typing (non-blocking)
+ *
+ * Текст копируется. Раскладки переключаются по плану с наименьшим числом
+ * отчетов; символы вне обеих раскладок пропускаются.
+ * The text is copied. Layouts are switched along the plan with the fewest
+ * reports; characters outside both layouts are skipped.
+ *
+ * @param length Длина текста в байтах / Text length in bytes
+ */
+esp_err_t hid_task_send_text(hid_task_handle_t handle, const char* text, size_t length);
+
+/**
+ * @brief Сообщить текущую раскладку хоста (не блокирует)
+ * Report the host's current layout (non-blocking)
+ *
+ * Нужно, если раскладку переключили на хосте вручную, а светодиод раскладки
+ * (HID_LAYOUT_LED) не настроен.
+ * Needed when the layout was switched on the host by hand and no layout LED
+ * (HID_LAYOUT_LED) is configured.
+ */
+esp_err_t hid_task_set_layout(hid_task_handle_t handle, text_layout_t layout);
+
+/**
+ * @brief Задать профиль времени (не блокирует)
+ * Set the timing profile (non-blocking)
+ *
+ * Ставится в очередь и действует с команд, поставленных после него.
+ * Queued, and applies from the commands queued after it.
+ */
+esp_err_t hid_task_set_timing(hid_task_handle_t handle, const hid_timing_profile_t* timing);
+
+/**
+ * @brief Получить текущий профиль времени
+ * Get the current timing profile
+ */
+esp_err_t hid_task_get_timing(hid_task_handle_t handle, hid_timing_profile_t* timing);
+
+/**
+ * @brief Подобрать профиль времени под хост (не блокирует)
+ * Tune the timing profile to the host (non-blocking)
+ *
+ * Начинается, когда отправлено все поставленное раньше; пока идет подбор,
+ * очередь не разбирается. Если хост не возвращает светодиоды, профиль не
+ * меняется.
+ * Starts once everything queued before it is sent; while tuning, the queue is
+ * held. If the host doesn't echo the LEDs, the profile is left unchanged.
+ */
+esp_err_t hid_task_autotune(hid_task_handle_t handle);
+
+/**
+ * @brief Callback активности вывода
+ * Output activity callback
+ *
+ * Вызывается из задачи HID, когда вывод начинается и когда хост забрал последний
+ * отчет, а очередь, буфер отчетов и движение мыши пусты.
+ * Called from the HID task when output starts and when the host took the last
+ * report with the queue, staging and mouse motion all empty.
+ */
+typedef void (*hid_task_activity_callback_t)(bool busy, void* user_data);
+
+/**
+ * @brief Установить callback активности (до hid_task_start)
+ * Set the activity callback (before hid_task_start)
+ */
+esp_err_t hid_task_set_activity_callback(hid_task_handle_t handle,
+                                         hid_task_activity_callback_t callback, void* user_data);
+
+/**
+ * @brief Проверить подключение HID
+ * Check HID connection
+ */
+bool hid_task_is_connected(hid_task_handle_t handle);
+
+/**
+ * @brief Получить статистику HID задачи
+ * Get HID task statistics
+ */
+esp_err_t hid_task_get_stats(hid_task_handle_t handle, hid_stats_t* stats);
+
+#endif // HID_TASK_H
@@ -0,0 +1,446 @@
+/**
+ * @file system_state.c
+ * @brief System state machine implementation
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Реализация конечного автомата системы
+ * Implementation of the system state machine
+ */
+
+#include "system_state.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config/config.h"
+#include "config/gpio_config.h"
+#include "config/i2s_config.h"
+
+static const char* TAG = "SYSTEM_STATE";
+
+// Сообщение очереди событий / Event queue message
+typedef struct {
+    uint8_t event;               // system_event_t
+    int64_t posted_us;           // Время события / Event time
+} system_event_msg_t;
+
+struct system_state {
+    system_state_config_t config;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+
+    // Читается из других задач / Read from other tasks
+    atomic_int state;            // system_state_t
+    atomic_bool capturing;
+    _Atomic(TaskHandle_t) capture_task;
+    atomic_uint dropped;         // Также из прерывания / Also from an interrupt
+
+    // Только задача автомата / State machine task only
+    int64_t deadline_us;         // Срок текущего состояния (0 - нет) / Current state deadline (0 - none)
+    bool output_busy;            // HID выводит / HID is outputting
+
+    // Журнал и статистика (под блокировкой) / Trace and statistics (lock held)
+    SemaphoreHandle_t lock;
+    int64_t entered_us;          // Вход в текущее состояние / Entry into the current state
+    system_transition_t trace[SYSTEM_TRACE_LENGTH];
+    uint32_t trace_count;        // Всего записано / Total written
+    system_state_stats_t stats;
+};
+
+static const char* const state_names[SYSTEM_STATE_COUNT] = {
+    [SYSTEM_STATE_IDLE] = "IDLE",
+    [SYSTEM_STATE_PRE_ROLL] = "PRE_ROLL",
+    [SYSTEM_STATE_RECORDING] = "RECORDING",
+    [SYSTEM_STATE_UPLOADING] = "UPLOADING",
+    [SYSTEM_STATE_TYPING] = "TYPING",
+    [SYSTEM_STATE_ERROR] = "ERROR",
+};
+
+static const char* const event_names[SYSTEM_EVENT_COUNT] = {
+    [SYSTEM_EVENT_BUTTON_DOWN] = "BUTTON_DOWN",
+    [SYSTEM_EVENT_BUTTON_UP] = "BUTTON_UP",
+    [SYSTEM_EVENT_SPEECH_START] = "SPEECH_START",
+    [SYSTEM_EVENT_SPEECH_END] = "SPEECH_END",
+    [SYSTEM_EVENT_RESULT] = "RESULT",
+    [SYSTEM_EVENT_OUTPUT_BUSY] = "OUTPUT_BUSY",
+    [SYSTEM_EVENT_OUTPUT_IDLE] = "OUTPUT_IDLE",
+    [SYSTEM_EVENT_ERROR] = "ERROR",
+    [SYSTEM_EVENT_TIMEOUT] = "TIMEOUT",
+};
+
+static bool is_capture_state(system_state_t state) {
+    return state == SYSTEM_STATE_PRE_ROLL || state == SYSTEM_STATE_RECORDING;
+}
+
+/**
+ * @brief Таблица переходов
+ * Transition table
+ *
+ * @return Новое состояние (то же - события нет в таблице) / New state (the same - the event isn't in the table)
+ */
+static system_state_t next_state(const struct system_state* sm, system_state_t state, system_event_t event) {
+    switch (event) {
+        case SYSTEM_EVENT_BUTTON_DOWN:
+            // Новое удержание не ждет прошлое высказывание / A new hold doesn't wait for the previous utterance
+            return is_capture_state(state) ? state : SYSTEM_STATE_PRE_ROLL;
+
+        case SYSTEM_EVENT_BUTTON_UP:
+            return is_capture_state(state) ? SYSTEM_STATE_UPLOADING : state;
+
+        case SYSTEM_EVENT_SPEECH_START:
+            return state == SYSTEM_STATE_PRE_ROLL ? SYSTEM_STATE_RECORDING : state;
+
+        case SYSTEM_EVENT_RESULT:
+            return state == SYSTEM_STATE_UPLOADING || state == SYSTEM_STATE_IDLE ? SYSTEM_STATE_TYPING : state;
+
+        case SYSTEM_EVENT_OUTPUT_BUSY:
+            // Запоздалый результат из офлайн-очереди / A late result from the offline spool
+            return state == SYSTEM_STATE_IDLE ? SYSTEM_STATE_TYPING : state;
+
+        case SYSTEM_EVENT_OUTPUT_IDLE:
+            return state == SYSTEM_STATE_TYPING ? SYSTEM_STATE_IDLE : state;
+
+        case SYSTEM_EVENT_ERROR:
+            return is_capture_state(state) ? SYSTEM_STATE_ERROR : state;
+
+        case SYSTEM_EVENT_TIMEOUT:
+            return sm->deadline_us ? SYSTEM_STATE_IDLE : state;
+
+        default:
+            // Конец речи внутри удержания только закрывает сегмент / Speech end within a hold only closes a segment
+            return state;
+    }
+}
+
+/**
+ * @brief Начать захват: распознаватель, I2S, светодиод, прогрев соединения
+ * Start capture: recognizer, I2S, LED, connection prewarm
+ */
+static esp_err_t start_capture(struct system_state* sm, int64_t pressed_us) {
+    esp_err_t ret = speech_recognizer_start(sm->config.recognizer, pressed_us);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start recognizer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = i2s_enable();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable I2S: %s", esp_err_to_name(ret));
+        speech_recognizer_stop(sm->config.recognizer, pressed_us);
+        return ret;
+    }
+
+    atomic_store(&sm->capturing, true);
+    TaskHandle_t capture_task = atomic_load(&sm->capture_task);
+    if (capture_task) {
+        xTaskNotifyGive(capture_task);
+    }
+    set_led_state(true);
+
+    // Открыть соединение пока пользователь говорит / Open the connection while the user speaks
+    if (sm->config.connection_pool) {
+        stt_connection_pool_prewarm(sm->config.connection_pool);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Остановить захват и отправить последний сегмент
+ * Stop capture and submit the last segment
+ */
+static void stop_capture(struct system_state* sm, int64_t released_us) {
+    atomic_store(&sm->capturing, false);
+    set_led_state(false);
+    i2s_disable();
+    speech_recognizer_stop(sm->config.recognizer, released_us);
+}
+
+/**
+ * @brief Срок нового состояния
+ * Deadline of the new state
+ */
+static int64_t state_deadline(const struct system_state* sm, system_state_t state, int64_t now) {
+    switch (state) {
+        case SYSTEM_STATE_UPLOADING:
+            // Сегменты без речи не отправляются - результата не будет / Silent segments aren't sent - no result comes
+            return now + SYSTEM_UPLOAD_TIMEOUT_MS * 1000LL;
+        case SYSTEM_STATE_TYPING:
+            // Результат мог не дать вывода (пустой текст) / The result may have produced no output (empty text)
+            return sm->output_busy ? 0 : now + SYSTEM_TYPING_GRACE_MS * 1000LL;
+        case SYSTEM_STATE_ERROR:
+            return now + SYSTEM_ERROR_HOLD_MS * 1000LL;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Сменить состояние и записать переход в журнал и статистику
+ * Change the state and record the transition in the trace and statistics
+ */
+static void record_transition(struct system_state* sm, const system_transition_t* transition) {
+    xSemaphoreTake(sm->lock, portMAX_DELAY);
+    sm->entered_us = transition->time_us;
+    atomic_store(&sm->state, transition->to);
+    sm->trace[sm->trace_count % SYSTEM_TRACE_LENGTH] = *transition;
+    sm->trace_count++;
+    sm->stats.transitions++;
+    sm->stats.entered[transition->to]++;
+    sm->stats.time_us[transition->from] += transition->duration_us;
+    xSemaphoreGive(sm->lock);
+
+    ESP_LOGI(TAG, "%s -> %s on %s (%u ms in %s, latency %u us)",
+             state_names[transition->from], state_names[transition->to], event_names[transition->event],
+             (unsigned)(transition->duration_us / 1000), state_names[transition->from],
+             (unsigned)transition->latency_us);
+}
+
+/**
+ * @brief Обработать событие: переход и его действия
+ * Handle an event: the transition and its actions
+ */
+static void handle_event(struct system_state* sm, const system_event_msg_t* msg) {
+    system_state_t state = (system_state_t)atomic_load(&sm->state);
+    system_event_t event = (system_event_t)msg->event;
+    int64_t now = esp_timer_get_time();
+    uint32_t latency = (uint32_t)(now - msg->posted_us);
+
+    if (event == SYSTEM_EVENT_OUTPUT_BUSY || event == SYSTEM_EVENT_OUTPUT_IDLE) {
+        sm->output_busy = event == SYSTEM_EVENT_OUTPUT_BUSY;
+        if (state == SYSTEM_STATE_TYPING && sm->output_busy) {
+            // Вывод пошел - ждем его конца без срока / Output started - wait for its end without a deadline
+            sm->deadline_us = 0;
+        }
+    }
+
+    system_state_t next = next_state(sm, state, event);
+
+    // Действия перехода / Transition actions
+    if (is_capture_state(state) && !is_capture_state(next)) {
+        stop_capture(sm, msg->posted_us);
+    } else if (!is_capture_state(state) && next == SYSTEM_STATE_PRE_ROLL) {
+        if (start_capture(sm, msg->posted_us) != ESP_OK) {
+            next = SYSTEM_STATE_ERROR;
+        }
+    }
+
+    xSemaphoreTake(sm->lock, portMAX_DELAY);
+    sm->stats.events++;
+    if (latency > sm->stats.max_latency_us) {
+        sm->stats.max_latency_us = latency;
+    }
+    if (next == state) {
+        sm->stats.ignored++;
+    } else if (event == SYSTEM_EVENT_TIMEOUT) {
+        sm->stats.timeouts++;
+    }
+    xSemaphoreGive(sm->lock);
+
+    if (next == state) {
+        return;
+    }
+
+    system_transition_t transition = {
+        .time_us = now,
+        .latency_us = latency,
+        .duration_us = (uint32_t)(now - sm->entered_us),
+        .from = state,
+        .to = next,
+        .event = event,
+    };
+    sm->deadline_us = state_deadline(sm, next, now);
+    record_transition(sm, &transition);
+}
+
+/**
+ * @brief Задача автомата
+ * State machine task
+ */
+static void system_state_task(void* arg) {
+    struct system_state* sm = (struct system_state*)arg;
+    system_event_msg_t msg;
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (sm->deadline_us) {
+            int64_t left_us = sm->deadline_us - esp_timer_get_time();
+            wait = left_us > 0 ? pdMS_TO_TICKS((left_us + 999) / 1000) + 1 : 0;
+        }
+
+        if (xQueueReceive(sm->queue, &msg, wait) != pdTRUE) {
+            if (!sm->deadline_us || esp_timer_get_time() < sm->deadline_us) {
+                continue;
+            }
+            msg.event = SYSTEM_EVENT_TIMEOUT;
+            msg.posted_us = sm->deadline_us;
+        }
+        handle_event(sm, &msg);
+    }
+}
+
+/**
+ * @brief Callback VAD распознавателя (задача аудио)
+ * Recognizer VAD callback (audio task)
+ */
+static void vad_callback(bool is_speaking, void* user_data) {
+    system_state_post((system_state_handle_t)user_data,
+                      is_speaking ? SYSTEM_EVENT_SPEECH_START : SYSTEM_EVENT_SPEECH_END);
+}
+
+esp_err_t system_state_init(system_state_handle_t* handle, const system_state_config_t* config) {
+    if (!handle || !config || !config->recognizer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Выделение памяти / Allocate memory
+    *handle = calloc(1, sizeof(struct system_state));
+    if (!*handle) {
+        ESP_LOGE(TAG, "Failed to allocate memory for state machine");
+        return ESP_ERR_NO_MEM;
+    }
+
+    (*handle)->config = *config;
+    atomic_init(&(*handle)->state, SYSTEM_STATE_IDLE);
+    atomic_init(&(*handle)->capturing, false);
+    atomic_init(&(*handle)->capture_task, NULL);
+    atomic_init(&(*handle)->dropped, 0);
+    (*handle)->entered_us = esp_timer_get_time();
+
+    (*handle)->lock = xSemaphoreCreateMutex();
+    (*handle)->queue = xQueueCreate(SYSTEM_EVENT_QUEUE_LENGTH, sizeof(system_event_msg_t));
+    if (!(*handle)->lock || !(*handle)->queue) {
+        ESP_LOGE(TAG, "Failed to create state machine queue");
+        if ((*handle)->lock) vSemaphoreDelete((*handle)->lock);
+        if ((*handle)->queue) vQueueDelete((*handle)->queue);
+        free(*handle);
+        *handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Остановка копирует сегмент из буфера захвата - ядро захвата
+    // Stopping copies the segment out of the capture buffer - the capture core
+    if (xTaskCreatePinnedToCore(system_state_task, "system_state", SYSTEM_TASK_STACK_SIZE, *handle,
+                                SYSTEM_TASK_PRIORITY, &(*handle)->task, AUDIO_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create state machine task");
+        vQueueDelete((*handle)->queue);
+        vSemaphoreDelete((*handle)->lock);
+        free(*handle);
+        *handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    speech_recognizer_set_vad_callback(config->recognizer, vad_callback, *handle);
+
+    ESP_LOGI(TAG, "State machine initialized (queue %d, trace %d)", SYSTEM_EVENT_QUEUE_LENGTH, SYSTEM_TRACE_LENGTH);
+    return ESP_OK;
+}
+
+esp_err_t system_state_deinit(system_state_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    speech_recognizer_set_vad_callback(handle->config.recognizer, NULL, NULL);
+    if (handle->task) {
+        vTaskDelete(handle->task);
+    }
+    if (is_capture_state((system_state_t)atomic_load(&handle->state))) {
+        stop_capture(handle, esp_timer_get_time());
+    }
+
+    vQueueDelete(handle->queue);
+    vSemaphoreDelete(handle->lock);
+    free(handle);
+
+    ESP_LOGI(TAG, "State machine deinitialized");
+    return ESP_OK;
+}
+
+esp_err_t system_state_post(system_state_handle_t handle, system_event_t event) {
+    return system_state_post_at(handle, event, esp_timer_get_time());
+}
+
+esp_err_t system_state_post_at(system_state_handle_t handle, system_event_t event, int64_t time_us) {
+    if (!handle || event >= SYSTEM_EVENT_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    system_event_msg_t msg = {.event = event, .posted_us = time_us};
+    if (xQueueSend(handle->queue, &msg, 0) != pdTRUE) {
+        atomic_fetch_add_explicit(&handle->dropped, 1, memory_order_relaxed);
+        ESP_LOGW(TAG, "Event queue full, %s dropped", event_names[event]);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+system_state_t system_state_get(system_state_handle_t handle) {
+    if (!handle) {
+        return SYSTEM_STATE_IDLE;
+    }
+
+    return (system_state_t)atomic_load(&handle->state);
+}
+
+bool system_state_is_capturing(system_state_handle_t handle) {
+    return handle && atomic_load(&handle->capturing);
+}
+
+void system_state_wait_capture(system_state_handle_t handle) {
+    // Сначала задача, потом флаг: уведомление не теряется / The task first, then the flag: no notification is lost
+    atomic_store(&handle->capture_task, xTaskGetCurrentTaskHandle());
+    while (!atomic_load(&handle->capturing)) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+const char* system_state_name(system_state_t state) {
+    return state < SYSTEM_STATE_COUNT ? state_names[state] : "UNKNOWN";
+}
+
+const char* system_event_name(system_event_t event) {
+    return event < SYSTEM_EVENT_COUNT ? event_names[event] : "UNKNOWN";
+}
+
+esp_err_t system_state_get_trace(system_state_handle_t handle, system_transition_t* trace,
+                                 size_t max_entries, size_t* count) {
+    if (!handle || !trace || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    uint32_t available = handle->trace_count < SYSTEM_TRACE_LENGTH ? handle->trace_count : SYSTEM_TRACE_LENGTH;
+    size_t copied = available < max_entries ? available : max_entries;
+
+    // Последние copied записей / The last copied entries
+    uint32_t first = handle->trace_count - copied;
+    for (size_t i = 0; i < copied; i++) {
+        trace[i] = handle->trace[(first + i) % SYSTEM_TRACE_LENGTH];
+    }
+    xSemaphoreGive(handle->lock);
+
+    *count = copied;
+    return ESP_OK;
+}
+
+esp_err_t system_state_get_stats(system_state_handle_t handle, system_state_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    *stats = handle->stats;
+    system_state_t state = (system_state_t)atomic_load(&handle->state);
+    int64_t entered_us = handle->entered_us;
+    xSemaphoreGive(handle->lock);
+
+    stats->time_us[state] += esp_timer_get_time() - entered_us;
+    stats->dropped = atomic_load_explicit(&handle->dropped, memory_order_relaxed);
+    return ESP_OK;
+}
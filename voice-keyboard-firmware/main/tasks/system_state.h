@@ -0,0 +1,185 @@
+/**
+ * @file system_state.h
+ * @brief System state machine header
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Заголовочный файл конечного автомата системы
+ * Header file for the system state machine
+ *
+ * Одна задача владеет состоянием устройства и меняет его только по событиям из
+ * очереди: кнопка, начало и конец речи (VAD), результат распознавания,
+ * активность HID, ошибки и таймауты. Побочные действия (запуск распознавателя,
+ * I2S, светодиод, прогрев соединения) выполняются в этой же задаче при
+ * переходе, так что между этапами нет гонок и опроса. Состояние читается
+ * атомарно из любой задачи; каждый переход попадает в кольцевой журнал со
+ * временем, задержкой события и временем в прошлом состоянии.
+ * One task owns the device state and changes it only on events from its queue:
+ * the button, speech start and end (VAD), the recognition result, HID activity,
+ * errors and timeouts. Side effects (starting the recognizer, I2S, the LED,
+ * prewarming the connection) run in that same task on the transition, so there
+ * are no races and no polling between stages. The state is read atomically from
+ * any task; every transition goes to a ring trace with its time, the event's
+ * latency and the time spent in the previous state.
+ *
+ * IDLE -> PRE_ROLL (кнопка / button) -> RECORDING (речь / speech)
+ *      -> UPLOADING (отпускание / release) -> TYPING (результат / result) -> IDLE
+ */
+
+#ifndef SYSTEM_STATE_H
+#define SYSTEM_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "config/speech_recognition.h"
+#include "config/stt_connection.h"
+
+// Состояния системы / System states
+typedef enum {
+    SYSTEM_STATE_IDLE,           // Ожидание / Idle
+    SYSTEM_STATE_PRE_ROLL,       // Кнопка нажата, захват идет, речи еще нет / Button held, capturing, no speech yet
+    SYSTEM_STATE_RECORDING,      // В удержании была речь / Speech seen during the hold
+    SYSTEM_STATE_UPLOADING,      // Кнопка отпущена, ждем распознавание / Button released, waiting for recognition
+    SYSTEM_STATE_TYPING,         // Результат выводится через HID / The result is being output over HID
+    SYSTEM_STATE_ERROR,          // Захват сорвался / Capture failed
+    SYSTEM_STATE_COUNT
+} system_state_t;
+
+// События системы / System events
+typedef enum {
+    SYSTEM_EVENT_BUTTON_DOWN,
+    SYSTEM_EVENT_BUTTON_UP,
+    SYSTEM_EVENT_SPEECH_START,   // VAD: речь началась / VAD: speech started
+    SYSTEM_EVENT_SPEECH_END,     // VAD: речь кончилась / VAD: speech ended
+    SYSTEM_EVENT_RESULT,         // Финальный результат высказывания / Final utterance result
+    SYSTEM_EVENT_OUTPUT_BUSY,    // HID начал вывод / HID started output
+    SYSTEM_EVENT_OUTPUT_IDLE,    // HID все вывел / HID finished output
+    SYSTEM_EVENT_ERROR,          // Ошибка захвата / Capture error
+    SYSTEM_EVENT_TIMEOUT,        // Срок состояния истек (внутреннее) / State deadline passed (internal)
+    SYSTEM_EVENT_COUNT
+} system_event_t;
+
+// Запись журнала переходов / Transition trace entry
+typedef struct {
+    int64_t time_us;             // Время перехода / Transition time
+    uint32_t latency_us;         // От события до перехода / From the event to the transition
+    uint32_t duration_us;        // Время в прошлом состоянии / Time spent in the previous state
+    uint8_t from;                // system_state_t
+    uint8_t to;                  // system_state_t
+    uint8_t event;               // system_event_t
+} system_transition_t;
+
+// Статистика автомата / State machine statistics
+typedef struct {
+    uint32_t events;             // Событий обработано / Events handled
+    uint32_t transitions;        // Переходов / Transitions
+    uint32_t ignored;            // Событий без перехода / Events with no transition
+    uint32_t dropped;            // Отброшено при полной очереди / Dropped on a full queue
+    uint32_t timeouts;           // Выходов по сроку / Exits on a deadline
+    uint32_t max_latency_us;     // Худшая задержка события / Worst event latency
+    uint32_t entered[SYSTEM_STATE_COUNT];  // Входов в состояние / Entries into each state
+    uint64_t time_us[SYSTEM_STATE_COUNT];  // Время в состоянии / Time spent in each state
+} system_state_stats_t;
+
+// Конфигурация автомата / State machine configuration
+typedef struct {
+    speech_recognizer_handle_t recognizer;
+    stt_connection_pool_handle_t connection_pool;  // Может быть NULL / May be NULL
+} system_state_config_t;
+
+// Дескриптор автомата / State machine handle
+typedef struct system_state* system_state_handle_t;
+
+/**
+ * @brief Инициализация автомата и его задачи
+ * Initialize the state machine and its task
+ *
+ * Подписывается на события VAD распознавателя.
+ * Subscribes to the recognizer's VAD events.
+ */
+esp_err_t system_state_init(system_state_handle_t* handle, const system_state_config_t* config);
+
+/**
+ * @brief Деинициализация автомата
+ * Deinitialize the state machine
+ */
+esp_err_t system_state_deinit(system_state_handle_t handle);
+
+/**
+ * @brief Опубликовать событие (из задачи, без ожидания)
+ * Post an event (from a task, without waiting)
+ *
+ * @return ESP_ERR_NO_MEM если очередь полна / ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t system_state_post(system_state_handle_t handle, system_event_t event);
+
+/**
+ * @brief Опубликовать событие со временем, когда оно произошло
+ * Post an event with the time it happened
+ *
+ * Задержка перехода считается от этого времени: для кнопки - от физического
+ * фронта, и время нажатия и отпускания уходит в результат высказывания.
+ * The transition latency is counted from this time: for the button, from the
+ * physical edge, and the press and release times go into the utterance result.
+ *
+ * @param time_us Время события (esp_timer) / Event time (esp_timer)
+ */
+esp_err_t system_state_post_at(system_state_handle_t handle, system_event_t event, int64_t time_us);
+
+/**
+ * @brief Текущее состояние (атомарно, из любой задачи)
+ * Current state (atomic, from any task)
+ */
+system_state_t system_state_get(system_state_handle_t handle);
+
+/**
+ * @brief Идет ли захват аудио
+ * Whether audio capture is running
+ */
+bool system_state_is_capturing(system_state_handle_t handle);
+
+/**
+ * @brief Ждать захвата аудио (задача аудио)
+ * Wait for audio capture (audio task)
+ *
+ * Блокирует вызывающую задачу на уведомлении, пока захват не начнется; если
+ * он уже идет, возвращается сразу.
+ * Blocks the calling task on a notification until capture starts; returns at
+ * once if it is already running.
+ */
+void system_state_wait_capture(system_state_handle_t handle);
+
+/**
+ * @brief Имя состояния
+ * State name
+ */
+const char* system_state_name(system_state_t state);
+
+/**
+ * @brief Имя события
+ * Event name
+ */
+const char* system_event_name(system_event_t event);
+
+/**
+ * @brief Получить журнал переходов, от старых к новым
+ * Get the transition trace, oldest first
+ *
+ * @param count Записей скопировано / Entries copied
+ */
+esp_err_t system_state_get_trace(system_state_handle_t handle, system_transition_t* trace,
+                                 size_t max_entries, size_t* count);
+
+/**
+ * @brief Получить статистику автомата
+ * Get state machine statistics
+ *
+ * Время текущего состояния учитывается до момента вызова.
+ * The current state's time is counted up to the call.
+ */
+esp_err_t system_state_get_stats(system_state_handle_t handle, system_state_stats_t* stats);
+
+#endif // SYSTEM_STATE_H
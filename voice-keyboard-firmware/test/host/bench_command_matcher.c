@@ -0,0 +1,98 @@
+/**
+ * @file bench_command_matcher.c
+ * @brief Command matcher host microbenchmark
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Сравнение автомата Ахо-Корасик с прежним линейным поиском (копия текста,
+ * tolower и strstr на каждый шаблон). Запускается вручную, в ctest не входит.
+ * Compares the Aho-Corasick automaton with the former linear scan (a text
+ * copy, tolower and strstr per pattern). Run by hand, not part of ctest.
+ *
+ *   bench_command_matcher [iterations]
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "config/command_matcher.h"
+#include "command_automaton.h"
+#include "command_pattern_list.h"
+
+#define PATTERN_COUNT (sizeof(command_pattern_list) / sizeof(command_pattern_list[0]))
+
+// Фразы замера / Benchmark phrases
+static const char* const phrases[] = {
+    "I think we should meet tomorrow afternoon near the old library",       // Без команд / No command
+    "давай встретимся завтра после обеда возле старой библиотеки",           // Без команд / No command
+    "please open the document and then press enter",                         // Команда в конце / Command at the end
+    "кликни правой",                                                         // Короткая команда / Short command
+};
+
+/**
+ * @brief Прежний линейный поиск: первый шаблон по порядку таблицы
+ * The former linear scan: the first pattern in table order
+ */
+static int linear_find(const char* text) {
+    for (size_t i = 0; i < PATTERN_COUNT; i++) {
+        char text_lower[256];
+        char pattern_lower[256];
+
+        strncpy(text_lower, text, sizeof(text_lower) - 1);
+        strncpy(pattern_lower, command_pattern_list[i], sizeof(pattern_lower) - 1);
+        text_lower[sizeof(text_lower) - 1] = '\0';
+        pattern_lower[sizeof(pattern_lower) - 1] = '\0';
+
+        for (char* c = text_lower; *c; c++) {
+            *c = tolower((unsigned char)*c);
+        }
+        for (char* c = pattern_lower; *c; c++) {
+            *c = tolower((unsigned char)*c);
+        }
+
+        if (strstr(text_lower, pattern_lower)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int automaton_find(const char* text) {
+    command_match_t match;
+    return command_matcher_find_longest(&command_automaton, text, strlen(text), &match) ? match.pattern : -1;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Среднее время вызова в наносекундах
+ * Mean time per call in nanoseconds
+ */
+static double measure(int (*find)(const char*), const char* text, long iterations, volatile int* sink) {
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        *sink += find(text);
+    }
+    return (now_ns() - start) / iterations;
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 100000;
+    volatile int sink = 0;
+
+    printf("%zu patterns, %ld iterations\n", PATTERN_COUNT, iterations);
+    printf("%-12s %-12s %s\n", "linear, ns", "automaton, ns", "phrase");
+    for (size_t i = 0; i < sizeof(phrases) / sizeof(phrases[0]); i++) {
+        double linear = measure(linear_find, phrases[i], iterations, &sink);
+        double automaton = measure(automaton_find, phrases[i], iterations, &sink);
+        printf("%-12.0f %-12.0f %s\n", linear, automaton, phrases[i]);
+    }
+
+    return 0;
+}
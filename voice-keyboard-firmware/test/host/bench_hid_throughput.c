@@ -0,0 +1,138 @@
+/**
+ * @file bench_hid_throughput.c
+ * @brief Dictation typing throughput benchmark on the recording HID transport
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Текст печатается через hid_transport_mock на имитированных часах esp_timer:
+ * упаковка 6KRO из text_transcoder против прежних нажатия и отпускания на
+ * каждый символ. Время - от первой отправки до доставки последнего отчета
+ * хосту (USB: опрос 1 мс, BLE: 7.5 мс и 4 уведомления за событие связи).
+ * Запускается вручную, в ctest не входит.
+ * Text is typed through hid_transport_mock on the simulated esp_timer clock:
+ * 6KRO packing from text_transcoder against the former press and release per
+ * character. Time runs from the first submit to the host delivery of the last
+ * report (USB: 1 ms polling, BLE: 7.5 ms and 4 notifications per connection
+ * event). Run by hand, not part of ctest.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "config/hid_mock.h"
+#include "config/text_transcoder.h"
+#include "config/command_matcher.h"
+
+// Транспорт хоста / Host link
+typedef struct {
+    const char* name;
+    uint32_t interval_us;        // Опрос USB или интервал связи BLE / USB polling or BLE connection interval
+    uint8_t reports_per_event;   // 0 - USB
+} link_t;
+
+static const link_t links[] = {
+    {"USB", 1000, 0},
+    {"BLE", 7500, 4},            // HID_BLE_NOTIFY_PER_EVENT
+};
+
+// Фразы замера / Benchmark phrases
+typedef struct {
+    const char* name;
+    text_layout_t layout;
+    const char* text;
+} phrase_t;
+
+static const phrase_t phrases[] = {
+    {"US pangram", TEXT_LAYOUT_US, "The quick brown fox jumps over the lazy dog."},
+    {"RU pangram", TEXT_LAYOUT_RU, "Съешь же ещё этих мягких французских булок, да выпей чаю."},
+};
+
+// Итог прогона / Run result
+typedef struct {
+    uint32_t characters;
+    uint32_t reports;
+    int64_t elapsed_us;
+} run_result_t;
+
+/**
+ * @brief Отправить отчет, дожидаясь хоста на имитированных часах
+ * Submit a report, waiting for the host on the simulated clock
+ */
+static void submit(const hid_keyboard_report_t* report, run_result_t* result, int64_t start_us) {
+    while (hid_transport_mock.submit(HID_INTERFACE_KEYBOARD, 0, report, sizeof(*report)) == ESP_ERR_NOT_FINISHED) {
+        esp_timer_sim_run_next();
+    }
+    result->reports++;
+
+    hid_mock_record_t record;
+    while (hid_mock_read(&record, 1) == 1) {
+        result->elapsed_us = record.delivered_us - start_us;
+    }
+}
+
+/**
+ * @brief Напечатать фразу на транспорте
+ * Type a phrase on the transport
+ *
+ * @param packed true - text_transcoder, false - нажатие и отпускание на символ / press and release per character
+ */
+static run_result_t run(const link_t* link, const phrase_t* phrase, bool packed) {
+    run_result_t result = {0};
+
+    hid_mock_set_interval(link->interval_us);
+    hid_mock_set_connection(link->reports_per_event ? link->interval_us : 0, link->reports_per_event);
+    hid_transport_mock.start(NULL, NULL);
+    int64_t start_us = esp_timer_get_time();
+
+    size_t length = strlen(phrase->text);
+    hid_keyboard_report_t report;
+    if (packed) {
+        text_transcoder_t transcoder;
+        text_transcoder_init(&transcoder, phrase->layout, phrase->text, length);
+        while (text_transcoder_next(&transcoder, &report)) {
+            submit(&report, &result, start_us);
+        }
+        result.characters = transcoder.characters;
+    } else {
+        size_t pos = 0;
+        while (pos < length) {
+            uint32_t code_point;
+            text_key_t key;
+            pos += command_matcher_decode_utf8(phrase->text + pos, length - pos, &code_point);
+            if (!text_layout_map(phrase->layout, code_point, &key)) {
+                continue;
+            }
+            memset(&report, 0, sizeof(report));
+            report.modifier = key.modifier;
+            report.keycode[0] = key.usage;
+            submit(&report, &result, start_us);
+            memset(&report, 0, sizeof(report));
+            submit(&report, &result, start_us);
+            result.characters++;
+        }
+    }
+
+    // Дождаться последнего отчета / Let the last report complete
+    while (esp_timer_sim_run_next()) {
+    }
+    hid_transport_mock.stop();
+    return result;
+}
+
+int main(void) {
+    printf("%-4s %-11s %-8s %6s %8s %12s %9s %8s\n",
+           "link", "phrase", "packing", "chars", "reports", "chars/report", "time, ms", "chars/s");
+    for (size_t l = 0; l < sizeof(links) / sizeof(links[0]); l++) {
+        for (size_t p = 0; p < sizeof(phrases) / sizeof(phrases[0]); p++) {
+            for (int packed = 0; packed <= 1; packed++) {
+                run_result_t result = run(&links[l], &phrases[p], packed);
+                printf("%-4s %-11s %-8s %6u %8u %12.2f %9.1f %8.0f\n", links[l].name, phrases[p].name,
+                       packed ? "6KRO" : "single", (unsigned)result.characters, (unsigned)result.reports,
+                       (double)result.characters / result.reports, result.elapsed_us / 1000.0,
+                       result.characters * 1e6 / result.elapsed_us);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+"""
+Список строк шаблонов для бенчмарка линейного поиска
+Pattern string list for the linear-scan benchmark
+
+Шаблоны читаются тем же разбором, что и у gen_command_automaton.py.
+Patterns are read with the same parser as gen_command_automaton.py.
+
+Использование / Usage:
+    gen_pattern_list.py <gen_command_automaton.py> <voice_commands.c> <command_pattern_list.h>
+"""
+
+import importlib.util
+import sys
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+
+    spec = importlib.util.spec_from_file_location('gen_command_automaton', sys.argv[1])
+    generator = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(generator)
+    patterns = generator.read_patterns(sys.argv[2])
+
+    out = ['/* Generated by test/host/gen_pattern_list.py - do not edit */', '',
+           'static const char* const command_pattern_list[] = {']
+    out.extend('    "%s",' % p for p in patterns)
+    out.extend(['};', ''])
+    with open(sys.argv[3], 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,25 @@
+/**
+ * @file esp_err.h
+ * @brief Host stub of the ESP-IDF error codes
+ *
+ * Только то, что используют модули хост-тестов / Only what the host-tested modules use
+ */
+
+#ifndef ESP_ERR_H
+#define ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_NOT_FOUND       0x105
+#define ESP_ERR_NOT_FINISHED    0x10C
+
+static inline const char* esp_err_to_name(esp_err_t code) {
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+#endif // ESP_ERR_H
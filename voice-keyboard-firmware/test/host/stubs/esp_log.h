@@ -0,0 +1,17 @@
+/**
+ * @file esp_log.h
+ * @brief Host stub of the ESP-IDF log macros
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+// Не печатаются, но аргументы проверяются / Not printed, but the arguments are checked
+#define ESP_LOGI(tag, format, ...) do { if (0) fprintf(stderr, "%s" format, tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) fprintf(stderr, "%s" format, tag, ##__VA_ARGS__); } while (0)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,43 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stub of esp_timer on a simulated clock
+ *
+ * Время идет только в esp_timer_sim_run_next(): часы переводятся на срок
+ * ближайшего таймера и вызывается его callback. Так замеры не зависят от
+ * загрузки машины.
+ * Time moves only in esp_timer_sim_run_next(): the clock jumps to the nearest
+ * timer deadline and its callback runs. Measurements don't depend on the
+ * machine load.
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+} esp_timer_create_args_t;
+
+int64_t esp_timer_get_time(void);
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+
+/**
+ * @brief Перевести часы к ближайшему таймеру и выполнить его
+ * Advance the clock to the nearest timer and run it
+ *
+ * @return false если таймеров нет / false if no timer is armed
+ */
+bool esp_timer_sim_run_next(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,77 @@
+/**
+ * @file esp_timer_sim.c
+ * @brief Simulated-clock esp_timer for host builds
+ */
+
+#include "esp_timer.h"
+#include <stdlib.h>
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    int64_t deadline_us;         // -1 - не взведен / -1 - not armed
+    struct esp_timer* next;
+};
+
+static int64_t now_us = 0;
+static struct esp_timer* timers = NULL;
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    struct esp_timer* timer = calloc(1, sizeof(struct esp_timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *args;
+    timer->deadline_us = -1;
+    timer->next = timers;
+    timers = timer;
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (timer->deadline_us >= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = now_us + (int64_t)timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer || timer->deadline_us < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = -1;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    for (struct esp_timer** link = &timers; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            free(timer);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+bool esp_timer_sim_run_next(void) {
+    struct esp_timer* nearest = NULL;
+    for (struct esp_timer* timer = timers; timer; timer = timer->next) {
+        if (timer->deadline_us >= 0 && (!nearest || timer->deadline_us < nearest->deadline_us)) {
+            nearest = timer;
+        }
+    }
+    if (!nearest) {
+        return false;
+    }
+
+    now_us = nearest->deadline_us;
+    nearest->deadline_us = -1;
+    nearest->args.callback(nearest->args.arg);
+    return true;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stub of the FreeRTOS base header (single-threaded host builds)
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFF)
+
+#endif // FREERTOS_H
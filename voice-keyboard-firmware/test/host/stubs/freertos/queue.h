@@ -0,0 +1,13 @@
+/**
+ * @file queue.h
+ * @brief Host stub of the FreeRTOS queue header (types only, nothing is scheduled)
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void* QueueHandle_t;
+
+#endif // QUEUE_H
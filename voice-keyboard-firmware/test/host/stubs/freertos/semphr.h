@@ -0,0 +1,33 @@
+/**
+ * @file semphr.h
+ * @brief Host stub of FreeRTOS mutexes (single-threaded host builds)
+ */
+
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return malloc(1);
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    free(semaphore);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    (void)semaphore;
+    (void)ticks;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    (void)semaphore;
+    return pdTRUE;
+}
+
+#endif // SEMPHR_H
@@ -0,0 +1,13 @@
+/**
+ * @file task.h
+ * @brief Host stub of the FreeRTOS task header (types only, nothing is scheduled)
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+#endif // TASK_H
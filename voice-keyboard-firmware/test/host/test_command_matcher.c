@@ -0,0 +1,162 @@
+/**
+ * @file test_command_matcher.c
+ * @brief Command matcher host tests
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Тесты поиска команд на словаре command_patterns[]
+ * Command matching tests on the command_patterns[] dictionary
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "config/command_matcher.h"
+#include "command_automaton.h"
+
+static int failures = 0;
+
+/**
+ * @brief Проверить найденные команды по тексту совпадений
+ * Check the commands found by their matched text
+ *
+ * @param expected Тексты совпадений по порядку, NULL в конце / Matched texts in order, NULL-terminated
+ */
+static void expect_all(const char* text, const char* const* expected) {
+    command_match_t matches[8];
+    size_t count = command_matcher_find_all(&command_automaton, text, strlen(text), matches, 8);
+
+    size_t expected_count = 0;
+    while (expected[expected_count]) {
+        expected_count++;
+    }
+
+    bool ok = count == expected_count;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = matches[i].length == strlen(expected[i]) &&
+             memcmp(text + matches[i].start, expected[i], matches[i].length) == 0;
+    }
+    if (!ok) {
+        printf("FAIL find_all(\"%s\"): %zu match(es)", text, count);
+        for (size_t i = 0; i < count; i++) {
+            printf(" [%.*s]", (int)matches[i].length, text + matches[i].start);
+        }
+        printf(", expected %zu\n", expected_count);
+        failures++;
+    }
+}
+
+#define EXPECT_ALL(text, ...) expect_all(text, (const char* const[]){__VA_ARGS__, NULL})
+#define EXPECT_NONE(text) expect_all(text, (const char* const[]){NULL})
+
+/**
+ * @brief Проверить самую длинную команду
+ * Check the longest command
+ */
+static void expect_longest(const char* text, const char* expected) {
+    command_match_t match;
+    bool found = command_matcher_find_longest(&command_automaton, text, strlen(text), &match);
+
+    bool ok = expected ? found && match.length == strlen(expected) &&
+                         memcmp(text + match.start, expected, match.length) == 0
+                       : !found;
+    if (!ok) {
+        printf("FAIL find_longest(\"%s\"): %s%.*s, expected %s\n", text, found ? "" : "none",
+               found ? (int)match.length : 0, found ? text + match.start : "", expected ? expected : "none");
+        failures++;
+    }
+}
+
+/**
+ * @brief Совпадения только на границах слов
+ * Matches only on word boundaries
+ */
+static void test_word_boundaries(void) {
+    // Шаблон внутри слова / A pattern inside a word
+    EXPECT_NONE("this is a test");
+    EXPECT_NONE("show me the display");
+    EXPECT_NONE("покажи мне файл");
+    EXPECT_NONE("stopwatch");
+    EXPECT_NONE("отсон");
+    expect_longest("this is a test", NULL);
+    expect_longest("покажи мне файл", NULL);
+
+    // Границы: начало/конец текста, пробелы, пунктуация / Boundaries: text start/end, spaces, punctuation
+    EXPECT_ALL("hi", "hi");
+    EXPECT_ALL("hi there", "hi");
+    EXPECT_ALL("ну, пока!", "пока");
+    EXPECT_ALL("Пока", "Пока");
+    EXPECT_ALL("«пауза»", "пауза");
+    EXPECT_ALL("play—pause", "play", "pause");
+
+    // Более короткий шаблон, если длинный начинается внутри слова
+    // A shorter pattern when the longer one starts inside a word
+    EXPECT_ALL("redouble click", "click");
+    expect_longest("redouble click", "click");
+}
+
+/**
+ * @brief Порядок и выбор самого длинного совпадения
+ * Order and longest-match selection
+ */
+static void test_order(void) {
+    EXPECT_ALL("нажми пробел, потом нажми ввод", "нажми пробел", "нажми ввод");
+    EXPECT_ALL("кликни правой", "кликни правой");
+    EXPECT_ALL("кликни", "кликни");
+    EXPECT_ALL("Громче и следующий трек", "Громче", "следующий трек");
+    expect_longest("пауза и следующий трек", "следующий трек");
+}
+
+/**
+ * @brief Проверить резервный нечеткий поиск, как в parse_commands
+ * Check the fuzzy fallback as parse_commands runs it
+ */
+static void expect_fuzzy(const char* text, const char* expected) {
+    static command_fuzzy_state_t workspace[COMMAND_AUTOMATON_PATTERN_COUNT];
+    command_match_t match;
+    bool found = command_matcher_find_all(&command_automaton, text, strlen(text), &match, 1) == 0 &&
+                 command_matcher_find_fuzzy(&command_automaton, text, strlen(text),
+                                            COMMAND_MATCHER_FUZZY_MAX_ERROR_RATIO, workspace, &match);
+
+    bool ok = expected ? found && match.length == strlen(expected) &&
+                         memcmp(text + match.start, expected, match.length) == 0
+                       : !found;
+    if (!ok) {
+        printf("FAIL find_fuzzy(\"%s\"): %s%.*s (pattern %d, %d error(s)), expected %s\n", text,
+               found ? "" : "none", found ? (int)match.length : 0, found ? text + match.start : "",
+               found ? match.pattern : -1, found ? match.errors : 0, expected ? expected : "none");
+        failures++;
+    }
+}
+
+/**
+ * @brief Нечеткий поиск только для фразы, почти целиком похожей на команду
+ * Fuzzy search only for an utterance that is almost entirely a command
+ */
+static void test_fuzzy(void) {
+    // Обычная диктовка не дает команд / Ordinary dictation yields no commands
+    expect_fuzzy("сегодня хорошая погода", NULL);
+    expect_fuzzy("я хочу купить молоко и хлеб", NULL);
+    expect_fuzzy("добрый день коллеги", NULL);
+    expect_fuzzy("напиши письмо маме", NULL);
+    expect_fuzzy("покажи", NULL);
+    expect_fuzzy("ну тишэ", NULL);
+
+    // Ошибки распознавания в самой команде / Recognition errors in the command itself
+    expect_fuzzy("громчи", "громчи");
+    expect_fuzzy("следущий трек", "следущий трек");
+    expect_fuzzy("Двойной клек.", "Двойной клек");
+    expect_fuzzy("тишэ", "тишэ");
+}
+
+int main(void) {
+    test_word_boundaries();
+    test_order();
+    test_fuzzy();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All command matcher checks passed\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_keyword_spotter.c
+ * @brief Keyword spotter host tests
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Синтетические "слова" из последовательностей тонов: образец, записанный с
+ * одного произношения, узнает другое (громкость, темп, шум), но не чужое слово
+ * Synthetic "words" made of tone sequences: a sample enrolled from one
+ * utterance recognizes another (loudness, tempo, noise) but not a different word
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "config/keyword_spotter.h"
+
+#define SAMPLE_RATE 16000
+#define MAX_SAMPLES (SAMPLE_RATE * KEYWORD_SPOTTER_MAX_MS / 1000)
+
+static int failures = 0;
+static int16_t audio[MAX_SAMPLES];
+
+// Слог: основной тон и форманта / Syllable: fundamental and formant
+typedef struct {
+    float pitch_hz;
+    float formant_hz;
+    int ms;
+} syllable_t;
+
+/**
+ * @brief Синтезировать слово с тишиной по краям
+ * Synthesize a word with silence at both ends
+ *
+ * @param tempo Множитель длительности слогов / Syllable duration multiplier
+ * @param gain Амплитуда / Amplitude
+ */
+static size_t synthesize(const syllable_t* syllables, size_t count, float tempo, float gain, unsigned seed) {
+    size_t length = SAMPLE_RATE / 10;
+    memset(audio, 0, sizeof(audio));
+    srand(seed);
+
+    for (size_t s = 0; s < count; s++) {
+        size_t samples = (size_t)(syllables[s].ms * tempo * SAMPLE_RATE / 1000);
+        for (size_t i = 0; i < samples && length < MAX_SAMPLES; i++, length++) {
+            float t = (float)i / SAMPLE_RATE;
+            float value = 0.6f * sinf(2.0f * (float)M_PI * syllables[s].pitch_hz * t) +
+                          0.4f * sinf(2.0f * (float)M_PI * syllables[s].formant_hz * t);
+            audio[length] = (int16_t)(gain * 20000.0f * value);
+        }
+    }
+    length += SAMPLE_RATE / 10;
+    if (length > MAX_SAMPLES) {
+        length = MAX_SAMPLES;
+    }
+
+    // Слабый шум / Faint noise
+    for (size_t i = 0; i < length; i++) {
+        audio[i] = (int16_t)(audio[i] + (rand() % 201) - 100);
+    }
+    return length;
+}
+
+static const syllable_t word_enter[] = {{150, 400, 150}, {180, 1600, 200}, {160, 2500, 150}};
+static const syllable_t word_tab[] = {{200, 6300, 120}, {170, 630, 250}, {150, 1000, 130}};
+
+int main(void) {
+    keyword_spotter_handle_t spotter = NULL;
+    speech_result_t result;
+    keyword_spotter_stats_t stats;
+
+    if (keyword_spotter_init(&spotter) != ESP_OK) {
+        printf("FAIL init\n");
+        return 1;
+    }
+
+    // Без образцов ничего не узнается / Nothing is recognized without samples
+    size_t length = synthesize(word_enter, 3, 1.0f, 1.0f, 1);
+    if (keyword_spotter_recognize(spotter, audio, length, &result) != ESP_ERR_NOT_FOUND) {
+        printf("FAIL recognized with no samples\n");
+        failures++;
+    }
+    if (keyword_spotter_learn(spotter, "нажми ввод") != ESP_OK) {
+        printf("FAIL learn\n");
+        failures++;
+    }
+    // Одно аудио - один образец / One audio, one sample
+    if (keyword_spotter_learn(spotter, "нажми ввод") != ESP_ERR_INVALID_STATE) {
+        printf("FAIL the same audio enrolled twice\n");
+        failures++;
+    }
+
+    length = synthesize(word_tab, 3, 1.0f, 1.0f, 2);
+    keyword_spotter_recognize(spotter, audio, length, &result);
+    keyword_spotter_learn(spotter, "нажми таб");
+
+    // То же слово тише, медленнее и с другим шумом / The same word quieter, slower and with other noise
+    length = synthesize(word_enter, 3, 1.15f, 0.3f, 3);
+    esp_err_t ret = keyword_spotter_recognize(spotter, audio, length, &result);
+    keyword_spotter_get_stats(spotter, &stats);
+    if (ret != ESP_OK || strcmp(result.text, "нажми ввод") != 0 || result.confidence < 0.6f) {
+        printf("FAIL same word: %s '%s' %.2f (distance %u)\n", esp_err_to_name(ret), ret == ESP_OK ? result.text : "",
+               ret == ESP_OK ? result.confidence : 0.0f, stats.last_distance);
+        failures++;
+    }
+
+    length = synthesize(word_tab, 3, 0.9f, 1.5f, 4);
+    ret = keyword_spotter_recognize(spotter, audio, length, &result);
+    keyword_spotter_get_stats(spotter, &stats);
+    if (ret != ESP_OK || strcmp(result.text, "нажми таб") != 0 || result.confidence < 0.6f) {
+        printf("FAIL second word: %s '%s' %.2f (distance %u)\n", esp_err_to_name(ret),
+               ret == ESP_OK ? result.text : "", ret == ESP_OK ? result.confidence : 0.0f, stats.last_distance);
+        failures++;
+    }
+
+    // Чужое слово не проходит порог / A different word stays below the threshold
+    static const syllable_t word_other[] = {{220, 4000, 200}, {140, 250, 200}, {190, 4000, 150}};
+    length = synthesize(word_other, 3, 1.0f, 1.0f, 5);
+    ret = keyword_spotter_recognize(spotter, audio, length, &result);
+    keyword_spotter_get_stats(spotter, &stats);
+    if (ret == ESP_OK && result.confidence >= 0.6f) {
+        printf("FAIL other word recognized as '%s' %.2f (distance %u)\n", result.text, result.confidence,
+               stats.last_distance);
+        failures++;
+    }
+
+    // Короче минимума речи / Below the speech minimum
+    static const syllable_t word_short[] = {{150, 400, 100}};
+    length = synthesize(word_short, 1, 1.0f, 1.0f, 6);
+    if (keyword_spotter_recognize(spotter, audio, length, &result) != ESP_ERR_NOT_FOUND ||
+        keyword_spotter_learn(spotter, "стоп") != ESP_ERR_INVALID_STATE) {
+        printf("FAIL too short utterance\n");
+        failures++;
+    }
+
+    keyword_spotter_get_stats(spotter, &stats);
+    if (stats.templates != 2 || stats.enrolled != 2 || stats.too_short != 1) {
+        printf("FAIL stats: templates=%u, enrolled=%u, too_short=%u\n", (unsigned)stats.templates,
+               (unsigned)stats.enrolled, (unsigned)stats.too_short);
+        failures++;
+    }
+
+    keyword_spotter_deinit(spotter);
+
+    if (failures > 0) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("All keyword spotter tests passed\n");
+    return 0;
+}
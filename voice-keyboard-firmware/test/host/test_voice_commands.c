@@ -0,0 +1,146 @@
+/**
+ * @file test_voice_commands.c
+ * @brief Voice command processor host tests
+ * @author Voice Keyboard Team
+ * @date 2025
+ *
+ * Разделение команд и диктовки на пути main.c: гипотезы печатаются через
+ * dictation_output, пакет команд стирает напечатанное и попадает в журнал
+ * Splitting commands from dictation on the main.c path: hypotheses are typed
+ * through dictation_output, a command batch erases what was typed and is logged
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "config/voice_commands.h"
+#include "config/dictation_output.h"
+
+static int failures = 0;
+
+// Экран хоста и выполненные команды / Host screen and executed commands
+static char screen[512];
+static size_t screen_length = 0;
+static char commands_run[256];
+static dictation_output_handle_t dictation_output = NULL;
+
+// Встроенный словарь, загружаемого нет / Built-in dictionary, none is loaded
+const command_dictionary_t* command_dictionary_acquire(command_dictionary_handle_t handle) {
+    (void)handle;
+    return NULL;
+}
+
+void command_dictionary_release(command_dictionary_handle_t handle) {
+    (void)handle;
+}
+
+/**
+ * @brief Применить правку к экрану, Backspace стирает символ UTF-8
+ * Apply an edit to the screen, Backspace erases one UTF-8 character
+ */
+static void apply_edit(const dictation_edit_t* edit) {
+    for (uint16_t i = 0; i < edit->backspaces && screen_length > 0; i++) {
+        do {
+            screen_length--;
+        } while (screen_length > 0 && ((unsigned char)screen[screen_length] & 0xC0) == 0x80);
+    }
+    if (edit->insert_length > 0 && screen_length + edit->insert_length < sizeof(screen)) {
+        memcpy(screen + screen_length, edit->insert, edit->insert_length);
+        screen_length += edit->insert_length;
+    }
+    screen[screen_length] = '\0';
+}
+
+// Как command_batch_callback в main.c / As command_batch_callback in main.c
+static void batch_callback(const voice_command_t* commands, size_t count, void* user_data) {
+    dictation_edit_t edit;
+    (void)user_data;
+
+    if (dictation_output_discard(dictation_output, &edit) == ESP_OK) {
+        apply_edit(&edit);
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t used = strlen(commands_run);
+        snprintf(commands_run + used, sizeof(commands_run) - used, "%s%s", used ? "," : "", commands[i].command);
+    }
+}
+
+// Как dictation_callback в main.c / As dictation_callback in main.c
+static void dictation_callback(const char* text, bool is_final, void* user_data) {
+    dictation_edit_t edit;
+    (void)user_data;
+
+    if (dictation_output_update(dictation_output, text, is_final, &edit) == ESP_OK) {
+        apply_edit(&edit);
+    }
+}
+
+/**
+ * @brief Провести фразу через гипотезы и финальный результат
+ * Run an utterance through its hypotheses and the final result
+ *
+ * @param hypotheses Гипотезы по порядку, последняя финальная, NULL в конце / Hypotheses in order, the last is final, NULL-terminated
+ * @param expected_screen Экран после фразы / Screen after the utterance
+ * @param expected_commands Команды через запятую ("" - нет) / Comma-separated commands ("" - none)
+ */
+static void expect_utterance(voice_command_processor_handle_t processor, uint32_t sequence,
+                             const char* const* hypotheses, const char* expected_screen,
+                             const char* expected_commands) {
+    commands_run[0] = '\0';
+
+    for (size_t i = 0; hypotheses[i]; i++) {
+        speech_result_t result;
+        memset(&result, 0, sizeof(result));
+        strncpy(result.text, hypotheses[i], sizeof(result.text) - 1);
+        result.confidence = 0.9f;
+        result.is_final = hypotheses[i + 1] == NULL;
+        result.sequence = sequence;
+        voice_command_processor_process_result(processor, &result);
+    }
+
+    if (strcmp(screen, expected_screen) != 0 || strcmp(commands_run, expected_commands) != 0) {
+        printf("FAIL \"%s\": screen \"%s\", commands \"%s\"; expected \"%s\", \"%s\"\n",
+               hypotheses[0], screen, commands_run, expected_screen, expected_commands);
+        failures++;
+    }
+}
+
+#define EXPECT_UTTERANCE(processor, sequence, screen, commands, ...) \
+    expect_utterance(processor, sequence, (const char* const[]){__VA_ARGS__, NULL}, screen, commands)
+
+int main(void) {
+    voice_command_processor_handle_t processor = NULL;
+
+    if (voice_command_processor_init(&processor) != ESP_OK || dictation_output_init(&dictation_output) != ESP_OK) {
+        printf("FAIL init\n");
+        return 1;
+    }
+    voice_command_processor_set_batch_callback(processor, batch_callback, NULL);
+    voice_command_processor_set_dictation_callback(processor, dictation_callback, NULL);
+
+    // Командное слово внутри фразы печатается и ничего не стирает
+    // A command word inside a sentence is typed and erases nothing
+    EXPECT_UTTERANCE(processor, 1, "I'll stop by later", "",
+                     "I'll", "I'll stop", "I'll stop by", "I'll stop by later");
+
+    // Приветствие без привязки HID - не команда / A greeting with no HID binding is not a command
+    EXPECT_UTTERANCE(processor, 2, "I'll stop by later hi John, see you at five", "",
+                     "hi John", "hi John, see you at five");
+    EXPECT_UTTERANCE(processor, 3, "I'll stop by later hi John, see you at five пока", "",
+                     "пока");
+
+    // Фраза из команд целиком стирает свои гипотезы / A whole-command utterance erases its hypotheses
+    EXPECT_UTTERANCE(processor, 4, "I'll stop by later hi John, see you at five пока", "enter,tab",
+                     "нажми", "нажми ввод", "нажми ввод и нажми", "нажми ввод и нажми таб");
+    EXPECT_UTTERANCE(processor, 5, "I'll stop by later hi John, see you at five пока", "stop",
+                     "стоп");
+
+    voice_command_processor_deinit(processor);
+    dictation_output_deinit(dictation_output);
+
+    if (failures > 0) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("All voice command tests passed\n");
+    return 0;
+}
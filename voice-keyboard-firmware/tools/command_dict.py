@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Компилятор словаря голосовых команд в двоичный образ
+Voice command dictionary compiler to a binary image
+
+Исходный файл - строки "шаблон | ТИП | ДЕЙСТВИЕ | команда | ПРИВЯЗКА", '#' - комментарий.
+ТИП и ДЕЙСТВИЕ - имена из voice_commands.h без префиксов CMD_TYPE_/CMD_ACTION_,
+ПРИВЯЗКА - имя из hid_bindings.h без HID_BINDING_.
+The source file has lines "pattern | TYPE | ACTION | command | BINDING", '#' starts
+a comment. TYPE and ACTION are names from voice_commands.h without
+CMD_TYPE_/CMD_ACTION_, BINDING is a name from hid_bindings.h without HID_BINDING_.
+
+Формат образа описан в main/config/command_dictionary.h.
+The image format is described in main/config/command_dictionary.h.
+
+Использование / Usage:
+    command_dict.py <commands.txt> <commands.bin> [--image <partition.bin> --partition-size <bytes>]
+
+Образ можно установить через command_dictionary_install(); --image собирает
+образ раздела для первичной прошивки (parttool.py write_partition).
+The image can be installed with command_dictionary_install(); --image builds a
+partition image for initial flashing (parttool.py write_partition).
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import gen_command_automaton  # noqa: E402
+
+MAGIC = 0x44434B56  # "VKCD"
+VERSION = 2
+
+# command_dictionary_header_t
+HEADER_FORMAT = '<IHHIII6HI10I'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+CONFIG_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main', 'config')
+VOICE_COMMANDS_H = os.path.join(CONFIG_DIR, 'voice_commands.h')
+HID_BINDINGS_H = os.path.join(CONFIG_DIR, 'hid_bindings.h')
+
+
+def read_enum(source, name):
+    """Значения перечисления по порядку / Enum values in declaration order"""
+    match = re.search(r'typedef enum \{([^{}]*)\}\s*%s;' % name, source)
+    if not match:
+        sys.exit('%s not found' % name)
+    body = re.sub(r'//[^\n]*', '', match.group(1))
+    names = [item.strip() for item in body.split(',') if item.strip()]
+    return {n: i for i, n in enumerate(names)}
+
+
+def read_source(path, types, actions, bindings):
+    entries = []
+    with open(path, encoding='utf-8') as f:
+        for number, line in enumerate(f, 1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            fields = [field.strip() for field in line.split('|')]
+            if len(fields) != 5 or not fields[0]:
+                sys.exit('%s:%d: expected "pattern | TYPE | ACTION | command | BINDING"' % (path, number))
+            pattern, type_name, action_name, command, binding_name = fields
+            type_key = 'CMD_TYPE_' + type_name.upper()
+            action_key = 'CMD_ACTION_' + action_name.upper()
+            if type_key not in types:
+                sys.exit('%s:%d: unknown type %s' % (path, number, type_name))
+            if action_key not in actions:
+                sys.exit('%s:%d: unknown action %s' % (path, number, action_name))
+            binding_key = 'HID_BINDING_' + binding_name.upper()
+            if binding_key not in bindings or binding_key == 'HID_BINDING_COUNT':
+                sys.exit('%s:%d: unknown binding %s' % (path, number, binding_name))
+            entries.append((pattern, types[type_key], actions[action_key], command, bindings[binding_key]))
+    if not entries:
+        sys.exit('%s: no commands' % path)
+    if len(entries) > 0xFFFF:
+        sys.exit('%s: too many commands' % path)
+    return entries
+
+
+class Sections:
+    """Раскладка секций с выравниванием 4 байта / Section layout with 4-byte alignment"""
+
+    def __init__(self):
+        self.data = bytearray()
+
+    def add(self, payload):
+        while (HEADER_SIZE + len(self.data)) % 4:
+            self.data.append(0)
+        offset = HEADER_SIZE + len(self.data)
+        self.data += payload
+        return offset
+
+
+def build_image(entries):
+    patterns = [e[0] for e in entries]
+    (ascii_symbols, cyrillic_symbols, states, edges, lengths,
+     fuzzy_entries, fuzzy_first, fuzzy_lengths, symbol_count) = gen_command_automaton.build(patterns)
+    if max(lengths) > 64:
+        sys.exit('Pattern longer than 64 characters')
+
+    # Таблица строк без повторов / String table without duplicates
+    strings = bytearray()
+    string_offsets = {}
+
+    def intern(text):
+        if text not in string_offsets:
+            string_offsets[text] = len(strings)
+            strings.extend(text.encode('utf-8') + b'\0')
+        return string_offsets[text]
+
+    records = [(intern(p), intern(c), t, a, b) for p, t, a, c, b in entries]
+
+    s = Sections()
+    ascii_offset = s.add(bytes(ascii_symbols))
+    cyrillic_offset = s.add(bytes(cyrillic_symbols))
+    states_offset = s.add(b''.join(struct.pack('<HBBHh', first, count, 0, fail, output)
+                                   for first, count, fail, output in states))
+    edges_offset = s.add(b''.join(struct.pack('<BBH', symbol, 0, target) for symbol, target in edges))
+    pattern_chars_offset = s.add(bytes(lengths))
+    fuzzy_entries_offset = s.add(b''.join(struct.pack('<IHH', mask, index, 0) for mask, index in fuzzy_entries))
+    fuzzy_first_offset = s.add(b''.join(struct.pack('<H', v) for v in fuzzy_first))
+    fuzzy_chars_offset = s.add(bytes(fuzzy_lengths))
+    entries_offset = s.add(b''.join(struct.pack('<IIBBH', p, c, t, a, b) for p, c, t, a, b in records))
+    strings_offset = s.add(bytes(strings))
+
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, HEADER_SIZE, HEADER_SIZE + len(s.data),
+                         zlib.crc32(bytes(s.data)) & 0xFFFFFFFF, 1,
+                         len(patterns), len(states), len(edges), symbol_count, len(fuzzy_entries), 0,
+                         len(strings),
+                         ascii_offset, cyrillic_offset, states_offset, edges_offset, pattern_chars_offset,
+                         fuzzy_entries_offset, fuzzy_first_offset, fuzzy_chars_offset,
+                         entries_offset, strings_offset)
+    return header + bytes(s.data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile a voice command dictionary')
+    parser.add_argument('source', help='text source (pattern | TYPE | ACTION | command | BINDING)')
+    parser.add_argument('output', help='dictionary image')
+    parser.add_argument('--image', help='also write a partition image with the dictionary in slot 0')
+    parser.add_argument('--partition-size', type=lambda v: int(v, 0), default=0x10000,
+                        help='partition size for --image (default 0x10000)')
+    args = parser.parse_args()
+
+    with open(VOICE_COMMANDS_H, encoding='utf-8') as f:
+        header_source = f.read()
+    types = read_enum(header_source, 'command_type_t')
+    actions = read_enum(header_source, 'command_action_t')
+    with open(HID_BINDINGS_H, encoding='utf-8') as f:
+        bindings = read_enum(f.read(), 'hid_binding_id_t')
+
+    blob = build_image(read_source(args.source, types, actions, bindings))
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+    print('%s: %d bytes' % (args.output, len(blob)))
+
+    if args.image:
+        slot_size = args.partition_size // 2
+        if len(blob) > slot_size:
+            sys.exit('Dictionary (%d bytes) does not fit a %d byte slot' % (len(blob), slot_size))
+        image = blob + b'\xff' * (args.partition_size - len(blob))
+        with open(args.image, 'wb') as f:
+            f.write(image)
+        print('%s: %d bytes' % (args.image, len(image)))
+
+
+if __name__ == '__main__':
+    main()
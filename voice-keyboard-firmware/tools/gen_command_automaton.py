@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""
+Генератор автомата Ахо-Корасик для словаря голосовых команд
+Aho-Corasick automaton generator for the voice command dictionary
+
+Читает command_patterns[] из voice_commands.c и пишет заголовок с
+константными таблицами (они остаются во flash). Свертка регистра совпадает
+с command_matcher.c: ASCII и кириллица в нижний регистр, ё -> е.
+Reads command_patterns[] from voice_commands.c and writes a header with
+constant tables (they stay in flash). Case folding matches command_matcher.c:
+ASCII and Cyrillic to lowercase, ё -> е.
+
+Для нечеткого поиска шаблоны переводятся в фонетическую форму
+(command_matcher_phonetic) и сохраняются как маски Eq, сгруппированные по символу.
+For fuzzy search patterns are converted to their phonetic form
+(command_matcher_phonetic) and stored as Eq masks grouped by symbol.
+
+Использование / Usage:
+    gen_command_automaton.py <voice_commands.c> <command_automaton.h>
+"""
+
+import re
+import sys
+from collections import deque
+
+# Шаблон записи словаря / Dictionary entry pattern
+ENTRY_RE = re.compile(r'\{\s*"((?:[^"\\]|\\.)*)"\s*,\s*CMD_TYPE_')
+
+
+def fold(ch):
+    """Свертка регистра / Case folding"""
+    cp = ord(ch)
+    if 0x41 <= cp <= 0x5A:
+        return chr(cp + 0x20)
+    if 0x410 <= cp <= 0x42F:
+        return chr(cp + 0x20)
+    if cp in (0x401, 0x451):
+        return 'е'
+    return ch
+
+
+# Фонетические классы, как в command_matcher_phonetic / Phonetic classes as in command_matcher_phonetic
+PHONETIC = {
+    'о': 'а', 'я': 'а',
+    'е': 'и', 'э': 'и', 'ы': 'и', 'й': 'и',
+    'ю': 'у',
+    'б': 'п', 'в': 'ф', 'г': 'к', 'д': 'т',
+    'ж': 'ш', 'щ': 'ш', 'з': 'с', 'ц': 'с',
+    'ъ': '', 'ь': '',
+}
+
+# Ширина маски нечеткого поиска / Fuzzy search mask width
+FUZZY_MAX_CHARS = 32
+
+
+def phonetic(text):
+    """Фонетическая форма без удвоений / Phonetic form without doubles"""
+    out = []
+    for ch in text:
+        ch = PHONETIC.get(fold(ch), fold(ch))
+        if ch and (not out or out[-1] != ch):
+            out.append(ch)
+    return ''.join(out)
+
+
+def symbol_space(cp):
+    """Таблица символов для кодовой точки / Symbol table of a code point"""
+    if cp < 0x80:
+        return 'ascii'
+    if 0x430 <= cp <= 0x44F:
+        return 'cyrillic'
+    return None
+
+
+def read_patterns(source_path):
+    with open(source_path, encoding='utf-8') as f:
+        source = f.read()
+    match = re.search(r'command_patterns\[\]\s*=\s*\{', source)
+    start = match.end() if match else -1
+    if start < 0:
+        sys.exit('command_patterns[] not found in %s' % source_path)
+    end = source.find('};', start)
+    patterns = [m.group(1) for m in ENTRY_RE.finditer(source, start, end)]
+    if not patterns:
+        sys.exit('command_patterns[] is empty')
+    return patterns
+
+
+def build(patterns):
+    folded = [''.join(fold(ch) for ch in p) for p in patterns]
+    phonetic_forms = [phonetic(p) for p in patterns]
+
+    # Алфавит: символ 0 - "нет в словаре" / Alphabet: symbol 0 is "not in dictionary"
+    alphabet = sorted({ch for p in folded + phonetic_forms for ch in p})
+    for ch in alphabet:
+        if symbol_space(ord(ch)) is None:
+            sys.exit('Unsupported character %r in command patterns' % ch)
+    if len(alphabet) > 255:
+        sys.exit('Too many distinct characters: %d' % len(alphabet))
+    symbol = {ch: i + 1 for i, ch in enumerate(alphabet)}
+
+    # Бор / Trie
+    goto = [{}]
+    own = [-1]
+    for index, p in enumerate(folded):
+        state = 0
+        for ch in p:
+            s = symbol[ch]
+            if s not in goto[state]:
+                goto.append({})
+                own.append(-1)
+                goto[state][s] = len(goto) - 1
+            state = goto[state][s]
+        # Дубликаты: выигрывает первый, как в линейном поиске / Duplicates: first wins, as in the linear scan
+        if own[state] < 0:
+            own[state] = index
+
+    # Суффиксные ссылки в порядке BFS / Failure links in BFS order
+    fail = [0] * len(goto)
+    output = list(own)
+    queue = deque()
+    for target in goto[0].values():
+        queue.append(target)
+    while queue:
+        state = queue.popleft()
+        # Самый длинный шаблон, оканчивающийся здесь / Longest pattern ending here
+        if output[state] < 0:
+            output[state] = output[fail[state]]
+        for s, target in goto[state].items():
+            f = fail[state]
+            while f and s not in goto[f]:
+                f = fail[f]
+            fail[target] = goto[f][s] if s in goto[f] and goto[f][s] != target else 0
+            queue.append(target)
+
+    if len(goto) > 0xFFFF:
+        sys.exit('Automaton too large: %d states' % len(goto))
+
+    states = []
+    edges = []
+    for state in range(len(goto)):
+        first = len(edges)
+        for s in sorted(goto[state]):
+            edges.append((s, goto[state][s]))
+        states.append((first, len(goto[state]), fail[state], output[state]))
+
+    ascii_symbols = [0] * 128
+    cyrillic_symbols = [0] * 32
+    for ch, s in symbol.items():
+        cp = ord(ch)
+        if cp < 0x80:
+            ascii_symbols[cp] = s
+        else:
+            cyrillic_symbols[cp - 0x430] = s
+
+    lengths = [len(p) for p in folded]
+
+    # Маски Eq по символам (CSR) / Eq masks by symbol (CSR)
+    fuzzy_lengths = []
+    masks = [[] for _ in range(len(alphabet) + 1)]
+    for index, p in enumerate(phonetic_forms):
+        if len(p) > FUZZY_MAX_CHARS:
+            fuzzy_lengths.append(0)
+            continue
+        fuzzy_lengths.append(len(p))
+        per_symbol = {}
+        for bit, ch in enumerate(p):
+            per_symbol[symbol[ch]] = per_symbol.get(symbol[ch], 0) | (1 << bit)
+        for s, mask in per_symbol.items():
+            masks[s].append((mask, index))
+    fuzzy_entries = []
+    fuzzy_first = []
+    for entries in masks:
+        fuzzy_first.append(len(fuzzy_entries))
+        fuzzy_entries.extend(entries)
+    fuzzy_first.append(len(fuzzy_entries))
+
+    return (ascii_symbols, cyrillic_symbols, states, edges, lengths,
+            fuzzy_entries, fuzzy_first, fuzzy_lengths, len(alphabet) + 1)
+
+
+def c_array(values, per_line=16):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def write_header(path, patterns, tables):
+    (ascii_symbols, cyrillic_symbols, states, edges, lengths,
+     fuzzy_entries, fuzzy_first, fuzzy_lengths, symbol_count) = tables
+    out = []
+    out.append('/**')
+    out.append(' * @file command_automaton.h')
+    out.append(' * @brief Generated by tools/gen_command_automaton.py - do not edit')
+    out.append(' *')
+    out.append(' * %d patterns, %d states, %d edges, %d fuzzy masks'
+               % (len(patterns), len(states), len(edges), len(fuzzy_entries)))
+    out.append(' */')
+    out.append('')
+    out.append('#ifndef COMMAND_AUTOMATON_H')
+    out.append('#define COMMAND_AUTOMATON_H')
+    out.append('')
+    out.append('#include "config/command_matcher.h"')
+    out.append('')
+    out.append('#define COMMAND_AUTOMATON_PATTERN_COUNT %d' % len(patterns))
+    out.append('#define COMMAND_AUTOMATON_MAX_PATTERN_CHARS %d' % max(lengths))
+    out.append('')
+    out.append('_Static_assert(COMMAND_AUTOMATON_MAX_PATTERN_CHARS <= COMMAND_MATCHER_MAX_PATTERN_CHARS,')
+    out.append('               "command pattern longer than COMMAND_MATCHER_MAX_PATTERN_CHARS");')
+    out.append('')
+    out.append('static const uint8_t command_automaton_ascii_symbols[128] = {')
+    out.append(c_array(ascii_symbols))
+    out.append('};')
+    out.append('')
+    out.append('static const uint8_t command_automaton_cyrillic_symbols[32] = {')
+    out.append(c_array(cyrillic_symbols))
+    out.append('};')
+    out.append('')
+    out.append('static const command_automaton_state_t command_automaton_states[%d] = {' % len(states))
+    for first, count, f, output in states:
+        out.append('    {%d, %d, 0, %d, %d},' % (first, count, f, output))
+    out.append('};')
+    out.append('')
+    out.append('static const command_automaton_edge_t command_automaton_edges[%d] = {' % max(len(edges), 1))
+    for s, target in edges:
+        out.append('    {%d, 0, %d},' % (s, target))
+    out.append('};')
+    out.append('')
+    out.append('static const uint8_t command_automaton_pattern_chars[%d] = {' % len(lengths))
+    out.append(c_array(lengths))
+    out.append('};')
+    out.append('')
+    out.append('static const command_fuzzy_entry_t command_automaton_fuzzy_entries[%d] = {'
+               % max(len(fuzzy_entries), 1))
+    for mask, index in fuzzy_entries:
+        out.append('    {0x%08X, %d, 0},' % (mask, index))
+    out.append('};')
+    out.append('')
+    out.append('static const uint16_t command_automaton_fuzzy_symbol_first[%d] = {' % len(fuzzy_first))
+    out.append(c_array(fuzzy_first))
+    out.append('};')
+    out.append('')
+    out.append('static const uint8_t command_automaton_fuzzy_pattern_chars[%d] = {' % len(fuzzy_lengths))
+    out.append(c_array(fuzzy_lengths))
+    out.append('};')
+    out.append('')
+    out.append('static const command_automaton_t command_automaton = {')
+    out.append('    .ascii_symbols = command_automaton_ascii_symbols,')
+    out.append('    .cyrillic_symbols = command_automaton_cyrillic_symbols,')
+    out.append('    .states = command_automaton_states,')
+    out.append('    .edges = command_automaton_edges,')
+    out.append('    .pattern_chars = command_automaton_pattern_chars,')
+    out.append('    .state_count = %d,' % len(states))
+    out.append('    .pattern_count = %d,' % len(patterns))
+    out.append('    .fuzzy_entries = command_automaton_fuzzy_entries,')
+    out.append('    .fuzzy_symbol_first = command_automaton_fuzzy_symbol_first,')
+    out.append('    .fuzzy_pattern_chars = command_automaton_fuzzy_pattern_chars,')
+    out.append('    .symbol_count = %d,' % symbol_count)
+    out.append('};')
+    out.append('')
+    out.append('#endif // COMMAND_AUTOMATON_H')
+    out.append('')
+
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    patterns = read_patterns(sys.argv[1])
+    write_header(sys.argv[2], patterns, build(patterns))
+
+
+if __name__ == '__main__':
+    main()